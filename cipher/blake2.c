@@ -30,6 +30,47 @@
 #include "cipher.h"
 #include "hash-common.h"
 
+/* USE_AVX indicates whether to compile with Intel AVX code. */
+#undef USE_AVX
+#if defined(__x86_64__) && defined(HAVE_GCC_INLINE_ASM_AVX) && \
+    (defined(HAVE_COMPATIBLE_GCC_AMD64_PLATFORM_AS) || \
+     defined(HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS))
+# define USE_AVX 1
+#endif
+
+/* USE_AVX2 indicates whether to compile with Intel AVX2 code. */
+#undef USE_AVX2
+#if defined(__x86_64__) && defined(HAVE_GCC_INLINE_ASM_AVX2) && \
+    (defined(HAVE_COMPATIBLE_GCC_AMD64_PLATFORM_AS) || \
+     defined(HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS))
+# define USE_AVX2 1
+#endif
+
+/* USE_AARCH64_SIMD indicates whether to enable ARMv8 SIMD assembly
+ * code. */
+#undef USE_AARCH64_SIMD
+#ifdef ENABLE_NEON_SUPPORT
+# if defined(__AARCH64EL__) \
+     && defined(HAVE_COMPATIBLE_GCC_AARCH64_PLATFORM_AS) \
+     && defined(HAVE_GCC_INLINE_ASM_AARCH64_NEON)
+#  define USE_AARCH64_SIMD 1
+# endif
+#endif
+
+/* AMD64 assembly implementations use SystemV ABI, ABI conversion and
+ * additional stack to store XMM6-XMM15 needed on Win64. */
+#undef ASM_FUNC_ABI
+#undef ASM_EXTRA_STACK
+#if defined(USE_AVX) || defined(USE_AVX2)
+# ifdef HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS
+#  define ASM_FUNC_ABI __attribute__((sysv_abi))
+#  define ASM_EXTRA_STACK (10 * 16)
+# else
+#  define ASM_FUNC_ABI
+#  define ASM_EXTRA_STACK 0
+# endif
+#endif
+
 #define BLAKE2B_BLOCKBYTES 128
 #define BLAKE2B_OUTBYTES 64
 #define BLAKE2B_KEYBYTES 64
@@ -38,6 +79,19 @@
 #define BLAKE2S_OUTBYTES 32
 #define BLAKE2S_KEYBYTES 32
 
+/* BLAKE2bp and BLAKE2sp split the message into stripes of one block
+ * per leaf; block N of every stripe goes to leaf N.  A stripe can be
+ * compressed only once enough data follows it for every leaf to still
+ * have input left for its final block, so up to HOLDBYTES are kept
+ * buffered. */
+#define BLAKE2BP_LEAVES 4
+#define BLAKE2BP_STRIPEBYTES (BLAKE2BP_LEAVES * BLAKE2B_BLOCKBYTES)
+#define BLAKE2BP_HOLDBYTES (2 * BLAKE2BP_STRIPEBYTES - BLAKE2B_BLOCKBYTES)
+
+#define BLAKE2SP_LEAVES 8
+#define BLAKE2SP_STRIPEBYTES (BLAKE2SP_LEAVES * BLAKE2S_BLOCKBYTES)
+#define BLAKE2SP_HOLDBYTES (2 * BLAKE2SP_STRIPEBYTES - BLAKE2S_BLOCKBYTES)
+
 typedef struct
 {
   u64 h[8];
@@ -67,8 +121,29 @@ typedef struct BLAKE2B_CONTEXT_S
   byte buf[BLAKE2B_BLOCKBYTES];
   size_t buflen;
   size_t outlen;
+#ifdef USE_AVX2
+  unsigned int use_avx2:1;
+#endif
+#ifdef USE_AARCH64_SIMD
+  unsigned int use_neon:1;
+#endif
 } BLAKE2B_CONTEXT;
 
+typedef struct BLAKE2BP_CONTEXT_S
+{
+  BLAKE2B_STATE leaf[BLAKE2BP_LEAVES];
+  byte buf[2 * BLAKE2BP_STRIPEBYTES];
+  size_t buflen;
+  size_t outlen;
+  size_t keylen;
+#ifdef USE_AVX2
+  unsigned int use_avx2:1;
+#endif
+#ifdef USE_AARCH64_SIMD
+  unsigned int use_neon:1;
+#endif
+} BLAKE2BP_CONTEXT;
+
 typedef struct
 {
   u32 h[8];
@@ -98,9 +173,33 @@ typedef struct BLAKE2S_CONTEXT_S
   byte buf[BLAKE2S_BLOCKBYTES];
   size_t buflen;
   size_t outlen;
+#ifdef USE_AVX
+  unsigned int use_avx:1;
+#endif
+#ifdef USE_AARCH64_SIMD
+  unsigned int use_neon:1;
+#endif
 } BLAKE2S_CONTEXT;
 
-typedef unsigned int (*blake2_transform_t)(void *S, const void *inblk,
+typedef struct BLAKE2SP_CONTEXT_S
+{
+  BLAKE2S_STATE leaf[BLAKE2SP_LEAVES];
+  byte buf[2 * BLAKE2SP_STRIPEBYTES];
+  size_t buflen;
+  size_t outlen;
+  size_t keylen;
+#ifdef USE_AVX
+  unsigned int use_avx:1;
+#endif
+#ifdef USE_AVX2
+  unsigned int use_avx2:1;
+#endif
+#ifdef USE_AARCH64_SIMD
+  unsigned int use_neon:1;
+#endif
+} BLAKE2SP_CONTEXT;
+
+typedef unsigned int (*blake2_transform_t)(void *ctx, const void *inblk,
 					   size_t nblks);
 
 
@@ -121,7 +220,35 @@ static const u32 blake2s_IV[8] =
 static byte zero_block[BLAKE2B_BLOCKBYTES] = { 0, };
 
 
-static void blake2_write(void *S, const void *inbuf, size_t inlen,
+#ifdef USE_AVX2
+unsigned int _gcry_blake2b_transform_amd64_avx2(BLAKE2B_STATE *S,
+						const void *inblks,
+						size_t nblks) ASM_FUNC_ABI;
+unsigned int _gcry_blake2b_transform_amd64_avx2_x4(BLAKE2B_STATE *S,
+						   const void *instripes,
+						   size_t nstripes) ASM_FUNC_ABI;
+unsigned int _gcry_blake2s_transform_amd64_avx2_x8(BLAKE2S_STATE *S,
+						   const void *instripes,
+						   size_t nstripes) ASM_FUNC_ABI;
+#endif
+
+#ifdef USE_AVX
+unsigned int _gcry_blake2s_transform_amd64_avx(BLAKE2S_STATE *S,
+					       const void *inblks,
+					       size_t nblks) ASM_FUNC_ABI;
+#endif
+
+#ifdef USE_AARCH64_SIMD
+unsigned int _gcry_blake2b_transform_aarch64(BLAKE2B_STATE *S,
+					     const void *inblks,
+					     size_t nblks);
+unsigned int _gcry_blake2s_transform_aarch64(BLAKE2S_STATE *S,
+					     const void *inblks,
+					     size_t nblks);
+#endif
+
+
+static void blake2_write(void *ctx, const void *inbuf, size_t inlen,
 			 byte *tmpbuf, size_t *tmpbuflen, size_t blkbytes,
 			 blake2_transform_t transform_fn)
 {
@@ -140,7 +267,7 @@ static void blake2_write(void *S, const void *inbuf, size_t inlen,
 	    buf_cpy (tmpbuf + left, in, fill); /* Fill buffer */
 	  left = 0;
 
-	  burn = transform_fn (S, tmpbuf, 1); /* Increment counter + Compress */
+	  burn = transform_fn (ctx, tmpbuf, 1); /* Increment counter + Compress */
 
 	  in += fill;
 	  inlen -= fill;
@@ -148,7 +275,7 @@ static void blake2_write(void *S, const void *inbuf, size_t inlen,
 	  nblks = inlen / blkbytes - !(inlen % blkbytes);
 	  if (nblks)
 	    {
-	      burn = transform_fn(S, in, nblks);
+	      burn = transform_fn(ctx, in, nblks);
 	      in += blkbytes * nblks;
 	      inlen -= blkbytes * nblks;
 	    }
@@ -166,6 +293,53 @@ static void blake2_write(void *S, const void *inbuf, size_t inlen,
   return;
 }
 
+/* Buffered write for the tree modes; TRANSFORM_FN compresses whole
+ * stripes. */
+static void blake2p_write(void *ctx, const void *inbuf, size_t inlen,
+			  byte *tmpbuf, size_t *tmpbuflen, size_t stripebytes,
+			  size_t holdbytes, blake2_transform_t transform_fn)
+{
+  const byte* in = inbuf;
+  unsigned int burn = 0;
+  size_t nstripes;
+  size_t fill;
+
+  /* Flush buffered stripes as long as enough data follows them. */
+  while (*tmpbuflen && *tmpbuflen + inlen > holdbytes)
+    {
+      if (*tmpbuflen < stripebytes)
+	{
+	  fill = stripebytes - *tmpbuflen;
+	  buf_cpy (tmpbuf + *tmpbuflen, in, fill);
+	  *tmpbuflen += fill;
+	  in += fill;
+	  inlen -= fill;
+	}
+
+      burn = transform_fn (ctx, tmpbuf, 1);
+
+      *tmpbuflen -= stripebytes;
+      memmove (tmpbuf, tmpbuf + stripebytes, *tmpbuflen);
+    }
+
+  if (!*tmpbuflen && inlen > holdbytes)
+    {
+      nstripes = (inlen - holdbytes - 1) / stripebytes + 1;
+      burn = transform_fn (ctx, in, nstripes);
+      in += stripebytes * nstripes;
+      inlen -= stripebytes * nstripes;
+    }
+
+  if (inlen > 0)
+    {
+      buf_cpy (tmpbuf + *tmpbuflen, in, inlen);
+      *tmpbuflen += inlen;
+    }
+
+  if (burn)
+    _gcry_burn_stack (burn);
+}
+
 
 static inline void blake2b_set_lastblock(BLAKE2B_STATE *S)
 {
@@ -188,8 +362,9 @@ static inline u64 rotr64(u64 x, u64 n)
   return ((x >> (n & 63)) | (x << ((64 - n) & 63)));
 }
 
-static unsigned int blake2b_transform(void *vS, const void *inblks,
-				      size_t nblks)
+static unsigned int blake2b_transform_generic(BLAKE2B_STATE *S,
+					      const void *inblks,
+					      size_t nblks)
 {
   static const byte blake2b_sigma[12][16] =
   {
@@ -206,7 +381,6 @@ static unsigned int blake2b_transform(void *vS, const void *inblks,
     {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
     { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
   };
-  BLAKE2B_STATE *S = vS;
   const byte* in = inblks;
   u64 m[16];
   u64 v[16];
@@ -306,6 +480,25 @@ static unsigned int blake2b_transform(void *vS, const void *inblks,
   return sizeof(void *) * 4 + sizeof(u64) * 16 * 2;
 }
 
+static unsigned int blake2b_transform(void *ctx, const void *inblks,
+				      size_t nblks)
+{
+  BLAKE2B_CONTEXT *c = ctx;
+
+#ifdef USE_AVX2
+  if (c->use_avx2)
+    return _gcry_blake2b_transform_amd64_avx2 (&c->state, inblks, nblks)
+	   + 4 * sizeof(void*) + ASM_EXTRA_STACK;
+#endif
+#ifdef USE_AARCH64_SIMD
+  if (c->use_neon)
+    return _gcry_blake2b_transform_aarch64 (&c->state, inblks, nblks)
+	   + 4 * sizeof(void*);
+#endif
+
+  return blake2b_transform_generic (&c->state, inblks, nblks);
+}
+
 static void blake2b_final(void *ctx)
 {
   BLAKE2B_CONTEXT *c = ctx;
@@ -321,7 +514,7 @@ static void blake2b_final(void *ctx)
     memset (c->buf + c->buflen, 0, BLAKE2B_BLOCKBYTES - c->buflen); /* Padding */
   blake2b_set_lastblock (S);
   blake2b_increment_counter (S, (int)c->buflen - BLAKE2B_BLOCKBYTES);
-  burn = blake2b_transform (S, c->buf, 1);
+  burn = blake2b_transform (c, c->buf, 1);
 
   /* Output full hash to buffer */
   for (i = 0; i < 8; ++i)
@@ -344,8 +537,7 @@ static byte *blake2b_read(void *ctx)
 static void blake2b_write(void *ctx, const void *inbuf, size_t inlen)
 {
   BLAKE2B_CONTEXT *c = ctx;
-  BLAKE2B_STATE *S = &c->state;
-  blake2_write(S, inbuf, inlen, c->buf, &c->buflen, BLAKE2B_BLOCKBYTES,
+  blake2_write(c, inbuf, inlen, c->buf, &c->buflen, BLAKE2B_BLOCKBYTES,
 	       blake2b_transform);
 }
 
@@ -397,11 +589,20 @@ static gcry_err_code_t blake2b_init_ctx(void *ctx, unsigned int flags,
 					unsigned int dbits)
 {
   BLAKE2B_CONTEXT *c = ctx;
+  unsigned int features = _gcry_get_hw_features ();
 
+  (void)features;
   (void)flags;
 
   memset (c, 0, sizeof (*c));
 
+#ifdef USE_AVX2
+  c->use_avx2 = !!(features & HWF_INTEL_AVX2);
+#endif
+#ifdef USE_AARCH64_SIMD
+  c->use_neon = !!(features & HWF_ARM_NEON);
+#endif
+
   c->outlen = dbits / 8;
   c->buflen = 0;
   return blake2b_init(c, key, keylen);
@@ -423,8 +624,9 @@ static inline void blake2s_increment_counter(BLAKE2S_STATE *S, const int inc)
   S->t[1] += (S->t[0] < (u32)inc) - (inc < 0);
 }
 
-static unsigned int blake2s_transform(void *vS, const void *inblks,
-				      size_t nblks)
+static unsigned int blake2s_transform_generic(BLAKE2S_STATE *S,
+					      const void *inblks,
+					      size_t nblks)
 {
   static const byte blake2s_sigma[10][16] =
   {
@@ -439,7 +641,6 @@ static unsigned int blake2s_transform(void *vS, const void *inblks,
     {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
     { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13 , 0 },
   };
-  BLAKE2S_STATE *S = vS;
   unsigned int burn = 0;
   const byte* in = inblks;
   u32 m[16];
@@ -538,6 +739,25 @@ static unsigned int blake2s_transform(void *vS, const void *inblks,
   return burn;
 }
 
+static unsigned int blake2s_transform(void *ctx, const void *inblks,
+				      size_t nblks)
+{
+  BLAKE2S_CONTEXT *c = ctx;
+
+#ifdef USE_AVX
+  if (c->use_avx)
+    return _gcry_blake2s_transform_amd64_avx (&c->state, inblks, nblks)
+	   + 4 * sizeof(void*) + ASM_EXTRA_STACK;
+#endif
+#ifdef USE_AARCH64_SIMD
+  if (c->use_neon)
+    return _gcry_blake2s_transform_aarch64 (&c->state, inblks, nblks)
+	   + 4 * sizeof(void*);
+#endif
+
+  return blake2s_transform_generic (&c->state, inblks, nblks);
+}
+
 static void blake2s_final(void *ctx)
 {
   BLAKE2S_CONTEXT *c = ctx;
@@ -553,7 +773,7 @@ static void blake2s_final(void *ctx)
     memset (c->buf + c->buflen, 0, BLAKE2S_BLOCKBYTES - c->buflen); /* Padding */
   blake2s_set_lastblock (S);
   blake2s_increment_counter (S, (int)c->buflen - BLAKE2S_BLOCKBYTES);
-  burn = blake2s_transform (S, c->buf, 1);
+  burn = blake2s_transform (c, c->buf, 1);
 
   /* Output full hash to buffer */
   for (i = 0; i < 8; ++i)
@@ -576,8 +796,7 @@ static byte *blake2s_read(void *ctx)
 static void blake2s_write(void *ctx, const void *inbuf, size_t inlen)
 {
   BLAKE2S_CONTEXT *c = ctx;
-  BLAKE2S_STATE *S = &c->state;
-  blake2_write(S, inbuf, inlen, c->buf, &c->buflen, BLAKE2S_BLOCKBYTES,
+  blake2_write(c, inbuf, inlen, c->buf, &c->buflen, BLAKE2S_BLOCKBYTES,
 	       blake2s_transform);
 }
 
@@ -629,16 +848,392 @@ static gcry_err_code_t blake2s_init_ctx(void *ctx, unsigned int flags,
 					unsigned int dbits)
 {
   BLAKE2S_CONTEXT *c = ctx;
+  unsigned int features = _gcry_get_hw_features ();
 
+  (void)features;
   (void)flags;
 
   memset (c, 0, sizeof (*c));
 
+#ifdef USE_AVX
+  c->use_avx = !!(features & HWF_INTEL_AVX);
+#endif
+#ifdef USE_AARCH64_SIMD
+  c->use_neon = !!(features & HWF_ARM_NEON);
+#endif
+
   c->outlen = dbits / 8;
   c->buflen = 0;
   return blake2s_init(c, key, keylen);
 }
 
+/* BLAKE2bp, four BLAKE2b leaves and a root node. */
+static unsigned int blake2bp_transform(void *ctx, const void *instripes,
+				       size_t nstripes)
+{
+  BLAKE2BP_CONTEXT *c = ctx;
+  const byte *in = instripes;
+  unsigned int burn = 0;
+  size_t i;
+
+#ifdef USE_AVX2
+  if (c->use_avx2)
+    return _gcry_blake2b_transform_amd64_avx2_x4 (c->leaf, in, nstripes)
+	   + 4 * sizeof(void*) + ASM_EXTRA_STACK;
+#endif
+
+  while (nstripes--)
+    {
+      for (i = 0; i < BLAKE2BP_LEAVES; i++)
+	{
+#ifdef USE_AARCH64_SIMD
+	  if (c->use_neon)
+	    burn = _gcry_blake2b_transform_aarch64 (&c->leaf[i],
+						    in + i * BLAKE2B_BLOCKBYTES,
+						    1)
+		   + 4 * sizeof(void*);
+	  else
+#endif
+	    burn = blake2b_transform_generic (&c->leaf[i],
+					      in + i * BLAKE2B_BLOCKBYTES, 1);
+	}
+      in += BLAKE2BP_STRIPEBYTES;
+    }
+
+  return burn;
+}
+
+static void blake2bp_init_node(BLAKE2B_CONTEXT *node, size_t outlen,
+			       size_t keylen, unsigned int node_offset,
+			       unsigned int node_depth)
+{
+  struct blake2b_param_s P[1] = { { 0, } };
+
+  memset (node, 0, sizeof (*node));
+
+  P->digest_length = outlen;
+  P->key_length = keylen;
+  P->fanout = BLAKE2BP_LEAVES;
+  P->depth = 2;
+  buf_put_le32 (P->node_offset, node_offset);
+  P->node_depth = node_depth;
+  P->inner_length = BLAKE2B_OUTBYTES;
+
+  blake2b_init_param (&node->state, P);
+  wipememory (P, sizeof(P));
+}
+
+static void blake2bp_final(void *ctx)
+{
+  BLAKE2BP_CONTEXT *c = ctx;
+  BLAKE2B_CONTEXT leaf;
+  BLAKE2B_CONTEXT root;
+  size_t i, pos;
+
+  gcry_assert (sizeof(c->buf) >= c->outlen);
+  if (blake2b_is_lastblock(&c->leaf[0]))
+    return;
+
+  blake2bp_init_node (&root, c->outlen, c->keylen, 0, 1);
+  root.outlen = c->outlen;
+#ifdef USE_AVX2
+  root.use_avx2 = c->use_avx2;
+#endif
+#ifdef USE_AARCH64_SIMD
+  root.use_neon = c->use_neon;
+#endif
+
+  for (i = 0; i < BLAKE2BP_LEAVES; i++)
+    {
+      memset (&leaf, 0, sizeof (leaf));
+      leaf.state = c->leaf[i];
+      leaf.outlen = BLAKE2B_OUTBYTES;
+#ifdef USE_AVX2
+      leaf.use_avx2 = c->use_avx2;
+#endif
+#ifdef USE_AARCH64_SIMD
+      leaf.use_neon = c->use_neon;
+#endif
+
+      /* Pass this leaf's share of the buffered data, the last block
+       * is kept back by blake2b_write. */
+      for (pos = i * BLAKE2B_BLOCKBYTES; pos < c->buflen;
+	   pos += BLAKE2BP_STRIPEBYTES)
+	blake2b_write (&leaf, c->buf + pos,
+		       c->buflen - pos < BLAKE2B_BLOCKBYTES
+			 ? c->buflen - pos : BLAKE2B_BLOCKBYTES);
+
+      if (i == BLAKE2BP_LEAVES - 1)
+	leaf.state.f[1] = U64_C(0xffffffffffffffff); /* Last node */
+      blake2b_final (&leaf);
+
+      blake2b_write (&root, leaf.buf, BLAKE2B_OUTBYTES);
+      c->leaf[i] = leaf.state;
+    }
+
+  root.state.f[1] = U64_C(0xffffffffffffffff); /* Last node */
+  blake2b_final (&root);
+
+  memcpy (c->buf, root.buf, c->outlen);
+  wipememory (c->buf + c->outlen, sizeof(c->buf) - c->outlen);
+  wipememory (&leaf, sizeof(leaf));
+  wipememory (&root, sizeof(root));
+}
+
+static byte *blake2bp_read(void *ctx)
+{
+  BLAKE2BP_CONTEXT *c = ctx;
+  return c->buf;
+}
+
+static void blake2bp_write(void *ctx, const void *inbuf, size_t inlen)
+{
+  BLAKE2BP_CONTEXT *c = ctx;
+  blake2p_write(c, inbuf, inlen, c->buf, &c->buflen, BLAKE2BP_STRIPEBYTES,
+		BLAKE2BP_HOLDBYTES, blake2bp_transform);
+}
+
+static gcry_err_code_t blake2bp_init_ctx(void *ctx, unsigned int flags,
+					 const byte *key, size_t keylen,
+					 unsigned int dbits)
+{
+  BLAKE2BP_CONTEXT *c = ctx;
+  BLAKE2B_CONTEXT node;
+  byte block[BLAKE2B_BLOCKBYTES];
+  unsigned int features = _gcry_get_hw_features ();
+  size_t i;
+
+  (void)features;
+  (void)flags;
+
+  memset (c, 0, sizeof (*c));
+
+#ifdef USE_AVX2
+  c->use_avx2 = !!(features & HWF_INTEL_AVX2);
+#endif
+#ifdef USE_AARCH64_SIMD
+  c->use_neon = !!(features & HWF_ARM_NEON);
+#endif
+
+  c->outlen = dbits / 8;
+  c->buflen = 0;
+
+  if (!c->outlen || c->outlen > BLAKE2B_OUTBYTES)
+    return GPG_ERR_INV_ARG;
+  if (keylen && (!key || keylen > BLAKE2B_KEYBYTES))
+    return GPG_ERR_INV_KEYLEN;
+
+  c->keylen = key ? keylen : 0;
+
+  for (i = 0; i < BLAKE2BP_LEAVES; i++)
+    {
+      blake2bp_init_node (&node, c->outlen, c->keylen, i, 0);
+      c->leaf[i] = node.state;
+    }
+  wipememory (&node, sizeof(node));
+
+  if (key)
+    {
+      /* Every leaf starts with the padded key block. */
+      memset (block, 0, sizeof(block));
+      memcpy (block, key, keylen);
+      for (i = 0; i < BLAKE2BP_LEAVES; i++)
+	blake2bp_write (c, block, BLAKE2B_BLOCKBYTES);
+      wipememory (block, sizeof(block));
+    }
+
+  return 0;
+}
+
+/* BLAKE2sp, eight BLAKE2s leaves and a root node. */
+static unsigned int blake2sp_transform(void *ctx, const void *instripes,
+				       size_t nstripes)
+{
+  BLAKE2SP_CONTEXT *c = ctx;
+  const byte *in = instripes;
+  unsigned int burn = 0;
+  size_t i;
+
+#ifdef USE_AVX2
+  if (c->use_avx2)
+    return _gcry_blake2s_transform_amd64_avx2_x8 (c->leaf, in, nstripes)
+	   + 4 * sizeof(void*) + ASM_EXTRA_STACK;
+#endif
+
+  while (nstripes--)
+    {
+      for (i = 0; i < BLAKE2SP_LEAVES; i++)
+	{
+#ifdef USE_AVX
+	  if (c->use_avx)
+	    burn = _gcry_blake2s_transform_amd64_avx (&c->leaf[i],
+						      in + i * BLAKE2S_BLOCKBYTES,
+						      1)
+		   + 4 * sizeof(void*) + ASM_EXTRA_STACK;
+	  else
+#endif
+#ifdef USE_AARCH64_SIMD
+	  if (c->use_neon)
+	    burn = _gcry_blake2s_transform_aarch64 (&c->leaf[i],
+						    in + i * BLAKE2S_BLOCKBYTES,
+						    1)
+		   + 4 * sizeof(void*);
+	  else
+#endif
+	    burn = blake2s_transform_generic (&c->leaf[i],
+					      in + i * BLAKE2S_BLOCKBYTES, 1);
+	}
+      in += BLAKE2SP_STRIPEBYTES;
+    }
+
+  return burn;
+}
+
+static void blake2sp_init_node(BLAKE2S_CONTEXT *node, size_t outlen,
+			       size_t keylen, unsigned int node_offset,
+			       unsigned int node_depth)
+{
+  struct blake2s_param_s P[1] = { { 0, } };
+
+  memset (node, 0, sizeof (*node));
+
+  P->digest_length = outlen;
+  P->key_length = keylen;
+  P->fanout = BLAKE2SP_LEAVES;
+  P->depth = 2;
+  buf_put_le32 (P->node_offset, node_offset);
+  P->node_depth = node_depth;
+  P->inner_length = BLAKE2S_OUTBYTES;
+
+  blake2s_init_param (&node->state, P);
+  wipememory (P, sizeof(P));
+}
+
+static void blake2sp_final(void *ctx)
+{
+  BLAKE2SP_CONTEXT *c = ctx;
+  BLAKE2S_CONTEXT leaf;
+  BLAKE2S_CONTEXT root;
+  size_t i, pos;
+
+  gcry_assert (sizeof(c->buf) >= c->outlen);
+  if (blake2s_is_lastblock(&c->leaf[0]))
+    return;
+
+  blake2sp_init_node (&root, c->outlen, c->keylen, 0, 1);
+  root.outlen = c->outlen;
+#ifdef USE_AVX
+  root.use_avx = c->use_avx;
+#endif
+#ifdef USE_AARCH64_SIMD
+  root.use_neon = c->use_neon;
+#endif
+
+  for (i = 0; i < BLAKE2SP_LEAVES; i++)
+    {
+      memset (&leaf, 0, sizeof (leaf));
+      leaf.state = c->leaf[i];
+      leaf.outlen = BLAKE2S_OUTBYTES;
+#ifdef USE_AVX
+      leaf.use_avx = c->use_avx;
+#endif
+#ifdef USE_AARCH64_SIMD
+      leaf.use_neon = c->use_neon;
+#endif
+
+      /* Pass this leaf's share of the buffered data, the last block
+       * is kept back by blake2s_write. */
+      for (pos = i * BLAKE2S_BLOCKBYTES; pos < c->buflen;
+	   pos += BLAKE2SP_STRIPEBYTES)
+	blake2s_write (&leaf, c->buf + pos,
+		       c->buflen - pos < BLAKE2S_BLOCKBYTES
+			 ? c->buflen - pos : BLAKE2S_BLOCKBYTES);
+
+      if (i == BLAKE2SP_LEAVES - 1)
+	leaf.state.f[1] = 0xFFFFFFFFUL; /* Last node */
+      blake2s_final (&leaf);
+
+      blake2s_write (&root, leaf.buf, BLAKE2S_OUTBYTES);
+      c->leaf[i] = leaf.state;
+    }
+
+  root.state.f[1] = 0xFFFFFFFFUL; /* Last node */
+  blake2s_final (&root);
+
+  memcpy (c->buf, root.buf, c->outlen);
+  wipememory (c->buf + c->outlen, sizeof(c->buf) - c->outlen);
+  wipememory (&leaf, sizeof(leaf));
+  wipememory (&root, sizeof(root));
+}
+
+static byte *blake2sp_read(void *ctx)
+{
+  BLAKE2SP_CONTEXT *c = ctx;
+  return c->buf;
+}
+
+static void blake2sp_write(void *ctx, const void *inbuf, size_t inlen)
+{
+  BLAKE2SP_CONTEXT *c = ctx;
+  blake2p_write(c, inbuf, inlen, c->buf, &c->buflen, BLAKE2SP_STRIPEBYTES,
+		BLAKE2SP_HOLDBYTES, blake2sp_transform);
+}
+
+static gcry_err_code_t blake2sp_init_ctx(void *ctx, unsigned int flags,
+					 const byte *key, size_t keylen,
+					 unsigned int dbits)
+{
+  BLAKE2SP_CONTEXT *c = ctx;
+  BLAKE2S_CONTEXT node;
+  byte block[BLAKE2S_BLOCKBYTES];
+  unsigned int features = _gcry_get_hw_features ();
+  size_t i;
+
+  (void)features;
+  (void)flags;
+
+  memset (c, 0, sizeof (*c));
+
+#ifdef USE_AVX
+  c->use_avx = !!(features & HWF_INTEL_AVX);
+#endif
+#ifdef USE_AVX2
+  c->use_avx2 = !!(features & HWF_INTEL_AVX2);
+#endif
+#ifdef USE_AARCH64_SIMD
+  c->use_neon = !!(features & HWF_ARM_NEON);
+#endif
+
+  c->outlen = dbits / 8;
+  c->buflen = 0;
+
+  if (!c->outlen || c->outlen > BLAKE2S_OUTBYTES)
+    return GPG_ERR_INV_ARG;
+  if (keylen && (!key || keylen > BLAKE2S_KEYBYTES))
+    return GPG_ERR_INV_KEYLEN;
+
+  c->keylen = key ? keylen : 0;
+
+  for (i = 0; i < BLAKE2SP_LEAVES; i++)
+    {
+      blake2sp_init_node (&node, c->outlen, c->keylen, i, 0);
+      c->leaf[i] = node.state;
+    }
+  wipememory (&node, sizeof(node));
+
+  if (key)
+    {
+      /* Every leaf starts with the padded key block. */
+      memset (block, 0, sizeof(block));
+      memcpy (block, key, keylen);
+      for (i = 0; i < BLAKE2SP_LEAVES; i++)
+	blake2sp_write (c, block, BLAKE2S_BLOCKBYTES);
+      wipememory (block, sizeof(block));
+    }
+
+  return 0;
+}
+
 /* Selftests from "RFC 7693, Appendix E. BLAKE2b and BLAKE2s Self-Test
  * Module C Source". */
 static void selftest_seq(byte *out, size_t len, u32 seed)
@@ -798,6 +1393,136 @@ failed:
   return GPG_ERR_SELFTEST_FAILED;
 }
 
+static gpg_err_code_t
+selftests_blake2bp (int algo, int extended, selftest_report_func_t report)
+{
+  static const byte blake2bp_res[32] =
+  {
+    0x30, 0x33, 0x2E, 0x31, 0xDC, 0x5A, 0xB7, 0x5F,
+    0x29, 0xA3, 0xE0, 0x7C, 0x0A, 0xFD, 0x27, 0x4F,
+    0xCF, 0xAE, 0x3A, 0x02, 0x40, 0x36, 0x6F, 0x32,
+    0x9F, 0xF4, 0x40, 0x06, 0xD8, 0x89, 0x19, 0xBB
+  };
+  static const size_t in_len[6] = { 0, 3, 512, 513, 1024, 2000 };
+  size_t i, j, inlen;
+  byte in[2000], key[64];
+  BLAKE2B_CONTEXT ctx;
+  BLAKE2BP_CONTEXT ctx2;
+  const char *what;
+  const char *errtxt;
+
+  (void)extended;
+
+  what = "BLAKE2bp selftest";
+
+  /* 256-bit BLAKE2b hash of the results */
+  if (blake2b_init_ctx(&ctx, 0, NULL, 0, 32 * 8))
+    {
+      errtxt = "init failed";
+      goto failed;
+    }
+
+  for (j = 0; j < 6; j++)
+    {
+      inlen = in_len[j];
+
+      selftest_seq(in, inlen, inlen); /* unkeyed hash */
+      blake2bp_init_ctx(&ctx2, 0, NULL, 0, 64 * 8);
+      blake2bp_write(&ctx2, in, inlen);
+      blake2bp_final(&ctx2);
+      blake2b_write(&ctx, ctx2.buf, 64); /* hash the hash */
+
+      selftest_seq(key, sizeof(key), sizeof(key)); /* keyed hash */
+      blake2bp_init_ctx(&ctx2, 0, key, sizeof(key), 64 * 8);
+      blake2bp_write(&ctx2, in, inlen);
+      blake2bp_final(&ctx2);
+      blake2b_write(&ctx, ctx2.buf, 64); /* hash the hash */
+    }
+
+  /* compute and compare the hash of hashes */
+  blake2b_final(&ctx);
+  for (i = 0; i < 32; i++)
+    {
+      if (ctx.buf[i] != blake2bp_res[i])
+	{
+	  errtxt = "digest mismatch";
+	  goto failed;
+	}
+    }
+
+  return 0;
+
+failed:
+  if (report)
+    report ("digest", algo, what, errtxt);
+  return GPG_ERR_SELFTEST_FAILED;
+}
+
+static gpg_err_code_t
+selftests_blake2sp (int algo, int extended, selftest_report_func_t report)
+{
+  static const byte blake2sp_res[32] =
+  {
+    0x55, 0x58, 0xAB, 0x9E, 0x68, 0x40, 0x6F, 0x5E,
+    0x5F, 0x0A, 0x7F, 0x5E, 0x0F, 0xBE, 0x85, 0xDB,
+    0xC8, 0x53, 0xD4, 0xD1, 0xE2, 0x85, 0x48, 0xC0,
+    0x28, 0xD3, 0xB7, 0xF4, 0x8B, 0xD0, 0x2D, 0x92
+  };
+  static const size_t in_len[6] = { 0, 3, 512, 513, 1024, 2000 };
+  size_t i, j, inlen;
+  byte in[2000], key[32];
+  BLAKE2S_CONTEXT ctx;
+  BLAKE2SP_CONTEXT ctx2;
+  const char *what;
+  const char *errtxt;
+
+  (void)extended;
+
+  what = "BLAKE2sp selftest";
+
+  /* 256-bit BLAKE2s hash of the results */
+  if (blake2s_init_ctx(&ctx, 0, NULL, 0, 32 * 8))
+    {
+      errtxt = "init failed";
+      goto failed;
+    }
+
+  for (j = 0; j < 6; j++)
+    {
+      inlen = in_len[j];
+
+      selftest_seq(in, inlen, inlen); /* unkeyed hash */
+      blake2sp_init_ctx(&ctx2, 0, NULL, 0, 32 * 8);
+      blake2sp_write(&ctx2, in, inlen);
+      blake2sp_final(&ctx2);
+      blake2s_write(&ctx, ctx2.buf, 32); /* hash the hash */
+
+      selftest_seq(key, sizeof(key), sizeof(key)); /* keyed hash */
+      blake2sp_init_ctx(&ctx2, 0, key, sizeof(key), 32 * 8);
+      blake2sp_write(&ctx2, in, inlen);
+      blake2sp_final(&ctx2);
+      blake2s_write(&ctx, ctx2.buf, 32); /* hash the hash */
+    }
+
+  /* compute and compare the hash of hashes */
+  blake2s_final(&ctx);
+  for (i = 0; i < 32; i++)
+    {
+      if (ctx.buf[i] != blake2sp_res[i])
+	{
+	  errtxt = "digest mismatch";
+	  goto failed;
+	}
+    }
+
+  return 0;
+
+failed:
+  if (report)
+    report ("digest", algo, what, errtxt);
+  return GPG_ERR_SELFTEST_FAILED;
+}
+
 
 gcry_err_code_t _gcry_blake2_init_with_key(void *ctx, unsigned int flags,
 					   const unsigned char *key,
@@ -830,6 +1555,12 @@ gcry_err_code_t _gcry_blake2_init_with_key(void *ctx, unsigned int flags,
     case GCRY_MD_BLAKE2S_128:
       rc = blake2s_init_ctx (ctx, flags, key, keylen, 128);
       break;
+    case GCRY_MD_BLAKE2BP_512:
+      rc = blake2bp_init_ctx (ctx, flags, key, keylen, 512);
+      break;
+    case GCRY_MD_BLAKE2SP_256:
+      rc = blake2sp_init_ctx (ctx, flags, key, keylen, 256);
+      break;
     default:
       rc = GPG_ERR_DIGEST_ALGO;
       break;
@@ -870,3 +1601,23 @@ DEFINE_BLAKE2_VARIANT(s, S, 256, "2.8")
 DEFINE_BLAKE2_VARIANT(s, S, 224, "2.7")
 DEFINE_BLAKE2_VARIANT(s, S, 160, "2.5")
 DEFINE_BLAKE2_VARIANT(s, S, 128, "2.4")
+
+#define DEFINE_BLAKE2P_VARIANT(bs, BS, dbits) \
+  static void blake2##bs##p_##dbits##_init(void *ctx, unsigned int flags) \
+  { \
+    int err = blake2##bs##p_init_ctx (ctx, flags, NULL, 0, dbits); \
+    gcry_assert (err == 0); \
+  } \
+  static byte blake2##bs##p_##dbits##_asn[] = { 0x30 }; \
+  gcry_md_spec_t _gcry_digest_spec_blake2##bs##p_##dbits = \
+    { \
+      GCRY_MD_BLAKE2##BS##P_##dbits, {0, 0}, \
+      "BLAKE2" #BS "P_" #dbits, blake2##bs##p_##dbits##_asn, \
+      DIM (blake2##bs##p_##dbits##_asn), NULL, \
+      dbits / 8, blake2##bs##p_##dbits##_init, blake2##bs##p_write, \
+      blake2##bs##p_final, blake2##bs##p_read, NULL, \
+      sizeof (BLAKE2##BS##P_CONTEXT), selftests_blake2##bs##p \
+    };
+
+DEFINE_BLAKE2P_VARIANT(b, B, 512)
+DEFINE_BLAKE2P_VARIANT(s, S, 256)
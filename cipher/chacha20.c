@@ -38,6 +38,8 @@
 #include "g10lib.h"
 #include "cipher.h"
 #include "bufhelp.h"
+#include "./cipher-internal.h"
+#include "./poly1305-internal.h"
 
 
 #define CHACHA20_MIN_KEY_SIZE 16        /* Bytes.  */
@@ -71,6 +73,15 @@
 # define USE_AVX2 1
 #endif
 
+/* USE_AVX512 indicates whether to compile with Intel AVX512 code. */
+#undef USE_AVX512
+#if defined(__x86_64__) && (defined(HAVE_COMPATIBLE_GCC_AMD64_PLATFORM_AS) || \
+    defined(HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS)) && \
+    defined(HAVE_GCC_INLINE_ASM_AVX512) && defined(ENABLE_AVX512_SUPPORT) && \
+    defined(USE_AVX2)
+# define USE_AVX512 1
+#endif
+
 /* USE_NEON indicates whether to enable ARM NEON assembly code. */
 #undef USE_NEON
 #ifdef ENABLE_NEON_SUPPORT
@@ -81,6 +92,17 @@
 # endif
 #endif /*ENABLE_NEON_SUPPORT*/
 
+/* USE_AARCH64_SIMD indicates whether to enable ARMv8 SIMD assembly
+ * code. */
+#undef USE_AARCH64_SIMD
+#ifdef ENABLE_NEON_SUPPORT
+# if defined(__AARCH64EL__) \
+     && defined(HAVE_COMPATIBLE_GCC_AARCH64_PLATFORM_AS) \
+     && defined(HAVE_GCC_INLINE_ASM_AARCH64_NEON)
+#  define USE_AARCH64_SIMD 1
+# endif
+#endif
+
 
 struct CHACHA20_context_s;
 
@@ -109,6 +131,9 @@ typedef struct CHACHA20_context_s
   u32 pad[CHACHA20_INPUT_LENGTH];
   chacha20_blocks_t blocks;
   unsigned int unused; /* bytes in the pad.  */
+#ifdef USE_AVX2
+  unsigned int use_avx2:1;
+#endif
 } CHACHA20_context_t;
 
 
@@ -134,8 +159,24 @@ unsigned int _gcry_chacha20_amd64_avx2_blocks(u32 *state, const byte *in,
                                               byte *out,
                                               size_t bytes) ASM_FUNC_ABI;
 
+unsigned int _gcry_chacha20_poly1305_amd64_avx2_blocks8(
+		u32 *state, byte *dst, const byte *src, size_t nblks,
+		void *poly1305_state, const byte *poly1305_src) ASM_FUNC_ABI;
+
+unsigned int _gcry_chacha20_poly1305_amd64_avx2_blocks4(
+		u32 *state, byte *dst, const byte *src, size_t nblks,
+		void *poly1305_state, const byte *poly1305_src) ASM_FUNC_ABI;
+
 #endif /* USE_AVX2 */
 
+#ifdef USE_AVX512
+
+unsigned int _gcry_chacha20_amd64_avx512_blocks16(u32 *state, byte *dst,
+                                                  const byte *src,
+                                                  size_t nblks) ASM_FUNC_ABI;
+
+#endif /* USE_AVX512 */
+
 #ifdef USE_NEON
 
 unsigned int _gcry_chacha20_armv7_neon_blocks(u32 *state, const byte *in,
@@ -144,6 +185,16 @@ unsigned int _gcry_chacha20_armv7_neon_blocks(u32 *state, const byte *in,
 
 #endif /* USE_NEON */
 
+#ifdef USE_AARCH64_SIMD
+
+unsigned int _gcry_chacha20_aarch64_blocks4(u32 *state, byte *dst,
+                                            const byte *src, size_t nblks);
+
+unsigned int _gcry_chacha20_aarch64_blocks8(u32 *state, byte *dst,
+                                            const byte *src, size_t nblks);
+
+#endif /* USE_AARCH64_SIMD */
+
 
 static void chacha20_setiv (void *context, const byte * iv, size_t ivlen);
 static const char *selftest (void);
@@ -284,6 +335,81 @@ chacha20_blocks (u32 *state, const byte *src, byte *dst, size_t bytes)
 }
 #endif /*!USE_SSE2*/
 
+
+#ifdef USE_AVX512
+/* Process sixteen blocks at a time with AVX512 and leave the rest,
+   and the key stream only requests from chacha20_core, to AVX2.  */
+ASM_FUNC_ABI static unsigned int
+chacha20_blocks_avx512 (u32 *state, const byte *src, byte *dst, size_t bytes)
+{
+  size_t nblks = bytes / CHACHA20_BLOCK_SIZE;
+  unsigned int nburn, burn = 0;
+
+  if (src && nblks >= 16)
+    {
+      size_t n = nblks & ~(size_t)15;
+
+      burn = _gcry_chacha20_amd64_avx512_blocks16 (state, dst, src, n);
+      n *= CHACHA20_BLOCK_SIZE;
+      bytes -= n;
+      dst += n;
+      src += n;
+    }
+
+  if (bytes)
+    {
+      nburn = _gcry_chacha20_amd64_avx2_blocks (state, src, dst, bytes);
+      burn = nburn > burn ? nburn : burn;
+    }
+
+  return burn;
+}
+#endif /*USE_AVX512*/
+
+
+#ifdef USE_AARCH64_SIMD
+/* Process eight and four blocks at a time with NEON and leave the
+   rest, and the key stream only requests, to the generic code.  */
+ASM_FUNC_ABI static unsigned int
+chacha20_blocks_aarch64 (u32 *state, const byte *src, byte *dst,
+                         size_t bytes)
+{
+  size_t nblks = bytes / CHACHA20_BLOCK_SIZE;
+  unsigned int nburn, burn = 0;
+  size_t n;
+
+  if (src && nblks >= 8)
+    {
+      n = nblks & ~(size_t)7;
+      burn = _gcry_chacha20_aarch64_blocks8 (state, dst, src, n);
+      nblks -= n;
+      n *= CHACHA20_BLOCK_SIZE;
+      bytes -= n;
+      dst += n;
+      src += n;
+    }
+
+  if (src && nblks >= 4)
+    {
+      n = nblks & ~(size_t)3;
+      nburn = _gcry_chacha20_aarch64_blocks4 (state, dst, src, n);
+      burn = nburn > burn ? nburn : burn;
+      n *= CHACHA20_BLOCK_SIZE;
+      bytes -= n;
+      dst += n;
+      src += n;
+    }
+
+  if (bytes)
+    {
+      nburn = chacha20_blocks (state, src, dst, bytes);
+      burn = nburn > burn ? nburn : burn;
+    }
+
+  return burn;
+}
+#endif /*USE_AARCH64_SIMD*/
+
 #undef QROUND
 #undef QOUT
 
@@ -399,13 +525,22 @@ chacha20_do_setkey (CHACHA20_context_t * ctx,
     ctx->blocks = _gcry_chacha20_amd64_ssse3_blocks;
 #endif
 #ifdef USE_AVX2
-  if (features & HWF_INTEL_AVX2)
+  ctx->use_avx2 = (features & HWF_INTEL_AVX2) != 0;
+  if (ctx->use_avx2)
     ctx->blocks = _gcry_chacha20_amd64_avx2_blocks;
 #endif
+#ifdef USE_AVX512
+  if ((features & HWF_INTEL_AVX512) && ctx->use_avx2)
+    ctx->blocks = chacha20_blocks_avx512;
+#endif
 #ifdef USE_NEON
   if (features & HWF_ARM_NEON)
     ctx->blocks = _gcry_chacha20_armv7_neon_blocks;
 #endif
+#ifdef USE_AARCH64_SIMD
+  if (features & HWF_ARM_NEON)
+    ctx->blocks = chacha20_blocks_aarch64;
+#endif
 
   (void)features;
 
@@ -511,6 +646,99 @@ chacha20_encrypt_stream (void *context, byte * outbuf, const byte * inbuf,
 }
 
 
+/* Bulk function for the Poly1305 AEAD mode.  Encrypts or decrypts
+   whole blocks at the current position of the key stream and absorbs
+   the ciphertext into the Poly1305 state of handle C in the same loop.
+   Returns the number of bytes processed; the rest is left to the
+   generic code.  */
+size_t
+_gcry_chacha20_poly1305_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
+                               const void *inbuf_arg, size_t length,
+                               int encrypt)
+{
+#ifdef USE_AVX2
+  CHACHA20_context_t *ctx = (void *) &c->context.c;
+  byte *outbuf = outbuf_arg;
+  const byte *inbuf = inbuf_arg;
+  const byte *authptr;
+  void *poly_state;
+  size_t nblocks, step, n;
+  unsigned int nburn, burn = 0;
+
+  nblocks = length / CHACHA20_BLOCK_SIZE;
+  if (!ctx->use_avx2 || ctx->unused || nblocks < 4)
+    return 0;
+
+  poly_state = _gcry_poly1305_stitched_state (&c->u_mode.poly1305.ctx);
+  if (!poly_state)
+    return 0;
+
+  if (encrypt)
+    {
+      /* The stitched code authenticates ciphertext from the previous
+         step, so encrypt the first step on its own.  */
+      step = nblocks >= 16 ? 8 : 4;
+      n = step * CHACHA20_BLOCK_SIZE;
+      burn = ctx->blocks (ctx->input, inbuf, outbuf, n) + ASM_EXTRA_STACK;
+      authptr = outbuf;
+      outbuf += n;
+      inbuf += n;
+      nblocks -= step;
+    }
+  else
+    {
+      step = 8;
+      authptr = inbuf;
+    }
+
+  if (step == 8 && nblocks >= 8)
+    {
+      n = nblocks & ~(size_t)7;
+      nburn = _gcry_chacha20_poly1305_amd64_avx2_blocks8 (
+		  ctx->input, outbuf, inbuf, n, poly_state, authptr)
+              + ASM_EXTRA_STACK;
+      burn = nburn > burn ? nburn : burn;
+      n *= CHACHA20_BLOCK_SIZE;
+      outbuf += n;
+      inbuf += n;
+      authptr += n;
+      nblocks &= 7;
+    }
+
+  if (nblocks >= 4)
+    {
+      n = nblocks & ~(size_t)3;
+      nburn = _gcry_chacha20_poly1305_amd64_avx2_blocks4 (
+		  ctx->input, outbuf, inbuf, n, poly_state, authptr)
+              + ASM_EXTRA_STACK;
+      burn = nburn > burn ? nburn : burn;
+      n *= CHACHA20_BLOCK_SIZE;
+      outbuf += n;
+      inbuf += n;
+      authptr += n;
+      nblocks &= 3;
+    }
+
+  /* Authenticate the ciphertext of the last step.  */
+  if (encrypt)
+    _gcry_poly1305_update (&c->u_mode.poly1305.ctx, authptr,
+                           outbuf - authptr);
+
+  if (burn)
+    _gcry_burn_stack (burn + 4 * sizeof(void *));
+
+  return outbuf - (byte *)outbuf_arg;
+#else
+  (void)c;
+  (void)outbuf_arg;
+  (void)inbuf_arg;
+  (void)length;
+  (void)encrypt;
+  return 0;
+#endif
+}
+
+
 static const char *
 selftest (void)
 {
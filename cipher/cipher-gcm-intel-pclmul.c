@@ -242,6 +242,220 @@ static inline void gfmul_pclmul_aggr4(void)
                 "pxor %%xmm3, %%xmm1\n\t" /* the result is in xmm1 */
                 :::"cc");
 }
+
+/* Karatsuba multiplication of data blocks A and B with their H powers
+   from the descending part of the table, accumulated to <xmm6:xmm4:xmm3>.
+   ACC is 'movdqa' for the first pair and 'pxor' for the rest. */
+#define GFMUL_AGGR8_ASM_2BLK(a, b, acc, xor_hash) \
+                "movdqu " #a "*16(%[buf]), %%xmm2\n\t" \
+                "movdqu " #b "*16(%[buf]), %%xmm10\n\t" \
+                "movdqu (8+" #a ")*16(%[h_table]), %%xmm5\n\t" \
+                "movdqu (8+" #b ")*16(%[h_table]), %%xmm11\n\t" \
+                "pshufb %[be_mask], %%xmm2\n\t" /* be => le */ \
+                "pshufb %[be_mask], %%xmm10\n\t" /* be => le */ \
+                xor_hash \
+                "pshufd $78, %%xmm5, %%xmm8\n\t" \
+                "pshufd $78, %%xmm11, %%xmm13\n\t" \
+                "pshufd $78, %%xmm2, %%xmm7\n\t" \
+                "pshufd $78, %%xmm10, %%xmm12\n\t" \
+                "pxor %%xmm5, %%xmm8\n\t" /* xmm8 holds a:a0+a1 */ \
+                "pxor %%xmm11, %%xmm13\n\t" /* xmm13 holds b:a0+a1 */ \
+                "pxor %%xmm2, %%xmm7\n\t" /* xmm7 holds a:b0+b1 */ \
+                "pxor %%xmm10, %%xmm12\n\t" /* xmm12 holds b:b0+b1 */ \
+                "movdqa %%xmm2, %%xmm9\n\t" \
+                "movdqa %%xmm10, %%xmm14\n\t" \
+                "pclmulqdq $0, %%xmm5, %%xmm9\n\t" /* xmm9 holds a:a0*b0 */ \
+                "pclmulqdq $0, %%xmm11, %%xmm14\n\t" /* xmm14 holds b:a0*b0 */ \
+                "pclmulqdq $17, %%xmm5, %%xmm2\n\t" /* xmm2 holds a:a1*b1 */ \
+                "pclmulqdq $17, %%xmm11, %%xmm10\n\t" /* xmm10 holds b:a1*b1 */ \
+                "pclmulqdq $0, %%xmm8, %%xmm7\n\t" /* xmm7 holds a:(a0+a1)*(b0+b1) */ \
+                "pclmulqdq $0, %%xmm13, %%xmm12\n\t" /* xmm12 holds b:(a0+a1)*(b0+b1) */ \
+                "pxor %%xmm14, %%xmm9\n\t" \
+                "pxor %%xmm10, %%xmm2\n\t" \
+                "pxor %%xmm12, %%xmm7\n\t" \
+                acc " %%xmm9, %%xmm3\n\t" \
+                acc " %%xmm2, %%xmm6\n\t" \
+                acc " %%xmm7, %%xmm4\n\t"
+
+static inline void gfmul_pclmul_aggr8(const void *buf, const void *h_table,
+                                      const void *be_mask)
+{
+  /* Input:
+      Y_(i-8): XMM1
+      X_(i-7)...X_i: BUF (big-endian)
+      H⁸...H¹: H_TABLE[8...15]
+     Output:
+      Y_i: XMM1
+     Input XMM0 stays unmodified.
+   */
+  asm volatile (/* perform clmul and merge results... */
+                GFMUL_AGGR8_ASM_2BLK(0, 1, "movdqa",
+                                     "pxor %%xmm1, %%xmm2\n\t")
+                GFMUL_AGGR8_ASM_2BLK(2, 3, "pxor", "")
+                GFMUL_AGGR8_ASM_2BLK(4, 5, "pxor", "")
+                GFMUL_AGGR8_ASM_2BLK(6, 7, "pxor", "")
+
+                /* aggregated reduction... */
+                "movdqa %%xmm3, %%xmm5\n\t"
+                "pxor %%xmm6, %%xmm5\n\t" /* xmm5 holds a0*b0+a1*b1 */
+                "pxor %%xmm5, %%xmm4\n\t" /* xmm4 holds a0*b0+a1*b1+(a0+a1)*(b0+b1) */
+                "movdqa %%xmm4, %%xmm5\n\t"
+                "psrldq $8, %%xmm4\n\t"
+                "pslldq $8, %%xmm5\n\t"
+                "pxor %%xmm5, %%xmm3\n\t"
+                "pxor %%xmm4, %%xmm6\n\t" /* <xmm6:xmm3> holds the result of the
+                                             aggregated carry-less
+                                             multiplication */
+
+                /* shift the result by one bit position to the left cope for
+                   the fact that bits are reversed */
+                "movdqa %%xmm3, %%xmm4\n\t"
+                "movdqa %%xmm6, %%xmm5\n\t"
+                "pslld $1, %%xmm3\n\t"
+                "pslld $1, %%xmm6\n\t"
+                "psrld $31, %%xmm4\n\t"
+                "psrld $31, %%xmm5\n\t"
+                "movdqa %%xmm4, %%xmm1\n\t"
+                "pslldq $4, %%xmm5\n\t"
+                "pslldq $4, %%xmm4\n\t"
+                "psrldq $12, %%xmm1\n\t"
+                "por %%xmm4, %%xmm3\n\t"
+                "por %%xmm5, %%xmm6\n\t"
+                "por %%xmm6, %%xmm1\n\t"
+
+                /* first phase of the reduction */
+                "movdqa %%xmm3, %%xmm6\n\t"
+                "movdqa %%xmm3, %%xmm7\n\t"
+                "pslld $31, %%xmm6\n\t"  /* packed right shifting << 31 */
+                "movdqa %%xmm3, %%xmm5\n\t"
+                "pslld $30, %%xmm7\n\t"  /* packed right shifting shift << 30 */
+                "pslld $25, %%xmm5\n\t"  /* packed right shifting shift << 25 */
+                "pxor %%xmm7, %%xmm6\n\t" /* xor the shifted versions */
+                "pxor %%xmm5, %%xmm6\n\t"
+                "movdqa %%xmm6, %%xmm7\n\t"
+                "pslldq $12, %%xmm6\n\t"
+                "psrldq $4, %%xmm7\n\t"
+                "pxor %%xmm6, %%xmm3\n\t" /* first phase of the reduction
+                                             complete */
+
+                /* second phase of the reduction */
+                "movdqa %%xmm3, %%xmm2\n\t"
+                "movdqa %%xmm3, %%xmm4\n\t"
+                "psrld $1, %%xmm2\n\t"    /* packed left shifting >> 1 */
+                "movdqa %%xmm3, %%xmm5\n\t"
+                "psrld $2, %%xmm4\n\t"    /* packed left shifting >> 2 */
+                "psrld $7, %%xmm5\n\t"    /* packed left shifting >> 7 */
+                "pxor %%xmm4, %%xmm2\n\t" /* xor the shifted versions */
+                "pxor %%xmm5, %%xmm2\n\t"
+                "pxor %%xmm7, %%xmm2\n\t"
+                "pxor %%xmm2, %%xmm3\n\t"
+                "pxor %%xmm3, %%xmm1\n\t" /* the result is in xmm1 */
+                :
+                : [buf] "r" (buf), [h_table] "r" (h_table),
+                  [be_mask] "m" (*(const byte *)be_mask)
+                : "cc");
+}
+
+#ifdef GCM_USE_INTEL_VPCLMUL_AVX512
+static inline void gfmul_vpclmul_avx512_aggr8_load_h(const void *h_table,
+                                                     const void *be_mask)
+{
+  /* Load H⁸...H¹ to ZMM22:ZMM23 and byte-swap mask to ZMM24. Clear upper
+     part of XMM1 so that hash can be xored to ZMM16. */
+  asm volatile ("vmovdqu64 8*16(%[h_table]), %%zmm22\n\t"
+                "vmovdqu64 12*16(%[h_table]), %%zmm23\n\t"
+                "vbroadcasti32x4 %[be_mask], %%zmm24\n\t"
+                "vmovdqa %%xmm1, %%xmm1\n\t"
+                :
+                : [h_table] "r" (h_table),
+                  [be_mask] "m" (*(const byte *)be_mask)
+                : "cc");
+}
+
+static inline void gfmul_vpclmul_avx512_aggr8(const void *buf)
+{
+  /* Input:
+      Y_(i-8): XMM1 (upper part of ZMM1 cleared)
+      X_(i-7)...X_i: BUF (big-endian)
+      H⁸...H¹: ZMM22:ZMM23
+      be_mask: ZMM24
+     Output:
+      Y_i: XMM1 (upper part of ZMM1 cleared)
+     Input XMM0 stays unmodified.
+   */
+  asm volatile ("vmovdqu64 0*16(%[buf]), %%zmm16\n\t"
+                "vmovdqu64 4*16(%[buf]), %%zmm17\n\t"
+                "vpshufb %%zmm24, %%zmm16, %%zmm16\n\t" /* be => le */
+                "vpshufb %%zmm24, %%zmm17, %%zmm17\n\t" /* be => le */
+                "vpxorq %%zmm1, %%zmm16, %%zmm16\n\t"
+
+                /* four block-wise products per ZMM register... */
+                "vpclmulqdq $0x00, %%zmm22, %%zmm16, %%zmm18\n\t" /* a0*b0 */
+                "vpclmulqdq $0x00, %%zmm23, %%zmm17, %%zmm19\n\t"
+                "vpclmulqdq $0x11, %%zmm22, %%zmm16, %%zmm20\n\t" /* a1*b1 */
+                "vpclmulqdq $0x11, %%zmm23, %%zmm17, %%zmm21\n\t"
+                "vpclmulqdq $0x01, %%zmm22, %%zmm16, %%zmm25\n\t" /* a1*b0 */
+                "vpclmulqdq $0x01, %%zmm23, %%zmm17, %%zmm26\n\t"
+                "vpclmulqdq $0x10, %%zmm22, %%zmm16, %%zmm27\n\t" /* a0*b1 */
+                "vpclmulqdq $0x10, %%zmm23, %%zmm17, %%zmm28\n\t"
+                "vpxorq %%zmm19, %%zmm18, %%zmm18\n\t"
+                "vpxorq %%zmm21, %%zmm20, %%zmm20\n\t"
+                "vpternlogq $0x96, %%zmm26, %%zmm25, %%zmm27\n\t"
+                "vpxorq %%zmm28, %%zmm27, %%zmm27\n\t"
+
+                /* merge middle products to low and high parts... */
+                "vpslldq $8, %%zmm27, %%zmm25\n\t"
+                "vpsrldq $8, %%zmm27, %%zmm27\n\t"
+                "vpxorq %%zmm25, %%zmm18, %%zmm18\n\t"
+                "vpxorq %%zmm27, %%zmm20, %%zmm20\n\t"
+
+                /* ... and sum 128-bit lanes together */
+                "vextracti64x4 $1, %%zmm18, %%ymm25\n\t"
+                "vextracti64x4 $1, %%zmm20, %%ymm27\n\t"
+                "vpxorq %%ymm25, %%ymm18, %%ymm18\n\t"
+                "vpxorq %%ymm27, %%ymm20, %%ymm20\n\t"
+                "vextracti32x4 $1, %%ymm18, %%xmm25\n\t"
+                "vextracti32x4 $1, %%ymm20, %%xmm27\n\t"
+                "vpxorq %%xmm25, %%xmm18, %%xmm3\n\t"
+                "vpxorq %%xmm27, %%xmm20, %%xmm6\n\t" /* <xmm6:xmm3> holds the
+                                                         result of the
+                                                         aggregated carry-less
+                                                         multiplication */
+
+                /* shift the result by one bit position to the left cope for
+                   the fact that bits are reversed */
+                "vpsrld $31, %%xmm3, %%xmm4\n\t"
+                "vpsrld $31, %%xmm6, %%xmm5\n\t"
+                "vpslld $1, %%xmm3, %%xmm3\n\t"
+                "vpslld $1, %%xmm6, %%xmm6\n\t"
+                "vpsrldq $12, %%xmm4, %%xmm1\n\t"
+                "vpslldq $4, %%xmm5, %%xmm5\n\t"
+                "vpslldq $4, %%xmm4, %%xmm4\n\t"
+                "vpor %%xmm4, %%xmm3, %%xmm3\n\t"
+                "vpor %%xmm5, %%xmm6, %%xmm6\n\t"
+                "vpor %%xmm6, %%xmm1, %%xmm1\n\t"
+
+                /* first phase of the reduction */
+                "vpslld $31, %%xmm3, %%xmm6\n\t"
+                "vpslld $30, %%xmm3, %%xmm7\n\t"
+                "vpslld $25, %%xmm3, %%xmm5\n\t"
+                "vpternlogq $0x96, %%xmm5, %%xmm7, %%xmm6\n\t"
+                "vpsrldq $4, %%xmm6, %%xmm7\n\t"
+                "vpslldq $12, %%xmm6, %%xmm6\n\t"
+                "vpxor %%xmm6, %%xmm3, %%xmm3\n\t"
+
+                /* second phase of the reduction */
+                "vpsrld $1, %%xmm3, %%xmm2\n\t"
+                "vpsrld $2, %%xmm3, %%xmm4\n\t"
+                "vpsrld $7, %%xmm3, %%xmm5\n\t"
+                "vpternlogq $0x96, %%xmm5, %%xmm4, %%xmm2\n\t"
+                "vpternlogq $0x96, %%xmm7, %%xmm3, %%xmm2\n\t"
+                "vpxor %%xmm2, %%xmm1, %%xmm1\n\t" /* the result is in xmm1 */
+                :
+                : [buf] "r" (buf)
+                : "cc");
+}
+#endif /* GCM_USE_INTEL_VPCLMUL_AVX512 */
 #endif
 
 
@@ -249,6 +463,9 @@ void
 _gcry_ghash_setup_intel_pclmul (gcry_cipher_hd_t c)
 {
   u64 tmp[2];
+#ifdef __x86_64__
+  int i;
+#endif
 #if defined(__x86_64__) && defined(__WIN64__)
   char win64tmp[3 * 16];
 
@@ -292,10 +509,54 @@ _gcry_ghash_setup_intel_pclmul (gcry_cipher_hd_t c)
   gfmul_pclmul (); /* H²•H² => H⁴ */
 
   asm volatile ("movdqu %%xmm1, 2*16(%[h_234])\n\t"
+                "movdqu %[h_1], %%xmm0\n\t"
+                "movdqa %%xmm1, %%xmm8\n\t"
                 :
-                : [h_234] "r" (c->u_mode.gcm.gcm_table)
+                : [h_234] "r" (c->u_mode.gcm.gcm_table),
+                  [h_1] "m" (*tmp)
                 : "memory");
 
+  gfmul_pclmul (); /* H•H⁴ => H⁵ */
+
+  asm volatile ("movdqu %%xmm1, 3*16(%[h_table])\n\t"
+                "movdqu 0*16(%[h_table]), %%xmm0\n\t"
+                "movdqa %%xmm8, %%xmm1\n\t"
+                :
+                : [h_table] "r" (c->u_mode.gcm.gcm_table)
+                : "memory");
+
+  gfmul_pclmul (); /* H²•H⁴ => H⁶ */
+
+  asm volatile ("movdqu %%xmm1, 4*16(%[h_table])\n\t"
+                "movdqu 1*16(%[h_table]), %%xmm0\n\t"
+                "movdqa %%xmm8, %%xmm1\n\t"
+                :
+                : [h_table] "r" (c->u_mode.gcm.gcm_table)
+                : "memory");
+
+  gfmul_pclmul (); /* H³•H⁴ => H⁷ */
+
+  asm volatile ("movdqu %%xmm1, 5*16(%[h_table])\n\t"
+                "movdqa %%xmm8, %%xmm0\n\t"
+                "movdqa %%xmm8, %%xmm1\n\t"
+                :
+                : [h_table] "r" (c->u_mode.gcm.gcm_table)
+                : "memory");
+
+  gfmul_pclmul (); /* H⁴•H⁴ => H⁸ */
+
+  asm volatile ("movdqu %%xmm1, 6*16(%[h_table])\n\t"
+                :
+                : [h_table] "r" (c->u_mode.gcm.gcm_table)
+                : "memory");
+
+  /* Second half of the table holds H⁸...H¹ in descending order for the
+     8-block aggregated GHASH. */
+  for (i = 0; i < 7; i++)
+    buf_cpy ((byte *)c->u_mode.gcm.gcm_table + (8 + i) * 16,
+             (byte *)c->u_mode.gcm.gcm_table + (6 - i) * 16, 16);
+  buf_cpy ((byte *)c->u_mode.gcm.gcm_table + 15 * 16, tmp, 16);
+
 #ifdef __WIN64__
   /* Clear/restore used registers. */
   asm volatile( "pxor %%xmm0, %%xmm0\n\t"
@@ -369,6 +630,64 @@ _gcry_ghash_intel_pclmul (gcry_cipher_hd_t c, byte *result, const byte *buf,
                   [hsub] "m" (*c->u_mode.gcm.u_ghash_key.key));
 
 #ifdef __x86_64__
+#ifdef GCM_USE_INTEL_VPCLMUL_AVX512
+  if (nblocks >= 8
+      && (c->u_mode.gcm.hw_impl_flags & GCM_INTEL_USE_VPCLMUL_AVX512))
+    {
+      gfmul_vpclmul_avx512_aggr8_load_h (c->u_mode.gcm.gcm_table, be_mask);
+
+      do
+        {
+          gfmul_vpclmul_avx512_aggr8 (buf);
+
+          buf += 8 * blocksize;
+          nblocks -= 8;
+        }
+      while (nblocks >= 8);
+
+      /* Clear used AVX512 registers. */
+      asm volatile ("vpxord %%xmm16, %%xmm16, %%xmm16\n\t"
+                    "vpxord %%xmm17, %%xmm17, %%xmm17\n\t"
+                    "vpxord %%xmm18, %%xmm18, %%xmm18\n\t"
+                    "vpxord %%xmm19, %%xmm19, %%xmm19\n\t"
+                    "vpxord %%xmm20, %%xmm20, %%xmm20\n\t"
+                    "vpxord %%xmm21, %%xmm21, %%xmm21\n\t"
+                    "vpxord %%xmm22, %%xmm22, %%xmm22\n\t"
+                    "vpxord %%xmm23, %%xmm23, %%xmm23\n\t"
+                    "vpxord %%xmm24, %%xmm24, %%xmm24\n\t"
+                    "vpxord %%xmm25, %%xmm25, %%xmm25\n\t"
+                    "vpxord %%xmm26, %%xmm26, %%xmm26\n\t"
+                    "vpxord %%xmm27, %%xmm27, %%xmm27\n\t"
+                    "vpxord %%xmm28, %%xmm28, %%xmm28\n\t"
+                    "vzeroupper\n\t"
+                    ::: "cc" );
+    }
+#endif
+
+  if (nblocks >= 8)
+    {
+      do
+        {
+          gfmul_pclmul_aggr8 (buf, c->u_mode.gcm.gcm_table, be_mask);
+
+          buf += 8 * blocksize;
+          nblocks -= 8;
+        }
+      while (nblocks >= 8);
+
+#ifndef __WIN64__
+      /* Clear used x86-64/XMM registers. */
+      asm volatile( "pxor %%xmm8, %%xmm8\n\t"
+                    "pxor %%xmm9, %%xmm9\n\t"
+                    "pxor %%xmm10, %%xmm10\n\t"
+                    "pxor %%xmm11, %%xmm11\n\t"
+                    "pxor %%xmm12, %%xmm12\n\t"
+                    "pxor %%xmm13, %%xmm13\n\t"
+                    "pxor %%xmm14, %%xmm14\n\t"
+                    ::: "cc" );
+#endif
+    }
+
   if (nblocks >= 4)
     {
       do
@@ -407,12 +407,19 @@ setupM (gcry_cipher_hd_t c)
   unsigned int features = _gcry_get_hw_features ();
 #endif
 
+  c->u_mode.gcm.hw_impl_flags = 0;
+
   if (0)
     ;
 #ifdef GCM_USE_INTEL_PCLMUL
   else if (features & HWF_INTEL_PCLMUL)
     {
       c->u_mode.gcm.ghash_fn = _gcry_ghash_intel_pclmul;
+      c->u_mode.gcm.hw_impl_flags = GCM_INTEL_USE_PCLMUL;
+#ifdef GCM_USE_INTEL_VPCLMUL_AVX512
+      if ((features & HWF_INTEL_AVX512) && (features & HWF_INTEL_VAES_VPCLMUL))
+        c->u_mode.gcm.hw_impl_flags |= GCM_INTEL_USE_VPCLMUL_AVX512;
+#endif
       _gcry_ghash_setup_intel_pclmul (c);
     }
 #endif
@@ -420,6 +427,7 @@ setupM (gcry_cipher_hd_t c)
   else if (features & HWF_ARM_PMULL)
     {
       c->u_mode.gcm.ghash_fn = ghash_armv8_ce_pmull;
+      c->u_mode.gcm.hw_impl_flags = GCM_ARM_USE_PMULL;
       ghash_setup_armv8_ce_pmull (c);
     }
 #endif
@@ -627,6 +635,30 @@ gcm_ctr_encrypt (gcry_cipher_hd_t c, byte *outbuf, size_t outbuflen,
 }
 
 
+/* Encrypt or decrypt full blocks with the bulk function of the cipher
+   which does the CTR encryption and the GHASH of the ciphertext in a
+   single pass.  Returns the number of bytes processed, which may be
+   zero if the bulk function is not available or can't be used at the
+   current position in the stream.  */
+static size_t
+gcm_crypt_bulk (gcry_cipher_hd_t c, byte *outbuf, const byte *inbuf,
+                size_t inbuflen, int encrypt)
+{
+  size_t nblocks;
+
+  if (!c->bulk.gcm_crypt || c->unused || c->u_mode.gcm.mac_unused)
+    return 0;
+
+  nblocks = inbuflen / GCRY_GCM_BLOCK_LEN;
+  if (!nblocks)
+    return 0;
+
+  nblocks -= c->bulk.gcm_crypt (c, outbuf, inbuf, nblocks, encrypt);
+
+  return nblocks * GCRY_GCM_BLOCK_LEN;
+}
+
+
 gcry_err_code_t
 _gcry_cipher_gcm_encrypt (gcry_cipher_hd_t c,
                           byte *outbuf, size_t outbuflen,
@@ -634,6 +666,7 @@ _gcry_cipher_gcm_encrypt (gcry_cipher_hd_t c,
 {
   static const unsigned char zerobuf[MAX_BLOCKSIZE];
   gcry_err_code_t err;
+  size_t n;
 
   if (c->spec->blocksize != GCRY_GCM_BLOCK_LEN)
     return GPG_ERR_CIPHER_ALGO;
@@ -666,6 +699,12 @@ _gcry_cipher_gcm_encrypt (gcry_cipher_hd_t c,
       return GPG_ERR_INV_LENGTH;
     }
 
+  n = gcm_crypt_bulk (c, outbuf, inbuf, inbuflen, 1);
+  inbuf += n;
+  inbuflen -= n;
+  outbuf += n;
+  outbuflen -= n;
+
   err = gcm_ctr_encrypt(c, outbuf, outbuflen, inbuf, inbuflen);
   if (err != 0)
     return err;
@@ -682,6 +721,7 @@ _gcry_cipher_gcm_decrypt (gcry_cipher_hd_t c,
                           const byte *inbuf, size_t inbuflen)
 {
   static const unsigned char zerobuf[MAX_BLOCKSIZE];
+  size_t n;
 
   if (c->spec->blocksize != GCRY_GCM_BLOCK_LEN)
     return GPG_ERR_CIPHER_ALGO;
@@ -711,6 +751,12 @@ _gcry_cipher_gcm_decrypt (gcry_cipher_hd_t c,
       return GPG_ERR_INV_LENGTH;
     }
 
+  n = gcm_crypt_bulk (c, outbuf, inbuf, inbuflen, 0);
+  inbuf += n;
+  inbuflen -= n;
+  outbuf += n;
+  outbuflen -= n;
+
   do_ghash_buf(c, c->u_mode.gcm.u_tag.tag, inbuf, inbuflen, 0);
 
   return gcm_ctr_encrypt(c, outbuf, outbuflen, inbuf, inbuflen);
@@ -72,6 +72,16 @@
 # endif
 #endif /* GCM_USE_INTEL_PCLMUL */
 
+/* GCM_USE_INTEL_VPCLMUL_AVX512 indicates whether to compile GCM with Intel
+   VPCLMUL/AVX512 code.  */
+#undef GCM_USE_INTEL_VPCLMUL_AVX512
+#if defined(__x86_64__) && defined(GCM_USE_INTEL_PCLMUL) && \
+    defined(ENABLE_AVX512_SUPPORT) && \
+    defined(HAVE_GCC_INLINE_ASM_AVX512) && \
+    defined(HAVE_GCC_INLINE_ASM_VAES_VPCLMUL)
+# define GCM_USE_INTEL_VPCLMUL_AVX512 1
+#endif /* GCM_USE_INTEL_VPCLMUL_AVX512 */
+
 /* GCM_USE_ARM_PMULL indicates whether to compile GCM with ARMv8 PMULL code. */
 #undef GCM_USE_ARM_PMULL
 #if defined(ENABLE_ARM_CRYPTO_SUPPORT) && defined(GCM_USE_TABLES)
@@ -86,6 +96,13 @@
 # endif
 #endif /* GCM_USE_ARM_PMULL */
 
+/* Flags for the GCM hw_impl_flags field telling which accelerated
+   GHASH implementation, and thus which layout of the key table, is in
+   use.  Stitched bulk functions of the ciphers check these.  */
+#define GCM_INTEL_USE_PCLMUL  (1 << 0)
+#define GCM_ARM_USE_PMULL     (1 << 1)
+#define GCM_INTEL_USE_VPCLMUL_AVX512 (1 << 2)
+
 
 typedef unsigned int (*ghash_fn_t) (gcry_cipher_hd_t c, byte *result,
                                     const byte *buf, size_t nblocks);
@@ -149,6 +166,11 @@ struct gcry_cipher_handle
     void (*xts_crypt)(gcry_cipher_hd_t c, unsigned char *tweak,
 		      void *outbuf_arg, const void *inbuf_arg,
 		      size_t nblocks, int encrypt);
+    size_t (*gcm_crypt)(gcry_cipher_hd_t c, void *outbuf_arg,
+			const void *inbuf_arg, size_t nblocks, int encrypt);
+    size_t (*poly1305_crypt)(gcry_cipher_hd_t c, void *outbuf_arg,
+			     const void *inbuf_arg, size_t length,
+			     int encrypt);
   } bulk;
 
 
@@ -261,6 +283,9 @@ struct gcry_cipher_handle
       /* GHASH implementation in use. */
       ghash_fn_t ghash_fn;
 
+      /* GCM_*_USE_* flags of the GHASH implementation in use. */
+      unsigned int hw_impl_flags;
+
       /* Pre-calculated table for GCM. */
 #ifdef GCM_USE_TABLES
  #if (SIZEOF_UNSIGNED_LONG == 8 || defined(__x86_64__))
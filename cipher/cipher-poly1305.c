@@ -134,12 +134,29 @@ _gcry_cipher_poly1305_authenticate (gcry_cipher_hd_t c,
 }
 
 
+/* Encrypt or decrypt with the bulk function of the cipher which does the
+   stream cipher and the Poly1305 of the ciphertext in a single pass.
+   Returns the number of bytes processed, which may be zero if the bulk
+   function is not available or can't be used at the current position
+   in the stream.  */
+static size_t
+poly1305_crypt_bulk (gcry_cipher_hd_t c, byte *outbuf, const byte *inbuf,
+		     size_t inbuflen, int encrypt)
+{
+  if (!c->bulk.poly1305_crypt)
+    return 0;
+
+  return c->bulk.poly1305_crypt (c, outbuf, inbuf, inbuflen, encrypt);
+}
+
+
 gcry_err_code_t
 _gcry_cipher_poly1305_encrypt (gcry_cipher_hd_t c,
 			       byte *outbuf, size_t outbuflen,
 			       const byte *inbuf, size_t inbuflen)
 {
   gcry_err_code_t err;
+  size_t n;
 
   if (outbuflen < inbuflen)
     return GPG_ERR_BUFFER_TOO_SHORT;
@@ -164,6 +181,13 @@ _gcry_cipher_poly1305_encrypt (gcry_cipher_hd_t c,
       return GPG_ERR_INV_LENGTH;
     }
 
+  n = poly1305_crypt_bulk (c, outbuf, inbuf, inbuflen, 1);
+  inbuf += n;
+  outbuf += n;
+  inbuflen -= n;
+  if (!inbuflen)
+    return 0;
+
   c->spec->stencrypt(&c->context.c, outbuf, (byte*)inbuf, inbuflen);
 
   _gcry_poly1305_update (&c->u_mode.poly1305.ctx, outbuf, inbuflen);
@@ -178,6 +202,7 @@ _gcry_cipher_poly1305_decrypt (gcry_cipher_hd_t c,
 			       const byte *inbuf, size_t inbuflen)
 {
   gcry_err_code_t err;
+  size_t n;
 
   if (outbuflen < inbuflen)
     return GPG_ERR_BUFFER_TOO_SHORT;
@@ -202,6 +227,13 @@ _gcry_cipher_poly1305_decrypt (gcry_cipher_hd_t c,
       return GPG_ERR_INV_LENGTH;
     }
 
+  n = poly1305_crypt_bulk (c, outbuf, inbuf, inbuflen, 0);
+  inbuf += n;
+  outbuf += n;
+  inbuflen -= n;
+  if (!inbuflen)
+    return 0;
+
   _gcry_poly1305_update (&c->u_mode.poly1305.ctx, inbuf, inbuflen);
 
   c->spec->stdecrypt(&c->context.c, outbuf, (byte*)inbuf, inbuflen);
@@ -321,8 +353,14 @@ _gcry_cipher_poly1305_setiv (gcry_cipher_hd_t c, const byte *iv, size_t ivlen)
   memset(tmpbuf, 0, sizeof(tmpbuf));
   c->spec->stencrypt(&c->context.c, tmpbuf, tmpbuf, sizeof(tmpbuf));
 
-  /* Use the first 32-bytes as Poly1305 key. */
-  err = _gcry_poly1305_init (&c->u_mode.poly1305.ctx, tmpbuf, POLY1305_KEYLEN);
+  /* Use the first 32-bytes as Poly1305 key.  With a stitched bulk
+     function the state needs to be in a layout known to it.  */
+  if (c->bulk.poly1305_crypt)
+    err = _gcry_poly1305_init_stitched (&c->u_mode.poly1305.ctx, tmpbuf,
+					POLY1305_KEYLEN);
+  else
+    err = _gcry_poly1305_init (&c->u_mode.poly1305.ctx, tmpbuf,
+			       POLY1305_KEYLEN);
 
   wipememory(tmpbuf, sizeof(tmpbuf));
 
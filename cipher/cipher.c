@@ -532,6 +532,8 @@ _gcry_cipher_open_internal (gcry_cipher_hd_t *handle,
               h->bulk.ctr_enc = _gcry_aes_ctr_enc;
               h->bulk.ocb_crypt = _gcry_aes_ocb_crypt;
               h->bulk.ocb_auth  = _gcry_aes_ocb_auth;
+              h->bulk.xts_crypt = _gcry_aes_xts_crypt;
+              h->bulk.gcm_crypt = _gcry_aes_gcm_crypt;
               break;
 #endif /*USE_AES*/
 #ifdef USE_BLOWFISH
@@ -587,6 +589,11 @@ _gcry_cipher_open_internal (gcry_cipher_hd_t *handle,
               h->bulk.ocb_auth  = _gcry_twofish_ocb_auth;
               break;
 #endif /*USE_TWOFISH*/
+#ifdef USE_CHACHA20
+	    case GCRY_CIPHER_CHACHA20:
+              h->bulk.poly1305_crypt = _gcry_chacha20_poly1305_crypt;
+              break;
+#endif /*USE_CHACHA20*/
 
             default:
               break;
@@ -82,6 +82,8 @@ const char *_gcry_ecc_get_curve (gcry_sexp_t keyparms,
                                  int iterator,
                                  unsigned int *r_nbits);
 gcry_sexp_t _gcry_ecc_get_param_sexp (const char *name);
+mpi_ec_t _gcry_ecc_ctx_acquire (elliptic_curve_t *E);
+void _gcry_ecc_ctx_release (mpi_ec_t ctx, elliptic_curve_t *E);
 
 /*-- ecc-misc.c --*/
 void _gcry_ecc_curve_free (elliptic_curve_t *E);
@@ -131,6 +133,20 @@ gpg_err_code_t _gcry_ecc_eddsa_verify (gcry_mpi_t input,
                                        gcry_mpi_t r, gcry_mpi_t s,
                                        int hashalgo, gcry_mpi_t pkmpi);
 
+/* An EdDSA signature to be checked by _gcry_ecc_eddsa_verify_batch.  */
+typedef struct
+{
+  gcry_mpi_t input;      /* The message.  */
+  gcry_mpi_t r, s;       /* The signature.  */
+  gcry_mpi_t pk;         /* The encoded public key.  */
+  int hashalgo;
+  gpg_err_code_t rc;     /* The result of the verification.  */
+} ecc_eddsa_batch_item_t;
+
+gpg_err_code_t _gcry_ecc_eddsa_verify_batch (ECC_public_key *pk,
+                                             ecc_eddsa_batch_item_t *items,
+                                             size_t n);
+
 /*-- ecc-gost.c --*/
 gpg_err_code_t _gcry_ecc_gost_sign (gcry_mpi_t input, ECC_secret_key *skey,
                                     gcry_mpi_t r, gcry_mpi_t s);
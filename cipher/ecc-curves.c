@@ -593,6 +593,157 @@ _gcry_ecc_fill_in_curve (unsigned int nbits, const char *name,
 }
 
 
+/* The cache of curve contexts enabled with GCRYCTL_ENABLE_ECC_CACHE.
+   For each curve of the domain_parms table we keep a few idle
+   contexts along with a table of multiples of the generator, so that
+   the signature functions neither need to set up a new context nor
+   do doublings to multiply G.  */
+#define ECC_CACHE_IDLE 4
+
+struct ecc_cache_s
+{
+  int initialized;              /* The entry has been set up.  */
+  enum gcry_mpi_ec_models model;
+  enum ecc_dialects dialect;
+  gcry_mpi_t p, a, b;           /* The domain parameters or NULL.  */
+  mpi_ec_fixed_base_t fixed_base; /* The table for G or NULL.  */
+  int nidle;                    /* Number of contexts in IDLE.  */
+  mpi_ec_t idle[ECC_CACHE_IDLE];
+};
+static struct ecc_cache_s ecc_cache[DIM (domain_parms) - 1];
+static int ecc_cache_enabled;
+/* Mutex used to protect access to ECC_CACHE.  */
+GPGRT_LOCK_DEFINE (ecc_cache_lock);
+
+
+/* Enable the use of the context cache.  */
+void
+_gcry_ecc_enable_cache (void)
+{
+  ecc_cache_enabled = 1;
+}
+
+
+/* Return the cache entry for the curve E or NULL if E does not match
+   a named curve.  Needs to be called while ecc_cache_lock is being
+   hold.  */
+static struct ecc_cache_s *
+get_cache_entry (elliptic_curve_t *E)
+{
+  struct ecc_cache_s *entry;
+  elliptic_curve_t E0;
+  mpi_ec_t ctx;
+  unsigned int nbits;
+  int idx;
+
+  idx = find_domain_parms_idx (E->name);
+  if (idx < 0)
+    return NULL;
+  entry = &ecc_cache[idx];
+
+  if (!entry->initialized)
+    {
+      entry->initialized = 1;
+      memset (&E0, 0, sizeof E0);
+      if (_gcry_ecc_fill_in_curve (0, E->name, &E0, NULL)
+          || E0.model == MPI_EC_MONTGOMERY)
+        {
+          _gcry_ecc_curve_free (&E0);
+          return NULL;
+        }
+      entry->model = E0.model;
+      entry->dialect = E0.dialect;
+      entry->p = E0.p;  E0.p = NULL;
+      entry->a = E0.a;  E0.a = NULL;
+      entry->b = E0.b;  E0.b = NULL;
+
+      /* The scalars are less than N, except for those modified by
+         _gcry_dsa_modify_k and the EdDSA secret scalar which are one
+         bit longer than N or P.  */
+      nbits = mpi_get_nbits (E0.n);
+      if (nbits < mpi_get_nbits (entry->p))
+        nbits = mpi_get_nbits (entry->p);
+      ctx = _gcry_mpi_ec_p_internal_new (entry->model, entry->dialect, 0,
+                                         entry->p, entry->a, entry->b);
+      /* The 2^255-19 code does its own multiplications and never
+         looks at the table.  */
+      if (!ctx->t.p25519)
+        entry->fixed_base = _gcry_mpi_ec_fixed_base_new (&E0.G, nbits + 1,
+                                                         ctx);
+      ctx->fixed_base = entry->fixed_base;
+      entry->idle[entry->nidle++] = ctx;
+      _gcry_ecc_curve_free (&E0);
+    }
+
+  if (!entry->p
+      || E->model != entry->model
+      || E->dialect != entry->dialect
+      || mpi_cmp (E->p, entry->p)
+      || mpi_cmp (E->a, entry->a)
+      || mpi_cmp (E->b, entry->b))
+    return NULL;
+
+  return entry;
+}
+
+
+/* Return a context for the curve E.  If the cache has been enabled
+   and E is a named curve, the context is taken from the cache.  The
+   context must be released with _gcry_ecc_ctx_release.  */
+mpi_ec_t
+_gcry_ecc_ctx_acquire (elliptic_curve_t *E)
+{
+  struct ecc_cache_s *entry = NULL;
+  mpi_ec_t ctx = NULL;
+
+  if (ecc_cache_enabled && E->name && !gpgrt_lock_lock (&ecc_cache_lock))
+    {
+      entry = get_cache_entry (E);
+      if (entry && entry->nidle)
+        ctx = entry->idle[--entry->nidle];
+      gpgrt_lock_unlock (&ecc_cache_lock);
+    }
+
+  if (!ctx)
+    {
+      ctx = _gcry_mpi_ec_p_internal_new (E->model, E->dialect, 0,
+                                         E->p, E->a, E->b);
+      if (entry)
+        ctx->fixed_base = entry->fixed_base;
+    }
+  return ctx;
+}
+
+
+/* Release the context CTX for the curve E as returned by
+   _gcry_ecc_ctx_acquire.  CTX may be NULL.  */
+void
+_gcry_ecc_ctx_release (mpi_ec_t ctx, elliptic_curve_t *E)
+{
+  struct ecc_cache_s *entry;
+
+  if (!ctx)
+    return;
+
+  if (ecc_cache_enabled && E->name)
+    {
+      _gcry_mpi_ec_wipe_scratch (ctx);
+      if (!gpgrt_lock_lock (&ecc_cache_lock))
+        {
+          entry = get_cache_entry (E);
+          if (entry && entry->nidle < ECC_CACHE_IDLE)
+            {
+              entry->idle[entry->nidle++] = ctx;
+              ctx = NULL;
+            }
+          gpgrt_lock_unlock (&ecc_cache_lock);
+        }
+    }
+
+  _gcry_mpi_ec_free (ctx);
+}
+
+
 /* Give the name of the curve NAME, store the curve parameters into P,
    A, B, G, N, and H if they point to NULL value.  Note that G is returned
    in standard uncompressed format.  Also update MODEL and DIALECT if
@@ -604,8 +604,7 @@ _gcry_ecc_eddsa_sign (gcry_mpi_t input, ECC_secret_key *skey,
   x = mpi_new (0);
   y = mpi_new (0);
   r = mpi_snew (0);
-  ctx = _gcry_mpi_ec_p_internal_new (skey->E.model, skey->E.dialect, 0,
-                                     skey->E.p, skey->E.a, skey->E.b);
+  ctx = _gcry_ecc_ctx_acquire (&skey->E);
   b = (ctx->nbits+7)/8;
   if (b != 256/8) {
     rc = GPG_ERR_INTERNAL; /* We only support 256 bit. */
@@ -660,6 +659,9 @@ _gcry_ecc_eddsa_sign (gcry_mpi_t input, ECC_secret_key *skey,
   if (DBG_CIPHER)
     log_printhex ("     r", digest, 64);
   _gcry_mpi_set_buffer (r, digest, 64, 0);
+  /* R is only used modulo N; reducing it halves the size of the
+     scalar multiplication.  */
+  mpi_mod (r, r, skey->E.n);
   _gcry_mpi_ec_mul_point (&I, r, &skey->E.G, ctx);
   if (DBG_CIPHER)
     log_printpnt ("   r", &I, ctx);
@@ -711,7 +713,7 @@ _gcry_ecc_eddsa_sign (gcry_mpi_t input, ECC_secret_key *skey,
   _gcry_mpi_release (y);
   _gcry_mpi_release (r);
   xfree (digest);
-  _gcry_mpi_ec_free (ctx);
+  _gcry_ecc_ctx_release (ctx, &skey->E);
   point_free (&I);
   point_free (&Q);
   xfree (encpk);
@@ -720,9 +722,28 @@ _gcry_ecc_eddsa_sign (gcry_mpi_t input, ECC_secret_key *skey,
 }
 
 
+/* Return true if H P is the neutral element, where H is the cofactor
+   of the curve of PKEY, which is a power of two.  P is modified.  */
+static int
+eddsa_cofactor_kills (mpi_point_t P, ECC_public_key *pkey, mpi_ec_t ctx)
+{
+  unsigned int j;
+
+  for (j = mpi_get_nbits (pkey->E.h); j > 1; j--)
+    _gcry_mpi_ec_dup_point (P, P, ctx);
+  return !mpi_cmp_ui (P->x, 0) && !mpi_cmp (P->y, P->z);
+}
+
+
 /* Verify an EdDSA signature.  See sign_eddsa for the reference.
  * Check if R_IN and S_IN verifies INPUT.  PKEY has the curve
  * parameters and PK is the EdDSA style encoded public key.
+ *
+ * As in RFC 8032 the group equation is checked with the cofactor,
+ * [h]sG = [h]R + [h]kQ, so that the result is the same as that of
+ * _gcry_ecc_eddsa_verify_batch.  The cheaper check without the
+ * cofactor, encodepoint(sG - kQ) = R, is tried first; it only fails
+ * for valid signatures if R or Q has a component of small order.
  */
 gpg_err_code_t
 _gcry_ecc_eddsa_verify (gcry_mpi_t input, ECC_public_key *pkey,
@@ -743,7 +764,8 @@ _gcry_ecc_eddsa_verify (gcry_mpi_t input, ECC_public_key *pkey,
   unsigned char digest[64];
   gcry_buffer_t hvec[3];
   gcry_mpi_t h, s;
-  mpi_point_struct Ia, Ib;
+  mpi_point_struct Ia;
+  mpi_point_struct R;
 
   if (!mpi_is_opaque (input) || !mpi_is_opaque (r_in) || !mpi_is_opaque (s_in))
     return GPG_ERR_INV_DATA;
@@ -752,12 +774,11 @@ _gcry_ecc_eddsa_verify (gcry_mpi_t input, ECC_public_key *pkey,
 
   point_init (&Q);
   point_init (&Ia);
-  point_init (&Ib);
+  point_init (&R);
   h = mpi_new (0);
   s = mpi_new (0);
 
-  ctx = _gcry_mpi_ec_p_internal_new (pkey->E.model, pkey->E.dialect, 0,
-                                     pkey->E.p, pkey->E.a, pkey->E.b);
+  ctx = _gcry_ecc_ctx_acquire (&pkey->E);
   b = ctx->nbits/8;
   if (b != 256/8)
     {
@@ -814,6 +835,12 @@ _gcry_ecc_eddsa_verify (gcry_mpi_t input, ECC_public_key *pkey,
   if (DBG_CIPHER)
     log_printhex (" H(R+)", digest, 64);
   _gcry_mpi_set_buffer (h, digest, 64, 0);
+  /* The order of Q divides the order of the curve, which is the
+     cofactor times N.  Thus H can be reduced modulo that product
+     without changing the result even if Q is not in the subgroup
+     generated by G.  */
+  mpi_mul (s, pkey->E.h, pkey->E.n);
+  mpi_mod (h, h, s);
 
   /* According to the paper the best way for verification is:
          encodepoint(sG - h·Q) = encodepoint(r)
@@ -836,17 +863,28 @@ _gcry_ecc_eddsa_verify (gcry_mpi_t input, ECC_public_key *pkey,
       }
   }
 
-  _gcry_mpi_ec_mul_point (&Ia, s, &pkey->E.G, ctx);
-  _gcry_mpi_ec_mul_point (&Ib, h, &Q, ctx);
-  _gcry_mpi_sub (Ib.x, ctx->p, Ib.x);
-  _gcry_mpi_ec_add_points (&Ia, &Ia, &Ib, ctx);
+  mpi_neg (h, h);
+  _gcry_mpi_ec_mul_point2 (&Ia, s, &pkey->E.G, h, &Q, ctx);
   rc = _gcry_ecc_eddsa_encodepoint (&Ia, ctx, s, h, 0, &tbuf, &tlen);
   if (rc)
     goto leave;
   if (tlen != rlen || memcmp (tbuf, rbuf, tlen))
     {
-      rc = GPG_ERR_BAD_SIGNATURE;
-      goto leave;
+      /* Check whether sG - kQ - R has a small order.  R needs to be
+         the canonical encoding of a point on the curve.  */
+      if (_gcry_ecc_eddsa_decodepoint (r_in, ctx, &R, NULL, NULL)
+          || !_gcry_mpi_ec_curve_point (&R, ctx))
+        {
+          rc = GPG_ERR_BAD_SIGNATURE;
+          goto leave;
+        }
+      mpi_subm (R.x, ctx->p, R.x, ctx->p);
+      _gcry_mpi_ec_add_points (&Ia, &Ia, &R, ctx);
+      if (!eddsa_cofactor_kills (&Ia, pkey, ctx))
+        {
+          rc = GPG_ERR_BAD_SIGNATURE;
+          goto leave;
+        }
     }
 
   rc = 0;
@@ -854,11 +892,228 @@ _gcry_ecc_eddsa_verify (gcry_mpi_t input, ECC_public_key *pkey,
  leave:
   xfree (encpk);
   xfree (tbuf);
-  _gcry_mpi_ec_free (ctx);
+  _gcry_ecc_ctx_release (ctx, &pkey->E);
   _gcry_mpi_release (s);
   _gcry_mpi_release (h);
+  point_free (&R);
   point_free (&Ia);
-  point_free (&Ib);
   point_free (&Q);
   return rc;
 }
+
+
+/* The minimum number of signatures checked as a batch.  For smaller
+   batches decoding R costs about as much as the saved work.  */
+#define EDDSA_MIN_BATCH 4
+
+
+/* Decode the public key and R of the batch item ITEM into A and R and
+   compute its H and S modulo the group order N.  A and R are negated for use in
+   _gcry_ecc_eddsa_verify_batch.  Returns an error if ITEM can't be
+   part of the batch; it then needs to be checked on its own.  */
+static gpg_err_code_t
+eddsa_batch_prepare (ecc_eddsa_batch_item_t *item, mpi_ec_t ctx,
+                     gcry_mpi_t n, mpi_point_t A, mpi_point_t R,
+                     gcry_mpi_t h, gcry_mpi_t s)
+{
+  gpg_err_code_t rc;
+  int b = ctx->nbits/8;
+  unsigned int tmp;
+  unsigned char *encpk = NULL;
+  unsigned int encpklen;
+  const void *mbuf, *rbuf;
+  size_t mlen, rlen;
+  void *sbuf;
+  unsigned int slen;
+  unsigned char digest[64];
+  gcry_buffer_t hvec[3];
+
+  if (!mpi_is_opaque (item->input) || !mpi_is_opaque (item->r)
+      || !mpi_is_opaque (item->s))
+    return GPG_ERR_INV_DATA;
+  if (item->hashalgo != GCRY_MD_SHA512)
+    return GPG_ERR_DIGEST_ALGO;
+
+  rc = _gcry_ecc_eddsa_decodepoint (item->pk, ctx, A, &encpk, &encpklen);
+  if (rc)
+    return rc;
+  if (!_gcry_mpi_ec_curve_point (A, ctx) || encpklen != b)
+    {
+      rc = GPG_ERR_BROKEN_PUBKEY;
+      goto leave;
+    }
+
+  mbuf = mpi_get_opaque (item->input, &tmp);
+  mlen = (tmp +7)/8;
+  rbuf = mpi_get_opaque (item->r, &tmp);
+  rlen = (tmp +7)/8;
+  mpi_get_opaque (item->s, &tmp);
+  slen = (tmp +7)/8;
+  if (rlen != b || slen != b)
+    {
+      rc = GPG_ERR_INV_LENGTH;
+      goto leave;
+    }
+
+  /* The single verification compares the encoding of sG - h·Q with
+     R.  Thus R needs to be the canonical encoding of a point on the
+     curve, which rules out coordinates not less than P.  */
+  rc = _gcry_ecc_eddsa_decodepoint (item->r, ctx, R, NULL, NULL);
+  if (rc || !_gcry_mpi_ec_curve_point (R, ctx))
+    {
+      rc = GPG_ERR_BAD_SIGNATURE;
+      goto leave;
+    }
+
+  /* h = H(encodepoint(R) + encodepoint(pk) + m)  */
+  hvec[0].data = (char*)rbuf;
+  hvec[0].off  = 0;
+  hvec[0].len  = rlen;
+  hvec[1].data = encpk;
+  hvec[1].off  = 0;
+  hvec[1].len  = encpklen;
+  hvec[2].data = (char*)mbuf;
+  hvec[2].off  = 0;
+  hvec[2].len  = mlen;
+  rc = _gcry_md_hash_buffers (item->hashalgo, 0, digest, hvec, 3);
+  if (rc)
+    goto leave;
+  reverse_buffer (digest, 64);
+  _gcry_mpi_set_buffer (h, digest, 64, 0);
+  mpi_mod (h, h, n);
+
+  sbuf = _gcry_mpi_get_opaque_copy (item->s, &tmp);
+  reverse_buffer (sbuf, slen);
+  _gcry_mpi_set_buffer (s, sbuf, slen, 0);
+  xfree (sbuf);
+  mpi_mod (s, s, n);
+
+  mpi_subm (A->x, ctx->p, A->x, ctx->p);
+  mpi_subm (R->x, ctx->p, R->x, ctx->p);
+
+ leave:
+  xfree (encpk);
+  return rc;
+}
+
+
+/* Verify the N EdDSA signatures described by ITEMS, which all use the
+   curve of PKEY, and store the result of each verification in the rc
+   field of the item.  This checks the random linear combination
+
+     h·(sum z_i s_i G - z_i R_i - z_i h_i A_i) = 0
+
+   with 128 bit random values z_i, the cofactor h and the public keys
+   A_i with a single multi-scalar multiplication.  The z_i make it
+   infeasible to find invalid signatures which cancel each other out.
+   Only if the batch check fails, the signatures are verified one by
+   one to find the bad ones.  Both this and _gcry_ecc_eddsa_verify
+   include the cofactor, so that they agree on signatures with points
+   of small order in R or A_i.  Without the cofactor, the random
+   linear combination can't be made to detect those reliably.  Returns
+   an error only if the signatures could not be checked at all.  */
+gpg_err_code_t
+_gcry_ecc_eddsa_verify_batch (ECC_public_key *pkey,
+                              ecc_eddsa_batch_item_t *items, size_t n)
+{
+  mpi_ec_t ctx;
+  mpi_point_struct *points;
+  mpi_point_t *ppoints;
+  gcry_mpi_t *scalars;
+  unsigned char *zbuf;
+  gcry_mpi_t h, s, z;
+  mpi_point_struct T;
+  size_t i, m;
+  int okay;
+
+  ctx = _gcry_ecc_ctx_acquire (&pkey->E);
+  if (ctx->nbits/8 != 256/8 || ctx->dialect != ECC_DIALECT_ED25519
+      || n < EDDSA_MIN_BATCH)
+    {
+      _gcry_ecc_ctx_release (ctx, &pkey->E);
+      for (i = 0; i < n; i++)
+        items[i].rc = _gcry_ecc_eddsa_verify (items[i].input, pkey,
+                                              items[i].r, items[i].s,
+                                              items[i].hashalgo, items[i].pk);
+      return 0;
+    }
+
+  /* POINTS[0] is G, followed by -A_i and -R_i of each signature.  */
+  points = xtrymalloc ((2 * n + 1) * sizeof *points);
+  ppoints = xtrymalloc ((2 * n + 1) * sizeof *ppoints);
+  scalars = xtrymalloc ((2 * n + 1) * sizeof *scalars);
+  zbuf = xtrymalloc (16 * n);
+  if (!points || !ppoints || !scalars || !zbuf)
+    {
+      gpg_err_code_t rc = gpg_err_code_from_syserror ();
+
+      xfree (zbuf);
+      xfree (scalars);
+      xfree (ppoints);
+      xfree (points);
+      _gcry_ecc_ctx_release (ctx, &pkey->E);
+      return rc;
+    }
+  for (i = 0; i < 2 * n + 1; i++)
+    {
+      point_init (&points[i]);
+      ppoints[i] = &points[i];
+      scalars[i] = mpi_new (0);
+    }
+  point_init (&T);
+  h = mpi_new (0);
+  s = mpi_new (0);
+  z = mpi_new (0);
+
+  _gcry_randomize (zbuf, 16 * n, GCRY_STRONG_RANDOM);
+
+  point_set (&points[0], &pkey->E.G);
+  for (i = m = 0; i < n; i++)
+    {
+      items[i].rc = eddsa_batch_prepare (&items[i], ctx, pkey->E.n,
+                                         &points[1 + 2 * m],
+                                         &points[2 + 2 * m], h, s);
+      if (items[i].rc)
+        continue;
+
+      _gcry_mpi_set_buffer (z, zbuf + 16 * i, 16, 0);
+      mpi_set_highbit (z, 127);
+      mpi_mulm (scalars[1 + 2 * m], z, h, pkey->E.n);
+      mpi_set (scalars[2 + 2 * m], z);
+      mpi_mulm (s, s, z, pkey->E.n);
+      mpi_addm (scalars[0], scalars[0], s, pkey->E.n);
+      m++;
+    }
+
+  okay = 0;
+  if (m >= EDDSA_MIN_BATCH)
+    {
+      _gcry_mpi_ec_mul_points (&T, 2 * m + 1, scalars, ppoints, ctx);
+      okay = eddsa_cofactor_kills (&T, pkey, ctx);
+    }
+
+  point_free (&T);
+  mpi_free (z);
+  mpi_free (s);
+  mpi_free (h);
+  for (i = 0; i < 2 * n + 1; i++)
+    {
+      mpi_free (scalars[i]);
+      point_free (&points[i]);
+    }
+  xfree (zbuf);
+  xfree (scalars);
+  xfree (ppoints);
+  xfree (points);
+  _gcry_ecc_ctx_release (ctx, &pkey->E);
+
+  /* Check the items which could not be part of the batch one by one
+     to get the exact error code.  The same is done for all items if
+     the batch did not verify.  */
+  for (i = 0; i < n; i++)
+    if (items[i].rc || !okay)
+      items[i].rc = _gcry_ecc_eddsa_verify (items[i].input, pkey,
+                                            items[i].r, items[i].s,
+                                            items[i].hashalgo, items[i].pk);
+  return 0;
+}
@@ -1022,48 +1022,61 @@ ecc_sign (gcry_sexp_t *r_sig, gcry_sexp_t s_data, gcry_sexp_t keyparms)
 }
 
 
-static gcry_err_code_t
-ecc_verify (gcry_sexp_t s_sig, gcry_sexp_t s_data, gcry_sexp_t s_keyparms)
+/* The parsed arguments of a verify operation.  */
+typedef struct
 {
-  gcry_err_code_t rc;
   struct pk_encoding_ctx ctx;
-  gcry_sexp_t l1 = NULL;
-  char *curvename = NULL;
-  gcry_mpi_t mpi_g = NULL;
-  gcry_mpi_t mpi_q = NULL;
-  gcry_mpi_t sig_r = NULL;
-  gcry_mpi_t sig_s = NULL;
-  gcry_mpi_t data = NULL;
   ECC_public_key pk;
+  gcry_mpi_t mpi_g;
+  gcry_mpi_t mpi_q;
+  gcry_mpi_t sig_r;
+  gcry_mpi_t sig_s;
+  gcry_mpi_t data;
+  char *curvename;
   int sigflags;
+} ecc_verify_parm_t;
 
-  memset (&pk, 0, sizeof pk);
-  _gcry_pk_util_init_encoding_ctx (&ctx, PUBKEY_OP_VERIFY,
+
+/* Extract the data, the signature and the key of a verify operation
+   into PARM, which needs to be released with verify_parm_release
+   even on error.  */
+static gcry_err_code_t
+verify_parm_parse (ecc_verify_parm_t *parm, gcry_sexp_t s_sig,
+                   gcry_sexp_t s_data, gcry_sexp_t s_keyparms)
+{
+  gcry_err_code_t rc;
+  gcry_sexp_t l1 = NULL;
+
+  memset (parm, 0, sizeof *parm);
+  _gcry_pk_util_init_encoding_ctx (&parm->ctx, PUBKEY_OP_VERIFY,
                                    ecc_get_nbits (s_keyparms));
 
   /* Extract the data.  */
-  rc = _gcry_pk_util_data_to_mpi (s_data, &data, &ctx);
+  rc = _gcry_pk_util_data_to_mpi (s_data, &parm->data, &parm->ctx);
   if (rc)
     goto leave;
   if (DBG_CIPHER)
-    log_mpidump ("ecc_verify data", data);
+    log_mpidump ("ecc_verify data", parm->data);
 
   /*
    * Extract the signature value.
    */
-  rc = _gcry_pk_util_preparse_sigval (s_sig, ecc_names, &l1, &sigflags);
+  rc = _gcry_pk_util_preparse_sigval (s_sig, ecc_names, &l1,
+                                      &parm->sigflags);
   if (rc)
     goto leave;
-  rc = sexp_extract_param (l1, NULL, (sigflags & PUBKEY_FLAG_EDDSA)? "/rs":"rs",
-                           &sig_r, &sig_s, NULL);
+  rc = sexp_extract_param (l1, NULL,
+                           (parm->sigflags & PUBKEY_FLAG_EDDSA)? "/rs":"rs",
+                           &parm->sig_r, &parm->sig_s, NULL);
   if (rc)
     goto leave;
   if (DBG_CIPHER)
     {
-      log_mpidump ("ecc_verify  s_r", sig_r);
-      log_mpidump ("ecc_verify  s_s", sig_s);
+      log_mpidump ("ecc_verify  s_r", parm->sig_r);
+      log_mpidump ("ecc_verify  s_s", parm->sig_s);
     }
-  if ((ctx.flags & PUBKEY_FLAG_EDDSA) ^ (sigflags & PUBKEY_FLAG_EDDSA))
+  if ((parm->ctx.flags & PUBKEY_FLAG_EDDSA)
+      ^ (parm->sigflags & PUBKEY_FLAG_EDDSA))
     {
       rc = GPG_ERR_CONFLICT; /* Inconsistent use of flag/algoname.  */
       goto leave;
@@ -1073,19 +1086,20 @@ ecc_verify (gcry_sexp_t s_sig, gcry_sexp_t s_data, gcry_sexp_t s_keyparms)
   /*
    * Extract the key.
    */
-  if ((ctx.flags & PUBKEY_FLAG_PARAM))
+  if ((parm->ctx.flags & PUBKEY_FLAG_PARAM))
     rc = sexp_extract_param (s_keyparms, NULL, "-p?a?b?g?n?h?/q",
-                             &pk.E.p, &pk.E.a, &pk.E.b, &mpi_g, &pk.E.n,
-                             &pk.E.h, &mpi_q, NULL);
+                             &parm->pk.E.p, &parm->pk.E.a, &parm->pk.E.b,
+                             &parm->mpi_g, &parm->pk.E.n, &parm->pk.E.h,
+                             &parm->mpi_q, NULL);
   else
     rc = sexp_extract_param (s_keyparms, NULL, "/q",
-                             &mpi_q, NULL);
+                             &parm->mpi_q, NULL);
   if (rc)
     goto leave;
-  if (mpi_g)
+  if (parm->mpi_g)
     {
-      point_init (&pk.E.G);
-      rc = _gcry_ecc_os2ec (&pk.E.G, mpi_g);
+      point_init (&parm->pk.E.G);
+      rc = _gcry_ecc_os2ec (&parm->pk.E.G, parm->mpi_g);
       if (rc)
         goto leave;
     }
@@ -1094,89 +1108,121 @@ ecc_verify (gcry_sexp_t s_sig, gcry_sexp_t s_data, gcry_sexp_t s_keyparms)
   l1 = sexp_find_token (s_keyparms, "curve", 5);
   if (l1)
     {
-      curvename = sexp_nth_string (l1, 1);
-      if (curvename)
+      parm->curvename = sexp_nth_string (l1, 1);
+      if (parm->curvename)
         {
-          rc = _gcry_ecc_fill_in_curve (0, curvename, &pk.E, NULL);
+          rc = _gcry_ecc_fill_in_curve (0, parm->curvename, &parm->pk.E,
+                                        NULL);
           if (rc)
             goto leave;
         }
     }
   /* Guess required fields if a curve parameter has not been given.
      FIXME: This is a crude hacks.  We need to fix that.  */
-  if (!curvename)
+  if (!parm->curvename)
     {
-      pk.E.model = ((sigflags & PUBKEY_FLAG_EDDSA)
-                    ? MPI_EC_EDWARDS
-                    : MPI_EC_WEIERSTRASS);
-      pk.E.dialect = ((sigflags & PUBKEY_FLAG_EDDSA)
-                      ? ECC_DIALECT_ED25519
-                      : ECC_DIALECT_STANDARD);
-      if (!pk.E.h)
-	pk.E.h = mpi_const (MPI_C_ONE);
+      parm->pk.E.model = ((parm->sigflags & PUBKEY_FLAG_EDDSA)
+                          ? MPI_EC_EDWARDS
+                          : MPI_EC_WEIERSTRASS);
+      parm->pk.E.dialect = ((parm->sigflags & PUBKEY_FLAG_EDDSA)
+                            ? ECC_DIALECT_ED25519
+                            : ECC_DIALECT_STANDARD);
+      if (!parm->pk.E.h)
+	parm->pk.E.h = mpi_const (MPI_C_ONE);
     }
 
   if (DBG_CIPHER)
     {
       log_debug ("ecc_verify info: %s/%s%s\n",
-                 _gcry_ecc_model2str (pk.E.model),
-                 _gcry_ecc_dialect2str (pk.E.dialect),
-                 (sigflags & PUBKEY_FLAG_EDDSA)? "+EdDSA":"");
-      if (pk.E.name)
-        log_debug  ("ecc_verify name: %s\n", pk.E.name);
-      log_printmpi ("ecc_verify    p", pk.E.p);
-      log_printmpi ("ecc_verify    a", pk.E.a);
-      log_printmpi ("ecc_verify    b", pk.E.b);
-      log_printpnt ("ecc_verify  g",   &pk.E.G, NULL);
-      log_printmpi ("ecc_verify    n", pk.E.n);
-      log_printmpi ("ecc_verify    h", pk.E.h);
-      log_printmpi ("ecc_verify    q", mpi_q);
-    }
-  if (!pk.E.p || !pk.E.a || !pk.E.b || !pk.E.G.x || !pk.E.n || !pk.E.h || !mpi_q)
+                 _gcry_ecc_model2str (parm->pk.E.model),
+                 _gcry_ecc_dialect2str (parm->pk.E.dialect),
+                 (parm->sigflags & PUBKEY_FLAG_EDDSA)? "+EdDSA":"");
+      if (parm->pk.E.name)
+        log_debug  ("ecc_verify name: %s\n", parm->pk.E.name);
+      log_printmpi ("ecc_verify    p", parm->pk.E.p);
+      log_printmpi ("ecc_verify    a", parm->pk.E.a);
+      log_printmpi ("ecc_verify    b", parm->pk.E.b);
+      log_printpnt ("ecc_verify  g",   &parm->pk.E.G, NULL);
+      log_printmpi ("ecc_verify    n", parm->pk.E.n);
+      log_printmpi ("ecc_verify    h", parm->pk.E.h);
+      log_printmpi ("ecc_verify    q", parm->mpi_q);
+    }
+  if (!parm->pk.E.p || !parm->pk.E.a || !parm->pk.E.b || !parm->pk.E.G.x
+      || !parm->pk.E.n || !parm->pk.E.h || !parm->mpi_q)
     {
       rc = GPG_ERR_NO_OBJ;
       goto leave;
     }
 
+ leave:
+  sexp_release (l1);
+  return rc;
+}
 
-  /*
-   * Verify the signature.
-   */
-  if ((sigflags & PUBKEY_FLAG_EDDSA))
+
+static void
+verify_parm_release (ecc_verify_parm_t *parm)
+{
+  _gcry_mpi_release (parm->pk.E.p);
+  _gcry_mpi_release (parm->pk.E.a);
+  _gcry_mpi_release (parm->pk.E.b);
+  _gcry_mpi_release (parm->mpi_g);
+  point_free (&parm->pk.E.G);
+  _gcry_mpi_release (parm->pk.E.n);
+  _gcry_mpi_release (parm->pk.E.h);
+  _gcry_mpi_release (parm->mpi_q);
+  point_free (&parm->pk.Q);
+  _gcry_mpi_release (parm->data);
+  _gcry_mpi_release (parm->sig_r);
+  _gcry_mpi_release (parm->sig_s);
+  xfree (parm->curvename);
+  _gcry_pk_util_free_encoding_ctx (&parm->ctx);
+}
+
+
+/* Verify the signature described by the parsed PARM.  */
+static gcry_err_code_t
+verify_parm_check (ecc_verify_parm_t *parm)
+{
+  gcry_err_code_t rc;
+  ECC_public_key *pk = &parm->pk;
+  gcry_mpi_t data = parm->data;
+
+  if ((parm->sigflags & PUBKEY_FLAG_EDDSA))
     {
-      rc = _gcry_ecc_eddsa_verify (data, &pk, sig_r, sig_s,
-                                   ctx.hash_algo, mpi_q);
+      rc = _gcry_ecc_eddsa_verify (data, pk, parm->sig_r, parm->sig_s,
+                                   parm->ctx.hash_algo, parm->mpi_q);
     }
-  else if ((sigflags & PUBKEY_FLAG_GOST))
+  else if ((parm->sigflags & PUBKEY_FLAG_GOST))
     {
-      point_init (&pk.Q);
-      rc = _gcry_ecc_os2ec (&pk.Q, mpi_q);
+      point_init (&pk->Q);
+      rc = _gcry_ecc_os2ec (&pk->Q, parm->mpi_q);
       if (rc)
-        goto leave;
+        return rc;
 
-      rc = _gcry_ecc_gost_verify (data, &pk, sig_r, sig_s);
+      rc = _gcry_ecc_gost_verify (data, pk, parm->sig_r, parm->sig_s);
     }
   else
     {
-      point_init (&pk.Q);
-      if (pk.E.dialect == ECC_DIALECT_ED25519)
+      point_init (&pk->Q);
+      if (pk->E.dialect == ECC_DIALECT_ED25519)
         {
           mpi_ec_t ec;
 
           /* Fixme: Factor the curve context setup out of eddsa_verify
              and ecdsa_verify. So that we don't do it twice.  */
-          ec = _gcry_mpi_ec_p_internal_new (pk.E.model, pk.E.dialect, 0,
-                                            pk.E.p, pk.E.a, pk.E.b);
+          ec = _gcry_ecc_ctx_acquire (&pk->E);
 
-          rc = _gcry_ecc_eddsa_decodepoint (mpi_q, ec, &pk.Q, NULL, NULL);
-          _gcry_mpi_ec_free (ec);
+          rc = _gcry_ecc_eddsa_decodepoint (parm->mpi_q, ec, &pk->Q,
+                                            NULL, NULL);
+          _gcry_ecc_ctx_release (ec, &pk->E);
         }
       else
         {
-          rc = _gcry_ecc_os2ec (&pk.Q, mpi_q);
+          rc = _gcry_ecc_os2ec (&pk->Q, parm->mpi_q);
         }
       if (rc)
-        goto leave;
+        return rc;
 
       if (mpi_is_opaque (data))
         {
@@ -1184,7 +1230,7 @@ ecc_verify (gcry_sexp_t s_sig, gcry_sexp_t s_data, gcry_sexp_t s_keyparms)
           unsigned int abits, qbits;
           gcry_mpi_t a;
 
-          qbits = mpi_get_nbits (pk.E.n);
+          qbits = mpi_get_nbits (pk->E.n);
 
           abuf = mpi_get_opaque (data, &abits);
           rc = _gcry_mpi_scan (&a, GCRYMPI_FMT_USG, abuf, (abits+7)/8, NULL);
@@ -1193,36 +1239,102 @@ ecc_verify (gcry_sexp_t s_sig, gcry_sexp_t s_data, gcry_sexp_t s_keyparms)
               if (abits > qbits)
                 mpi_rshift (a, a, abits - qbits);
 
-              rc = _gcry_ecc_ecdsa_verify (a, &pk, sig_r, sig_s);
+              rc = _gcry_ecc_ecdsa_verify (a, pk, parm->sig_r, parm->sig_s);
               _gcry_mpi_release (a);
             }
         }
       else
-        rc = _gcry_ecc_ecdsa_verify (data, &pk, sig_r, sig_s);
+        rc = _gcry_ecc_ecdsa_verify (data, pk, parm->sig_r, parm->sig_s);
     }
 
- leave:
-  _gcry_mpi_release (pk.E.p);
-  _gcry_mpi_release (pk.E.a);
-  _gcry_mpi_release (pk.E.b);
-  _gcry_mpi_release (mpi_g);
-  point_free (&pk.E.G);
-  _gcry_mpi_release (pk.E.n);
-  _gcry_mpi_release (pk.E.h);
-  _gcry_mpi_release (mpi_q);
-  point_free (&pk.Q);
-  _gcry_mpi_release (data);
-  _gcry_mpi_release (sig_r);
-  _gcry_mpi_release (sig_s);
-  xfree (curvename);
-  sexp_release (l1);
-  _gcry_pk_util_free_encoding_ctx (&ctx);
+  return rc;
+}
+
+
+static gcry_err_code_t
+ecc_verify (gcry_sexp_t s_sig, gcry_sexp_t s_data, gcry_sexp_t s_keyparms)
+{
+  gcry_err_code_t rc;
+  ecc_verify_parm_t parm;
+
+  rc = verify_parm_parse (&parm, s_sig, s_data, s_keyparms);
+  if (!rc)
+    rc = verify_parm_check (&parm);
+  verify_parm_release (&parm);
   if (DBG_CIPHER)
     log_debug ("ecc_verify    => %s\n", rc?gpg_strerror (rc):"Good");
   return rc;
 }
 
 
+/* Verify the N signatures S_SIGS of S_DATA made with the keys
+   S_KEYPARMS and store the result of each verification at R_RCS.
+   Ed25519 signatures are checked as a batch; the other signatures are
+   checked one by one.  Returns an error only if the signatures could
+   not be checked at all.  */
+static gcry_err_code_t
+ecc_verify_batch (gcry_sexp_t *s_sigs, gcry_sexp_t *s_data,
+                  gcry_sexp_t *s_keyparms, size_t n, gcry_err_code_t *r_rcs)
+{
+  gcry_err_code_t rc = 0;
+  ecc_verify_parm_t *parms;
+  ecc_eddsa_batch_item_t *items;
+  size_t *idx;
+  size_t i, m;
+
+  parms = xtrycalloc (n, sizeof *parms);
+  items = xtrycalloc (n, sizeof *items);
+  idx = xtrycalloc (n, sizeof *idx);
+  if (!parms || !items || !idx)
+    {
+      rc = gpg_err_code_from_syserror ();
+      goto leave;
+    }
+
+  for (i = m = 0; i < n; i++)
+    {
+      r_rcs[i] = verify_parm_parse (&parms[i], s_sigs[i], s_data[i],
+                                    s_keyparms[i]);
+      if (r_rcs[i])
+        continue;
+
+      /* All the batch items need to use the same curve.  A curve
+         given by parameters is not considered even if it is the
+         same.  */
+      if ((parms[i].sigflags & PUBKEY_FLAG_EDDSA)
+          && !(parms[i].ctx.flags & PUBKEY_FLAG_PARAM)
+          && parms[i].pk.E.name && !strcmp (parms[i].pk.E.name, "Ed25519"))
+        {
+          items[m].input = parms[i].data;
+          items[m].r = parms[i].sig_r;
+          items[m].s = parms[i].sig_s;
+          items[m].pk = parms[i].mpi_q;
+          items[m].hashalgo = parms[i].ctx.hash_algo;
+          idx[m++] = i;
+        }
+      else
+        r_rcs[i] = verify_parm_check (&parms[i]);
+    }
+
+  if (m)
+    {
+      rc = _gcry_ecc_eddsa_verify_batch (&parms[idx[0]].pk, items, m);
+      if (!rc)
+        for (i = 0; i < m; i++)
+          r_rcs[idx[i]] = items[i].rc;
+    }
+
+  for (i = 0; i < n; i++)
+    verify_parm_release (&parms[i]);
+
+ leave:
+  xfree (idx);
+  xfree (items);
+  xfree (parms);
+  return rc;
+}
+
+
 /* ecdh raw is classic 2-round DH protocol published in 1976.
  *
  * Overview of ecc_encrypt_raw and ecc_decrypt_raw.
@@ -2252,5 +2364,6 @@ gcry_pk_spec_t _gcry_pubkey_spec_ecc =
     run_selftests,
     compute_keygrip,
     _gcry_ecc_get_curve,
-    _gcry_ecc_get_param_sexp
+    _gcry_ecc_get_param_sexp,
+    ecc_verify_batch
   };
@@ -26,6 +26,7 @@
 #endif
 
 #include "g10lib.h"
+#include "bufhelp.h"
 #include "hash-common.h"
 
 
@@ -165,3 +166,183 @@ _gcry_md_block_write (void *context, const void *inbuf_arg, size_t inlen)
   for (; inlen && hd->count < blocksize; inlen--)
     hd->buf[hd->count++] = *inbuf++;
 }
+
+
+/* State of one lane of the multi-buffer helper.  */
+struct md_multi_lane
+{
+  const unsigned char *data;   /* Current segment. */
+  size_t nblks;                /* Blocks left in the current segment. */
+  int msg;                     /* Index of the message or -1 if idle. */
+  int in_tail;                 /* Current segment is TAIL. */
+  unsigned int ntail;          /* Number of blocks in TAIL. */
+  unsigned char tail[2 * 64];  /* Last partial block and padding. */
+};
+
+
+static void
+md_multi_lane_start (const gcry_md_multi_spec_t *spec, u32 *state,
+                     struct md_multi_lane *lane, unsigned int l,
+                     const gcry_buffer_t *iov, int msg)
+{
+  const unsigned char *data = (const unsigned char *)iov->data + iov->off;
+  size_t len = iov->len;
+  size_t rem = len % 64;
+  unsigned int i;
+
+  lane->msg = msg;
+  lane->data = data;
+  lane->nblks = len / 64;
+  lane->in_tail = 0;
+
+  lane->ntail = rem < 56 ? 1 : 2;
+  memcpy (lane->tail, data + len - rem, rem);
+  lane->tail[rem] = 0x80;
+  memset (lane->tail + rem + 1, 0, lane->ntail * 64 - rem - 1 - 8);
+  buf_put_be64 (lane->tail + lane->ntail * 64 - 8, (u64)len << 3);
+
+  if (!lane->nblks)
+    {
+      lane->data = lane->tail;
+      lane->nblks = lane->ntail;
+      lane->in_tail = 1;
+    }
+
+  for (i = 0; i < spec->nwords; i++)
+    state[i * spec->nlanes + l] = spec->iv[i];
+}
+
+
+static void
+md_multi_lane_output (const gcry_md_multi_spec_t *spec, const u32 *state,
+                      unsigned int l, unsigned char *digest)
+{
+  unsigned int i;
+
+  for (i = 0; i < spec->dlen / 4; i++)
+    buf_put_be32 (digest + i * 4, state[i * spec->nlanes + l]);
+}
+
+
+/* Hash NMSGS independent messages given by IOV and store the digests
+   consecutively at DIGESTS.  The messages are distributed over the
+   lanes of SPEC->transform_multi; whenever a lane finishes its message
+   the next pending message is started in it.  When less than
+   SPEC->min_lanes lanes are left busy, they are finished with
+   SPEC->transform_lane. */
+void
+_gcry_md_block_hash_multi (const gcry_md_multi_spec_t *spec, void *digests,
+                           const gcry_buffer_t *iov, int nmsgs)
+{
+  struct md_multi_lane lanes[MD_MULTI_MAX_LANES];
+  u32 state[8 * MD_MULTI_MAX_LANES];
+  unsigned char *out = digests;
+  const unsigned char *ptrs[MD_MULTI_MAX_LANES];
+  const unsigned int nlanes = spec->nlanes;
+  unsigned int burn, stack_burn = 0;
+  unsigned int l, active = 0;
+  int next = 0;
+  size_t n;
+
+  gcry_assert (nlanes <= MD_MULTI_MAX_LANES && spec->nwords <= 8);
+
+  for (l = 0; l < nlanes; l++)
+    {
+      lanes[l].msg = -1;
+      if (next < nmsgs)
+        {
+          md_multi_lane_start (spec, state, &lanes[l], l, &iov[next], next);
+          next++;
+          active++;
+        }
+    }
+
+  while (active)
+    {
+      if (next >= nmsgs && active < spec->min_lanes)
+        {
+          /* Few stragglers left; finish them one by one.  */
+          for (l = 0; l < nlanes; l++)
+            {
+              u32 h[8];
+              unsigned int i;
+
+              if (lanes[l].msg < 0)
+                continue;
+
+              for (i = 0; i < spec->nwords; i++)
+                h[i] = state[i * nlanes + l];
+              burn = spec->transform_lane (h, lanes[l].data, lanes[l].nblks);
+              stack_burn = burn > stack_burn ? burn : stack_burn;
+              if (!lanes[l].in_tail)
+                {
+                  burn = spec->transform_lane (h, lanes[l].tail,
+                                               lanes[l].ntail);
+                  stack_burn = burn > stack_burn ? burn : stack_burn;
+                }
+              for (i = 0; i < spec->nwords; i++)
+                state[i * nlanes + l] = h[i];
+              md_multi_lane_output (spec, state, l,
+                                    out + lanes[l].msg * spec->dlen);
+              wipememory (h, sizeof(h));
+            }
+          break;
+        }
+
+      /* Process as many blocks as all busy lanes have available.  Idle
+         lanes just hash data of some busy lane. */
+      n = (size_t)-1;
+      for (l = 0; l < nlanes; l++)
+        if (lanes[l].msg >= 0 && lanes[l].nblks < n)
+          n = lanes[l].nblks;
+      for (l = 0; l < nlanes; l++)
+        if (lanes[l].msg >= 0)
+          break;
+      for (; l < nlanes; l++)
+        if (lanes[l].msg >= 0)
+          ptrs[l] = lanes[l].data;
+        else
+          ptrs[l] = ptrs[l - 1];
+      for (l = 0; l < nlanes && lanes[l].msg < 0; l++)
+        ptrs[l] = ptrs[nlanes - 1];
+
+      burn = spec->transform_multi (state, ptrs, n);
+      stack_burn = burn > stack_burn ? burn : stack_burn;
+
+      for (l = 0; l < nlanes; l++)
+        {
+          struct md_multi_lane *lane = &lanes[l];
+
+          if (lane->msg < 0)
+            continue;
+
+          lane->data += n * 64;
+          lane->nblks -= n;
+          if (lane->nblks)
+            continue;
+
+          if (!lane->in_tail)
+            {
+              lane->data = lane->tail;
+              lane->nblks = lane->ntail;
+              lane->in_tail = 1;
+              continue;
+            }
+
+          md_multi_lane_output (spec, state, l, out + lane->msg * spec->dlen);
+          lane->msg = -1;
+          active--;
+
+          if (next < nmsgs)
+            {
+              md_multi_lane_start (spec, state, lane, l, &iov[next], next);
+              next++;
+              active++;
+            }
+        }
+    }
+
+  wipememory (lanes, sizeof(lanes));
+  wipememory (state, sizeof(state));
+  _gcry_burn_stack (stack_burn);
+}
@@ -56,4 +56,45 @@ typedef struct gcry_md_block_ctx
 void
 _gcry_md_block_write( void *context, const void *inbuf_arg, size_t inlen);
 
+
+/* Maximum number of lanes for the multi-buffer helper.  */
+#define MD_MULTI_MAX_LANES 8
+
+/* Type for the multi-buffer transform function.  STATE holds the
+   state words of all lanes, word by word (STATE[word * nlanes + lane]),
+   DATA[lane] points to NBLKS consecutive 64 byte blocks of each lane.  */
+typedef unsigned int (*_gcry_md_multi_transform_t) (u32 *state,
+                                                    const unsigned char **data,
+                                                    size_t nblks);
+
+/* Type for the single lane transform function working on the state
+   words of one lane.  */
+typedef unsigned int (*_gcry_md_lane_transform_t) (u32 *state,
+                                                   const unsigned char *data,
+                                                   size_t nblks);
+
+/* Description of a multi-buffer implementation of a hash algorithm
+   with 64 byte blocks, big-endian 32-bit state words and 64-bit
+   big-endian bit count padding (i.e. SHA-1 and SHA-2/256).  */
+typedef struct gcry_md_multi_spec
+{
+  unsigned int nlanes;
+  unsigned int min_lanes; /* Fewer busy lanes are done by TRANSFORM_LANE. */
+  unsigned int nwords;
+  unsigned int dlen;
+  const u32 *iv;
+  _gcry_md_multi_transform_t transform_multi;
+  _gcry_md_lane_transform_t transform_lane;
+} gcry_md_multi_spec_t;
+
+void
+_gcry_md_block_hash_multi (const gcry_md_multi_spec_t *spec, void *digests,
+                           const gcry_buffer_t *iov, int nmsgs);
+
+/*-- sha1.c --*/
+void _gcry_sha1_get_multi_spec (gcry_md_multi_spec_t *spec);
+
+/*-- sha256.c --*/
+void _gcry_sha256_get_multi_spec (gcry_md_multi_spec_t *spec, int is_sha224);
+
 #endif /*GCRY_HASH_COMMON_H*/
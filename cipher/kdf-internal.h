@@ -29,12 +29,24 @@ _gcry_kdf_pkdf2 (const void *passphrase, size_t passphraselen,
                  size_t keysize, void *keybuffer);
 
 /*-- scrypt.c --*/
+struct scrypt_ctx_s;
+typedef struct scrypt_ctx_s *scrypt_ctx_t;
+
 gcry_err_code_t
 _gcry_kdf_scrypt (const unsigned char *passwd, size_t passwdlen,
                   int algo, int subalgo,
                   const unsigned char *salt, size_t saltlen,
                   unsigned long iterations,
                   size_t dklen, unsigned char *dk);
+gcry_err_code_t
+_gcry_kdf_scrypt_prepare (scrypt_ctx_t *r_ctx, int algo, int subalgo,
+                          unsigned long iterations, int parallel);
+void _gcry_kdf_scrypt_release (scrypt_ctx_t ctx);
+gcry_err_code_t
+_gcry_kdf_scrypt_compute (scrypt_ctx_t ctx,
+                          const unsigned char *passwd, size_t passwdlen,
+                          const unsigned char *salt, size_t saltlen,
+                          size_t dklen, unsigned char *dk);
 
 
 #endif /*GCRY_KDF_INTERNAL_H*/
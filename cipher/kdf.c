@@ -26,9 +26,24 @@
 
 #include "g10lib.h"
 #include "cipher.h"
+#include "bufhelp.h"
+#include "hash-common.h"
+#include "context.h"
 #include "kdf-internal.h"
 
 
+/* A prepared KDF as stored in a gcry_ctx_t.  */
+typedef struct
+{
+  int algo;
+  int subalgo;
+  unsigned long iterations;
+#if USE_SCRYPT
+  scrypt_ctx_t scrypt;  /* The memory for scrypt or NULL.  */
+#endif
+} kdf_prepared_t;
+
+
 /* Transform a passphrase into a suitable key of length KEYSIZE and
    store this key in the caller provided buffer KEYBUFFER.  The caller
    must provide an HASHALGO, a valid ALGO and depending on that algo a
@@ -108,6 +123,230 @@ openpgp_s2k (const void *passphrase, size_t passphraselen,
   return 0;
 }
 
+/* Fill SPEC and return true if HASHALGO can be used with the raw
+   block transform of pkdf2_hmac.  */
+static int
+pkdf2_get_spec (int hashalgo, gcry_md_multi_spec_t *spec)
+{
+  if (_gcry_md_test_algo (hashalgo))
+    return 0;
+
+  switch (hashalgo)
+    {
+#if USE_SHA1
+    case GCRY_MD_SHA1:
+      _gcry_sha1_get_multi_spec (spec);
+      return 1;
+#endif
+#if USE_SHA256
+    case GCRY_MD_SHA224:
+      _gcry_sha256_get_multi_spec (spec, 1);
+      return 1;
+    case GCRY_MD_SHA256:
+      _gcry_sha256_get_multi_spec (spec, 0);
+      return 1;
+#endif
+    default:
+      return 0;
+    }
+}
+
+
+/* Finish the hash of a message of which PREFIX bytes, a multiple of
+   the block size, have already been compressed into the state words
+   H by compressing DATA of LEN bytes and the padding.  */
+static unsigned int
+pkdf2_lane_final (const gcry_md_multi_spec_t *spec, u32 *h, size_t prefix,
+                  const unsigned char *data, size_t len)
+{
+  unsigned char tail[2 * 64];
+  size_t nblks = len / 64;
+  size_t rem = len % 64;
+  size_t ntail = rem < 56 ? 1 : 2;
+  unsigned int burn = 0;
+  unsigned int nburn;
+
+  if (nblks)
+    burn = spec->transform_lane (h, data, nblks);
+
+  memcpy (tail, data + nblks * 64, rem);
+  tail[rem] = 0x80;
+  memset (tail + rem + 1, 0, ntail * 64 - rem - 1 - 8);
+  buf_put_be64 (tail + ntail * 64 - 8, ((u64)prefix + len) << 3);
+  nburn = spec->transform_lane (h, tail, ntail);
+  burn = nburn > burn ? nburn : burn;
+
+  wipememory (tail, sizeof tail);
+  return burn;
+}
+
+
+/* PBKDF2 with HMAC on top of the raw block transform described by
+   SPEC.  The inner and outer pad states are computed once; all
+   U_(2..c) and outer hash inputs fit into a single padded block which
+   is compressed directly.  If SPEC has a multi-lane transform, up to
+   SPEC->NLANES output blocks are computed at once.  */
+static gpg_err_code_t
+pkdf2_hmac (const gcry_md_multi_spec_t *spec,
+            const void *passphrase, size_t passphraselen,
+            const void *salt, size_t saltlen,
+            unsigned long iterations,
+            size_t dklen, unsigned char *dk, int secmode)
+{
+  const unsigned int nw = spec->nwords;
+  const unsigned int hlen = spec->dlen;
+  const unsigned int hw = hlen / 4;
+  unsigned int nl = spec->nlanes;
+  u32 istate[8], ostate[8];
+  u32 state[8 * MD_MULTI_MAX_LANES];
+  u32 tbuf[MD_MULTI_MAX_LANES][8];
+  unsigned char ublk[MD_MULTI_MAX_LANES][64];
+  unsigned char oblk[MD_MULTI_MAX_LANES][64];
+  const unsigned char *ptrs[MD_MULTI_MAX_LANES];
+  unsigned char kblk[64];
+  unsigned char *sbuf;
+  unsigned int lidx, nlanes, lane, w;
+  unsigned long iter;
+  unsigned int burn, nburn;
+  size_t n;
+
+  sbuf = secmode ? xtrymalloc_secure (saltlen + 4) : xtrymalloc (saltlen + 4);
+  if (!sbuf)
+    return gpg_err_code_from_syserror ();
+  memcpy (sbuf, salt, saltlen);
+
+  /* Compute the inner and outer pad states from K or H(K).  */
+  memset (kblk, 0, sizeof kblk);
+  burn = 0;
+  if (passphraselen > 64)
+    {
+      memcpy (istate, spec->iv, nw * 4);
+      burn = pkdf2_lane_final (spec, istate, 0, passphrase, passphraselen);
+      for (w = 0; w < hw; w++)
+        buf_put_be32 (kblk + 4 * w, istate[w]);
+    }
+  else if (passphraselen)
+    memcpy (kblk, passphrase, passphraselen);
+
+  for (n = 0; n < 64; n++)
+    kblk[n] ^= 0x36;
+  memcpy (istate, spec->iv, nw * 4);
+  nburn = spec->transform_lane (istate, kblk, 1);
+  burn = nburn > burn ? nburn : burn;
+  for (n = 0; n < 64; n++)
+    kblk[n] ^= 0x36 ^ 0x5c;
+  memcpy (ostate, spec->iv, nw * 4);
+  spec->transform_lane (ostate, kblk, 1);
+
+  /* The inner hash input U and the outer hash input are HLEN bytes
+     long, the padding of their blocks does not change.  */
+  for (lane = 0; lane < MD_MULTI_MAX_LANES; lane++)
+    {
+      memset (ublk[lane], 0, 64);
+      ublk[lane][hlen] = 0x80;
+      buf_put_be64 (ublk[lane] + 56, (u64)(64 + hlen) << 3);
+      memcpy (oblk[lane], ublk[lane], 64);
+    }
+
+  for (lidx = 1; dklen; lidx += nlanes)
+    {
+      nlanes = (dklen - 1) / hlen + 1;
+      if (!spec->transform_multi || nlanes < spec->min_lanes)
+        nlanes = 1;
+      else if (nlanes > nl)
+        nlanes = nl;
+
+      /* Compute U_1.  */
+      for (lane = 0; lane < nlanes; lane++)
+        {
+          buf_put_be32 (sbuf + saltlen, lidx + lane);
+          memcpy (state, istate, nw * 4);
+          nburn = pkdf2_lane_final (spec, state, 64, sbuf, saltlen + 4);
+          burn = nburn > burn ? nburn : burn;
+          for (w = 0; w < hw; w++)
+            buf_put_be32 (oblk[lane] + 4 * w, state[w]);
+          memcpy (state, ostate, nw * 4);
+          spec->transform_lane (state, oblk[lane], 1);
+          for (w = 0; w < hw; w++)
+            {
+              tbuf[lane][w] = state[w];
+              buf_put_be32 (ublk[lane] + 4 * w, state[w]);
+            }
+        }
+
+      /* Compute U_(2..c).  */
+      if (nlanes == 1)
+        {
+          for (iter = 1; iter < iterations; iter++)
+            {
+              memcpy (state, istate, nw * 4);
+              spec->transform_lane (state, ublk[0], 1);
+              for (w = 0; w < hw; w++)
+                buf_put_be32 (oblk[0] + 4 * w, state[w]);
+              memcpy (state, ostate, nw * 4);
+              spec->transform_lane (state, oblk[0], 1);
+              for (w = 0; w < hw; w++)
+                {
+                  tbuf[0][w] ^= state[w];
+                  buf_put_be32 (ublk[0] + 4 * w, state[w]);
+                }
+            }
+        }
+      else
+        {
+          /* Idle lanes redo the work of lane 0.  */
+          for (iter = 1; iter < iterations; iter++)
+            {
+              for (w = 0; w < nw; w++)
+                for (lane = 0; lane < nl; lane++)
+                  state[w * nl + lane] = istate[w];
+              for (lane = 0; lane < nl; lane++)
+                ptrs[lane] = ublk[lane < nlanes ? lane : 0];
+              spec->transform_multi (state, ptrs, 1);
+              for (lane = 0; lane < nlanes; lane++)
+                for (w = 0; w < hw; w++)
+                  buf_put_be32 (oblk[lane] + 4 * w, state[w * nl + lane]);
+
+              for (w = 0; w < nw; w++)
+                for (lane = 0; lane < nl; lane++)
+                  state[w * nl + lane] = ostate[w];
+              for (lane = 0; lane < nl; lane++)
+                ptrs[lane] = oblk[lane < nlanes ? lane : 0];
+              nburn = spec->transform_multi (state, ptrs, 1);
+              for (lane = 0; lane < nlanes; lane++)
+                for (w = 0; w < hw; w++)
+                  {
+                    tbuf[lane][w] ^= state[w * nl + lane];
+                    buf_put_be32 (ublk[lane] + 4 * w, state[w * nl + lane]);
+                  }
+            }
+          if (iterations > 1)
+            burn = nburn > burn ? nburn : burn;
+        }
+
+      for (lane = 0; lane < nlanes; lane++)
+        {
+          for (w = 0; w < hw; w++)
+            buf_put_be32 (kblk + 4 * w, tbuf[lane][w]);
+          n = dklen < hlen ? dklen : hlen;
+          memcpy (dk, kblk, n);
+          dk += n;
+          dklen -= n;
+        }
+    }
+
+  wipememory (istate, sizeof istate);
+  wipememory (ostate, sizeof ostate);
+  wipememory (state, sizeof state);
+  wipememory (tbuf, sizeof tbuf);
+  wipememory (ublk, sizeof ublk);
+  wipememory (oblk, sizeof oblk);
+  wipememory (kblk, sizeof kblk);
+  xfree (sbuf);
+  _gcry_burn_stack (burn);
+  return 0;
+}
+
 
 /* Transform a passphrase into a suitable key of length KEYSIZE and
    store this key in the caller provided buffer KEYBUFFER.  The caller
@@ -137,6 +376,7 @@ _gcry_kdf_pkdf2 (const void *passphrase, size_t passphraselen,
   unsigned int lidx;   /* Current block number.  */
   unsigned long iter;  /* Current iteration number.  */
   unsigned int i;
+  gcry_md_multi_spec_t spec;
 
   /* We allow for a saltlen of 0 here to support scrypt.  It is not
      clear whether rfc2898 allows for this this, thus we do a test on
@@ -161,6 +401,11 @@ _gcry_kdf_pkdf2 (const void *passphrase, size_t passphraselen,
 #endif
 
 
+  /* SHA-1 and SHA-2/256 use the raw block transform.  */
+  if (pkdf2_get_spec (hashalgo, &spec))
+    return pkdf2_hmac (&spec, passphrase, passphraselen, salt, saltlen,
+                       iterations, dklen, keybuffer, secmode);
+
   /* Step 2 */
   l = ((dklen - 1)/ hlen) + 1;
   r = dklen - (l - 1) * hlen;
@@ -305,3 +550,108 @@ _gcry_kdf_derive (const void *passphrase, size_t passphraselen,
  leave:
   return ec;
 }
+
+
+/* Deinitialize a prepared KDF.  */
+static void
+prepared_kdf_deinit (void *ptr)
+{
+  kdf_prepared_t *kdf = ptr;
+
+#if USE_SCRYPT
+  _gcry_kdf_scrypt_release (kdf->scrypt);
+#else
+  (void)kdf;
+#endif
+}
+
+
+/* Prepare the KDF ALGO with the parameters SUBALGO and ITERATIONS as
+   described for _gcry_kdf_derive for use with
+   _gcry_kdf_derive_prepared and store the context at R_CTX.  For
+   scrypt the context holds the memory for the derivation; with
+   GCRY_KDF_FLAG_PARALLEL in FLAGS the P lanes are computed by worker
+   threads.  A context may only be used by one thread at a time.  */
+gpg_err_code_t
+_gcry_kdf_prepare (gcry_ctx_t *r_ctx, int algo, int subalgo,
+                   unsigned long iterations, unsigned int flags)
+{
+  gpg_err_code_t ec = 0;
+  gcry_ctx_t ctx;
+  kdf_prepared_t *kdf;
+
+  *r_ctx = NULL;
+
+  if ((flags & ~GCRY_KDF_FLAG_PARALLEL))
+    return GPG_ERR_INV_FLAG;
+
+  switch (algo)
+    {
+    case GCRY_KDF_SIMPLE_S2K:
+    case GCRY_KDF_SALTED_S2K:
+    case GCRY_KDF_ITERSALTED_S2K:
+    case GCRY_KDF_PBKDF1:
+    case GCRY_KDF_PBKDF2:
+    case 41:
+    case GCRY_KDF_SCRYPT:
+      break;
+
+    default:
+      return GPG_ERR_UNKNOWN_ALGORITHM;
+    }
+
+  ctx = _gcry_ctx_alloc (CONTEXT_TYPE_KDF, sizeof *kdf, prepared_kdf_deinit);
+  if (!ctx)
+    return gpg_err_code_from_syserror ();
+  kdf = _gcry_ctx_get_pointer (ctx, CONTEXT_TYPE_KDF);
+  kdf->algo = algo;
+  kdf->subalgo = subalgo;
+  kdf->iterations = iterations;
+
+  if (algo == 41 || algo == GCRY_KDF_SCRYPT)
+    {
+#if USE_SCRYPT
+      ec = _gcry_kdf_scrypt_prepare (&kdf->scrypt, algo, subalgo, iterations,
+                                     !!(flags & GCRY_KDF_FLAG_PARALLEL));
+#else
+      ec = GPG_ERR_UNSUPPORTED_ALGORITHM;
+#endif /*USE_SCRYPT*/
+    }
+
+  if (ec)
+    _gcry_ctx_release (ctx);
+  else
+    *r_ctx = ctx;
+  return ec;
+}
+
+
+/* Derive a key like _gcry_kdf_derive using the algorithm and the
+   parameters of the prepared KDF CTX.  */
+gpg_err_code_t
+_gcry_kdf_derive_prepared (gcry_ctx_t ctx,
+                           const void *passphrase, size_t passphraselen,
+                           const void *salt, size_t saltlen,
+                           size_t keysize, void *keybuffer)
+{
+  kdf_prepared_t *kdf = _gcry_ctx_find_pointer (ctx, CONTEXT_TYPE_KDF);
+
+  if (!kdf)
+    return GPG_ERR_INV_ARG;
+
+#if USE_SCRYPT
+  if (kdf->scrypt)
+    {
+      if (!passphrase)
+        return GPG_ERR_INV_DATA;
+      if (!keybuffer || !keysize)
+        return GPG_ERR_INV_VALUE;
+      return _gcry_kdf_scrypt_compute (kdf->scrypt, passphrase, passphraselen,
+                                       salt, saltlen, keysize, keybuffer);
+    }
+#endif /*USE_SCRYPT*/
+
+  return _gcry_kdf_derive (passphrase, passphraselen,
+                           kdf->algo, kdf->subalgo, salt, saltlen,
+                           kdf->iterations, keysize, keybuffer);
+}
@@ -71,6 +71,44 @@
 #endif /*ENABLE_NEON_SUPPORT*/
 
 
+/* USE_64BIT_AVX512 indicates whether to compile with Intel AVX512 code. */
+#undef USE_64BIT_AVX512
+#if defined(USE_64BIT) && defined(__x86_64__) && \
+    defined(HAVE_GCC_INLINE_ASM_AVX512) && defined(ENABLE_AVX512_SUPPORT) && \
+    (defined(HAVE_COMPATIBLE_GCC_AMD64_PLATFORM_AS) || \
+     defined(HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS))
+# define USE_64BIT_AVX512 1
+#endif
+
+
+/* USE_64BIT_AVX2_X4 indicates whether to compile with Intel AVX2 code
+ * for four interleaved states. */
+#undef USE_64BIT_AVX2_X4
+#if defined(USE_64BIT) && defined(__x86_64__) && \
+    defined(HAVE_GCC_INLINE_ASM_AVX2) && \
+    (defined(HAVE_COMPATIBLE_GCC_AMD64_PLATFORM_AS) || \
+     defined(HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS))
+# define USE_64BIT_AVX2_X4 1
+#endif
+
+
+#if defined(USE_64BIT_AVX512) || defined(USE_64BIT_AVX2_X4)
+# define USE_64BIT_X4 1
+#endif
+
+
+/* Assembly implementations use SystemV ABI, ABI conversion and additional
+ * stack to store XMM6-XMM15 needed on Win64. */
+#undef ASM_FUNC_ABI
+#if defined(USE_64BIT_AVX512) || defined(USE_64BIT_AVX2_X4)
+# ifdef HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS
+#  define ASM_FUNC_ABI __attribute__((sysv_abi))
+# else
+#  define ASM_FUNC_ABI
+# endif
+#endif
+
+
 #if defined(USE_64BIT) || defined(USE_64BIT_ARM_NEON)
 # define NEED_COMMON64 1
 #endif
@@ -461,6 +499,97 @@ static const keccak_ops_t keccak_armv7_neon_64_ops =
 #endif /* USE_64BIT_ARM_NEON */
 
 
+/* 64-bit Intel AVX512 implementation. */
+#ifdef USE_64BIT_AVX512
+
+extern unsigned int
+_gcry_keccak_f1600_state_permute64_avx512(u64 *state, const u64 *rconst)
+  ASM_FUNC_ABI;
+
+extern unsigned int
+_gcry_keccak_absorb_blocks_avx512(u64 *state, const u64 *rconst,
+				  const byte *lanes, size_t nblks,
+				  size_t blocklanes) ASM_FUNC_ABI;
+
+extern unsigned int
+_gcry_keccak_f1600_state_permute64_avx512_x4(u64 *state, const u64 *rconst)
+  ASM_FUNC_ABI;
+
+static unsigned int keccak_f1600_state_permute64_avx512(KECCAK_STATE *hd)
+{
+  return _gcry_keccak_f1600_state_permute64_avx512 (
+				hd->u.state64, _gcry_keccak_round_consts_64bit);
+}
+
+static unsigned int
+keccak_absorb_lanes64_avx512(KECCAK_STATE *hd, int pos, const byte *lanes,
+			     unsigned int nlanes, int blocklanes)
+{
+  unsigned int burn = 0;
+  size_t nblks;
+
+  while (nlanes)
+    {
+      if (pos == 0 && blocklanes > 0 && nlanes >= (unsigned int)blocklanes)
+	{
+	  nblks = nlanes / blocklanes;
+	  burn = _gcry_keccak_absorb_blocks_avx512 (
+				hd->u.state64, _gcry_keccak_round_consts_64bit,
+				lanes, nblks, blocklanes);
+	  lanes += nblks * blocklanes * 8;
+	  nlanes -= nblks * blocklanes;
+	}
+
+      while (nlanes)
+	{
+	  hd->u.state64[pos] ^= buf_get_le64(lanes);
+	  lanes += 8;
+	  nlanes--;
+
+	  if (++pos == blocklanes)
+	    {
+	      burn = keccak_f1600_state_permute64_avx512(hd);
+	      pos = 0;
+	      break;
+	    }
+	}
+    }
+
+  return burn;
+}
+
+static const keccak_ops_t keccak_avx512_64_ops =
+{
+  .permute = keccak_f1600_state_permute64_avx512,
+  .absorb = keccak_absorb_lanes64_avx512,
+  .extract = keccak_extract64,
+};
+
+static unsigned int keccak_f1600_state_permute64_avx512_x4(u64 *state)
+{
+  return _gcry_keccak_f1600_state_permute64_avx512_x4 (
+				state, _gcry_keccak_round_consts_64bit);
+}
+
+#endif /* USE_64BIT_AVX512 */
+
+
+/* 64-bit Intel AVX2 implementation for four interleaved states. */
+#ifdef USE_64BIT_AVX2_X4
+
+extern unsigned int
+_gcry_keccak_f1600_state_permute64_avx2_x4(u64 *state, const u64 *rconst)
+  ASM_FUNC_ABI;
+
+static unsigned int keccak_f1600_state_permute64_avx2_x4(u64 *state)
+{
+  return _gcry_keccak_f1600_state_permute64_avx2_x4 (
+				state, _gcry_keccak_round_consts_64bit);
+}
+
+#endif /* USE_64BIT_AVX2_X4 */
+
+
 /* Construct generic 32-bit implementation. */
 #ifdef USE_32BIT
 
@@ -727,6 +856,10 @@ keccak_init (int algo, void *context, unsigned int flags)
   else if (features & HWF_ARM_NEON)
     ctx->ops = &keccak_armv7_neon_64_ops;
 #endif
+#ifdef USE_64BIT_AVX512
+  else if (features & HWF_INTEL_AVX512)
+    ctx->ops = &keccak_avx512_64_ops;
+#endif
 #ifdef USE_64BIT_BMI2
   else if (features & HWF_INTEL_BMI2)
     ctx->ops = &keccak_bmi2_64_ops;
@@ -997,6 +1130,265 @@ keccak_extract (void *context, void *out, size_t outlen)
     _gcry_burn_stack (burn);
 }
 
+/* Hash one message given by IOV and store OUTLEN bytes of the digest
+ * or of the XOF output at OUTBUF.  */
+static void
+keccak_hash_buffer_one (int algo, byte *outbuf, size_t outlen,
+			const gcry_buffer_t *iov)
+{
+  KECCAK_CONTEXT ctx;
+
+  keccak_init (algo, &ctx, 0);
+  keccak_write (&ctx, (const byte *)iov->data + iov->off, iov->len);
+  keccak_final (&ctx);
+  if (ctx.suffix == SHAKE_DELIMITED_SUFFIX)
+    keccak_extract (&ctx, outbuf, outlen);
+  else
+    memcpy (outbuf, keccak_read (&ctx), outlen);
+
+  wipememory (&ctx, sizeof(ctx));
+}
+
+
+#ifdef USE_64BIT_X4
+
+struct keccak_x4_lane
+{
+  const byte *data;	/* Next full input block. */
+  size_t nblks;		/* Input blocks left, including the padded tail. */
+  byte *out;		/* Output position. */
+  size_t outleft;	/* Number of output bytes left to squeeze. */
+  byte tail[1344 / 8];	/* Last input block with padding. */
+};
+
+
+static void
+keccak_x4_lane_start (const KECCAK_CONTEXT *ctx, struct keccak_x4_lane *lane,
+		      u64 *state, unsigned int l, const gcry_buffer_t *iov,
+		      byte *out, size_t outlen)
+{
+  const size_t bsize = ctx->blocksize;
+  const byte *data = (const byte *)iov->data + iov->off;
+  size_t rem = iov->len % bsize;
+  unsigned int i;
+
+  lane->data = data;
+  lane->nblks = iov->len / bsize + 1;
+  lane->out = out;
+  lane->outleft = outlen;
+
+  if (rem)
+    memcpy (lane->tail, data + iov->len - rem, rem);
+  memset (lane->tail + rem, 0, bsize - rem);
+  lane->tail[rem] = ctx->suffix;
+  lane->tail[bsize - 1] |= 0x80;
+
+  for (i = 0; i < 25; i++)
+    state[i * 4 + l] = 0;
+}
+
+
+/* Take lane L out of the interleaved STATE and complete its message
+ * with the single state implementation.  */
+static unsigned int
+keccak_x4_lane_finish (const KECCAK_CONTEXT *ctx,
+		       struct keccak_x4_lane *lane, const u64 *state,
+		       unsigned int l)
+{
+  const unsigned int blocklanes = ctx->blocksize / 8;
+  KECCAK_CONTEXT hd;
+  unsigned int nburn, burn = 0;
+  unsigned int i;
+
+  hd = *ctx;
+  for (i = 0; i < 25; i++)
+    hd.state.u.state64[i] = state[i * 4 + l];
+
+  if (lane->nblks)
+    {
+      if (lane->nblks > 1)
+	{
+	  nburn = hd.ops->absorb(&hd.state, 0, lane->data,
+				 (lane->nblks - 1) * blocklanes, blocklanes);
+	  burn = nburn > burn ? nburn : burn;
+	}
+
+      /* The padded tail block is permuted by keccak_extract. */
+      nburn = hd.ops->absorb(&hd.state, 0, lane->tail, blocklanes, -1);
+      burn = nburn > burn ? nburn : burn;
+    }
+
+  hd.count = 0;
+  keccak_extract (&hd, lane->out, lane->outleft);
+
+  wipememory (&hd, sizeof(hd));
+  return burn;
+}
+
+
+/* Hash NMSGS messages given by IOV with the four-way permutation
+ * function PERMUTE_X4 and store OUTLEN bytes of output for each of
+ * them consecutively at OUTBUF.  CTX gives the algorithm parameters.
+ * Four messages are processed in parallel; whenever a lane has
+ * squeezed all of its output, the next pending message is started in
+ * it.  When less than MIN_LANES lanes are left busy, they are finished
+ * with the single state implementation.  */
+static void
+keccak_hash_buffers_x4 (const KECCAK_CONTEXT *ctx,
+			unsigned int (*permute_x4)(u64 *state),
+			unsigned int min_lanes, byte *outbuf, size_t outlen,
+			const gcry_buffer_t *iov, int nmsgs)
+{
+  const size_t bsize = ctx->blocksize;
+  const unsigned int blocklanes = bsize / 8;
+  struct keccak_x4_lane lanes[4];
+  u64 state[25 * 4];
+  byte lane[8];
+  int active[4];
+  unsigned int nactive = 0;
+  unsigned int nburn, burn = 0;
+  unsigned int l, i;
+  const byte *src;
+  size_t n;
+  int next = 0;
+
+  for (l = 0; l < 4; l++)
+    {
+      active[l] = next < nmsgs;
+      if (active[l])
+	{
+	  keccak_x4_lane_start (ctx, &lanes[l], state, l, &iov[next],
+				outbuf + next * outlen, outlen);
+	  next++;
+	  nactive++;
+	}
+    }
+
+  while (nactive >= min_lanes)
+    {
+      /* Absorb the next input block of each lane. */
+      for (l = 0; l < 4; l++)
+	{
+	  if (!active[l] || !lanes[l].nblks)
+	    continue;
+
+	  if (lanes[l].nblks > 1)
+	    {
+	      src = lanes[l].data;
+	      lanes[l].data += bsize;
+	    }
+	  else
+	    src = lanes[l].tail;
+	  lanes[l].nblks--;
+
+	  for (i = 0; i < blocklanes; i++)
+	    state[i * 4 + l] ^= buf_get_le64(src + i * 8);
+	}
+
+      nburn = permute_x4 (state);
+      burn = nburn > burn ? nburn : burn;
+
+      /* Squeeze the lanes that are done with their input. */
+      for (l = 0; l < 4; l++)
+	{
+	  if (!active[l] || lanes[l].nblks)
+	    continue;
+
+	  n = lanes[l].outleft < bsize ? lanes[l].outleft : bsize;
+	  for (i = 0; i < n / 8; i++)
+	    buf_put_le64(lanes[l].out + i * 8, state[i * 4 + l]);
+	  if (n % 8)
+	    {
+	      buf_put_le64(lane, state[i * 4 + l]);
+	      memcpy (lanes[l].out + i * 8, lane, n % 8);
+	    }
+	  lanes[l].out += n;
+	  lanes[l].outleft -= n;
+
+	  if (lanes[l].outleft)
+	    continue;
+
+	  if (next < nmsgs)
+	    {
+	      keccak_x4_lane_start (ctx, &lanes[l], state, l, &iov[next],
+				    outbuf + next * outlen, outlen);
+	      next++;
+	    }
+	  else
+	    {
+	      active[l] = 0;
+	      nactive--;
+	    }
+	}
+    }
+
+  for (l = 0; l < 4; l++)
+    {
+      if (!active[l])
+	continue;
+
+      nburn = keccak_x4_lane_finish (ctx, &lanes[l], state, l);
+      burn = nburn > burn ? nburn : burn;
+    }
+
+  wipememory (lanes, sizeof(lanes));
+  wipememory (state, sizeof(state));
+  wipememory (lane, sizeof(lane));
+  if (burn)
+    _gcry_burn_stack (burn);
+}
+
+#endif /* USE_64BIT_X4 */
+
+
+/* Shortcut function which hashes NMSGS independent messages given by
+ * IOV with the SHA-3 or SHAKE algorithm ALGO and stores OUTLEN bytes
+ * of output for each message consecutively at OUTBUF.  For the SHA-3
+ * algorithms OUTLEN must be the digest length. */
+void
+_gcry_keccak_hash_buffers_multi (int algo, void *outbuf, size_t outlen,
+				 const gcry_buffer_t *iov, int nmsgs)
+{
+  byte *out = outbuf;
+
+#ifdef USE_64BIT_X4
+  unsigned int features = _gcry_get_hw_features ();
+  unsigned int (*permute_x4)(u64 *state) = NULL;
+  unsigned int min_lanes = 0;
+
+  /* MIN_LANES is the number of busy lanes at which the four-way code
+   * is still faster than hashing the messages one by one.  */
+  if (0) {}
+#ifdef USE_64BIT_AVX512
+  else if (features & HWF_INTEL_AVX512)
+    {
+      permute_x4 = keccak_f1600_state_permute64_avx512_x4;
+      min_lanes = 2;
+    }
+#endif
+#ifdef USE_64BIT_AVX2_X4
+  else if (features & HWF_INTEL_AVX2)
+    {
+      permute_x4 = keccak_f1600_state_permute64_avx2_x4;
+      min_lanes = 3;
+    }
+#endif
+
+  if (permute_x4 && (unsigned int)nmsgs >= min_lanes)
+    {
+      KECCAK_CONTEXT ctx;
+
+      keccak_init (algo, &ctx, 0);
+      keccak_hash_buffers_x4 (&ctx, permute_x4, min_lanes, out, outlen,
+			      iov, nmsgs);
+      return;
+    }
+#endif
+
+  for (; nmsgs > 0; iov++, nmsgs--, out += outlen)
+    keccak_hash_buffer_one (algo, out, outlen, iov);
+}
+
 
 
 /*
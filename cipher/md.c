@@ -94,6 +94,8 @@ static gcry_md_spec_t *digest_list[] =
      &_gcry_digest_spec_blake2s_224,
      &_gcry_digest_spec_blake2s_160,
      &_gcry_digest_spec_blake2s_128,
+     &_gcry_digest_spec_blake2bp_512,
+     &_gcry_digest_spec_blake2sp_256,
 #endif
      NULL
   };
@@ -709,6 +711,8 @@ md_setkey (gcry_md_hd_t h, const unsigned char *key, size_t keylen)
 	case GCRY_MD_BLAKE2S_224:
 	case GCRY_MD_BLAKE2S_160:
 	case GCRY_MD_BLAKE2S_128:
+	case GCRY_MD_BLAKE2BP_512:
+	case GCRY_MD_BLAKE2SP_256:
 	  algo_had_setkey = 1;
 	  memset (r->context.c, 0, r->spec->contextsize);
 	  rc = _gcry_blake2_init_with_key (r->context.c,
@@ -786,6 +790,7 @@ prepare_macpads (gcry_md_hd_t a, const unsigned char *key, size_t keylen)
         case GCRY_MD_BLAKE2B_384:
         case GCRY_MD_BLAKE2B_256:
         case GCRY_MD_BLAKE2B_160:
+        case GCRY_MD_BLAKE2BP_512:
           macpad_Bsize = 128;
           break;
         case GCRY_MD_GOSTR3411_94:
@@ -1171,6 +1176,110 @@ _gcry_md_hash_buffers (int algo, unsigned int flags, void *digest,
 }
 
 
+/* Shortcut function to hash NMSGS independent messages.  Each item
+   of the array IOV is one complete message.  The NMSGS digests are
+   stored consecutively at DIGESTS which must have been provided by
+   the caller with a length of NMSGS times the digest length of ALGO.
+   For some algorithms several messages are processed in parallel.
+   FLAGS is reserved and must be 0.  */
+gpg_err_code_t
+_gcry_md_hash_buffers_multi (int algo, unsigned int flags, void *digests,
+                             const gcry_buffer_t *iov, int nmsgs)
+{
+  unsigned char *out = digests;
+  gpg_err_code_t rc;
+  int dlen;
+
+  if (!iov || nmsgs < 0)
+    return GPG_ERR_INV_ARG;
+  if (flags)
+    return GPG_ERR_INV_ARG;
+
+  if (0)
+    ;
+#if USE_SHA256
+  else if (algo == GCRY_MD_SHA256)
+    _gcry_sha256_hash_buffers_multi (digests, iov, nmsgs);
+  else if (algo == GCRY_MD_SHA224)
+    _gcry_sha224_hash_buffers_multi (digests, iov, nmsgs);
+#endif
+#if USE_SHA1
+  else if (algo == GCRY_MD_SHA1)
+    _gcry_sha1_hash_buffers_multi (digests, iov, nmsgs);
+#endif
+#if USE_SHA3
+  else if (algo == GCRY_MD_SHA3_224 || algo == GCRY_MD_SHA3_256
+           || algo == GCRY_MD_SHA3_384 || algo == GCRY_MD_SHA3_512)
+    _gcry_keccak_hash_buffers_multi (algo, digests, md_digest_length (algo),
+                                     iov, nmsgs);
+#endif
+  else
+    {
+      dlen = md_digest_length (algo);
+      if (!dlen)
+        return GPG_ERR_DIGEST_ALGO;
+
+      for (; nmsgs > 0; iov++, nmsgs--, out += dlen)
+        {
+          rc = _gcry_md_hash_buffers (algo, 0, out, iov, 1);
+          if (rc)
+            return rc;
+        }
+    }
+
+  return 0;
+}
+
+
+/* Shortcut function to compute OUTLEN bytes of output of the XOF
+ * algorithm ALGO for NMSGS independent messages.  Each item of IOV
+ * describes one message; the outputs are stored consecutively at
+ * OUTPUTS which must have a size of NMSGS * OUTLEN bytes.  FLAGS must
+ * be 0.  */
+gpg_err_code_t
+_gcry_md_hash_buffers_extract_multi (int algo, unsigned int flags,
+                                     void *outputs, size_t outlen,
+                                     const gcry_buffer_t *iov, int nmsgs)
+{
+  unsigned char *out = outputs;
+  gcry_md_spec_t *spec;
+  gcry_md_hd_t hd;
+  gpg_err_code_t rc;
+
+  if (!iov || nmsgs < 0)
+    return GPG_ERR_INV_ARG;
+  if (flags)
+    return GPG_ERR_INV_ARG;
+
+  spec = spec_from_algo (algo);
+  if (!spec || !spec->extract)
+    return GPG_ERR_DIGEST_ALGO;
+
+  if (0)
+    ;
+#if USE_SHA3
+  else if (algo == GCRY_MD_SHAKE128 || algo == GCRY_MD_SHAKE256)
+    _gcry_keccak_hash_buffers_multi (algo, outputs, outlen, iov, nmsgs);
+#endif
+  else
+    {
+      for (; nmsgs > 0; iov++, nmsgs--, out += outlen)
+        {
+          rc = _gcry_md_open (&hd, algo, 0);
+          if (rc)
+            return rc;
+          _gcry_md_write (hd, (const char*)iov->data + iov->off, iov->len);
+          rc = _gcry_md_extract (hd, algo, out, outlen);
+          _gcry_md_close (hd);
+          if (rc)
+            return rc;
+        }
+    }
+
+  return 0;
+}
+
+
 static int
 md_get_algo (gcry_md_hd_t a)
 {
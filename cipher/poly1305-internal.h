@@ -71,6 +71,21 @@
 #endif
 
 
+/* POLY1305_USE_AMD64 indicates whether to compile with AMD64 scalar code.
+ * This implementation is only used together with the stitched
+ * ChaCha20-Poly1305 code, which updates its state directly. */
+#undef POLY1305_USE_AMD64
+#if defined(__x86_64__) && (defined(HAVE_COMPATIBLE_GCC_AMD64_PLATFORM_AS) || \
+    defined(HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS)) && \
+    defined(ENABLE_AVX2_SUPPORT)
+# define POLY1305_USE_AMD64 1
+# define POLY1305_AMD64_BLOCKSIZE 16
+# define POLY1305_AMD64_STATESIZE 56
+# define POLY1305_AMD64_ALIGNMENT 8
+# define POLY1305_SYSV_FUNC_ABI 1
+#endif
+
+
 /* POLY1305_USE_NEON indicates whether to enable ARM NEON assembly code. */
 #undef POLY1305_USE_NEON
 #if defined(ENABLE_NEON_SUPPORT) && defined(HAVE_ARM_ARCH_V6) && \
@@ -163,5 +178,11 @@ void _gcry_poly1305_finish (poly1305_context_t * ctx,
 void _gcry_poly1305_update (poly1305_context_t * ctx, const byte * buf,
 			    size_t buflen);
 
+gcry_err_code_t _gcry_poly1305_init_stitched (poly1305_context_t * ctx,
+					      const byte * key,
+					      size_t keylen);
+
+void *_gcry_poly1305_stitched_state (poly1305_context_t * ctx);
+
 
 #endif /* G10_POLY1305_INTERNAL_H */
@@ -95,6 +95,26 @@ static const poly1305_ops_t poly1305_amd64_avx2_ops = {
 #endif
 
 
+#ifdef POLY1305_USE_AMD64
+
+void _gcry_poly1305_amd64_init_ext(void *state, const poly1305_key_t *key)
+                                  OPS_FUNC_ABI;
+unsigned int _gcry_poly1305_amd64_finish_ext(void *state, const byte *m,
+					     size_t remaining,
+					     byte mac[16]) OPS_FUNC_ABI;
+unsigned int _gcry_poly1305_amd64_blocks(void *ctx, const byte *m,
+					 size_t bytes) OPS_FUNC_ABI;
+
+static const poly1305_ops_t poly1305_amd64_ops = {
+  POLY1305_AMD64_BLOCKSIZE,
+  _gcry_poly1305_amd64_init_ext,
+  _gcry_poly1305_amd64_blocks,
+  _gcry_poly1305_amd64_finish_ext
+};
+
+#endif
+
+
 #ifdef POLY1305_USE_NEON
 
 void _gcry_poly1305_armv7_neon_init_ext(void *state, const poly1305_key_t *key)
@@ -452,9 +472,9 @@ _gcry_poly1305_finish (poly1305_context_t * ctx, byte mac[POLY1305_TAGLEN])
 }
 
 
-gcry_err_code_t
-_gcry_poly1305_init (poly1305_context_t * ctx, const byte * key,
-		     size_t keylen)
+static gcry_err_code_t
+poly1305_do_init (poly1305_context_t * ctx, const byte * key,
+		  size_t keylen, int stitched)
 {
   static int initialized;
   static const char *selftest_failed;
@@ -488,8 +508,13 @@ _gcry_poly1305_init (poly1305_context_t * ctx, const byte * key,
 #ifdef POLY1305_USE_NEON
   if (features & HWF_ARM_NEON)
     ctx->ops = &poly1305_armv7_neon_ops;
+#endif
+#ifdef POLY1305_USE_AMD64
+  if (stitched && (features & HWF_INTEL_AVX2))
+    ctx->ops = &poly1305_amd64_ops;
 #endif
   (void)features;
+  (void)stitched;
 
   buf_cpy (keytmp.b, key, POLY1305_KEYLEN);
   poly1305_init (ctx, &keytmp);
@@ -500,15 +525,50 @@ _gcry_poly1305_init (poly1305_context_t * ctx, const byte * key,
 }
 
 
+gcry_err_code_t
+_gcry_poly1305_init (poly1305_context_t * ctx, const byte * key,
+		     size_t keylen)
+{
+  return poly1305_do_init (ctx, key, keylen, 0);
+}
+
+
+/* Same as _gcry_poly1305_init but prefer an implementation whose state
+   can be updated directly by a stitched cipher implementation; see
+   _gcry_poly1305_stitched_state.  */
+gcry_err_code_t
+_gcry_poly1305_init_stitched (poly1305_context_t * ctx, const byte * key,
+			      size_t keylen)
+{
+  return poly1305_do_init (ctx, key, keylen, 1);
+}
+
+
+/* Return the state of CTX in the layout of poly1305-amd64.S if that
+   implementation is in use and there are no buffered bytes, so that
+   the caller may process whole blocks with its own code.  Returns
+   NULL otherwise.  */
+void *
+_gcry_poly1305_stitched_state (poly1305_context_t * ctx)
+{
+#ifdef POLY1305_USE_AMD64
+  if (ctx->ops == &poly1305_amd64_ops && !ctx->leftover)
+    return poly1305_get_state (ctx);
+#endif
+  (void)ctx;
+  return NULL;
+}
+
+
 static void
 poly1305_auth (byte mac[POLY1305_TAGLEN], const byte * m, size_t bytes,
-	       const byte * key)
+	       const byte * key, int stitched)
 {
   poly1305_context_t ctx;
 
   memset (&ctx, 0, sizeof (ctx));
 
-  _gcry_poly1305_init (&ctx, key, POLY1305_KEYLEN);
+  poly1305_do_init (&ctx, key, POLY1305_KEYLEN, stitched);
   _gcry_poly1305_update (&ctx, m, bytes);
   _gcry_poly1305_finish (&ctx, mac);
 
@@ -517,7 +577,7 @@ poly1305_auth (byte mac[POLY1305_TAGLEN], const byte * m, size_t bytes,
 
 
 static const char *
-selftest (void)
+selftest_one (int stitched)
 {
   /* example from nacl */
   static const byte nacl_key[POLY1305_KEYLEN] = {
@@ -596,14 +656,14 @@ selftest (void)
   memset (&total_ctx, 0, sizeof (total_ctx));
 
   memset (mac, 0, sizeof (mac));
-  poly1305_auth (mac, nacl_msg, sizeof (nacl_msg), nacl_key);
+  poly1305_auth (mac, nacl_msg, sizeof (nacl_msg), nacl_key, stitched);
   if (memcmp (nacl_mac, mac, sizeof (nacl_mac)) != 0)
     return "Poly1305 test 1 failed.";
 
   /* SSE2/AVX have a 32 byte block size, but also support 64 byte blocks, so
    * make sure everything still works varying between them */
   memset (mac, 0, sizeof (mac));
-  _gcry_poly1305_init (&ctx, nacl_key, POLY1305_KEYLEN);
+  poly1305_do_init (&ctx, nacl_key, POLY1305_KEYLEN, stitched);
   _gcry_poly1305_update (&ctx, nacl_msg + 0, 32);
   _gcry_poly1305_update (&ctx, nacl_msg + 32, 64);
   _gcry_poly1305_update (&ctx, nacl_msg + 96, 16);
@@ -620,11 +680,11 @@ selftest (void)
     return "Poly1305 test 2 failed.";
 
   memset (mac, 0, sizeof (mac));
-  poly1305_auth (mac, wrap_msg, sizeof (wrap_msg), wrap_key);
+  poly1305_auth (mac, wrap_msg, sizeof (wrap_msg), wrap_key, stitched);
   if (memcmp (wrap_mac, mac, sizeof (nacl_mac)) != 0)
     return "Poly1305 test 3 failed.";
 
-  _gcry_poly1305_init (&total_ctx, total_key, POLY1305_KEYLEN);
+  poly1305_do_init (&total_ctx, total_key, POLY1305_KEYLEN, stitched);
   for (i = 0; i < 256; i++)
     {
       /* set key and message to 'i,i,i..' */
@@ -632,7 +692,7 @@ selftest (void)
 	all_key[j] = i;
       for (j = 0; j < i; j++)
 	all_msg[j] = i;
-      poly1305_auth (mac, all_msg, i, all_key);
+      poly1305_auth (mac, all_msg, i, all_key, stitched);
       _gcry_poly1305_update (&total_ctx, mac, 16);
     }
   _gcry_poly1305_finish (&total_ctx, mac);
@@ -641,3 +701,15 @@ selftest (void)
 
   return NULL;
 }
+
+
+static const char *
+selftest (void)
+{
+  const char *r;
+
+  r = selftest_one (0);
+  if (!r)
+    r = selftest_one (1);
+  return r;
+}
@@ -33,6 +33,11 @@
 static gcry_mpi_t gen_prime (unsigned int nbits, int secret, int randomlevel,
                              int (*extra_check)(void *, gcry_mpi_t),
                              void *extra_check_arg);
+static gcry_mpi_t gen_prime_parallel (unsigned int nbits, int secret,
+                                      int randomlevel,
+                                      int (*extra_check)(void *, gcry_mpi_t),
+                                      void *extra_check_arg,
+                                      unsigned int nworkers);
 static int check_prime( gcry_mpi_t prime, gcry_mpi_t val_2, int rm_rounds,
                         gcry_prime_check_func_t cb_func, void *cb_arg );
 static int is_prime (gcry_mpi_t n, int steps, unsigned int *count);
@@ -125,7 +130,6 @@ static ushort small_prime_numbers[] = {
     4957, 4967, 4969, 4973, 4987, 4993, 4999,
     0
 };
-static int no_of_small_prime_numbers = DIM (small_prime_numbers) - 1;
 
 
 
@@ -143,11 +147,33 @@ struct primepool_s *primepool;
 GPGRT_LOCK_DEFINE (primepool_lock);
 
 
+/* The odd primes below 2^16 used by gen_prime to sieve the
+   candidates, terminated by a zero.  There are 6541 of them.  */
+static ushort sieve_primes[6542];
+
+
 gcry_err_code_t
 _gcry_primegen_init (void)
 {
+  /* Bit I of COMPOSITE is set if 2I+1 is not a prime.  */
+  unsigned char composite[65536 / 16];
+  unsigned int i, j, n;
+
   /* This function was formerly used to initialize the primepool
-     Mutex. This has been replace by a static initialization.  */
+     Mutex. This has been replace by a static initialization.  Now it
+     sets up the table of sieve primes.  */
+  if (sieve_primes[0])
+    return 0;
+
+  memset (composite, 0, sizeof composite);
+  for (i = 1; i < 128; i++)
+    if (!(composite[i / 8] & (1 << (i % 8))))
+      for (j = (2*i + 1) * (2*i + 1) / 2; j < 65536 / 2; j += 2*i + 1)
+        composite[j / 8] |= 1 << (j % 8);
+  for (i = 1, n = 0; i < 65536 / 2; i++)
+    if (!(composite[i / 8] & (1 << (i % 8))))
+      sieve_primes[n++] = 2*i + 1;
+  gcry_assert (n == DIM (sieve_primes) - 1);
   return 0;
 }
 
@@ -259,6 +285,24 @@ _gcry_generate_secret_prime (unsigned int nbits,
 }
 
 
+/* Same as _gcry_generate_secret_prime but search with NWORKERS
+   threads at once.  */
+gcry_mpi_t
+_gcry_generate_secret_prime_parallel (unsigned int nbits,
+                                      gcry_random_level_t random_level,
+                                      int (*extra_check)(void*, gcry_mpi_t),
+                                      void *extra_check_arg,
+                                      unsigned int nworkers)
+{
+  gcry_mpi_t prime;
+
+  prime = gen_prime_parallel (nbits, 1, random_level,
+                              extra_check, extra_check_arg, nworkers);
+  progress('\n');
+  return prime;
+}
+
+
 /* Generate a prime number which may be public, i.e. not allocated in
    secure memory.  */
 gcry_mpi_t
@@ -742,38 +786,67 @@ _gcry_generate_elg_prime (int mode, unsigned pbits, unsigned qbits,
 }
 
 
-static gcry_mpi_t
-gen_prime (unsigned int nbits, int secret, int randomlevel,
-           int (*extra_check)(void *, gcry_mpi_t), void *extra_check_arg)
+/* The number of odd candidates gen_prime sieves and tests for each
+   random start value.  */
+#define PRIME_SIEVE_SIZE 10000
+
+/* The state shared by the workers of gen_prime.  */
+struct gen_prime_s
 {
-  gcry_mpi_t prime, ptest, pminus1, val_2, val_3, result;
-  int i;
-  unsigned int x, step;
-  unsigned int count1, count2;
-  int *mods;
+  unsigned int nbits;
+  int secret;
+  int randomlevel;
+  int (*extra_check)(void *, gcry_mpi_t);
+  void *extra_check_arg;
+  gpgrt_lock_t lock;            /* Protects RESULT.  */
+  gcry_mpi_t result;            /* The first prime found or NULL.  */
+};
 
-/*   if (  DBG_CIPHER ) */
-/*     log_debug ("generate a prime of %u bits ", nbits ); */
 
-  if (nbits < 16)
-    log_fatal ("can't generate a prime with less than %d bits\n", 16);
+/* Return true if a worker of gen_prime has already found a prime.  */
+static int
+gen_prime_done (struct gen_prime_s *state)
+{
+  int done;
+
+  gpgrt_lock_lock (&state->lock);
+  done = !!state->result;
+  gpgrt_lock_unlock (&state->lock);
+  return done;
+}
+
+
+/* Search for a prime as described by STATE and store it there.  Stop
+   as soon as any worker has found one.  IDX is not used.  */
+static void
+gen_prime_worker (void *arg, unsigned int idx)
+{
+  struct gen_prime_s *state = arg;
+  unsigned int nbits = state->nbits;
+  int secret = state->secret;
+  gcry_mpi_t prime, ptest, pminus1, val_2, result;
+  unsigned char *sieve;
+  unsigned int i, j, x, r, xlimit;
+  unsigned int count2;
+
+  (void)idx;
 
-  mods = (secret? xmalloc_secure (no_of_small_prime_numbers * sizeof *mods)
-          /* */ : xmalloc (no_of_small_prime_numbers * sizeof *mods));
-  /* Make nbits fit into gcry_mpi_t implementation. */
+  xlimit = nbits > 17? 65536 : 1u << (nbits - 1);
+
+  sieve = (secret? xmalloc_secure (PRIME_SIEVE_SIZE / 8 + 1)
+           /* */ : xmalloc (PRIME_SIEVE_SIZE / 8 + 1));
   val_2  = mpi_alloc_set_ui( 2 );
-  val_3 = mpi_alloc_set_ui( 3);
   prime  = secret? mpi_snew (nbits): mpi_new (nbits);
   result = mpi_alloc_like( prime );
   pminus1= mpi_alloc_like( prime );
   ptest  = mpi_alloc_like( prime );
-  count1 = count2 = 0;
-  for (;;)
-    {  /* try forvever */
+  count2 = 0;
+  while (!gen_prime_done (state))
+    {
       int dotcount=0;
 
       /* generate a random number */
-      _gcry_mpi_randomize( prime, nbits, randomlevel );
+      _gcry_mpi_randomize( prime, nbits, state->randomlevel );
 
       /* Set high order bit to 1, set low order bit to 1.  If we are
          generating a secret prime we are most probably doing that
@@ -784,26 +857,31 @@ gen_prime (unsigned int nbits, int secret, int randomlevel,
         mpi_set_bit (prime, nbits-2);
       mpi_set_bit(prime, 0);
 
-      /* Calculate all remainders. */
-      for (i=0; (x = small_prime_numbers[i]); i++ )
-        mods[i] = mpi_fdiv_r_ui(NULL, prime, x);
+      /* Mark the candidates prime + 2j which are a multiple of one of
+         the sieve primes.  With r = prime mod x, these are the j with
+         2j = x - r mod x.  Primes which might be a candidate
+         themselves are not used.  */
+      memset (sieve, 0, PRIME_SIEVE_SIZE / 8 + 1);
+      for (i=0; (x = sieve_primes[i]) && x < xlimit; i++ )
+        {
+          r = mpi_fdiv_r_ui (NULL, prime, x);
+          j = r? x - r : 0;
+          if ((j & 1))
+            j += x;
+          for (j /= 2; j < PRIME_SIEVE_SIZE; j += x)
+            sieve[j / 8] |= 1 << (j % 8);
+        }
 
-      /* Now try some primes starting with prime. */
-      for(step=0; step < 20000; step += 2 )
+      /* Now try the remaining candidates starting with prime. */
+      for (j=0; j < PRIME_SIEVE_SIZE; j++)
         {
-          /* Check against all the small primes we have in mods. */
-          count1++;
-          for (i=0; (x = small_prime_numbers[i]); i++ )
-            {
-              while ( mods[i] + step >= x )
-                mods[i] -= x;
-              if ( !(mods[i] + step) )
-                break;
-	    }
-          if ( x )
+          if ((sieve[j / 8] & (1 << (j % 8))))
             continue;   /* Found a multiple of an already known prime. */
 
-          mpi_add_ui( ptest, prime, step );
+          if (gen_prime_done (state))
+            break;
+
+          mpi_add_ui( ptest, prime, 2 * j );
 
           /* Do a fast Fermat test now. */
           count2++;
@@ -821,7 +899,8 @@ gen_prime (unsigned int nbits, int secret, int randomlevel,
                       break; /* Stop loop, continue with a new prime. */
                     }
 
-                  if (extra_check && extra_check (extra_check_arg, ptest))
+                  if (state->extra_check
+                      && state->extra_check (state->extra_check_arg, ptest))
                     {
                       /* The extra check told us that this prime is
                          not of the caller's taste. */
@@ -830,24 +909,73 @@ gen_prime (unsigned int nbits, int secret, int randomlevel,
                   else
                     {
                       /* Got it. */
-                      mpi_free(val_2);
-                      mpi_free(val_3);
-                      mpi_free(result);
-                      mpi_free(pminus1);
-                      mpi_free(prime);
-                      xfree(mods);
-                      return ptest;
+                      gpgrt_lock_lock (&state->lock);
+                      if (!state->result)
+                        {
+                          state->result = ptest;
+                          ptest = NULL;
+                        }
+                      gpgrt_lock_unlock (&state->lock);
+                      break;
                     }
                 }
-	    }
+            }
           if (++dotcount == 10 )
             {
               progress('.');
               dotcount = 0;
-	    }
-	}
+            }
+        }
+      if (!ptest)
+        break;
       progress(':'); /* restart with a new random value */
     }
+
+  wipememory (sieve, PRIME_SIEVE_SIZE / 8 + 1);
+  xfree (sieve);
+  mpi_free(val_2);
+  mpi_free(result);
+  mpi_free(pminus1);
+  mpi_free(prime);
+  mpi_free(ptest);
+}
+
+
+/* Generate a random prime of NBITS.  The search is done by NWORKERS
+   threads at once, which reduces the variance of the time needed.  */
+static gcry_mpi_t
+gen_prime_parallel (unsigned int nbits, int secret, int randomlevel,
+                    int (*extra_check)(void *, gcry_mpi_t),
+                    void *extra_check_arg, unsigned int nworkers)
+{
+  struct gen_prime_s state;
+
+  if (nbits < 16)
+    log_fatal ("can't generate a prime with less than %d bits\n", 16);
+
+  memset (&state, 0, sizeof state);
+  state.nbits = nbits;
+  state.secret = secret;
+  state.randomlevel = randomlevel;
+  state.extra_check = extra_check;
+  state.extra_check_arg = extra_check_arg;
+  if (gpgrt_lock_init (&state.lock))
+    log_fatal ("failed to initialize the prime generation lock\n");
+
+  _gcry_run_workers (nworkers? nworkers : 1, gen_prime_worker, &state);
+
+  gpgrt_lock_destroy (&state.lock);
+  gcry_assert (state.result);
+  return state.result;
+}
+
+
+static gcry_mpi_t
+gen_prime (unsigned int nbits, int secret, int randomlevel,
+           int (*extra_check)(void *, gcry_mpi_t), void *extra_check_arg)
+{
+  return gen_prime_parallel (nbits, secret, randomlevel,
+                             extra_check, extra_check_arg, 1);
 }
 
 /****************
@@ -139,6 +139,8 @@ _gcry_pk_util_parse_flaglist (gcry_sexp_t list,
         case 8:
           if (!memcmp (s, "use-x931", 8))
             flags |= PUBKEY_FLAG_USE_X931;
+          else if (!memcmp (s, "parallel", 8))
+            flags |= PUBKEY_FLAG_PARALLEL;
           else if (!igninvflag)
             rc = GPG_ERR_INV_FLAG;
           break;
@@ -466,6 +466,216 @@ _gcry_pk_verify (gcry_sexp_t s_sig, gcry_sexp_t s_hash, gcry_sexp_t s_pkey)
 }
 
 
+/*
+   Verify a batch of signatures.
+
+   This is the same as calling gcry_pk_verify for each of the N
+   triples S_SIGS[i], S_HASHES[i] and S_PKEYS[i], but algorithms which
+   support it check all their signatures at once.  If R_ERRS is not
+   NULL the result of each verification is stored there.
+
+   Returns: 0 if all signatures are good or the error code of the
+            first signature which failed.  */
+gcry_err_code_t
+_gcry_pk_verify_batch (gcry_sexp_t *s_sigs, gcry_sexp_t *s_hashes,
+                       gcry_sexp_t *s_pkeys, size_t n, gcry_error_t *r_errs)
+{
+  gcry_err_code_t rc;
+  gcry_pk_spec_t **specs = NULL;
+  gcry_sexp_t *keyparms = NULL;
+  gcry_sexp_t *sub_sigs = NULL;
+  gcry_sexp_t *sub_hashes = NULL;
+  gcry_sexp_t *sub_keyparms = NULL;
+  gcry_err_code_t *sub_rcs = NULL;
+  gcry_err_code_t *rcs = NULL;
+  size_t *sub_idx = NULL;
+  size_t i, j, m;
+
+  if (!n)
+    return 0;
+
+  specs = xtrycalloc (n, sizeof *specs);
+  keyparms = xtrycalloc (n, sizeof *keyparms);
+  rcs = xtrycalloc (n, sizeof *rcs);
+  sub_sigs = xtrycalloc (n, sizeof *sub_sigs);
+  sub_hashes = xtrycalloc (n, sizeof *sub_hashes);
+  sub_keyparms = xtrycalloc (n, sizeof *sub_keyparms);
+  sub_rcs = xtrycalloc (n, sizeof *sub_rcs);
+  sub_idx = xtrycalloc (n, sizeof *sub_idx);
+  if (!specs || !keyparms || !rcs || !sub_sigs || !sub_hashes
+      || !sub_keyparms || !sub_rcs || !sub_idx)
+    {
+      rc = gpg_err_code_from_syserror ();
+      goto leave;
+    }
+
+  for (i = 0; i < n; i++)
+    rcs[i] = spec_from_sexp (s_pkeys[i], 0, &specs[i], &keyparms[i]);
+
+  /* Hand all the signatures of an algorithm with batch support to
+     its verify_batch function.  SPECS[i] is cleared once the
+     signature has been checked.  */
+  for (i = 0; i < n; i++)
+    {
+      gcry_pk_spec_t *spec = specs[i];
+
+      if (rcs[i] || !spec)
+        continue;
+
+      if (!spec->verify_batch)
+        {
+          if (spec->verify)
+            rcs[i] = spec->verify (s_sigs[i], s_hashes[i], keyparms[i]);
+          else
+            rcs[i] = GPG_ERR_NOT_IMPLEMENTED;
+          continue;
+        }
+
+      for (j = i, m = 0; j < n; j++)
+        if (!rcs[j] && specs[j] == spec)
+          {
+            sub_sigs[m] = s_sigs[j];
+            sub_hashes[m] = s_hashes[j];
+            sub_keyparms[m] = keyparms[j];
+            sub_idx[m++] = j;
+            specs[j] = NULL;
+          }
+      rc = spec->verify_batch (sub_sigs, sub_hashes, sub_keyparms, m,
+                               sub_rcs);
+      if (rc)
+        goto leave;
+      for (j = 0; j < m; j++)
+        rcs[sub_idx[j]] = sub_rcs[j];
+    }
+
+  rc = 0;
+  for (i = 0; i < n; i++)
+    {
+      if (!rc)
+        rc = rcs[i];
+      if (r_errs)
+        r_errs[i] = gpg_error (rcs[i]);
+    }
+
+ leave:
+  if (keyparms)
+    for (i = 0; i < n; i++)
+      sexp_release (keyparms[i]);
+  xfree (sub_idx);
+  xfree (sub_rcs);
+  xfree (sub_keyparms);
+  xfree (sub_hashes);
+  xfree (sub_sigs);
+  xfree (rcs);
+  xfree (keyparms);
+  xfree (specs);
+  return rc;
+}
+
+
+/* The private part of a context of type CONTEXT_TYPE_PK_KEY.  */
+typedef struct
+{
+  gcry_pk_spec_t *spec;         /* The algorithm of the key.  */
+  void *key;                    /* The key as prepared by SPEC.  */
+} pk_prepared_key_t;
+
+
+static void
+prepared_key_deinit (void *ptr)
+{
+  pk_prepared_key_t *pk = ptr;
+
+  if (pk->key)
+    pk->spec->release_prepared (pk->key);
+}
+
+
+/*
+   Prepare the secret key S_SKEY for use with _gcry_pk_sign_prepared
+   and _gcry_pk_decrypt_prepared.
+
+   The key is parsed only once and the values derived from it are
+   kept in the context stored at R_CTX, which may then be used by
+   several threads at the same time.  */
+gcry_err_code_t
+_gcry_pk_prepare_key (gcry_ctx_t *r_ctx, gcry_sexp_t s_skey)
+{
+  gcry_err_code_t rc;
+  gcry_pk_spec_t *spec;
+  gcry_sexp_t keyparms;
+  gcry_ctx_t ctx;
+  pk_prepared_key_t *pk;
+
+  *r_ctx = NULL;
+
+  rc = spec_from_sexp (s_skey, 1, &spec, &keyparms);
+  if (rc)
+    goto leave;
+
+  if (!spec->prepare)
+    {
+      rc = GPG_ERR_NOT_IMPLEMENTED;
+      goto leave;
+    }
+
+  ctx = _gcry_ctx_alloc (CONTEXT_TYPE_PK_KEY, sizeof *pk,
+                         prepared_key_deinit);
+  if (!ctx)
+    {
+      rc = gpg_err_code_from_syserror ();
+      goto leave;
+    }
+  pk = _gcry_ctx_get_pointer (ctx, CONTEXT_TYPE_PK_KEY);
+  pk->spec = spec;
+  rc = spec->prepare (&pk->key, keyparms);
+  if (rc)
+    _gcry_ctx_release (ctx);
+  else
+    *r_ctx = ctx;
+
+ leave:
+  sexp_release (keyparms);
+  return rc;
+}
+
+
+/* Same as _gcry_pk_decrypt but with a key prepared by
+   _gcry_pk_prepare_key.  */
+gcry_err_code_t
+_gcry_pk_decrypt_prepared (gcry_sexp_t *r_plain, gcry_sexp_t s_data,
+                           gcry_ctx_t ctx)
+{
+  pk_prepared_key_t *pk = _gcry_ctx_find_pointer (ctx, CONTEXT_TYPE_PK_KEY);
+
+  *r_plain = NULL;
+
+  if (!pk)
+    return GPG_ERR_INV_ARG;
+  if (!pk->spec->decrypt_prepared)
+    return GPG_ERR_NOT_IMPLEMENTED;
+  return pk->spec->decrypt_prepared (r_plain, s_data, pk->key);
+}
+
+
+/* Same as _gcry_pk_sign but with a key prepared by
+   _gcry_pk_prepare_key.  */
+gcry_err_code_t
+_gcry_pk_sign_prepared (gcry_sexp_t *r_sig, gcry_sexp_t s_hash,
+                        gcry_ctx_t ctx)
+{
+  pk_prepared_key_t *pk = _gcry_ctx_find_pointer (ctx, CONTEXT_TYPE_PK_KEY);
+
+  *r_sig = NULL;
+
+  if (!pk)
+    return GPG_ERR_INV_ARG;
+  if (!pk->spec->sign_prepared)
+    return GPG_ERR_NOT_IMPLEMENTED;
+  return pk->spec->sign_prepared (r_sig, s_hash, pk->key);
+}
+
+
 /*
    Test a key.
 
@@ -93,6 +93,56 @@ typedef struct u128_s
    } while (0)
 #endif
 
+/* Two further macros for code paths which also use the XMM7 to XMM15
+   registers.  These are only available on AMD64.  */
+#ifdef __x86_64__
+# ifdef __WIN64__
+#  define aesni_prepare_7_15_variable char win64tmp7_15[16 * 9]
+#  define aesni_prepare_7_15()                                          \
+   do { asm volatile ("movdqu %%xmm7,  0*16(%0)\n\t"                    \
+                      "movdqu %%xmm8,  1*16(%0)\n\t"                    \
+                      "movdqu %%xmm9,  2*16(%0)\n\t"                    \
+                      "movdqu %%xmm10, 3*16(%0)\n\t"                    \
+                      "movdqu %%xmm11, 4*16(%0)\n\t"                    \
+                      "movdqu %%xmm12, 5*16(%0)\n\t"                    \
+                      "movdqu %%xmm13, 6*16(%0)\n\t"                    \
+                      "movdqu %%xmm14, 7*16(%0)\n\t"                    \
+                      "movdqu %%xmm15, 8*16(%0)\n\t"                    \
+                      :                                                 \
+                      : "r" (win64tmp7_15)                              \
+                      : "memory");                                      \
+   } while (0)
+#  define aesni_cleanup_7_15()                                          \
+   do { asm volatile ("movdqu 0*16(%0), %%xmm7\n\t"                     \
+                      "movdqu 1*16(%0), %%xmm8\n\t"                     \
+                      "movdqu 2*16(%0), %%xmm9\n\t"                     \
+                      "movdqu 3*16(%0), %%xmm10\n\t"                    \
+                      "movdqu 4*16(%0), %%xmm11\n\t"                    \
+                      "movdqu 5*16(%0), %%xmm12\n\t"                    \
+                      "movdqu 6*16(%0), %%xmm13\n\t"                    \
+                      "movdqu 7*16(%0), %%xmm14\n\t"                    \
+                      "movdqu 8*16(%0), %%xmm15\n\t"                    \
+                      :                                                 \
+                      : "r" (win64tmp7_15)                              \
+                      : "memory");                                      \
+   } while (0)
+# else
+#  define aesni_prepare_7_15_variable
+#  define aesni_prepare_7_15() do { } while (0)
+#  define aesni_cleanup_7_15()                                          \
+   do { asm volatile ("pxor %%xmm7, %%xmm7\n\t"                         \
+                      "pxor %%xmm8, %%xmm8\n\t"                         \
+                      "pxor %%xmm9, %%xmm9\n\t"                         \
+                      "pxor %%xmm10, %%xmm10\n\t"                       \
+                      "pxor %%xmm11, %%xmm11\n\t"                       \
+                      "pxor %%xmm12, %%xmm12\n\t"                       \
+                      "pxor %%xmm13, %%xmm13\n\t"                       \
+                      "pxor %%xmm14, %%xmm14\n\t"                       \
+                      "pxor %%xmm15, %%xmm15\n":: );                    \
+   } while (0)
+# endif
+#endif /*__x86_64__*/
+
 void
 _gcry_aes_aesni_do_setkey (RIJNDAEL_context *ctx, const byte *key)
 {
@@ -703,6 +753,379 @@ do_aesni_dec_vec4 (const RIJNDAEL_context *ctx)
 #undef aesdeclast_xmm0_xmm4
 }
 
+#ifdef __x86_64__
+
+/* Encrypt eight blocks using the Intel AES-NI instructions.  Blocks are input
+ * and output through SSE registers xmm1 to xmm4 and xmm8 to xmm11.  */
+static inline void
+do_aesni_enc_vec8 (const RIJNDAEL_context *ctx)
+{
+#define aesenc_xmm0_xmm1         ".byte 0x66, 0x0f, 0x38, 0xdc, 0xc8\n\t"
+#define aesenc_xmm0_xmm2         ".byte 0x66, 0x0f, 0x38, 0xdc, 0xd0\n\t"
+#define aesenc_xmm0_xmm3         ".byte 0x66, 0x0f, 0x38, 0xdc, 0xd8\n\t"
+#define aesenc_xmm0_xmm4         ".byte 0x66, 0x0f, 0x38, 0xdc, 0xe0\n\t"
+#define aesenc_xmm0_xmm8         ".byte 0x66, 0x44, 0x0f, 0x38, 0xdc, 0xc0\n\t"
+#define aesenc_xmm0_xmm9         ".byte 0x66, 0x44, 0x0f, 0x38, 0xdc, 0xc8\n\t"
+#define aesenc_xmm0_xmm10        ".byte 0x66, 0x44, 0x0f, 0x38, 0xdc, 0xd0\n\t"
+#define aesenc_xmm0_xmm11        ".byte 0x66, 0x44, 0x0f, 0x38, 0xdc, 0xd8\n\t"
+#define aesenclast_xmm0_xmm1     ".byte 0x66, 0x0f, 0x38, 0xdd, 0xc8\n\t"
+#define aesenclast_xmm0_xmm2     ".byte 0x66, 0x0f, 0x38, 0xdd, 0xd0\n\t"
+#define aesenclast_xmm0_xmm3     ".byte 0x66, 0x0f, 0x38, 0xdd, 0xd8\n\t"
+#define aesenclast_xmm0_xmm4     ".byte 0x66, 0x0f, 0x38, 0xdd, 0xe0\n\t"
+#define aesenclast_xmm0_xmm8     ".byte 0x66, 0x44, 0x0f, 0x38, 0xdd, 0xc0\n\t"
+#define aesenclast_xmm0_xmm9     ".byte 0x66, 0x44, 0x0f, 0x38, 0xdd, 0xc8\n\t"
+#define aesenclast_xmm0_xmm10    ".byte 0x66, 0x44, 0x0f, 0x38, 0xdd, 0xd0\n\t"
+#define aesenclast_xmm0_xmm11    ".byte 0x66, 0x44, 0x0f, 0x38, 0xdd, 0xd8\n\t"
+  asm volatile ("movdqa (%[key]), %%xmm0\n\t"
+                "pxor   %%xmm0, %%xmm1\n\t"     /* xmm1 ^= key[0] */
+                "pxor   %%xmm0, %%xmm2\n\t"     /* xmm2 ^= key[0] */
+                "pxor   %%xmm0, %%xmm3\n\t"     /* xmm3 ^= key[0] */
+                "pxor   %%xmm0, %%xmm4\n\t"     /* xmm4 ^= key[0] */
+                "pxor   %%xmm0, %%xmm8\n\t"     /* xmm8 ^= key[0] */
+                "pxor   %%xmm0, %%xmm9\n\t"     /* xmm9 ^= key[0] */
+                "pxor   %%xmm0, %%xmm10\n\t"    /* xmm10 ^= key[0] */
+                "pxor   %%xmm0, %%xmm11\n\t"    /* xmm11 ^= key[0] */
+                "movdqa 0x10(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0x20(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0x30(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0x40(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0x50(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0x60(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0x70(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0x80(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0x90(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0xa0(%[key]), %%xmm0\n\t"
+                "cmpl $10, %[rounds]\n\t"
+                "jz .Lenclast%=\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0xb0(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0xc0(%[key]), %%xmm0\n\t"
+                "cmpl $12, %[rounds]\n\t"
+                "jz .Lenclast%=\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0xd0(%[key]), %%xmm0\n\t"
+                aesenc_xmm0_xmm1
+                aesenc_xmm0_xmm2
+                aesenc_xmm0_xmm3
+                aesenc_xmm0_xmm4
+                aesenc_xmm0_xmm8
+                aesenc_xmm0_xmm9
+                aesenc_xmm0_xmm10
+                aesenc_xmm0_xmm11
+                "movdqa 0xe0(%[key]), %%xmm0\n"
+
+                ".Lenclast%=:\n\t"
+                aesenclast_xmm0_xmm1
+                aesenclast_xmm0_xmm2
+                aesenclast_xmm0_xmm3
+                aesenclast_xmm0_xmm4
+                aesenclast_xmm0_xmm8
+                aesenclast_xmm0_xmm9
+                aesenclast_xmm0_xmm10
+                aesenclast_xmm0_xmm11
+                : /* no output */
+                : [key] "r" (ctx->keyschenc),
+                  [rounds] "r" (ctx->rounds)
+                : "cc", "memory");
+#undef aesenc_xmm0_xmm1
+#undef aesenc_xmm0_xmm2
+#undef aesenc_xmm0_xmm3
+#undef aesenc_xmm0_xmm4
+#undef aesenc_xmm0_xmm8
+#undef aesenc_xmm0_xmm9
+#undef aesenc_xmm0_xmm10
+#undef aesenc_xmm0_xmm11
+#undef aesenclast_xmm0_xmm1
+#undef aesenclast_xmm0_xmm2
+#undef aesenclast_xmm0_xmm3
+#undef aesenclast_xmm0_xmm4
+#undef aesenclast_xmm0_xmm8
+#undef aesenclast_xmm0_xmm9
+#undef aesenclast_xmm0_xmm10
+#undef aesenclast_xmm0_xmm11
+}
+
+
+/* Decrypt eight blocks using the Intel AES-NI instructions.  Blocks are input
+ * and output through SSE registers xmm1 to xmm4 and xmm8 to xmm11.  */
+static inline void
+do_aesni_dec_vec8 (const RIJNDAEL_context *ctx)
+{
+#define aesdec_xmm0_xmm1         ".byte 0x66, 0x0f, 0x38, 0xde, 0xc8\n\t"
+#define aesdec_xmm0_xmm2         ".byte 0x66, 0x0f, 0x38, 0xde, 0xd0\n\t"
+#define aesdec_xmm0_xmm3         ".byte 0x66, 0x0f, 0x38, 0xde, 0xd8\n\t"
+#define aesdec_xmm0_xmm4         ".byte 0x66, 0x0f, 0x38, 0xde, 0xe0\n\t"
+#define aesdec_xmm0_xmm8         ".byte 0x66, 0x44, 0x0f, 0x38, 0xde, 0xc0\n\t"
+#define aesdec_xmm0_xmm9         ".byte 0x66, 0x44, 0x0f, 0x38, 0xde, 0xc8\n\t"
+#define aesdec_xmm0_xmm10        ".byte 0x66, 0x44, 0x0f, 0x38, 0xde, 0xd0\n\t"
+#define aesdec_xmm0_xmm11        ".byte 0x66, 0x44, 0x0f, 0x38, 0xde, 0xd8\n\t"
+#define aesdeclast_xmm0_xmm1     ".byte 0x66, 0x0f, 0x38, 0xdf, 0xc8\n\t"
+#define aesdeclast_xmm0_xmm2     ".byte 0x66, 0x0f, 0x38, 0xdf, 0xd0\n\t"
+#define aesdeclast_xmm0_xmm3     ".byte 0x66, 0x0f, 0x38, 0xdf, 0xd8\n\t"
+#define aesdeclast_xmm0_xmm4     ".byte 0x66, 0x0f, 0x38, 0xdf, 0xe0\n\t"
+#define aesdeclast_xmm0_xmm8     ".byte 0x66, 0x44, 0x0f, 0x38, 0xdf, 0xc0\n\t"
+#define aesdeclast_xmm0_xmm9     ".byte 0x66, 0x44, 0x0f, 0x38, 0xdf, 0xc8\n\t"
+#define aesdeclast_xmm0_xmm10    ".byte 0x66, 0x44, 0x0f, 0x38, 0xdf, 0xd0\n\t"
+#define aesdeclast_xmm0_xmm11    ".byte 0x66, 0x44, 0x0f, 0x38, 0xdf, 0xd8\n\t"
+  asm volatile ("movdqa (%[key]), %%xmm0\n\t"
+                "pxor   %%xmm0, %%xmm1\n\t"     /* xmm1 ^= key[0] */
+                "pxor   %%xmm0, %%xmm2\n\t"     /* xmm2 ^= key[0] */
+                "pxor   %%xmm0, %%xmm3\n\t"     /* xmm3 ^= key[0] */
+                "pxor   %%xmm0, %%xmm4\n\t"     /* xmm4 ^= key[0] */
+                "pxor   %%xmm0, %%xmm8\n\t"     /* xmm8 ^= key[0] */
+                "pxor   %%xmm0, %%xmm9\n\t"     /* xmm9 ^= key[0] */
+                "pxor   %%xmm0, %%xmm10\n\t"    /* xmm10 ^= key[0] */
+                "pxor   %%xmm0, %%xmm11\n\t"    /* xmm11 ^= key[0] */
+                "movdqa 0x10(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0x20(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0x30(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0x40(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0x50(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0x60(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0x70(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0x80(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0x90(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0xa0(%[key]), %%xmm0\n\t"
+                "cmpl $10, %[rounds]\n\t"
+                "jz .Ldeclast%=\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0xb0(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0xc0(%[key]), %%xmm0\n\t"
+                "cmpl $12, %[rounds]\n\t"
+                "jz .Ldeclast%=\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0xd0(%[key]), %%xmm0\n\t"
+                aesdec_xmm0_xmm1
+                aesdec_xmm0_xmm2
+                aesdec_xmm0_xmm3
+                aesdec_xmm0_xmm4
+                aesdec_xmm0_xmm8
+                aesdec_xmm0_xmm9
+                aesdec_xmm0_xmm10
+                aesdec_xmm0_xmm11
+                "movdqa 0xe0(%[key]), %%xmm0\n"
+
+                ".Ldeclast%=:\n\t"
+                aesdeclast_xmm0_xmm1
+                aesdeclast_xmm0_xmm2
+                aesdeclast_xmm0_xmm3
+                aesdeclast_xmm0_xmm4
+                aesdeclast_xmm0_xmm8
+                aesdeclast_xmm0_xmm9
+                aesdeclast_xmm0_xmm10
+                aesdeclast_xmm0_xmm11
+                : /* no output */
+                : [key] "r" (ctx->keyschdec),
+                  [rounds] "r" (ctx->rounds)
+                : "cc", "memory");
+#undef aesdec_xmm0_xmm1
+#undef aesdec_xmm0_xmm2
+#undef aesdec_xmm0_xmm3
+#undef aesdec_xmm0_xmm4
+#undef aesdec_xmm0_xmm8
+#undef aesdec_xmm0_xmm9
+#undef aesdec_xmm0_xmm10
+#undef aesdec_xmm0_xmm11
+#undef aesdeclast_xmm0_xmm1
+#undef aesdeclast_xmm0_xmm2
+#undef aesdeclast_xmm0_xmm3
+#undef aesdeclast_xmm0_xmm4
+#undef aesdeclast_xmm0_xmm8
+#undef aesdeclast_xmm0_xmm9
+#undef aesdeclast_xmm0_xmm10
+#undef aesdeclast_xmm0_xmm11
+}
+
+#endif /*__x86_64__*/
+
 
 /* Perform a CTR encryption round using the counter CTR and the input
    block A.  Write the result to the output block B and update CTR.
@@ -1813,4 +2236,667 @@ _gcry_aes_aesni_ocb_auth (gcry_cipher_hd_t c, const void *abuf_arg,
 }
 
 
+/* Multiply the XTS tweak in XMM5 by the primitive element alpha.  XMM6
+ * holds XTS_GFMUL_CONST and XSHUF the tweak shuffled with PSHUFD $0x13,
+ * so that the sign bits of its two 32-bit lanes 0 and 2 are the carry
+ * bits of the 64-bit halves of the tweak.  XSHUF is advanced along with
+ * the tweak so that several tweaks can be generated from one shuffle.
+ * XMM0 is clobbered.  */
+#define XTS_NEXT_TWEAK(xshuf) \
+		"movdqa %%" #xshuf ", %%xmm0\n\t" \
+		"paddd  %%" #xshuf ", %%" #xshuf "\n\t" \
+		"psrad  $31,       %%xmm0\n\t" \
+		"paddq  %%xmm5,    %%xmm5\n\t" \
+		"pand   %%xmm6,    %%xmm0\n\t" \
+		"pxor   %%xmm0,    %%xmm5\n\t"
+
+/* Load input block BLK to XREG, whiten it with the current tweak, stash
+ * the tweak to the output buffer and advance to the next tweak.  */
+#define XTS_LOAD_BLOCK(blk, xreg, xshuf) \
+		"movdqu " #blk "*16(%[inbuf]), %%" #xreg "\n\t" \
+		"pxor   %%xmm5, %%" #xreg "\n\t" \
+		"movdqu %%xmm5, " #blk "*16(%[outbuf])\n\t" \
+		XTS_NEXT_TWEAK(xshuf)
+
+/* Whiten processed block in XREG with the tweak stashed to the output
+ * buffer by XTS_LOAD_BLOCK and store the result.  */
+#define XTS_STORE_BLOCK(blk, xreg) \
+		"movdqu " #blk "*16(%[outbuf]), %%xmm0\n\t" \
+		"pxor   %%xmm0, %%" #xreg "\n\t" \
+		"movdqu %%" #xreg ", " #blk "*16(%[outbuf])\n\t"
+
+static const byte xts_gfmul_const[16] __attribute__ ((aligned (16))) =
+  { 0x87, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+static void
+aesni_xts_enc (const RIJNDAEL_context *ctx, unsigned char *tweak,
+               unsigned char *outbuf, const unsigned char *inbuf,
+               size_t nblocks)
+{
+  aesni_prepare_2_6_variable;
+
+  aesni_prepare ();
+  aesni_prepare_2_6 ();
+
+  /* Preload Tweak */
+  asm volatile ("movdqu %[tweak], %%xmm5\n\t"
+		"movdqa %[gfmul], %%xmm6\n\t"
+		:
+		: [tweak] "m" (*tweak),
+		  [gfmul] "m" (*xts_gfmul_const)
+		: "memory" );
+
+#ifdef __x86_64__
+  if (nblocks >= 8)
+    {
+      aesni_prepare_7_15_variable;
+
+      aesni_prepare_7_15 ();
+
+      for ( ;nblocks >= 8 ; nblocks -= 8 )
+	{
+	  asm volatile ("pshufd $0x13, %%xmm5, %%xmm7\n\t"
+			XTS_LOAD_BLOCK(0, xmm1, xmm7)
+			XTS_LOAD_BLOCK(1, xmm2, xmm7)
+			XTS_LOAD_BLOCK(2, xmm3, xmm7)
+			XTS_LOAD_BLOCK(3, xmm4, xmm7)
+			XTS_LOAD_BLOCK(4, xmm8, xmm7)
+			XTS_LOAD_BLOCK(5, xmm9, xmm7)
+			XTS_LOAD_BLOCK(6, xmm10, xmm7)
+			XTS_LOAD_BLOCK(7, xmm11, xmm7)
+			:
+			: [inbuf] "r" (inbuf),
+			  [outbuf] "r" (outbuf)
+			: "memory" );
+
+	  do_aesni_enc_vec8 (ctx);
+
+	  asm volatile (XTS_STORE_BLOCK(0, xmm1)
+			XTS_STORE_BLOCK(1, xmm2)
+			XTS_STORE_BLOCK(2, xmm3)
+			XTS_STORE_BLOCK(3, xmm4)
+			XTS_STORE_BLOCK(4, xmm8)
+			XTS_STORE_BLOCK(5, xmm9)
+			XTS_STORE_BLOCK(6, xmm10)
+			XTS_STORE_BLOCK(7, xmm11)
+			:
+			: [outbuf] "r" (outbuf)
+			: "memory" );
+
+	  outbuf += 8*BLOCKSIZE;
+	  inbuf  += 8*BLOCKSIZE;
+	}
+
+      aesni_cleanup_7_15 ();
+    }
+#endif
+
+  for ( ;nblocks >= 4; nblocks -= 4 )
+    {
+      /* XMM4 holds the shuffled tweak until the last block is loaded,
+       * the tweak following the last block is generated afresh.  */
+      asm volatile ("pshufd $0x13, %%xmm5, %%xmm4\n\t"
+		    XTS_LOAD_BLOCK(0, xmm1, xmm4)
+		    XTS_LOAD_BLOCK(1, xmm2, xmm4)
+		    XTS_LOAD_BLOCK(2, xmm3, xmm4)
+		    "movdqu 3*16(%[inbuf]), %%xmm4\n\t"
+		    "pxor   %%xmm5, %%xmm4\n\t"
+		    "movdqu %%xmm5, 3*16(%[outbuf])\n\t"
+		    "pshufd $0x13, %%xmm5, %%xmm0\n\t"
+		    "psrad  $31, %%xmm0\n\t"
+		    "paddq  %%xmm5, %%xmm5\n\t"
+		    "pand   %%xmm6, %%xmm0\n\t"
+		    "pxor   %%xmm0, %%xmm5\n\t"
+		    :
+		    : [inbuf] "r" (inbuf),
+		      [outbuf] "r" (outbuf)
+		    : "memory" );
+
+      do_aesni_enc_vec4 (ctx);
+
+      asm volatile (XTS_STORE_BLOCK(0, xmm1)
+		    XTS_STORE_BLOCK(1, xmm2)
+		    XTS_STORE_BLOCK(2, xmm3)
+		    XTS_STORE_BLOCK(3, xmm4)
+		    :
+		    : [outbuf] "r" (outbuf)
+		    : "memory" );
+
+      outbuf += 4*BLOCKSIZE;
+      inbuf  += 4*BLOCKSIZE;
+    }
+
+  for ( ;nblocks; nblocks-- )
+    {
+      asm volatile ("movdqa %%xmm5,    %%xmm4\n\t"
+		    "pshufd $0x13,     %%xmm5,  %%xmm1\n\t"
+		    XTS_NEXT_TWEAK(xmm1)
+
+		    "movdqu %[inbuf],  %%xmm0\n\t"
+		    "pxor   %%xmm4,    %%xmm0\n\t"
+		    :
+		    : [inbuf] "m" (*inbuf)
+		    : "memory" );
+
+      do_aesni_enc (ctx);
+
+      asm volatile ("pxor   %%xmm4,    %%xmm0\n\t"
+		    "movdqu %%xmm0,    %[outbuf]\n\t"
+		    : [outbuf] "=m" (*outbuf)
+		    :
+		    : "memory" );
+
+      outbuf += BLOCKSIZE;
+      inbuf  += BLOCKSIZE;
+    }
+
+  asm volatile ("movdqu %%xmm5, %[tweak]\n\t"
+		: [tweak] "=m" (*tweak)
+		:
+		: "memory" );
+
+  aesni_cleanup ();
+  aesni_cleanup_2_6 ();
+}
+
+
+static void
+aesni_xts_dec (const RIJNDAEL_context *ctx, unsigned char *tweak,
+               unsigned char *outbuf, const unsigned char *inbuf,
+               size_t nblocks)
+{
+  aesni_prepare_2_6_variable;
+
+  aesni_prepare ();
+  aesni_prepare_2_6 ();
+
+  /* Preload Tweak */
+  asm volatile ("movdqu %[tweak], %%xmm5\n\t"
+		"movdqa %[gfmul], %%xmm6\n\t"
+		:
+		: [tweak] "m" (*tweak),
+		  [gfmul] "m" (*xts_gfmul_const)
+		: "memory" );
+
+#ifdef __x86_64__
+  if (nblocks >= 8)
+    {
+      aesni_prepare_7_15_variable;
+
+      aesni_prepare_7_15 ();
+
+      for ( ;nblocks >= 8 ; nblocks -= 8 )
+	{
+	  asm volatile ("pshufd $0x13, %%xmm5, %%xmm7\n\t"
+			XTS_LOAD_BLOCK(0, xmm1, xmm7)
+			XTS_LOAD_BLOCK(1, xmm2, xmm7)
+			XTS_LOAD_BLOCK(2, xmm3, xmm7)
+			XTS_LOAD_BLOCK(3, xmm4, xmm7)
+			XTS_LOAD_BLOCK(4, xmm8, xmm7)
+			XTS_LOAD_BLOCK(5, xmm9, xmm7)
+			XTS_LOAD_BLOCK(6, xmm10, xmm7)
+			XTS_LOAD_BLOCK(7, xmm11, xmm7)
+			:
+			: [inbuf] "r" (inbuf),
+			  [outbuf] "r" (outbuf)
+			: "memory" );
+
+	  do_aesni_dec_vec8 (ctx);
+
+	  asm volatile (XTS_STORE_BLOCK(0, xmm1)
+			XTS_STORE_BLOCK(1, xmm2)
+			XTS_STORE_BLOCK(2, xmm3)
+			XTS_STORE_BLOCK(3, xmm4)
+			XTS_STORE_BLOCK(4, xmm8)
+			XTS_STORE_BLOCK(5, xmm9)
+			XTS_STORE_BLOCK(6, xmm10)
+			XTS_STORE_BLOCK(7, xmm11)
+			:
+			: [outbuf] "r" (outbuf)
+			: "memory" );
+
+	  outbuf += 8*BLOCKSIZE;
+	  inbuf  += 8*BLOCKSIZE;
+	}
+
+      aesni_cleanup_7_15 ();
+    }
+#endif
+
+  for ( ;nblocks >= 4; nblocks -= 4 )
+    {
+      /* XMM4 holds the shuffled tweak until the last block is loaded,
+       * the tweak following the last block is generated afresh.  */
+      asm volatile ("pshufd $0x13, %%xmm5, %%xmm4\n\t"
+		    XTS_LOAD_BLOCK(0, xmm1, xmm4)
+		    XTS_LOAD_BLOCK(1, xmm2, xmm4)
+		    XTS_LOAD_BLOCK(2, xmm3, xmm4)
+		    "movdqu 3*16(%[inbuf]), %%xmm4\n\t"
+		    "pxor   %%xmm5, %%xmm4\n\t"
+		    "movdqu %%xmm5, 3*16(%[outbuf])\n\t"
+		    "pshufd $0x13, %%xmm5, %%xmm0\n\t"
+		    "psrad  $31, %%xmm0\n\t"
+		    "paddq  %%xmm5, %%xmm5\n\t"
+		    "pand   %%xmm6, %%xmm0\n\t"
+		    "pxor   %%xmm0, %%xmm5\n\t"
+		    :
+		    : [inbuf] "r" (inbuf),
+		      [outbuf] "r" (outbuf)
+		    : "memory" );
+
+      do_aesni_dec_vec4 (ctx);
+
+      asm volatile (XTS_STORE_BLOCK(0, xmm1)
+		    XTS_STORE_BLOCK(1, xmm2)
+		    XTS_STORE_BLOCK(2, xmm3)
+		    XTS_STORE_BLOCK(3, xmm4)
+		    :
+		    : [outbuf] "r" (outbuf)
+		    : "memory" );
+
+      outbuf += 4*BLOCKSIZE;
+      inbuf  += 4*BLOCKSIZE;
+    }
+
+  for ( ;nblocks; nblocks-- )
+    {
+      asm volatile ("movdqa %%xmm5,    %%xmm4\n\t"
+		    "pshufd $0x13,     %%xmm5,  %%xmm1\n\t"
+		    XTS_NEXT_TWEAK(xmm1)
+
+		    "movdqu %[inbuf],  %%xmm0\n\t"
+		    "pxor   %%xmm4,    %%xmm0\n\t"
+		    :
+		    : [inbuf] "m" (*inbuf)
+		    : "memory" );
+
+      do_aesni_dec (ctx);
+
+      asm volatile ("pxor   %%xmm4,    %%xmm0\n\t"
+		    "movdqu %%xmm0,    %[outbuf]\n\t"
+		    : [outbuf] "=m" (*outbuf)
+		    :
+		    : "memory" );
+
+      outbuf += BLOCKSIZE;
+      inbuf  += BLOCKSIZE;
+    }
+
+  asm volatile ("movdqu %%xmm5, %[tweak]\n\t"
+		: [tweak] "=m" (*tweak)
+		:
+		: "memory" );
+
+  aesni_cleanup ();
+  aesni_cleanup_2_6 ();
+}
+
+#undef XTS_NEXT_TWEAK
+#undef XTS_LOAD_BLOCK
+#undef XTS_STORE_BLOCK
+
+
+void
+_gcry_aes_aesni_xts_crypt (RIJNDAEL_context *ctx, unsigned char *tweak,
+			   unsigned char *outbuf, const unsigned char *inbuf,
+			   size_t nblocks, int encrypt)
+{
+  if (encrypt)
+    aesni_xts_enc(ctx, tweak, outbuf, inbuf, nblocks);
+  else
+    aesni_xts_dec(ctx, tweak, outbuf, inbuf, nblocks);
+}
+
+
+#if defined(__x86_64__) && defined(GCM_USE_INTEL_PCLMUL)
+
+#define aesenc_xmm0_xmm1      ".byte 0x66, 0x0f, 0x38, 0xdc, 0xc8\n\t"
+#define aesenc_xmm0_xmm2      ".byte 0x66, 0x0f, 0x38, 0xdc, 0xd0\n\t"
+#define aesenc_xmm0_xmm3      ".byte 0x66, 0x0f, 0x38, 0xdc, 0xd8\n\t"
+#define aesenc_xmm0_xmm4      ".byte 0x66, 0x0f, 0x38, 0xdc, 0xe0\n\t"
+#define aesenclast_xmm0_xmm1  ".byte 0x66, 0x0f, 0x38, 0xdd, 0xc8\n\t"
+#define aesenclast_xmm0_xmm2  ".byte 0x66, 0x0f, 0x38, 0xdd, 0xd0\n\t"
+#define aesenclast_xmm0_xmm3  ".byte 0x66, 0x0f, 0x38, 0xdd, 0xd8\n\t"
+#define aesenclast_xmm0_xmm4  ".byte 0x66, 0x0f, 0x38, 0xdd, 0xe0\n\t"
+
+/* Register usage of the stitched GCM code:
+      xmm0        round key / temp
+      xmm1-xmm4   counter blocks
+      xmm5        counter, little-endian
+      xmm6        GHASH state, little-endian
+      xmm7        endian swapping mask
+      xmm8-xmm10  GHASH low, high and middle accumulators
+      xmm11-xmm12 GHASH temps
+      xmm13       counter increment, le(1)
+      xmm14-xmm15 GHASH temps
+ */
+
+/* Generate four counter blocks to XMM1-XMM4 and whiten them with the
+ * first round key.  Only the low 32 bits of the counter are
+ * incremented as required by GCM.  */
+#define GCM_CTR4_INIT \
+		"movdqa %%xmm5, %%xmm1\n\t" \
+		"paddd  %%xmm13, %%xmm5\n\t" \
+		"movdqa %%xmm5, %%xmm2\n\t" \
+		"paddd  %%xmm13, %%xmm5\n\t" \
+		"movdqa %%xmm5, %%xmm3\n\t" \
+		"paddd  %%xmm13, %%xmm5\n\t" \
+		"movdqa %%xmm5, %%xmm4\n\t" \
+		"paddd  %%xmm13, %%xmm5\n\t" \
+		"pshufb %%xmm7, %%xmm1\n\t" \
+		"pshufb %%xmm7, %%xmm2\n\t" \
+		"pshufb %%xmm7, %%xmm3\n\t" \
+		"pshufb %%xmm7, %%xmm4\n\t" \
+		"movdqa (%[key]), %%xmm0\n\t" \
+		"pxor   %%xmm0, %%xmm1\n\t" \
+		"pxor   %%xmm0, %%xmm2\n\t" \
+		"pxor   %%xmm0, %%xmm3\n\t" \
+		"pxor   %%xmm0, %%xmm4\n\t"
+
+#define GCM_AES_ROUND(off) \
+		"movdqa " #off "(%[key]), %%xmm0\n\t" \
+		aesenc_xmm0_xmm1 \
+		aesenc_xmm0_xmm2 \
+		aesenc_xmm0_xmm3 \
+		aesenc_xmm0_xmm4
+
+/* Remaining rounds for AES-192 and AES-256, final round and the XOR of
+ * the key stream with the input.  */
+#define GCM_AES_LAST_XOR_STORE \
+		"movdqa 0xa0(%[key]), %%xmm0\n\t" \
+		"cmpl $10, %[rounds]\n\t" \
+		"jz .Lenclast%=\n\t" \
+		aesenc_xmm0_xmm1 \
+		aesenc_xmm0_xmm2 \
+		aesenc_xmm0_xmm3 \
+		aesenc_xmm0_xmm4 \
+		GCM_AES_ROUND(0xb0) \
+		"movdqa 0xc0(%[key]), %%xmm0\n\t" \
+		"cmpl $12, %[rounds]\n\t" \
+		"jz .Lenclast%=\n\t" \
+		aesenc_xmm0_xmm1 \
+		aesenc_xmm0_xmm2 \
+		aesenc_xmm0_xmm3 \
+		aesenc_xmm0_xmm4 \
+		GCM_AES_ROUND(0xd0) \
+		"movdqa 0xe0(%[key]), %%xmm0\n" \
+		\
+		".Lenclast%=:\n\t" \
+		aesenclast_xmm0_xmm1 \
+		aesenclast_xmm0_xmm2 \
+		aesenclast_xmm0_xmm3 \
+		aesenclast_xmm0_xmm4 \
+		\
+		"movdqu 0*16(%[inbuf]), %%xmm0\n\t" \
+		"pxor   %%xmm0, %%xmm1\n\t" \
+		"movdqu 1*16(%[inbuf]), %%xmm0\n\t" \
+		"pxor   %%xmm0, %%xmm2\n\t" \
+		"movdqu 2*16(%[inbuf]), %%xmm0\n\t" \
+		"pxor   %%xmm0, %%xmm3\n\t" \
+		"movdqu 3*16(%[inbuf]), %%xmm0\n\t" \
+		"pxor   %%xmm0, %%xmm4\n\t" \
+		"movdqu %%xmm1, 0*16(%[outbuf])\n\t" \
+		"movdqu %%xmm2, 1*16(%[outbuf])\n\t" \
+		"movdqu %%xmm3, 2*16(%[outbuf])\n\t" \
+		"movdqu %%xmm4, 3*16(%[outbuf])\n\t"
+
+/* Load GHASH input block BLK, convert it to little-endian and for the
+ * first block of a batch, add in the current GHASH state.  */
+#define GCM_GHASH_LOAD(blk) \
+		"movdqu " #blk "*16(%[gbuf]), %%xmm11\n\t" \
+		"pshufb %%xmm7, %%xmm11\n\t"
+
+/* Karatsuba multiply XMM11 with HKEY and add (ACCOP pxor) or move
+ * (ACCOP movdqa) the partial products to the accumulators.  */
+#define GCM_GHASH_MUL(hkey, accop) \
+		"movdqu " hkey ", %%xmm12\n\t" \
+		"movdqa %%xmm11, %%xmm14\n\t" \
+		"pshufd $78, %%xmm11, %%xmm15\n\t" \
+		"pclmulqdq $0, %%xmm12, %%xmm14\n\t" \
+		"pxor   %%xmm11, %%xmm15\n\t" \
+		"pclmulqdq $17, %%xmm12, %%xmm11\n\t" \
+		#accop " %%xmm14, %%xmm8\n\t" \
+		"pshufd $78, %%xmm12, %%xmm14\n\t" \
+		#accop " %%xmm11, %%xmm9\n\t" \
+		"pxor   %%xmm12, %%xmm14\n\t" \
+		"pclmulqdq $0, %%xmm14, %%xmm15\n\t" \
+		#accop " %%xmm15, %%xmm10\n\t"
+
+/* Merge the middle product to get the 256-bit product in <XMM9:XMM8>. */
+#define GCM_GHASH_REDUCE_1 \
+		"pxor   %%xmm8, %%xmm10\n\t" \
+		"pxor   %%xmm9, %%xmm10\n\t" \
+		"movdqa %%xmm10, %%xmm11\n\t" \
+		"psrldq $8, %%xmm10\n\t" \
+		"pslldq $8, %%xmm11\n\t" \
+		"pxor   %%xmm11, %%xmm8\n\t" \
+		"pxor   %%xmm10, %%xmm9\n\t"
+
+/* Shift the product left by one bit; the high part goes to XMM6.  */
+#define GCM_GHASH_REDUCE_2 \
+		"movdqa %%xmm8, %%xmm10\n\t" \
+		"movdqa %%xmm9, %%xmm11\n\t" \
+		"pslld  $1, %%xmm8\n\t" \
+		"pslld  $1, %%xmm9\n\t" \
+		"psrld  $31, %%xmm10\n\t" \
+		"psrld  $31, %%xmm11\n\t" \
+		"movdqa %%xmm10, %%xmm6\n\t" \
+		"pslldq $4, %%xmm11\n\t" \
+		"pslldq $4, %%xmm10\n\t" \
+		"psrldq $12, %%xmm6\n\t" \
+		"por    %%xmm10, %%xmm8\n\t" \
+		"por    %%xmm11, %%xmm9\n\t" \
+		"por    %%xmm9, %%xmm6\n\t"
+
+/* First phase of the reduction.  */
+#define GCM_GHASH_REDUCE_3 \
+		"movdqa %%xmm8, %%xmm9\n\t" \
+		"movdqa %%xmm8, %%xmm12\n\t" \
+		"pslld  $31, %%xmm9\n\t" \
+		"movdqa %%xmm8, %%xmm11\n\t" \
+		"pslld  $30, %%xmm12\n\t" \
+		"pslld  $25, %%xmm11\n\t" \
+		"pxor   %%xmm12, %%xmm9\n\t" \
+		"pxor   %%xmm11, %%xmm9\n\t" \
+		"movdqa %%xmm9, %%xmm12\n\t" \
+		"pslldq $12, %%xmm9\n\t" \
+		"psrldq $4, %%xmm12\n\t" \
+		"pxor   %%xmm9, %%xmm8\n\t"
+
+/* Second phase of the reduction, result is added to XMM6.  */
+#define GCM_GHASH_REDUCE_4 \
+		"movdqa %%xmm8, %%xmm14\n\t" \
+		"movdqa %%xmm8, %%xmm10\n\t" \
+		"psrld  $1, %%xmm14\n\t" \
+		"movdqa %%xmm8, %%xmm11\n\t" \
+		"psrld  $2, %%xmm10\n\t" \
+		"psrld  $7, %%xmm11\n\t" \
+		"pxor   %%xmm10, %%xmm14\n\t" \
+		"pxor   %%xmm11, %%xmm14\n\t" \
+		"pxor   %%xmm12, %%xmm14\n\t" \
+		"pxor   %%xmm14, %%xmm8\n\t" \
+		"pxor   %%xmm8, %%xmm6\n\t"
+
+
+/* CTR encrypt four blocks without GHASH.  */
+static inline void
+do_aesni_gcm_ctr_4 (const RIJNDAEL_context *ctx, unsigned char *outbuf,
+                    const unsigned char *inbuf)
+{
+  asm volatile (GCM_CTR4_INIT
+		GCM_AES_ROUND(0x10)
+		GCM_AES_ROUND(0x20)
+		GCM_AES_ROUND(0x30)
+		GCM_AES_ROUND(0x40)
+		GCM_AES_ROUND(0x50)
+		GCM_AES_ROUND(0x60)
+		GCM_AES_ROUND(0x70)
+		GCM_AES_ROUND(0x80)
+		GCM_AES_ROUND(0x90)
+		GCM_AES_LAST_XOR_STORE
+		:
+		: [key] "r" (ctx->keyschenc),
+		  [rounds] "r" (ctx->rounds),
+		  [inbuf] "r" (inbuf),
+		  [outbuf] "r" (outbuf)
+		: "cc", "memory");
+}
+
+
+/* CTR encrypt four blocks from INBUF to OUTBUF and, interleaved with
+ * the AES rounds, add the four blocks at GBUF to the GHASH state using
+ * H⁴...H¹ so that only a single reduction is needed.  */
+static inline void
+do_aesni_gcm_4 (const RIJNDAEL_context *ctx, gcry_cipher_hd_t c,
+                const unsigned char *gbuf, unsigned char *outbuf,
+                const unsigned char *inbuf)
+{
+  asm volatile (GCM_CTR4_INIT
+		GCM_GHASH_LOAD(0)
+		"pxor   %%xmm6, %%xmm11\n\t"
+		GCM_GHASH_MUL("2*16(%[h_234])", movdqa)
+		GCM_AES_ROUND(0x10)
+		GCM_GHASH_LOAD(1)
+		GCM_GHASH_MUL("1*16(%[h_234])", pxor)
+		GCM_AES_ROUND(0x20)
+		GCM_GHASH_LOAD(2)
+		GCM_GHASH_MUL("0*16(%[h_234])", pxor)
+		GCM_AES_ROUND(0x30)
+		GCM_GHASH_LOAD(3)
+		GCM_GHASH_MUL("(%[h_1])", pxor)
+		GCM_AES_ROUND(0x40)
+		GCM_GHASH_REDUCE_1
+		GCM_AES_ROUND(0x50)
+		GCM_GHASH_REDUCE_2
+		GCM_AES_ROUND(0x60)
+		GCM_GHASH_REDUCE_3
+		GCM_AES_ROUND(0x70)
+		GCM_GHASH_REDUCE_4
+		GCM_AES_ROUND(0x80)
+		GCM_AES_ROUND(0x90)
+		GCM_AES_LAST_XOR_STORE
+		:
+		: [key] "r" (ctx->keyschenc),
+		  [rounds] "r" (ctx->rounds),
+		  [gbuf] "r" (gbuf),
+		  [h_1] "r" (c->u_mode.gcm.u_ghash_key.key),
+		  [h_234] "r" (c->u_mode.gcm.gcm_table),
+		  [inbuf] "r" (inbuf),
+		  [outbuf] "r" (outbuf)
+		: "cc", "memory");
+}
+
+#undef GCM_CTR4_INIT
+#undef GCM_AES_ROUND
+#undef GCM_AES_LAST_XOR_STORE
+#undef GCM_GHASH_LOAD
+#undef GCM_GHASH_MUL
+#undef GCM_GHASH_REDUCE_1
+#undef GCM_GHASH_REDUCE_2
+#undef GCM_GHASH_REDUCE_3
+#undef GCM_GHASH_REDUCE_4
+#undef aesenc_xmm0_xmm1
+#undef aesenc_xmm0_xmm2
+#undef aesenc_xmm0_xmm3
+#undef aesenc_xmm0_xmm4
+#undef aesenclast_xmm0_xmm1
+#undef aesenclast_xmm0_xmm2
+#undef aesenclast_xmm0_xmm3
+#undef aesenclast_xmm0_xmm4
+
+#endif /* __x86_64__ && GCM_USE_INTEL_PCLMUL */
+
+
+/* Bulk GCM encryption/decryption with the CTR encryption and the GHASH
+ * of the ciphertext done in the same pass over the data.  Returns the
+ * number of blocks left unprocessed.  */
+size_t
+_gcry_aes_aesni_gcm_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
+                           const void *inbuf_arg, size_t nblocks, int encrypt)
+{
+#if defined(__x86_64__) && defined(GCM_USE_INTEL_PCLMUL)
+  static const unsigned char be_mask[16] __attribute__ ((aligned (16))) =
+    { 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+  static const unsigned char le_one[16] __attribute__ ((aligned (16))) =
+    { 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  RIJNDAEL_context *ctx = (void *)&c->context.c;
+  unsigned char *outbuf = outbuf_arg;
+  const unsigned char *inbuf = inbuf_arg;
+  aesni_prepare_2_6_variable;
+  aesni_prepare_7_15_variable;
+
+  /* The GHASH part uses the key table set up by the PCLMUL GHASH.  */
+  if (!(c->u_mode.gcm.hw_impl_flags & GCM_INTEL_USE_PCLMUL) || nblocks < 4)
+    return nblocks;
+
+  aesni_prepare ();
+  aesni_prepare_2_6 ();
+  aesni_prepare_7_15 ();
+
+  asm volatile ("movdqa %[mask], %%xmm7\n\t"
+		"movdqa %[one], %%xmm13\n\t"
+		"movdqu %[ctr], %%xmm5\n\t"
+		"movdqu %[hash], %%xmm6\n\t"
+		"pshufb %%xmm7, %%xmm5\n\t" /* be => le */
+		"pshufb %%xmm7, %%xmm6\n\t" /* be => le */
+		:
+		: [mask] "m" (*be_mask),
+		  [one] "m" (*le_one),
+		  [ctr] "m" (*c->u_ctr.ctr),
+		  [hash] "m" (*c->u_mode.gcm.u_tag.tag)
+		: "memory");
+
+  if (encrypt)
+    {
+      /* GHASH lags one batch behind the encryption.  */
+      do_aesni_gcm_ctr_4 (ctx, outbuf, inbuf);
+      outbuf += 4*BLOCKSIZE;
+      inbuf  += 4*BLOCKSIZE;
+      nblocks -= 4;
+
+      for ( ;nblocks >= 4; nblocks -= 4 )
+	{
+	  do_aesni_gcm_4 (ctx, c, outbuf - 4*BLOCKSIZE, outbuf, inbuf);
+	  outbuf += 4*BLOCKSIZE;
+	  inbuf  += 4*BLOCKSIZE;
+	}
+    }
+  else
+    {
+      for ( ;nblocks >= 4; nblocks -= 4 )
+	{
+	  do_aesni_gcm_4 (ctx, c, inbuf, outbuf, inbuf);
+	  outbuf += 4*BLOCKSIZE;
+	  inbuf  += 4*BLOCKSIZE;
+	}
+    }
+
+  asm volatile ("pshufb %%xmm7, %%xmm5\n\t" /* le => be */
+		"pshufb %%xmm7, %%xmm6\n\t" /* le => be */
+		"movdqu %%xmm5, %[ctr]\n\t"
+		"movdqu %%xmm6, %[hash]\n\t"
+		: [ctr] "=m" (*c->u_ctr.ctr),
+		  [hash] "=m" (*c->u_mode.gcm.u_tag.tag)
+		:
+		: "memory");
+
+  aesni_cleanup ();
+  aesni_cleanup_2_6 ();
+  aesni_cleanup_7_15 ();
+
+  if (encrypt)
+    c->u_mode.gcm.ghash_fn (c, c->u_mode.gcm.u_tag.tag,
+                            outbuf - 4*BLOCKSIZE, 4);
+#else
+  (void)c;
+  (void)outbuf_arg;
+  (void)inbuf_arg;
+  (void)encrypt;
+#endif /* __x86_64__ && GCM_USE_INTEL_PCLMUL */
+
+  return nblocks;
+}
+
+
 #endif /* USE_AESNI */
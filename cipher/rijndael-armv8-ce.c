@@ -102,12 +102,53 @@ extern void _gcry_aes_ocb_auth_armv8_ce (const void *keysched,
                                          unsigned int nrounds,
                                          unsigned int blkn);
 
+extern void _gcry_aes_xts_enc_armv8_ce (const void *keysched,
+                                        unsigned char *outbuf,
+                                        const unsigned char *inbuf,
+                                        unsigned char *tweak,
+                                        size_t nblocks, unsigned int nrounds);
+extern void _gcry_aes_xts_dec_armv8_ce (const void *keysched,
+                                        unsigned char *outbuf,
+                                        const unsigned char *inbuf,
+                                        unsigned char *tweak,
+                                        size_t nblocks, unsigned int nrounds);
+
+#ifdef __AARCH64EL__
+extern void _gcry_aes_gcm_enc_armv8_ce (const void *keysched,
+                                        unsigned char *outbuf,
+                                        const unsigned char *inbuf,
+                                        unsigned char *ctr,
+                                        unsigned char *hash,
+                                        size_t nblocks, unsigned int nrounds,
+                                        const void *gcm_key,
+                                        const void *gcm_table);
+extern void _gcry_aes_gcm_dec_armv8_ce (const void *keysched,
+                                        unsigned char *outbuf,
+                                        const unsigned char *inbuf,
+                                        unsigned char *ctr,
+                                        unsigned char *hash,
+                                        size_t nblocks, unsigned int nrounds,
+                                        const void *gcm_key,
+                                        const void *gcm_table);
+
+typedef void (*gcm_crypt_fn_t) (const void *keysched, unsigned char *outbuf,
+                                const unsigned char *inbuf,
+                                unsigned char *ctr, unsigned char *hash,
+                                size_t nblocks, unsigned int nrounds,
+                                const void *gcm_key, const void *gcm_table);
+#endif
+
 typedef void (*ocb_crypt_fn_t) (const void *keysched, unsigned char *outbuf,
                                 const unsigned char *inbuf,
                                 unsigned char *offset, unsigned char *checksum,
                                 unsigned char *L_table, size_t nblocks,
                                 unsigned int nrounds, unsigned int blkn);
 
+typedef void (*xts_crypt_fn_t) (const void *keysched, unsigned char *outbuf,
+                                const unsigned char *inbuf,
+                                unsigned char *tweak, size_t nblocks,
+                                unsigned int nrounds);
+
 void
 _gcry_aes_armv8_ce_setkey (RIJNDAEL_context *ctx, const byte *key)
 {
@@ -361,4 +402,51 @@ _gcry_aes_armv8_ce_ocb_auth (gcry_cipher_hd_t c, void *abuf_arg,
 			      nblocks, nrounds, (unsigned int)blkn);
 }
 
+void
+_gcry_aes_armv8_ce_xts_crypt (RIJNDAEL_context *ctx, unsigned char *tweak,
+                              unsigned char *outbuf,
+                              const unsigned char *inbuf,
+                              size_t nblocks, int encrypt)
+{
+  const void *keysched = encrypt ? ctx->keyschenc32 : ctx->keyschdec32;
+  xts_crypt_fn_t crypt_fn = encrypt ? _gcry_aes_xts_enc_armv8_ce
+                                    : _gcry_aes_xts_dec_armv8_ce;
+  unsigned int nrounds = ctx->rounds;
+
+  crypt_fn(keysched, outbuf, inbuf, tweak, nblocks, nrounds);
+}
+
+size_t
+_gcry_aes_armv8_ce_gcm_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
+                              const void *inbuf_arg, size_t nblocks,
+                              int encrypt)
+{
+#ifdef __AARCH64EL__
+  RIJNDAEL_context *ctx = (void *)&c->context.c;
+  const void *keysched = ctx->keyschenc32;
+  gcm_crypt_fn_t crypt_fn = encrypt ? _gcry_aes_gcm_enc_armv8_ce
+                                    : _gcry_aes_gcm_dec_armv8_ce;
+  unsigned int nrounds = ctx->rounds;
+  size_t nleft = nblocks & 3;
+
+  /* The GHASH part uses the key table set up by the PMULL GHASH.  The
+     assembly processes four blocks at a time.  */
+  if (!(c->u_mode.gcm.hw_impl_flags & GCM_ARM_USE_PMULL) || nblocks < 4)
+    return nblocks;
+
+  crypt_fn(keysched, outbuf_arg, inbuf_arg, c->u_ctr.ctr,
+           c->u_mode.gcm.u_tag.tag, nblocks - nleft, nrounds,
+           c->u_mode.gcm.u_ghash_key.key, c->u_mode.gcm.gcm_table);
+
+  return nleft;
+#else
+  (void)c;
+  (void)outbuf_arg;
+  (void)inbuf_arg;
+  (void)encrypt;
+
+  return nblocks;
+#endif
+}
+
 #endif /* USE_ARM_CE */
@@ -690,6 +690,71 @@ _gcry_aes_ssse3_ocb_crypt(gcry_cipher_hd_t c, void *outbuf_arg,
 }
 
 
+static const byte xts_gfmul_const[16] __attribute__ ((aligned (16))) =
+  { 0x87, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+void
+_gcry_aes_ssse3_xts_crypt (RIJNDAEL_context *ctx, unsigned char *tweak,
+                           unsigned char *outbuf, const unsigned char *inbuf,
+                           size_t nblocks, int encrypt)
+{
+  unsigned int nrounds = ctx->rounds;
+  byte ssse3_state[SSSE3_STATE_SIZE];
+
+  if (encrypt)
+    {
+      vpaes_ssse3_prepare_enc ();
+    }
+  else
+    {
+      vpaes_ssse3_prepare_dec ();
+    }
+
+  /* Preload Tweak; it is kept in XMM7 which is preserved by the cores. */
+  asm volatile ("movdqu %[tweak], %%xmm7\n\t"
+                : /* No output */
+                : [tweak] "m" (*tweak)
+                : "memory" );
+
+  for ( ;nblocks; nblocks-- )
+    {
+      asm volatile ("movdqu %[inbuf], %%xmm0\n\t"
+                    "pxor   %%xmm7,   %%xmm0\n\t"
+                    :
+                    : [inbuf] "m" (*inbuf)
+                    : "memory" );
+
+      if (encrypt)
+        do_vpaes_ssse3_enc (ctx, nrounds);
+      else
+        do_vpaes_ssse3_dec (ctx, nrounds);
+
+      /* Output whitening and generation of the next tweak.  */
+      asm volatile ("pshufd $0x13,    %%xmm7, %%xmm6\n\t"
+                    "pxor   %%xmm7,   %%xmm0\n\t"
+                    "psrad  $31,      %%xmm6\n\t"
+                    "movdqu %%xmm0,   %[outbuf]\n\t"
+                    "paddq  %%xmm7,   %%xmm7\n\t"
+                    "pand   %[gfmul], %%xmm6\n\t"
+                    "pxor   %%xmm6,   %%xmm7\n\t"
+                    : [outbuf] "=m" (*outbuf)
+                    : [gfmul] "m" (*xts_gfmul_const)
+                    : "memory" );
+
+      outbuf += BLOCKSIZE;
+      inbuf  += BLOCKSIZE;
+    }
+
+  asm volatile ("movdqu %%xmm7, %[tweak]\n\t"
+                : [tweak] "=m" (*tweak)
+                :
+                : "memory" );
+
+  vpaes_ssse3_cleanup ();
+}
+
+
 void
 _gcry_aes_ssse3_ocb_auth (gcry_cipher_hd_t c, const void *abuf_arg,
                           size_t nblocks)
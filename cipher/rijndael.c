@@ -103,6 +103,14 @@ extern void _gcry_aes_aesni_ocb_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
                                        int encrypt);
 extern void _gcry_aes_aesni_ocb_auth (gcry_cipher_hd_t c, const void *abuf_arg,
                                       size_t nblocks);
+extern void _gcry_aes_aesni_xts_crypt (RIJNDAEL_context *ctx,
+                                       unsigned char *tweak,
+                                       unsigned char *outbuf,
+                                       const unsigned char *inbuf,
+                                       size_t nblocks, int encrypt);
+extern size_t _gcry_aes_aesni_gcm_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
+                                         const void *inbuf_arg, size_t nblocks,
+                                         int encrypt);
 #endif
 
 #ifdef USE_SSSE3
@@ -142,6 +150,11 @@ extern void _gcry_aes_ssse3_ocb_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
                                        int encrypt);
 extern void _gcry_aes_ssse3_ocb_auth (gcry_cipher_hd_t c, const void *abuf_arg,
                                       size_t nblocks);
+extern void _gcry_aes_ssse3_xts_crypt (RIJNDAEL_context *ctx,
+                                       unsigned char *tweak,
+                                       unsigned char *outbuf,
+                                       const unsigned char *inbuf,
+                                       size_t nblocks, int encrypt);
 #endif
 
 #ifdef USE_PADLOCK
@@ -206,6 +219,15 @@ extern void _gcry_aes_armv8_ce_ocb_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
                                           int encrypt);
 extern void _gcry_aes_armv8_ce_ocb_auth (gcry_cipher_hd_t c,
                                          const void *abuf_arg, size_t nblocks);
+extern void _gcry_aes_armv8_ce_xts_crypt (RIJNDAEL_context *ctx,
+                                          unsigned char *tweak,
+                                          unsigned char *outbuf,
+                                          const unsigned char *inbuf,
+                                          size_t nblocks, int encrypt);
+extern size_t _gcry_aes_armv8_ce_gcm_crypt (gcry_cipher_hd_t c,
+                                            void *outbuf_arg,
+                                            const void *inbuf_arg,
+                                            size_t nblocks, int encrypt);
 #endif /*USE_ARM_ASM*/
 
 static unsigned int do_encrypt (const RIJNDAEL_context *ctx, unsigned char *bx,
@@ -1467,6 +1489,134 @@ _gcry_aes_ocb_auth (gcry_cipher_hd_t c, const void *abuf_arg, size_t nblocks)
 }
 
 
+/* Bulk encryption/decryption of complete blocks in XTS mode. */
+void
+_gcry_aes_xts_crypt (gcry_cipher_hd_t c, unsigned char *tweak,
+                     void *outbuf_arg, const void *inbuf_arg,
+                     size_t nblocks, int encrypt)
+{
+  RIJNDAEL_context *ctx = (void *)&c->context.c;
+  unsigned char *outbuf = outbuf_arg;
+  const unsigned char *inbuf = inbuf_arg;
+  unsigned int burn_depth = 0;
+  rijndael_cryptfn_t crypt_fn;
+  u64 tweak_lo, tweak_hi, tweak_next_lo, tweak_next_hi, tmp_lo, tmp_hi, carry;
+
+  if (encrypt)
+    {
+      if (ctx->prefetch_enc_fn)
+        ctx->prefetch_enc_fn();
+
+      crypt_fn = ctx->encrypt_fn;
+    }
+  else
+    {
+      check_decryption_preparation (ctx);
+
+      if (ctx->prefetch_dec_fn)
+        ctx->prefetch_dec_fn();
+
+      crypt_fn = ctx->decrypt_fn;
+    }
+
+  if (0)
+    ;
+#ifdef USE_AESNI
+  else if (ctx->use_aesni)
+    {
+      _gcry_aes_aesni_xts_crypt (ctx, tweak, outbuf, inbuf, nblocks, encrypt);
+      burn_depth = 0;
+    }
+#endif /*USE_AESNI*/
+#ifdef USE_SSSE3
+  else if (ctx->use_ssse3)
+    {
+      _gcry_aes_ssse3_xts_crypt (ctx, tweak, outbuf, inbuf, nblocks, encrypt);
+      burn_depth = 0;
+    }
+#endif /*USE_SSSE3*/
+#ifdef USE_ARM_CE
+  else if (ctx->use_arm_ce)
+    {
+      _gcry_aes_armv8_ce_xts_crypt (ctx, tweak, outbuf, inbuf, nblocks,
+                                    encrypt);
+      burn_depth = 0;
+    }
+#endif /*USE_ARM_CE*/
+  else
+    {
+      tweak_next_lo = buf_get_le64 (tweak + 0);
+      tweak_next_hi = buf_get_le64 (tweak + 8);
+
+      while (nblocks)
+        {
+          tweak_lo = tweak_next_lo;
+          tweak_hi = tweak_next_hi;
+
+          /* Xor-Encrypt/Decrypt-Xor block. */
+          tmp_lo = buf_get_le64 (inbuf + 0) ^ tweak_lo;
+          tmp_hi = buf_get_le64 (inbuf + 8) ^ tweak_hi;
+
+          buf_put_le64 (outbuf + 0, tmp_lo);
+          buf_put_le64 (outbuf + 8, tmp_hi);
+
+          /* Generate next tweak. */
+          carry = -(tweak_next_hi >> 63) & 0x87;
+          tweak_next_hi = (tweak_next_hi << 1) + (tweak_next_lo >> 63);
+          tweak_next_lo = (tweak_next_lo << 1) ^ carry;
+
+          burn_depth = crypt_fn (ctx, outbuf, outbuf);
+
+          buf_put_le64 (outbuf + 0, buf_get_le64 (outbuf + 0) ^ tweak_lo);
+          buf_put_le64 (outbuf + 8, buf_get_le64 (outbuf + 8) ^ tweak_hi);
+
+          outbuf += GCRY_XTS_BLOCK_LEN;
+          inbuf += GCRY_XTS_BLOCK_LEN;
+          nblocks--;
+        }
+
+      buf_put_le64 (tweak + 0, tweak_next_lo);
+      buf_put_le64 (tweak + 8, tweak_next_hi);
+    }
+
+  if (burn_depth)
+    _gcry_burn_stack (burn_depth + 4 * sizeof(void *));
+}
+
+
+/* Bulk encryption/decryption of complete blocks in GCM mode with the
+   CTR encryption and the GHASH computed in a single pass.  Returns the
+   number of blocks not processed; the caller handles those with the
+   generic CTR and GHASH code.  */
+size_t
+_gcry_aes_gcm_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
+                     const void *inbuf_arg, size_t nblocks, int encrypt)
+{
+  RIJNDAEL_context *ctx = (void *)&c->context.c;
+
+  if (0)
+    ;
+#ifdef USE_AESNI
+  else if (ctx->use_aesni)
+    {
+      return _gcry_aes_aesni_gcm_crypt (c, outbuf_arg, inbuf_arg, nblocks,
+                                        encrypt);
+    }
+#endif /*USE_AESNI*/
+#ifdef USE_ARM_CE
+  else if (ctx->use_arm_ce)
+    {
+      return _gcry_aes_armv8_ce_gcm_crypt (c, outbuf_arg, inbuf_arg, nblocks,
+                                           encrypt);
+    }
+#endif /*USE_ARM_CE*/
+
+  (void)ctx;
+
+  return nblocks;
+}
+
+
 
 /* Run the self-tests for AES 128.  Returns NULL on success. */
 static const char*
@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "g10lib.h"
 #include "mpi.h"
@@ -50,6 +51,8 @@ typedef struct
   gcry_mpi_t p;	    /* prime  p. */
   gcry_mpi_t q;	    /* prime  q. */
   gcry_mpi_t u;	    /* inverse of p mod q. */
+  gcry_mpi_t dp;    /* d mod (p-1) or NULL.  */
+  gcry_mpi_t dq;    /* d mod (q-1) or NULL.  */
 } RSA_secret_key;
 
 
@@ -203,11 +206,12 @@ check_exponent (void *arg, gcry_mpi_t a)
  *       > 2 Use this public exponent.  If the given exponent
  *           is not odd one is internally added to it.
  * TRANSIENT_KEY:  If true, generate the primes using the standard RNG.
+ * NWORKERS: The number of threads searching for each prime.
  * Returns: 2 structures filled with all needed values
  */
 static gpg_err_code_t
 generate_std (RSA_secret_key *sk, unsigned int nbits, unsigned long use_e,
-              int transient_key)
+              int transient_key, unsigned int nworkers)
 {
   gcry_mpi_t p, q; /* the two primes */
   gcry_mpi_t d;    /* the private key */
@@ -269,15 +273,19 @@ generate_std (RSA_secret_key *sk, unsigned int nbits, unsigned long use_e,
       if (use_e)
         { /* Do an extra test to ensure that the given exponent is
              suitable. */
-          p = _gcry_generate_secret_prime (nbits/2, random_level,
-                                           check_exponent, e);
-          q = _gcry_generate_secret_prime (nbits/2, random_level,
-                                           check_exponent, e);
+          p = _gcry_generate_secret_prime_parallel (nbits/2, random_level,
+                                                    check_exponent, e,
+                                                    nworkers);
+          q = _gcry_generate_secret_prime_parallel (nbits/2, random_level,
+                                                    check_exponent, e,
+                                                    nworkers);
         }
       else
         { /* We check the exponent later. */
-          p = _gcry_generate_secret_prime (nbits/2, random_level, NULL, NULL);
-          q = _gcry_generate_secret_prime (nbits/2, random_level, NULL, NULL);
+          p = _gcry_generate_secret_prime_parallel (nbits/2, random_level,
+                                                    NULL, NULL, nworkers);
+          q = _gcry_generate_secret_prime_parallel (nbits/2, random_level,
+                                                    NULL, NULL, nworkers);
         }
       if (mpi_cmp (p, q) > 0 ) /* p shall be smaller than q (for calc of u)*/
         mpi_swap(p,q);
@@ -1010,11 +1018,14 @@ secret_core_std (gcry_mpi_t M, gcry_mpi_t C,
  *      m2 = c ^ (d mod (q-1)) mod q
  *      h = u * (m2 - m1) mod q
  *      m = m1 + h * p
+ *
+ * DP and DQ are d mod (p-1) and d mod (q-1) if already known or NULL.
  */
 static void
 secret_core_crt (gcry_mpi_t M, gcry_mpi_t C,
                  gcry_mpi_t D, unsigned int Nlimbs,
-                 gcry_mpi_t P, gcry_mpi_t Q, gcry_mpi_t U)
+                 gcry_mpi_t P, gcry_mpi_t Q, gcry_mpi_t U,
+                 gcry_mpi_t DP, gcry_mpi_t DQ)
 {
   gcry_mpi_t m1 = mpi_alloc_secure ( Nlimbs + 1 );
   gcry_mpi_t m2 = mpi_alloc_secure ( Nlimbs + 1 );
@@ -1034,8 +1045,13 @@ secret_core_crt (gcry_mpi_t M, gcry_mpi_t C,
   mpi_set_highbit (r, r_nbits - 1);
   mpi_sub_ui ( h, P, 1 );
   mpi_mul ( D_blind, h, r );
-  mpi_fdiv_r ( h, D, h );
-  mpi_add ( D_blind, D_blind, h );
+  if (DP)
+    mpi_add ( D_blind, D_blind, DP );
+  else
+    {
+      mpi_fdiv_r ( h, D, h );
+      mpi_add ( D_blind, D_blind, h );
+    }
   mpi_powm ( m1, C, D_blind, P );
 
   /* d_blind = (d mod (q-1)) + (q-1) * r            */
@@ -1044,8 +1060,13 @@ secret_core_crt (gcry_mpi_t M, gcry_mpi_t C,
   mpi_set_highbit (r, r_nbits - 1);
   mpi_sub_ui ( h, Q, 1  );
   mpi_mul ( D_blind, h, r );
-  mpi_fdiv_r ( h, D, h );
-  mpi_add ( D_blind, D_blind, h );
+  if (DQ)
+    mpi_add ( D_blind, D_blind, DQ );
+  else
+    {
+      mpi_fdiv_r ( h, D, h );
+      mpi_add ( D_blind, D_blind, h );
+    }
   mpi_powm ( m2, C, D_blind, Q );
 
   mpi_free ( r );
@@ -1084,27 +1105,24 @@ secret (gcry_mpi_t output, gcry_mpi_t input, RSA_secret_key *skey )
   else
     {
       secret_core_crt (output, input, skey->d, mpi_get_nlimbs (skey->n),
-                       skey->p, skey->q, skey->u);
+                       skey->p, skey->q, skey->u, skey->dp, skey->dq);
     }
 }
 
 
+/* Set RE to r^e mod n and RI to r^-1 mod n for a new random r.  */
 static void
-secret_blinded (gcry_mpi_t output, gcry_mpi_t input,
-                RSA_secret_key *sk, unsigned int nbits)
+blinding_new_pair (gcry_mpi_t re, gcry_mpi_t ri,
+                   RSA_secret_key *sk, unsigned int nbits)
 {
   gcry_mpi_t r;	           /* Random number needed for blinding.  */
-  gcry_mpi_t ri;	   /* Modular multiplicative inverse of r.  */
-  gcry_mpi_t bldata;       /* Blinded data to decrypt.  */
 
   /* First, we need a random number r between 0 and n - 1, which is
    * relatively prime to n (i.e. it is neither p nor q).  The random
    * number needs to be only unpredictable, thus we employ the
    * gcry_create_nonce function by using GCRY_WEAK_RANDOM with
    * gcry_mpi_randomize.  */
-  r  = mpi_snew (nbits);
-  ri = mpi_snew (nbits);
-  bldata = mpi_snew (nbits);
+  r = mpi_snew (nbits);
 
   do
     {
@@ -1113,11 +1131,175 @@ secret_blinded (gcry_mpi_t output, gcry_mpi_t input,
     }
   while (!mpi_invm (ri, r, sk->n));
 
+  mpi_powm (re, r, sk->e, sk->n);
+  _gcry_mpi_release (r);
+}
+
+
+/* The cache of blinding pairs enabled with
+   GCRYCTL_ENABLE_RSA_BLINDING_CACHE.  Instead of drawing a new r for
+   each operation, the pair (r^e, r^-1) of a key is squared after
+   each use, which gives the pair for r^2.  A new r is drawn after
+   RSA_BLINDING_REFRESH uses and in a forked child.  */
+#define RSA_BLINDING_REFRESH 32
+#define RSA_BLINDING_CACHE_SIZE 8
+
+struct rsa_blinding_s
+{
+  gcry_mpi_t n, e;              /* The public key or NULL.  */
+  gcry_mpi_t re;                /* r^e mod n.  */
+  gcry_mpi_t ri;                /* r^-1 mod n.  */
+  unsigned int uses;            /* Uses of the pair since R was drawn.  */
+  pid_t pid;                    /* The process which drew R.  */
+};
+static struct rsa_blinding_s rsa_blinding_cache[RSA_BLINDING_CACHE_SIZE];
+static unsigned int rsa_blinding_next_slot;
+static int rsa_blinding_cache_enabled;
+/* Mutex used to protect access to RSA_BLINDING_CACHE.  */
+GPGRT_LOCK_DEFINE (rsa_blinding_lock);
+
+
+/* Enable the use of the blinding cache.  */
+void
+_gcry_rsa_enable_blinding_cache (void)
+{
+  rsa_blinding_cache_enabled = 1;
+}
+
+
+/* Store the next blinding pair of the key SK in RE and RI, updating
+   the cached pair B.  Returns false without storing anything if B
+   needs a new pair; see blinding_store_pair.  Needs to be called
+   while the lock protecting B is being held.  */
+static int
+blinding_next_pair (struct rsa_blinding_s *b, gcry_mpi_t re, gcry_mpi_t ri,
+                    RSA_secret_key *sk)
+{
+  if (!b->uses || b->uses >= RSA_BLINDING_REFRESH || b->pid != getpid ())
+    return 0;
+
+  mpi_mulm (b->re, b->re, b->re, sk->n);
+  mpi_mulm (b->ri, b->ri, b->ri, sk->n);
+  b->uses++;
+
+  mpi_set (re, b->re);
+  mpi_set (ri, b->ri);
+  return 1;
+}
+
+
+/* Make the pair RE and RI, which was just drawn by blinding_new_pair
+   and used once, the cached pair B.  Needs to be called while the lock
+   protecting B is being held.  */
+static void
+blinding_store_pair (struct rsa_blinding_s *b, gcry_mpi_t re, gcry_mpi_t ri,
+                     unsigned int nbits)
+{
+  if (!b->re)
+    {
+      b->re = mpi_snew (nbits);
+      b->ri = mpi_snew (nbits);
+    }
+  mpi_set (b->re, re);
+  mpi_set (b->ri, ri);
+  b->uses = 1;
+  b->pid = getpid ();
+}
+
+
+/* Return the cache entry for the key SK, replacing the oldest entry if
+   SK is not yet cached.  Needs to be called while rsa_blinding_lock
+   is being held.  */
+static struct rsa_blinding_s *
+get_blinding_entry (RSA_secret_key *sk)
+{
+  struct rsa_blinding_s *b;
+  int i;
+
+  for (i = 0; i < RSA_BLINDING_CACHE_SIZE; i++)
+    {
+      b = &rsa_blinding_cache[i];
+      if (b->n && !mpi_cmp (b->n, sk->n) && !mpi_cmp (b->e, sk->e))
+        return b;
+    }
+
+  b = &rsa_blinding_cache[rsa_blinding_next_slot];
+  rsa_blinding_next_slot = (rsa_blinding_next_slot + 1)
+                           % RSA_BLINDING_CACHE_SIZE;
+  _gcry_mpi_release (b->n);
+  _gcry_mpi_release (b->e);
+  _gcry_mpi_release (b->re);
+  _gcry_mpi_release (b->ri);
+  b->n = mpi_copy (sk->n);
+  b->e = mpi_copy (sk->e);
+  b->re = b->ri = NULL;
+  b->uses = 0;
+  return b;
+}
+
+
+/* A secret key prepared by rsa_prepare for repeated use.  The
+   operations only read SK, so that the key may be used by several
+   threads at the same time.  Each key has its own blinding pair,
+   which is updated while LOCK is being held.  */
+typedef struct
+{
+  RSA_secret_key sk;            /* The key including DP and DQ.  */
+  unsigned int nbits;           /* The size of N.  */
+  gpgrt_lock_t lock;            /* Protects BLINDING.  */
+  struct rsa_blinding_s blinding;
+} rsa_prepared_key_t;
+
+
+/* Perform a secret key operation on INPUT with SK, using blinding
+   against timing attacks.  PKEY is the prepared key SK belongs to or
+   NULL.  */
+static void
+secret_blinded (gcry_mpi_t output, gcry_mpi_t input,
+                RSA_secret_key *sk, unsigned int nbits,
+                rsa_prepared_key_t *pkey)
+{
+  gcry_mpi_t re;	   /* r^e mod n.  */
+  gcry_mpi_t ri;	   /* Modular multiplicative inverse of r.  */
+  gcry_mpi_t bldata;       /* Blinded data to decrypt.  */
+  gpgrt_lock_t *lock = NULL;
+  struct rsa_blinding_s *b;
+  int have_pair = 0;
+
+  re = mpi_snew (nbits);
+  ri = mpi_snew (nbits);
+  bldata = mpi_snew (nbits);
+
+  /* A new pair takes an inversion and a powm, so it is drawn without
+     holding the lock and only stored under the lock.  */
+  if (pkey)
+    lock = &pkey->lock;
+  else if (rsa_blinding_cache_enabled)
+    lock = &rsa_blinding_lock;
+  if (lock && !gpgrt_lock_lock (lock))
+    {
+      b = pkey? &pkey->blinding : get_blinding_entry (sk);
+      have_pair = blinding_next_pair (b, re, ri, sk);
+      gpgrt_lock_unlock (lock);
+    }
+  else
+    lock = NULL;
+
+  if (!have_pair)
+    {
+      blinding_new_pair (re, ri, sk, nbits);
+      if (lock && !gpgrt_lock_lock (lock))
+        {
+          b = pkey? &pkey->blinding : get_blinding_entry (sk);
+          blinding_store_pair (b, re, ri, nbits);
+          gpgrt_lock_unlock (lock);
+        }
+    }
+
   /* Do blinding.  We calculate: y = (x * r^e) mod n, where r is the
    * random number, e is the public exponent, x is the non-blinded
    * input data and n is the RSA modulus.  */
-  mpi_powm (bldata, r, sk->e, sk->n);
-  mpi_mulm (bldata, bldata, input, sk->n);
+  mpi_mulm (bldata, re, input, sk->n);
 
   /* Perform decryption.  */
   secret (output, bldata, sk);
@@ -1128,7 +1310,7 @@ secret_blinded (gcry_mpi_t output, gcry_mpi_t input,
    * inverse of r and n is the RSA modulus.  */
   mpi_mulm (output, output, ri, sk->n);
 
-  _gcry_mpi_release (r);
+  _gcry_mpi_release (re);
   _gcry_mpi_release (ri);
 }
 
@@ -1214,7 +1396,9 @@ rsa_generate (const gcry_sexp_t genparms, gcry_sexp_t *r_skey)
       else
         {
           ec = generate_std (&sk, nbits, evalue,
-                             !!(flags & PUBKEY_FLAG_TRANSIENT_KEY));
+                             !!(flags & PUBKEY_FLAG_TRANSIENT_KEY),
+                             ((flags & PUBKEY_FLAG_PARALLEL)?
+                              _gcry_get_ncpus () : 1));
         }
       sexp_release (deriveparms);
     }
@@ -1342,21 +1526,25 @@ rsa_encrypt (gcry_sexp_t *r_ciph, gcry_sexp_t s_data, gcry_sexp_t keyparms)
 }
 
 
+/* Decrypt S_DATA with the key given by KEYPARMS or, if KEYPARMS is
+   NULL, with the prepared key PKEY.  */
 static gcry_err_code_t
-rsa_decrypt (gcry_sexp_t *r_plain, gcry_sexp_t s_data, gcry_sexp_t keyparms)
-
+decrypt_with_key (gcry_sexp_t *r_plain, gcry_sexp_t s_data,
+                  gcry_sexp_t keyparms, rsa_prepared_key_t *pkey)
 {
   gpg_err_code_t rc;
   struct pk_encoding_ctx ctx;
   gcry_sexp_t l1 = NULL;
   gcry_mpi_t data = NULL;
   RSA_secret_key sk = {NULL, NULL, NULL, NULL, NULL, NULL};
+  RSA_secret_key *skey;
   gcry_mpi_t plain = NULL;
   unsigned char *unpad = NULL;
   size_t unpadlen = 0;
 
   _gcry_pk_util_init_encoding_ctx (&ctx, PUBKEY_OP_DECRYPT,
-                                   rsa_get_nbits (keyparms));
+                                   keyparms? rsa_get_nbits (keyparms)
+                                   : pkey->nbits);
 
   /* Extract the data.  */
   rc = _gcry_pk_util_preparse_encval (s_data, rsa_names, &l1, &ctx);
@@ -1374,21 +1562,27 @@ rsa_decrypt (gcry_sexp_t *r_plain, gcry_sexp_t s_data, gcry_sexp_t keyparms)
     }
 
   /* Extract the key.  */
-  rc = sexp_extract_param (keyparms, NULL, "nedp?q?u?",
-                           &sk.n, &sk.e, &sk.d, &sk.p, &sk.q, &sk.u,
-                           NULL);
-  if (rc)
-    goto leave;
+  if (keyparms)
+    {
+      rc = sexp_extract_param (keyparms, NULL, "nedp?q?u?",
+                               &sk.n, &sk.e, &sk.d, &sk.p, &sk.q, &sk.u,
+                               NULL);
+      if (rc)
+        goto leave;
+      skey = &sk;
+    }
+  else
+    skey = &pkey->sk;
   if (DBG_CIPHER)
     {
-      log_printmpi ("rsa_decrypt    n", sk.n);
-      log_printmpi ("rsa_decrypt    e", sk.e);
+      log_printmpi ("rsa_decrypt    n", skey->n);
+      log_printmpi ("rsa_decrypt    e", skey->e);
       if (!fips_mode ())
         {
-          log_printmpi ("rsa_decrypt    d", sk.d);
-          log_printmpi ("rsa_decrypt    p", sk.p);
-          log_printmpi ("rsa_decrypt    q", sk.q);
-          log_printmpi ("rsa_decrypt    u", sk.u);
+          log_printmpi ("rsa_decrypt    d", skey->d);
+          log_printmpi ("rsa_decrypt    p", skey->p);
+          log_printmpi ("rsa_decrypt    q", skey->q);
+          log_printmpi ("rsa_decrypt    u", skey->u);
         }
     }
 
@@ -1396,7 +1590,7 @@ rsa_decrypt (gcry_sexp_t *r_plain, gcry_sexp_t s_data, gcry_sexp_t keyparms)
      the input and it has not been "padded" using multiples of N.
      This mitigates side-channel attacks (CVE-2013-4576).  */
   mpi_normalize (data);
-  mpi_fdiv_r (data, data, sk.n);
+  mpi_fdiv_r (data, data, skey->n);
 
   /* Allocate MPI for the plaintext.  */
   plain = mpi_snew (ctx.nbits);
@@ -1405,9 +1599,9 @@ rsa_decrypt (gcry_sexp_t *r_plain, gcry_sexp_t s_data, gcry_sexp_t keyparms)
      be practically mounted over the network as shown by Brumley and
      Boney in 2003.  */
   if ((ctx.flags & PUBKEY_FLAG_NO_BLINDING))
-    secret (plain, data, &sk);
+    secret (plain, data, skey);
   else
-    secret_blinded (plain, data, &sk, ctx.nbits);
+    secret_blinded (plain, data, skey, ctx.nbits, pkey);
 
   if (DBG_CIPHER)
     log_printmpi ("rsa_decrypt  res", plain);
@@ -1461,18 +1655,30 @@ rsa_decrypt (gcry_sexp_t *r_plain, gcry_sexp_t s_data, gcry_sexp_t keyparms)
 
 
 static gcry_err_code_t
-rsa_sign (gcry_sexp_t *r_sig, gcry_sexp_t s_data, gcry_sexp_t keyparms)
+rsa_decrypt (gcry_sexp_t *r_plain, gcry_sexp_t s_data, gcry_sexp_t keyparms)
+{
+  return decrypt_with_key (r_plain, s_data, keyparms, NULL);
+}
+
+
+/* Sign S_DATA with the key given by KEYPARMS or, if KEYPARMS is NULL,
+   with the prepared key PKEY.  */
+static gcry_err_code_t
+sign_with_key (gcry_sexp_t *r_sig, gcry_sexp_t s_data,
+               gcry_sexp_t keyparms, rsa_prepared_key_t *pkey)
 {
   gpg_err_code_t rc;
   struct pk_encoding_ctx ctx;
   gcry_mpi_t data = NULL;
   RSA_secret_key sk = {NULL, NULL, NULL, NULL, NULL, NULL};
+  RSA_secret_key *skey;
   RSA_public_key pk;
   gcry_mpi_t sig = NULL;
   gcry_mpi_t result = NULL;
 
   _gcry_pk_util_init_encoding_ctx (&ctx, PUBKEY_OP_SIGN,
-                                   rsa_get_nbits (keyparms));
+                                   keyparms? rsa_get_nbits (keyparms)
+                                   : pkey->nbits);
 
   /* Extract the data.  */
   rc = _gcry_pk_util_data_to_mpi (s_data, &data, &ctx);
@@ -1487,38 +1693,44 @@ rsa_sign (gcry_sexp_t *r_sig, gcry_sexp_t s_data, gcry_sexp_t keyparms)
     }
 
   /* Extract the key.  */
-  rc = sexp_extract_param (keyparms, NULL, "nedp?q?u?",
-                           &sk.n, &sk.e, &sk.d, &sk.p, &sk.q, &sk.u,
-                           NULL);
-  if (rc)
-    goto leave;
+  if (keyparms)
+    {
+      rc = sexp_extract_param (keyparms, NULL, "nedp?q?u?",
+                               &sk.n, &sk.e, &sk.d, &sk.p, &sk.q, &sk.u,
+                               NULL);
+      if (rc)
+        goto leave;
+      skey = &sk;
+    }
+  else
+    skey = &pkey->sk;
   if (DBG_CIPHER)
     {
-      log_printmpi ("rsa_sign      n", sk.n);
-      log_printmpi ("rsa_sign      e", sk.e);
+      log_printmpi ("rsa_sign      n", skey->n);
+      log_printmpi ("rsa_sign      e", skey->e);
       if (!fips_mode ())
         {
-          log_printmpi ("rsa_sign      d", sk.d);
-          log_printmpi ("rsa_sign      p", sk.p);
-          log_printmpi ("rsa_sign      q", sk.q);
-          log_printmpi ("rsa_sign      u", sk.u);
+          log_printmpi ("rsa_sign      d", skey->d);
+          log_printmpi ("rsa_sign      p", skey->p);
+          log_printmpi ("rsa_sign      q", skey->q);
+          log_printmpi ("rsa_sign      u", skey->u);
         }
     }
 
   /* Do RSA computation.  */
   sig = mpi_new (0);
   if ((ctx.flags & PUBKEY_FLAG_NO_BLINDING))
-    secret (sig, data, &sk);
+    secret (sig, data, skey);
   else
-    secret_blinded (sig, data, &sk, ctx.nbits);
+    secret_blinded (sig, data, skey, ctx.nbits, pkey);
   if (DBG_CIPHER)
     log_printmpi ("rsa_sign    res", sig);
 
   /* Check that the created signature is good.  This detects a failure
      of the CRT algorithm  (Lenstra's attack on RSA's use of the CRT).  */
   result = mpi_new (0);
-  pk.n = sk.n;
-  pk.e = sk.e;
+  pk.n = skey->n;
+  pk.e = skey->e;
   public (result, sig, &pk);
   if (mpi_cmp (result, data))
     {
@@ -1532,7 +1744,7 @@ rsa_sign (gcry_sexp_t *r_sig, gcry_sexp_t s_data, gcry_sexp_t keyparms)
       /* We need to make sure to return the correct length to avoid
          problems with missing leading zeroes.  */
       unsigned char *em;
-      size_t emlen = (mpi_get_nbits (sk.n)+7)/8;
+      size_t emlen = (mpi_get_nbits (skey->n)+7)/8;
 
       rc = _gcry_mpi_to_octet_string (&em, NULL, sig, emlen);
       if (!rc)
@@ -1562,6 +1774,109 @@ rsa_sign (gcry_sexp_t *r_sig, gcry_sexp_t s_data, gcry_sexp_t keyparms)
 }
 
 
+static gcry_err_code_t
+rsa_sign (gcry_sexp_t *r_sig, gcry_sexp_t s_data, gcry_sexp_t keyparms)
+{
+  return sign_with_key (r_sig, s_data, keyparms, NULL);
+}
+
+
+/* Release the prepared key KEY.  */
+static void
+rsa_release_prepared (void *key)
+{
+  rsa_prepared_key_t *pkey = key;
+
+  if (!pkey)
+    return;
+
+  _gcry_mpi_release (pkey->sk.n);
+  _gcry_mpi_release (pkey->sk.e);
+  _gcry_mpi_release (pkey->sk.d);
+  _gcry_mpi_release (pkey->sk.p);
+  _gcry_mpi_release (pkey->sk.q);
+  _gcry_mpi_release (pkey->sk.u);
+  _gcry_mpi_release (pkey->sk.dp);
+  _gcry_mpi_release (pkey->sk.dq);
+  _gcry_mpi_release (pkey->blinding.re);
+  _gcry_mpi_release (pkey->blinding.ri);
+  gpgrt_lock_destroy (&pkey->lock);
+  xfree (pkey);
+}
+
+
+/* Parse the secret key KEYPARMS and store an object with the key and
+   the values derived from it at R_KEY.  */
+static gcry_err_code_t
+rsa_prepare (void **r_key, gcry_sexp_t keyparms)
+{
+  gpg_err_code_t rc;
+  rsa_prepared_key_t *pkey;
+  gcry_mpi_t tmp;
+
+  *r_key = NULL;
+
+  pkey = xtrycalloc (1, sizeof *pkey);
+  if (!pkey)
+    return gpg_err_code_from_syserror ();
+  rc = gpgrt_lock_init (&pkey->lock);
+  if (rc)
+    {
+      xfree (pkey);
+      return rc;
+    }
+
+  rc = sexp_extract_param (keyparms, NULL, "nedp?q?u?",
+                           &pkey->sk.n, &pkey->sk.e, &pkey->sk.d,
+                           &pkey->sk.p, &pkey->sk.q, &pkey->sk.u,
+                           NULL);
+  if (rc)
+    {
+      rsa_release_prepared (pkey);
+      return rc;
+    }
+
+  /* Normalize the parameters now, so that using them later does not
+     modify them.  */
+  mpi_normalize (pkey->sk.n);
+  mpi_normalize (pkey->sk.e);
+  mpi_normalize (pkey->sk.d);
+  pkey->nbits = mpi_get_nbits (pkey->sk.n);
+
+  if (pkey->sk.p && pkey->sk.q && pkey->sk.u)
+    {
+      mpi_normalize (pkey->sk.p);
+      mpi_normalize (pkey->sk.q);
+      mpi_normalize (pkey->sk.u);
+      tmp = mpi_new (0);
+      pkey->sk.dp = mpi_snew (mpi_get_nbits (pkey->sk.p));
+      mpi_sub_ui (tmp, pkey->sk.p, 1);
+      mpi_fdiv_r (pkey->sk.dp, pkey->sk.d, tmp);
+      pkey->sk.dq = mpi_snew (mpi_get_nbits (pkey->sk.q));
+      mpi_sub_ui (tmp, pkey->sk.q, 1);
+      mpi_fdiv_r (pkey->sk.dq, pkey->sk.d, tmp);
+      _gcry_mpi_release (tmp);
+    }
+
+  *r_key = pkey;
+  return 0;
+}
+
+
+static gcry_err_code_t
+rsa_decrypt_prepared (gcry_sexp_t *r_plain, gcry_sexp_t s_data, void *key)
+{
+  return decrypt_with_key (r_plain, s_data, NULL, key);
+}
+
+
+static gcry_err_code_t
+rsa_sign_prepared (gcry_sexp_t *r_sig, gcry_sexp_t s_data, void *key)
+{
+  return sign_with_key (r_sig, s_data, NULL, key);
+}
+
+
 static gcry_err_code_t
 rsa_verify (gcry_sexp_t s_sig, gcry_sexp_t s_data, gcry_sexp_t keyparms)
 {
@@ -2031,5 +2346,12 @@ gcry_pk_spec_t _gcry_pubkey_spec_rsa =
     rsa_verify,
     rsa_get_nbits,
     run_selftests,
-    compute_keygrip
+    compute_keygrip,
+    NULL,
+    NULL,
+    NULL,
+    rsa_prepare,
+    rsa_sign_prepared,
+    rsa_decrypt_prepared,
+    rsa_release_prepared
   };
@@ -49,6 +49,71 @@
 #include "kdf-internal.h"
 #include "bufhelp.h"
 
+
+/* USE_SSE2 indicates whether to compile with the AMD64 SSE2 code. */
+#undef USE_SSE2
+#if defined(__x86_64__) && (defined(HAVE_COMPATIBLE_GCC_AMD64_PLATFORM_AS) || \
+    defined(HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS))
+# define USE_SSE2 1
+#endif
+
+#ifdef USE_SSE2
+/* Assembly implementations use SystemV ABI, ABI conversion and additional
+ * stack to store XMM6-XMM15 needed on Win64. */
+# ifdef HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS
+#  define ASM_FUNC_ABI __attribute__((sysv_abi))
+# else
+#  define ASM_FUNC_ABI
+# endif
+
+void _gcry_scrypt_blockmix_sse2 (unsigned char *out, const unsigned char *in,
+                                 size_t r) ASM_FUNC_ABI;
+void _gcry_scrypt_blockmix_xor_sse2 (unsigned char *out,
+                                     const unsigned char *in,
+                                     const unsigned char *in2,
+                                     size_t r) ASM_FUNC_ABI;
+# define USE_SHUFFLED_BLOCKMIX 1
+# define scrypt_blockmix_shuffled _gcry_scrypt_blockmix_sse2
+# define scrypt_blockmix_xor_shuffled _gcry_scrypt_blockmix_xor_sse2
+#endif /*USE_SSE2*/
+
+/* USE_AARCH64_SIMD indicates whether to compile with the ARMv8 SIMD
+ * code.  Like SSE2 on AMD64, it is part of the base architecture.  */
+#undef USE_AARCH64_SIMD
+#ifdef ENABLE_NEON_SUPPORT
+# if defined(__AARCH64EL__) \
+     && defined(HAVE_COMPATIBLE_GCC_AARCH64_PLATFORM_AS) \
+     && defined(HAVE_GCC_INLINE_ASM_AARCH64_NEON)
+#  define USE_AARCH64_SIMD 1
+# endif
+#endif
+
+#ifdef USE_AARCH64_SIMD
+void _gcry_scrypt_blockmix_aarch64 (unsigned char *out,
+                                    const unsigned char *in, size_t r);
+void _gcry_scrypt_blockmix_xor_aarch64 (unsigned char *out,
+                                        const unsigned char *in,
+                                        const unsigned char *in2, size_t r);
+# define USE_SHUFFLED_BLOCKMIX 1
+# define scrypt_blockmix_shuffled _gcry_scrypt_blockmix_aarch64
+# define scrypt_blockmix_xor_shuffled _gcry_scrypt_blockmix_xor_aarch64
+#endif /*USE_AARCH64_SIMD*/
+
+
+/* State of a prepared scrypt derivation.  */
+struct scrypt_ctx_s
+{
+  u64 N;                  /* CPU/memory cost parameter.  */
+  u32 r;                  /* Block size.  */
+  u32 p;                  /* Parallelization parameter.  */
+  size_t r128;            /* Size of a block: R * 128.  */
+  unsigned int nworkers;  /* Number of lanes computed at the same time.  */
+  size_t worksize;        /* Size of the V and tmp buffers of a worker.  */
+  unsigned char *B;       /* P * R128 bytes.  */
+  unsigned char *V;       /* NWORKERS * WORKSIZE bytes.  */
+};
+
+
 /* We really need a 64 bit type for this code.  */
 #define SALSA20_INPUT_LENGTH 16
 
@@ -73,6 +138,7 @@
   } while(0)
 
 
+#ifndef USE_SHUFFLED_BLOCKMIX
 static void
 salsa20_core (u32 *dst, const u32 *src, unsigned int rounds)
 {
@@ -170,12 +236,64 @@ scrypt_block_mix (u32 r, unsigned char *B, unsigned char *tmp2)
     }
 #endif
 }
+#endif /*!USE_SHUFFLED_BLOCKMIX*/
+
+
+#ifdef USE_SHUFFLED_BLOCKMIX
+/* The version of scrypt_ro_mix for the SSE2 and ARMv8 SIMD BlockMix.
+   B is shuffled into V[0], all blocks in V, X and Y are shuffled, and
+   the result is restored to the normal word order in B.  TMP is
+   2 * R * 128 bytes long.  */
+static void
+scrypt_ro_mix_shuffled (u32 r, unsigned char *B, u64 N,
+                        unsigned char *V, unsigned char *tmp)
+{
+  size_t r128 = (size_t)r * 128;
+  unsigned char *X = tmp, *Y = tmp + r128, *T;
+  const unsigned char *last;
+  size_t k;
+  u64 i, j;
+  unsigned int w;
+
+  for (k = 0; k < 2 * r; k++)
+    for (w = 0; w < 16; w++)
+      buf_put_le32 (&V[k * 64 + w * 4],
+                    buf_get_le32 (&B[k * 64 + (w * 5 % 16) * 4]));
+
+  /* V[i + 1] = BlockMix (V[i]), X = BlockMix (V[N - 1])  */
+  for (i = 0; i < N - 1; i++)
+    scrypt_blockmix_shuffled (&V[(i + 1) * r128], &V[i * r128], r);
+  scrypt_blockmix_shuffled (X, &V[(N - 1) * r128], r);
+
+  for (i = 0; i < N; i++)
+    {
+      /* Words 0 and 1 of the last block are at 0 and 13.  */
+      last = &X[r128 - 64];
+      j = (((u64)buf_get_le32 (&last[13 * 4]) << 32)
+           | buf_get_le32 (&last[0])) % N;
+
+      /* Y = BlockMix (X xor V[j])  */
+      scrypt_blockmix_xor_shuffled (Y, X, &V[j * r128], r);
+      T = X;
+      X = Y;
+      Y = T;
+    }
+
+  for (k = 0; k < 2 * r; k++)
+    for (w = 0; w < 16; w++)
+      buf_put_le32 (&B[k * 64 + (w * 5 % 16) * 4],
+                    buf_get_le32 (&X[k * 64 + w * 4]));
+}
+#endif /*USE_SHUFFLED_BLOCKMIX*/
 
 
 static void
 scrypt_ro_mix (u32 r, unsigned char *B, u64 N,
 	      unsigned char *tmp1, unsigned char *tmp2)
 {
+#ifdef USE_SHUFFLED_BLOCKMIX
+  scrypt_ro_mix_shuffled (r, B, N, tmp1, tmp2);
+#else /*!USE_SHUFFLED_BLOCKMIX*/
   unsigned char *X = B, *T = B;
   u64 i;
 
@@ -231,30 +349,47 @@ scrypt_ro_mix (u32 r, unsigned char *B, u64 N,
       putchar ('\n');
     }
 #endif
+#endif /*!USE_SHUFFLED_BLOCKMIX*/
 }
 
 
-/*
- *
- */
+/* Compute the lanes IDX, IDX + NWORKERS, ... of the scrypt context
+   ARG, each with its own part of V.  The part is wiped at the end:
+   every block in it is derived from the passphrase, and V[N - 1]
+   alone is enough to compute the result of a lane.  */
+static void
+scrypt_worker (void *arg, unsigned int idx)
+{
+  scrypt_ctx_t ctx = arg;
+  unsigned char *tmp1 = ctx->V + idx * ctx->worksize;
+  unsigned char *tmp2 = tmp1 + ctx->N * ctx->r128;
+  u32 i;
+
+  for (i = idx; i < ctx->p; i += ctx->nworkers)
+    scrypt_ro_mix (ctx->r, &ctx->B[i * ctx->r128], ctx->N, tmp1, tmp2);
+
+  wipememory (tmp1, ctx->worksize);
+}
+
+
+/* Check the scrypt parameters and allocate the memory for them.  If
+   PARALLEL is set, the P lanes are computed by up to one worker
+   thread per CPU, each with its own V.  On success the new context is
+   stored at R_CTX.  */
 gcry_err_code_t
-_gcry_kdf_scrypt (const unsigned char *passwd, size_t passwdlen,
-                  int algo, int subalgo,
-                  const unsigned char *salt, size_t saltlen,
-                  unsigned long iterations,
-                  size_t dkLen, unsigned char *DK)
+_gcry_kdf_scrypt_prepare (scrypt_ctx_t *r_ctx, int algo, int subalgo,
+                          unsigned long iterations, int parallel)
 {
+  scrypt_ctx_t ctx;
   u64 N = subalgo;    /* CPU/memory cost parameter.  */
   u32 r;              /* Block size.  */
   u32 p = iterations; /* Parallelization parameter.  */
-
-  gpg_err_code_t ec;
-  u32 i;
-  unsigned char *B = NULL;
-  unsigned char *tmp1 = NULL;
-  unsigned char *tmp2 = NULL;
+  unsigned int nworkers = 1;
   size_t r128;
   size_t nbytes;
+  gpg_err_code_t ec;
+
+  *r_ctx = NULL;
 
   if (subalgo < 1 || !iterations)
     return GPG_ERR_INV_VALUE;
@@ -278,45 +413,117 @@ _gcry_kdf_scrypt (const unsigned char *passwd, size_t passwdlen,
   if (r128 && nbytes / r128 != N)
     return GPG_ERR_ENOMEM;
 
-  nbytes = 64 + r128;
-  if (nbytes < r128)
+  /* The SIMD code needs two blocks of temporary space, the generic
+     code 64 bytes and one block.  */
+  nbytes += 2 * r128;
+  if (nbytes < 2 * r128)
     return GPG_ERR_ENOMEM;
 
-  B = xtrymalloc (p * r128);
-  if (!B)
+  if (parallel)
     {
-      ec = gpg_err_code_from_syserror ();
-      goto leave;
+      nworkers = _gcry_get_ncpus ();
+      if (nworkers > p)
+        nworkers = p;
+      if (nworkers < 1)
+        nworkers = 1;
     }
+  if (nworkers * nbytes / nworkers != nbytes)
+    return GPG_ERR_ENOMEM;
 
-  tmp1 = xtrymalloc (N * r128);
-  if (!tmp1)
+  ctx = xtrycalloc (1, sizeof *ctx);
+  if (!ctx)
+    return gpg_err_code_from_syserror ();
+  ctx->N = N;
+  ctx->r = r;
+  ctx->p = p;
+  ctx->r128 = r128;
+  ctx->nworkers = nworkers;
+  ctx->worksize = nbytes;
+
+  ctx->B = xtrymalloc (p * r128);
+  if (!ctx->B)
     {
       ec = gpg_err_code_from_syserror ();
       goto leave;
     }
 
-  tmp2 = xtrymalloc (64 + r128);
-  if (!tmp2)
+  ctx->V = xtrymalloc (nworkers * nbytes);
+  if (!ctx->V)
     {
       ec = gpg_err_code_from_syserror ();
       goto leave;
     }
 
+  *r_ctx = ctx;
+  return 0;
+
+ leave:
+  _gcry_kdf_scrypt_release (ctx);
+  return ec;
+}
+
+
+/* Release the scrypt context CTX.  */
+void
+_gcry_kdf_scrypt_release (scrypt_ctx_t ctx)
+{
+  if (!ctx)
+    return;
+  if (ctx->V)
+    wipememory (ctx->V, ctx->nworkers * ctx->worksize);
+  xfree (ctx->V);
+  xfree (ctx->B);
+  xfree (ctx);
+}
+
+
+/* Derive DKLEN bytes into DK using the prepared scrypt context CTX.
+   The context may only be used by one thread at a time.  */
+gcry_err_code_t
+_gcry_kdf_scrypt_compute (scrypt_ctx_t ctx,
+                          const unsigned char *passwd, size_t passwdlen,
+                          const unsigned char *salt, size_t saltlen,
+                          size_t dkLen, unsigned char *DK)
+{
+  size_t nbytes = ctx->p * ctx->r128;
+  gpg_err_code_t ec;
+
   ec = _gcry_kdf_pkdf2 (passwd, passwdlen, GCRY_MD_SHA256, salt, saltlen,
-                        1 /* iterations */, p * r128, B);
+                        1 /* iterations */, nbytes, ctx->B);
+
+  if (!ec)
+    {
+      _gcry_run_workers (ctx->nworkers, scrypt_worker, ctx);
 
-  for (i = 0; !ec && i < p; i++)
-    scrypt_ro_mix (r, &B[i * r128], N, tmp1, tmp2);
+      ec = _gcry_kdf_pkdf2 (passwd, passwdlen, GCRY_MD_SHA256, ctx->B, nbytes,
+                            1 /* iterations */, dkLen, DK);
+    }
 
-  for (i = 0; !ec && i < p; i++)
-    ec = _gcry_kdf_pkdf2 (passwd, passwdlen, GCRY_MD_SHA256, B, p * r128,
-                          1 /* iterations */, dkLen, DK);
+  wipememory (ctx->B, nbytes);
+  return ec;
+}
 
- leave:
-  xfree (tmp2);
-  xfree (tmp1);
-  xfree (B);
+
+/*
+ *
+ */
+gcry_err_code_t
+_gcry_kdf_scrypt (const unsigned char *passwd, size_t passwdlen,
+                  int algo, int subalgo,
+                  const unsigned char *salt, size_t saltlen,
+                  unsigned long iterations,
+                  size_t dkLen, unsigned char *DK)
+{
+  scrypt_ctx_t ctx;
+  gpg_err_code_t ec;
+
+  ec = _gcry_kdf_scrypt_prepare (&ctx, algo, subalgo, iterations, 0);
+  if (ec)
+    return ec;
+
+  ec = _gcry_kdf_scrypt_compute (ctx, passwd, passwdlen, salt, saltlen,
+                                 dkLen, DK);
+  _gcry_kdf_scrypt_release (ctx);
 
   return ec;
 }
@@ -0,0 +1,235 @@
+/* sha1-intel-shaext.c - SHAEXT accelerated SHA-1 transform function
+ *
+ * This file is part of Libgcrypt.
+ *
+ * Libgcrypt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * Libgcrypt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "types.h"
+
+#if defined(HAVE_GCC_INLINE_ASM_SHAEXT) && \
+    defined(HAVE_GCC_INLINE_ASM_SSE41) && defined(USE_SHA1) && \
+    defined(ENABLE_SHAEXT_SUPPORT)
+
+#if _GCRY_GCC_VERSION >= 40400 /* 4.4 */
+/* Prevent compiler from issuing SSE instructions between asm blocks. */
+#  pragma GCC target("no-sse")
+#endif
+
+/* Byte-swap mask for loading message blocks.  */
+static const unsigned char be_mask[16] __attribute__ ((aligned (16))) =
+  { 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+
+/* Register usage:
+ *   xmm0: ABCD
+ *   xmm1, xmm2: E0, E1
+ *   xmm3...xmm6: MSG0...MSG3
+ *   xmm7: byte-swap mask
+ */
+#define ABCD "%%xmm0"
+#define E0   "%%xmm1"
+#define E1   "%%xmm2"
+#define MSG0 "%%xmm3"
+#define MSG1 "%%xmm4"
+#define MSG2 "%%xmm5"
+#define MSG3 "%%xmm6"
+#define MASK "%%xmm7"
+
+/* Four rounds with message expansion.  MSG_A is the current message
+ * quad, E_X holds the E value for these rounds and E_Y receives the
+ * state for the next four rounds.  */
+#define ROUNDS4(f, msg_a, msg_b, msg_c, msg_d, e_x, e_y) \
+	"sha1nexte " msg_a ", " e_x "\n\t" \
+	"movdqa " ABCD ", " e_y "\n\t" \
+	"sha1msg2 " msg_a ", " msg_b "\n\t" \
+	"sha1rnds4 $" #f ", " e_x ", " ABCD "\n\t" \
+	"sha1msg1 " msg_a ", " msg_d "\n\t" \
+	"pxor " msg_a ", " msg_c "\n\t"
+
+/* Load and byte-swap message quad.  */
+#define LOAD_MSG(i, msg) \
+	"movdqu " #i "*16(%[data]), " msg "\n\t" \
+	"pshufb " MASK ", " msg "\n\t"
+
+#ifdef __WIN64__
+/* XMM6 and XMM7 are callee-saved registers on WIN64. */
+# define shaext_prepare_variable char win64tmp[2 * 16]
+# define shaext_prepare()                                               \
+   do { asm volatile ("movdqu %%xmm6, 0*16(%0)\n\t"                     \
+                      "movdqu %%xmm7, 1*16(%0)\n\t"                     \
+                      :                                                 \
+                      : "r" (win64tmp)                                  \
+                      : "memory");                                      \
+   } while (0)
+# define shaext_cleanup()                                               \
+   do { asm volatile ("pxor %%xmm0, %%xmm0\n\t"                         \
+                      "pxor %%xmm1, %%xmm1\n\t"                         \
+                      "pxor %%xmm2, %%xmm2\n\t"                         \
+                      "pxor %%xmm3, %%xmm3\n\t"                         \
+                      "pxor %%xmm4, %%xmm4\n\t"                         \
+                      "pxor %%xmm5, %%xmm5\n\t"                         \
+                      "movdqu 0*16(%0), %%xmm6\n\t"                     \
+                      "movdqu 1*16(%0), %%xmm7\n\t"                     \
+                      :                                                 \
+                      : "r" (win64tmp)                                  \
+                      : "memory");                                      \
+   } while (0)
+#else
+# define shaext_prepare_variable
+# define shaext_prepare() do { } while (0)
+# define shaext_cleanup()                                               \
+   do { asm volatile ("pxor %%xmm0, %%xmm0\n\t"                         \
+                      "pxor %%xmm1, %%xmm1\n\t"                         \
+                      "pxor %%xmm2, %%xmm2\n\t"                         \
+                      "pxor %%xmm3, %%xmm3\n\t"                         \
+                      "pxor %%xmm4, %%xmm4\n\t"                         \
+                      "pxor %%xmm5, %%xmm5\n\t"                         \
+                      "pxor %%xmm6, %%xmm6\n\t"                         \
+                      "pxor %%xmm7, %%xmm7\n\t"                         \
+                      ::: "memory");                                    \
+   } while (0)
+#endif
+
+
+/*
+ * Transform NBLKS*64 bytes (NBLKS*16 32-bit words) at DATA.
+ * STATE points to the five 32-bit words H0...H4.
+ */
+unsigned int
+_gcry_sha1_transform_intel_shaext (void *state, const unsigned char *data,
+                                   size_t nblks)
+{
+  u32 *h = state;
+  struct
+  {
+    unsigned char abcd[16];
+    unsigned char e[16];
+  } save __attribute__ ((aligned (16)));
+  shaext_prepare_variable;
+
+  if (nblks == 0)
+    return 0;
+
+  shaext_prepare ();
+
+  asm volatile ("movdqa %[mask], " MASK "\n\t"
+                "movdqu %[h0], " ABCD "\n\t"
+                "movd %[h4], " E0 "\n\t"
+                "pshufd $0x1b, " ABCD ", " ABCD "\n\t"
+                "pslldq $12, " E0 "\n\t"
+                :
+                : [mask] "m" (*be_mask),
+                  [h0] "m" (*h),
+                  [h4] "m" (h[4])
+                : "memory" );
+
+  do
+    {
+      asm volatile (
+        "movdqa " E0 ", %[e_save]\n\t"
+        "movdqa " ABCD ", %[abcd_save]\n\t"
+
+        /* Rounds 0-3 */
+        LOAD_MSG(0, MSG0)
+        "paddd " MSG0 ", " E0 "\n\t"
+        "movdqa " ABCD ", " E1 "\n\t"
+        "sha1rnds4 $0, " E0 ", " ABCD "\n\t"
+
+        /* Rounds 4-7 */
+        LOAD_MSG(1, MSG1)
+        "sha1nexte " MSG1 ", " E1 "\n\t"
+        "movdqa " ABCD ", " E0 "\n\t"
+        "sha1rnds4 $0, " E1 ", " ABCD "\n\t"
+        "sha1msg1 " MSG1 ", " MSG0 "\n\t"
+
+        /* Rounds 8-11 */
+        LOAD_MSG(2, MSG2)
+        "sha1nexte " MSG2 ", " E0 "\n\t"
+        "movdqa " ABCD ", " E1 "\n\t"
+        "sha1rnds4 $0, " E0 ", " ABCD "\n\t"
+        "sha1msg1 " MSG2 ", " MSG1 "\n\t"
+        "pxor " MSG2 ", " MSG0 "\n\t"
+
+        /* Rounds 12-15 */
+        LOAD_MSG(3, MSG3)
+        ROUNDS4(0, MSG3, MSG0, MSG1, MSG2, E1, E0)
+
+        /* Rounds 16-67 */
+        ROUNDS4(0, MSG0, MSG1, MSG2, MSG3, E0, E1)
+        ROUNDS4(1, MSG1, MSG2, MSG3, MSG0, E1, E0)
+        ROUNDS4(1, MSG2, MSG3, MSG0, MSG1, E0, E1)
+        ROUNDS4(1, MSG3, MSG0, MSG1, MSG2, E1, E0)
+        ROUNDS4(1, MSG0, MSG1, MSG2, MSG3, E0, E1)
+        ROUNDS4(1, MSG1, MSG2, MSG3, MSG0, E1, E0)
+        ROUNDS4(2, MSG2, MSG3, MSG0, MSG1, E0, E1)
+        ROUNDS4(2, MSG3, MSG0, MSG1, MSG2, E1, E0)
+        ROUNDS4(2, MSG0, MSG1, MSG2, MSG3, E0, E1)
+        ROUNDS4(2, MSG1, MSG2, MSG3, MSG0, E1, E0)
+        ROUNDS4(2, MSG2, MSG3, MSG0, MSG1, E0, E1)
+        ROUNDS4(3, MSG3, MSG0, MSG1, MSG2, E1, E0)
+        ROUNDS4(3, MSG0, MSG1, MSG2, MSG3, E0, E1)
+
+        /* Rounds 68-71 */
+        "sha1nexte " MSG1 ", " E1 "\n\t"
+        "movdqa " ABCD ", " E0 "\n\t"
+        "sha1msg2 " MSG1 ", " MSG2 "\n\t"
+        "sha1rnds4 $3, " E1 ", " ABCD "\n\t"
+        "pxor " MSG1 ", " MSG3 "\n\t"
+
+        /* Rounds 72-75 */
+        "sha1nexte " MSG2 ", " E0 "\n\t"
+        "movdqa " ABCD ", " E1 "\n\t"
+        "sha1msg2 " MSG2 ", " MSG3 "\n\t"
+        "sha1rnds4 $3, " E0 ", " ABCD "\n\t"
+
+        /* Rounds 76-79 */
+        "sha1nexte " MSG3 ", " E1 "\n\t"
+        "movdqa " ABCD ", " E0 "\n\t"
+        "sha1rnds4 $3, " E1 ", " ABCD "\n\t"
+
+        /* Add saved state.  */
+        "sha1nexte %[e_save], " E0 "\n\t"
+        "paddd %[abcd_save], " ABCD "\n\t"
+        : [abcd_save] "+m" (save.abcd),
+          [e_save] "+m" (save.e)
+        : [data] "r" (data)
+        : "memory" );
+
+      data += 64;
+    }
+  while (--nblks);
+
+  asm volatile ("pshufd $0x1b, " ABCD ", " ABCD "\n\t"
+                "psrldq $12, " E0 "\n\t"
+                "movdqu " ABCD ", %[h0]\n\t"
+                "movd " E0 ", %[h4]\n\t"
+                "pxor " ABCD ", " ABCD "\n\t"
+                "movdqa " ABCD ", %[abcd_save]\n\t"
+                "movdqa " ABCD ", %[e_save]\n\t"
+                : [h0] "=m" (*h),
+                  [h4] "=m" (h[4]),
+                  [abcd_save] "=m" (save.abcd),
+                  [e_save] "=m" (save.e)
+                :
+                : "memory" );
+
+  shaext_cleanup ();
+
+  /* No stack burning needed, the saved state was cleared above.  */
+  return 0;
+}
+
+#endif /* HAVE_GCC_INLINE_ASM_SHAEXT */
@@ -68,6 +68,23 @@
 # define USE_BMI2 1
 #endif
 
+/* USE_AVX2 indicates whether to compile with Intel AVX2 multi-buffer
+ * code. */
+#undef USE_AVX2
+#if defined(__x86_64__) && defined(HAVE_GCC_INLINE_ASM_AVX2) && \
+    (defined(HAVE_COMPATIBLE_GCC_AMD64_PLATFORM_AS) || \
+     defined(HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS))
+# define USE_AVX2 1
+#endif
+
+/* USE_SHAEXT indicates whether to compile with Intel SHA Extension code. */
+#undef USE_SHAEXT
+#if defined(HAVE_GCC_INLINE_ASM_SHAEXT) && \
+    defined(HAVE_GCC_INLINE_ASM_SSE41) && \
+    defined(ENABLE_SHAEXT_SUPPORT)
+# define USE_SHAEXT 1
+#endif
+
 /* USE_NEON indicates whether to enable ARM NEON assembly code. */
 #undef USE_NEON
 #ifdef ENABLE_NEON_SUPPORT
@@ -138,6 +155,9 @@ sha1_init (void *context, unsigned int flags)
 #ifdef USE_BMI2
   hd->use_bmi2 = (features & HWF_INTEL_AVX) && (features & HWF_INTEL_BMI2);
 #endif
+#ifdef USE_SHAEXT
+  hd->use_shaext = (features & HWF_INTEL_SHAEXT) != 0;
+#endif
 #ifdef USE_NEON
   hd->use_neon = (features & HWF_ARM_NEON) != 0;
 #endif
@@ -311,7 +331,8 @@ transform_blk (void *ctx, const unsigned char *data)
  * stack to store XMM6-XMM15 needed on Win64. */
 #undef ASM_FUNC_ABI
 #undef ASM_EXTRA_STACK
-#if defined(USE_SSSE3) || defined(USE_AVX) || defined(USE_BMI2)
+#if defined(USE_SSSE3) || defined(USE_AVX) || defined(USE_BMI2) || \
+    defined(USE_AVX2)
 # ifdef HAVE_COMPATIBLE_GCC_WIN64_PLATFORM_AS
 #  define ASM_FUNC_ABI __attribute__((sysv_abi))
 #  define ASM_EXTRA_STACK (10 * 16)
@@ -340,6 +361,20 @@ _gcry_sha1_transform_amd64_avx_bmi2 (void *state, const unsigned char *data,
                                      size_t nblks) ASM_FUNC_ABI;
 #endif
 
+#ifdef USE_SHAEXT
+/* Does not need ASM_FUNC_ABI */
+unsigned int
+_gcry_sha1_transform_intel_shaext (void *state, const unsigned char *data,
+                                   size_t nblks);
+#endif
+
+#ifdef USE_AVX2
+unsigned int
+_gcry_sha1_transform_amd64_avx2_x8 (u32 state[5 * 8],
+                                    const unsigned char **data,
+                                    size_t nblks) ASM_FUNC_ABI;
+#endif
+
 
 static unsigned int
 transform (void *ctx, const unsigned char *data, size_t nblks)
@@ -347,6 +382,10 @@ transform (void *ctx, const unsigned char *data, size_t nblks)
   SHA1_CONTEXT *hd = ctx;
   unsigned int burn;
 
+#ifdef USE_SHAEXT
+  if (hd->use_shaext)
+    return _gcry_sha1_transform_intel_shaext (&hd->h0, data, nblks);
+#endif
 #ifdef USE_BMI2
   if (hd->use_bmi2)
     return _gcry_sha1_transform_amd64_avx_bmi2 (&hd->h0, data, nblks)
@@ -524,6 +563,106 @@ _gcry_sha1_hash_buffers (void *outbuf, const gcry_buffer_t *iov, int iovcnt)
 }
 
 
+static const u32 sha1_iv[5] =
+  {
+    0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+  };
+
+/* Single lane transform for the multi-buffer helper.  */
+static unsigned int
+transform_lane (u32 *state, const unsigned char *data, size_t nblks)
+{
+  SHA1_CONTEXT hd;
+  unsigned int burn;
+
+  sha1_init (&hd, 0);
+  hd.h0 = state[0];
+  hd.h1 = state[1];
+  hd.h2 = state[2];
+  hd.h3 = state[3];
+  hd.h4 = state[4];
+
+  burn = transform (&hd, data, nblks);
+
+  state[0] = hd.h0;
+  state[1] = hd.h1;
+  state[2] = hd.h2;
+  state[3] = hd.h3;
+  state[4] = hd.h4;
+  wipememory (&hd, sizeof(hd));
+
+  return burn;
+}
+
+#ifdef USE_AVX2
+static unsigned int
+transform_multi_avx2 (u32 *state, const unsigned char **data, size_t nblks)
+{
+  return _gcry_sha1_transform_amd64_avx2_x8 (state, data, nblks)
+         + 4 * sizeof(void*) + ASM_EXTRA_STACK;
+}
+#endif
+
+
+/* Fill SPEC with the description of SHA-1 for the multi-buffer
+ * helper.  If no multi-lane transform is available, NLANES is set to
+ * 1 and TRANSFORM_MULTI to NULL.  */
+void
+_gcry_sha1_get_multi_spec (gcry_md_multi_spec_t *spec)
+{
+#ifdef USE_AVX2
+  unsigned int features = _gcry_get_hw_features ();
+#endif
+
+  spec->nlanes = 1;
+  spec->min_lanes = 1;
+  spec->nwords = 5;
+  spec->dlen = 20;
+  spec->iv = sha1_iv;
+  spec->transform_multi = NULL;
+  spec->transform_lane = transform_lane;
+
+#ifdef USE_AVX2
+  if ((features & HWF_INTEL_AVX2))
+    {
+      spec->nlanes = 8;
+      /* With SHAEXT, eight AVX2 lanes pay off only if most are busy.  */
+      spec->min_lanes = (features & HWF_INTEL_SHAEXT) ? 5 : 3;
+      spec->transform_multi = transform_multi_avx2;
+    }
+#endif
+}
+
+
+/* Shortcut function which puts the hash values of NMSGS independent
+ * messages given by IOV consecutively into OUTBUF, which must have a
+ * size of 20 bytes for each message.  */
+void
+_gcry_sha1_hash_buffers_multi (void *outbuf, const gcry_buffer_t *iov,
+                               int nmsgs)
+{
+  unsigned char *out = outbuf;
+  gcry_md_multi_spec_t spec;
+  SHA1_CONTEXT hd;
+
+  _gcry_sha1_get_multi_spec (&spec);
+  if (spec.transform_multi)
+    {
+      _gcry_md_block_hash_multi (&spec, outbuf, iov, nmsgs);
+      return;
+    }
+
+  for (; nmsgs > 0; iov++, nmsgs--, out += 20)
+    {
+      sha1_init (&hd, 0);
+      _gcry_md_block_write (&hd,
+                            (const char*)iov[0].data + iov[0].off, iov[0].len);
+      sha1_final (&hd);
+      memcpy (out, hd.bctx.buf, 20);
+    }
+}
+
+
 
 /*
      Self-test section.
@@ -0,0 +1,267 @@
+/* sha256-intel-shaext.c - SHAEXT accelerated SHA-256 transform function
+ *
+ * This file is part of Libgcrypt.
+ *
+ * Libgcrypt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * Libgcrypt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "types.h"
+
+#if defined(HAVE_GCC_INLINE_ASM_SHAEXT) && \
+    defined(HAVE_GCC_INLINE_ASM_SSE41) && defined(USE_SHA256) && \
+    defined(ENABLE_SHAEXT_SUPPORT)
+
+#if _GCRY_GCC_VERSION >= 40400 /* 4.4 */
+/* Prevent compiler from issuing SSE instructions between asm blocks. */
+#  pragma GCC target("no-sse")
+#endif
+
+/* Byte-swap mask for loading message blocks.  */
+static const unsigned char bshuf_mask[16] __attribute__ ((aligned (16))) =
+  { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+
+static const u32 K[64] __attribute__ ((aligned (16))) =
+  {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+  };
+
+/* Register usage:
+ *   xmm0: MSG (implicit operand of sha256rnds2)
+ *   xmm1, xmm2: STATE0 (ABEF), STATE1 (CDGH)
+ *   xmm3...xmm6: TMP0...TMP3, message schedule
+ *   xmm7: TMP4
+ */
+#define MSG    "%%xmm0"
+#define STATE0 "%%xmm1"
+#define STATE1 "%%xmm2"
+#define TMP0   "%%xmm3"
+#define TMP1   "%%xmm4"
+#define TMP2   "%%xmm5"
+#define TMP3   "%%xmm6"
+#define TMP4   "%%xmm7"
+
+/* Four rounds using message quad in MSG.  */
+#define ROUNDS4_HALF1(i) \
+	"paddd " #i "*16(%[k]), " MSG "\n\t" \
+	"sha256rnds2 " STATE0 ", " STATE1 "\n\t"
+#define ROUNDS4_HALF2() \
+	"pshufd $0x0e, " MSG ", " MSG "\n\t" \
+	"sha256rnds2 " STATE1 ", " STATE0 "\n\t"
+
+/* Load and byte-swap message quad to MSG and TMP.  */
+#define LOAD_MSG(i, tmp) \
+	"movdqu " #i "*16(%[data]), " MSG "\n\t" \
+	"pshufb %[mask], " MSG "\n\t" \
+	"movdqa " MSG ", " tmp "\n\t"
+
+/* Message expansion: compute next quad in T_NEXT using current quad
+ * T_CUR and previous quad T_PREV.  */
+#define SCHED2(t_cur, t_prev, t_next) \
+	"movdqa " t_cur ", " TMP4 "\n\t" \
+	"palignr $4, " t_prev ", " TMP4 "\n\t" \
+	"paddd " TMP4 ", " t_next "\n\t" \
+	"sha256msg2 " t_cur ", " t_next "\n\t"
+#define SCHED1(t_cur, t_prev) \
+	"sha256msg1 " t_cur ", " t_prev "\n\t"
+
+/* Four rounds with full message expansion.  */
+#define ROUNDS4(i, t_cur, t_prev, t_next) \
+	"movdqa " t_cur ", " MSG "\n\t" \
+	ROUNDS4_HALF1(i) \
+	SCHED2(t_cur, t_prev, t_next) \
+	ROUNDS4_HALF2() \
+	SCHED1(t_cur, t_prev)
+
+#ifdef __WIN64__
+/* XMM6 and XMM7 are callee-saved registers on WIN64. */
+# define shaext_prepare_variable char win64tmp[2 * 16]
+# define shaext_prepare()                                               \
+   do { asm volatile ("movdqu %%xmm6, 0*16(%0)\n\t"                     \
+                      "movdqu %%xmm7, 1*16(%0)\n\t"                     \
+                      :                                                 \
+                      : "r" (win64tmp)                                  \
+                      : "memory");                                      \
+   } while (0)
+# define shaext_cleanup()                                               \
+   do { asm volatile ("pxor %%xmm0, %%xmm0\n\t"                         \
+                      "pxor %%xmm1, %%xmm1\n\t"                         \
+                      "pxor %%xmm2, %%xmm2\n\t"                         \
+                      "pxor %%xmm3, %%xmm3\n\t"                         \
+                      "pxor %%xmm4, %%xmm4\n\t"                         \
+                      "pxor %%xmm5, %%xmm5\n\t"                         \
+                      "movdqu 0*16(%0), %%xmm6\n\t"                     \
+                      "movdqu 1*16(%0), %%xmm7\n\t"                     \
+                      :                                                 \
+                      : "r" (win64tmp)                                  \
+                      : "memory");                                      \
+   } while (0)
+#else
+# define shaext_prepare_variable
+# define shaext_prepare() do { } while (0)
+# define shaext_cleanup()                                               \
+   do { asm volatile ("pxor %%xmm0, %%xmm0\n\t"                         \
+                      "pxor %%xmm1, %%xmm1\n\t"                         \
+                      "pxor %%xmm2, %%xmm2\n\t"                         \
+                      "pxor %%xmm3, %%xmm3\n\t"                         \
+                      "pxor %%xmm4, %%xmm4\n\t"                         \
+                      "pxor %%xmm5, %%xmm5\n\t"                         \
+                      "pxor %%xmm6, %%xmm6\n\t"                         \
+                      "pxor %%xmm7, %%xmm7\n\t"                         \
+                      ::: "memory");                                    \
+   } while (0)
+#endif
+
+
+/*
+ * Transform NBLKS*64 bytes (NBLKS*16 32-bit words) at DATA.
+ * STATE points to the eight 32-bit words H0...H7.
+ */
+unsigned int
+_gcry_sha256_transform_intel_shaext (u32 *state, const unsigned char *data,
+                                     size_t nblks)
+{
+  struct
+  {
+    unsigned char abef[16];
+    unsigned char cdgh[16];
+  } save __attribute__ ((aligned (16)));
+  shaext_prepare_variable;
+
+  if (nblks == 0)
+    return 0;
+
+  shaext_prepare ();
+
+  asm volatile ("movdqu 0*16(%[state]), " STATE0 "\n\t" /* DCBA */
+                "movdqu 1*16(%[state]), " STATE1 "\n\t" /* HGFE */
+                "pshufd $0xb1, " STATE0 ", " STATE0 "\n\t" /* CDAB */
+                "pshufd $0x1b, " STATE1 ", " STATE1 "\n\t" /* EFGH */
+                "movdqa " STATE0 ", " TMP4 "\n\t"
+                "palignr $8, " STATE1 ", " STATE0 "\n\t" /* ABEF */
+                "pblendw $0xf0, " TMP4 ", " STATE1 "\n\t" /* CDGH */
+                :
+                : [state] "r" (state)
+                : "memory" );
+
+  do
+    {
+      asm volatile (
+        "movdqa " STATE0 ", %[abef_save]\n\t"
+        "movdqa " STATE1 ", %[cdgh_save]\n\t"
+
+        /* Rounds 0-3 */
+        LOAD_MSG(0, TMP0)
+        ROUNDS4_HALF1(0)
+        ROUNDS4_HALF2()
+
+        /* Rounds 4-7 */
+        LOAD_MSG(1, TMP1)
+        ROUNDS4_HALF1(1)
+        ROUNDS4_HALF2()
+        SCHED1(TMP1, TMP0)
+
+        /* Rounds 8-11 */
+        LOAD_MSG(2, TMP2)
+        ROUNDS4_HALF1(2)
+        ROUNDS4_HALF2()
+        SCHED1(TMP2, TMP1)
+
+        /* Rounds 12-15 */
+        LOAD_MSG(3, TMP3)
+        ROUNDS4_HALF1(3)
+        SCHED2(TMP3, TMP2, TMP0)
+        ROUNDS4_HALF2()
+        SCHED1(TMP3, TMP2)
+
+        /* Rounds 16-51 */
+        ROUNDS4(4, TMP0, TMP3, TMP1)
+        ROUNDS4(5, TMP1, TMP0, TMP2)
+        ROUNDS4(6, TMP2, TMP1, TMP3)
+        ROUNDS4(7, TMP3, TMP2, TMP0)
+        ROUNDS4(8, TMP0, TMP3, TMP1)
+        ROUNDS4(9, TMP1, TMP0, TMP2)
+        ROUNDS4(10, TMP2, TMP1, TMP3)
+        ROUNDS4(11, TMP3, TMP2, TMP0)
+        ROUNDS4(12, TMP0, TMP3, TMP1)
+
+        /* Rounds 52-55 */
+        "movdqa " TMP1 ", " MSG "\n\t"
+        ROUNDS4_HALF1(13)
+        SCHED2(TMP1, TMP0, TMP2)
+        ROUNDS4_HALF2()
+
+        /* Rounds 56-59 */
+        "movdqa " TMP2 ", " MSG "\n\t"
+        ROUNDS4_HALF1(14)
+        SCHED2(TMP2, TMP1, TMP3)
+        ROUNDS4_HALF2()
+
+        /* Rounds 60-63 */
+        "movdqa " TMP3 ", " MSG "\n\t"
+        ROUNDS4_HALF1(15)
+        ROUNDS4_HALF2()
+
+        /* Add saved state.  */
+        "paddd %[abef_save], " STATE0 "\n\t"
+        "paddd %[cdgh_save], " STATE1 "\n\t"
+        : [abef_save] "+m" (save.abef),
+          [cdgh_save] "+m" (save.cdgh)
+        : [data] "r" (data),
+          [k] "r" (K),
+          [mask] "m" (*bshuf_mask)
+        : "memory" );
+
+      data += 64;
+    }
+  while (--nblks);
+
+  asm volatile ("pshufd $0x1b, " STATE0 ", " STATE0 "\n\t" /* FEBA */
+                "pshufd $0xb1, " STATE1 ", " STATE1 "\n\t" /* DCHG */
+                "movdqa " STATE0 ", " TMP4 "\n\t"
+                "pblendw $0xf0, " STATE1 ", " STATE0 "\n\t" /* DCBA */
+                "palignr $8, " TMP4 ", " STATE1 "\n\t" /* HGFE */
+                "movdqu " STATE0 ", 0*16(%[state])\n\t"
+                "movdqu " STATE1 ", 1*16(%[state])\n\t"
+                "pxor " TMP4 ", " TMP4 "\n\t"
+                "movdqa " TMP4 ", %[abef_save]\n\t"
+                "movdqa " TMP4 ", %[cdgh_save]\n\t"
+                : [abef_save] "=m" (save.abef),
+                  [cdgh_save] "=m" (save.cdgh)
+                : [state] "r" (state)
+                : "memory" );
+
+  shaext_cleanup ();
+
+  /* No stack burning needed, the saved state was cleared above.  */
+  return 0;
+}
+
+#endif /* HAVE_GCC_INLINE_ASM_SHAEXT */
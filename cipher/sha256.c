@@ -75,6 +75,14 @@
 # define USE_AVX2 1
 #endif
 
+/* USE_SHAEXT indicates whether to compile with Intel SHA Extension code. */
+#undef USE_SHAEXT
+#if defined(HAVE_GCC_INLINE_ASM_SHAEXT) && \
+    defined(HAVE_GCC_INLINE_ASM_SSE41) && \
+    defined(ENABLE_SHAEXT_SUPPORT)
+# define USE_SHAEXT 1
+#endif
+
 /* USE_ARM_CE indicates whether to enable ARMv8 Crypto Extension assembly
  * code. */
 #undef USE_ARM_CE
@@ -103,6 +111,9 @@ typedef struct {
 #ifdef USE_AVX2
   unsigned int use_avx2:1;
 #endif
+#ifdef USE_SHAEXT
+  unsigned int use_shaext:1;
+#endif
 #ifdef USE_ARM_CE
   unsigned int use_arm_ce:1;
 #endif
@@ -147,6 +158,9 @@ sha256_init (void *context, unsigned int flags)
 #ifdef USE_AVX2
   hd->use_avx2 = (features & HWF_INTEL_AVX2) && (features & HWF_INTEL_BMI2);
 #endif
+#ifdef USE_SHAEXT
+  hd->use_shaext = (features & HWF_INTEL_SHAEXT) != 0;
+#endif
 #ifdef USE_ARM_CE
   hd->use_arm_ce = (features & HWF_ARM_SHA2) != 0;
 #endif
@@ -188,6 +202,9 @@ sha224_init (void *context, unsigned int flags)
 #ifdef USE_AVX2
   hd->use_avx2 = (features & HWF_INTEL_AVX2) && (features & HWF_INTEL_BMI2);
 #endif
+#ifdef USE_SHAEXT
+  hd->use_shaext = (features & HWF_INTEL_SHAEXT) != 0;
+#endif
 #ifdef USE_ARM_CE
   hd->use_arm_ce = (features & HWF_ARM_SHA2) != 0;
 #endif
@@ -377,6 +394,18 @@ unsigned int _gcry_sha256_transform_amd64_avx(const void *input_data,
 unsigned int _gcry_sha256_transform_amd64_avx2(const void *input_data,
                                                u32 state[8],
                                                size_t num_blks) ASM_FUNC_ABI;
+
+unsigned int _gcry_sha256_transform_amd64_avx2_x8(u32 state[8 * 8],
+                                                  const unsigned char **data,
+                                                  size_t num_blks) ASM_FUNC_ABI;
+#endif
+
+#ifdef USE_SHAEXT
+/* Does not need ASM_FUNC_ABI.  STATE points to the words H0...H7.  */
+unsigned int
+_gcry_sha256_transform_intel_shaext(u32 *state,
+                                    const unsigned char *input_data,
+                                    size_t num_blks);
 #endif
 
 #ifdef USE_ARM_CE
@@ -391,6 +420,11 @@ transform (void *ctx, const unsigned char *data, size_t nblks)
   SHA256_CONTEXT *hd = ctx;
   unsigned int burn;
 
+#ifdef USE_SHAEXT
+  if (hd->use_shaext)
+    return _gcry_sha256_transform_intel_shaext (&hd->h0, data, nblks);
+#endif
+
 #ifdef USE_AVX2
   if (hd->use_avx2)
     return _gcry_sha256_transform_amd64_avx2 (data, &hd->h0, nblks)
@@ -538,6 +572,136 @@ _gcry_sha256_hash_buffers (void *outbuf, const gcry_buffer_t *iov, int iovcnt)
 }
 
 
+static const u32 sha224_iv[8] =
+  {
+    0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939,
+    0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4
+  };
+
+static const u32 sha256_iv[8] =
+  {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+/* Single lane transform for the multi-buffer helper.  */
+static unsigned int
+transform_lane (u32 *state, const unsigned char *data, size_t nblks)
+{
+  SHA256_CONTEXT hd;
+  unsigned int burn;
+
+  sha256_init (&hd, 0);
+  hd.h0 = state[0];
+  hd.h1 = state[1];
+  hd.h2 = state[2];
+  hd.h3 = state[3];
+  hd.h4 = state[4];
+  hd.h5 = state[5];
+  hd.h6 = state[6];
+  hd.h7 = state[7];
+
+  burn = transform (&hd, data, nblks);
+
+  state[0] = hd.h0;
+  state[1] = hd.h1;
+  state[2] = hd.h2;
+  state[3] = hd.h3;
+  state[4] = hd.h4;
+  state[5] = hd.h5;
+  state[6] = hd.h6;
+  state[7] = hd.h7;
+  wipememory (&hd, sizeof(hd));
+
+  return burn;
+}
+
+#ifdef USE_AVX2
+static unsigned int
+transform_multi_avx2 (u32 *state, const unsigned char **data, size_t nblks)
+{
+  return _gcry_sha256_transform_amd64_avx2_x8 (state, data, nblks)
+         + 4 * sizeof(void*) + ASM_EXTRA_STACK;
+}
+#endif
+
+
+/* Fill SPEC with the description of SHA-256 or, if IS_SHA224 is set,
+ * SHA-224 for the multi-buffer helper.  If no multi-lane transform is
+ * available, NLANES is set to 1 and TRANSFORM_MULTI to NULL.  */
+void
+_gcry_sha256_get_multi_spec (gcry_md_multi_spec_t *spec, int is_sha224)
+{
+  spec->nlanes = 1;
+  spec->min_lanes = 1;
+  spec->nwords = 8;
+  spec->dlen = is_sha224 ? 28 : 32;
+  spec->iv = is_sha224 ? sha224_iv : sha256_iv;
+  spec->transform_multi = NULL;
+  spec->transform_lane = transform_lane;
+
+#ifdef USE_AVX2
+  /* The SHAEXT transform is about as fast as eight AVX2 lanes.  */
+  if ((_gcry_get_hw_features () & (HWF_INTEL_AVX2 | HWF_INTEL_SHAEXT))
+      == HWF_INTEL_AVX2)
+    {
+      spec->nlanes = 8;
+      spec->min_lanes = 3;
+      spec->transform_multi = transform_multi_avx2;
+    }
+#endif
+}
+
+
+/* Shortcut function which puts the hash values of NMSGS independent
+ * messages given by IOV consecutively into OUTBUF, which must have a
+ * size of 28 (IS_SHA224 set) or 32 bytes for each message.  */
+static void
+sha256_hash_buffers_multi (void *outbuf, const gcry_buffer_t *iov, int nmsgs,
+                           int is_sha224)
+{
+  const unsigned int dlen = is_sha224 ? 28 : 32;
+  unsigned char *out = outbuf;
+  gcry_md_multi_spec_t spec;
+  SHA256_CONTEXT hd;
+
+  _gcry_sha256_get_multi_spec (&spec, is_sha224);
+  if (spec.transform_multi)
+    {
+      _gcry_md_block_hash_multi (&spec, outbuf, iov, nmsgs);
+      return;
+    }
+
+  for (; nmsgs > 0; iov++, nmsgs--, out += dlen)
+    {
+      if (is_sha224)
+        sha224_init (&hd, 0);
+      else
+        sha256_init (&hd, 0);
+      _gcry_md_block_write (&hd,
+                            (const char*)iov[0].data + iov[0].off, iov[0].len);
+      sha256_final (&hd);
+      memcpy (out, hd.bctx.buf, dlen);
+    }
+}
+
+
+/* Variants of the above shortcut function for SHA-256 and SHA-224.  */
+void
+_gcry_sha256_hash_buffers_multi (void *outbuf, const gcry_buffer_t *iov,
+                                 int nmsgs)
+{
+  sha256_hash_buffers_multi (outbuf, iov, nmsgs, 0);
+}
+
+void
+_gcry_sha224_hash_buffers_multi (void *outbuf, const gcry_buffer_t *iov,
+                                 int nmsgs)
+{
+  sha256_hash_buffers_multi (outbuf, iov, nmsgs, 1);
+}
+
+
 
 /*
      Self-test section.
@@ -17,3 +17,17 @@
  #define FUNC_ENTRY() /**/
  #define FUNC_EXIT() /**/
 #endif
+
+/* Load _gcry_mpih_hwf, the CPU features for the MPI code (see
+ * mpi-internal.h), into the 32 bit register REG32.  REG64 is the 64
+ * bit name of the same register.  */
+#define MPIH_HWF_MULX 1
+#define MPIH_HWF_IFMA 2
+#if defined(__PIC__) && !defined(USE_MS_ABI)
+ #define LOAD_MPIH_HWF(reg32, reg64) \
+	movq C_SYMBOL_NAME(_gcry_mpih_hwf)@GOTPCREL(%rip), reg64; \
+	movl (reg64), reg32;
+#else
+ #define LOAD_MPIH_HWF(reg32, reg64) \
+	movl C_SYMBOL_NAME(_gcry_mpih_hwf)(%rip), reg32;
+#endif
@@ -2,3 +2,11 @@
  * need to define the types on a per-CPU basis, so it is done with
  * this file here.  */
 #define BYTES_PER_MPI_LIMB  (SIZEOF_UNSIGNED_LONG_LONG)
+
+/* Multiplication thresholds as found by tests/mpitune and rounded.
+ * The assembler mul_1 and addmul_1 are fast enough to push the
+ * Karatsuba crossover well above the generic default.  */
+#define KARATSUBA_THRESHOLD      32
+#define KARATSUBA_SQR_THRESHOLD  48
+#define TOOM3_THRESHOLD          96
+#define TOOM3_SQR_THRESHOLD      128
@@ -17,9 +17,27 @@
  * License along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+/*
+ * Curve25519 and Ed25519 are defined over the field of the prime
+ * P = 2^255 - 19.  The functions here implement the scalar
+ * multiplications on these curves with field elements of a fixed
+ * size instead of MPIs.  On 64 bit platforms with a 128 bit integer
+ * type an element is stored in 5 limbs of 51 bits, otherwise in 10
+ * limbs of alternately 26 and 25 bits.  The limbs are not fully
+ * reduced; a carry step after each operation keeps them small enough
+ * so that the products do not overflow.
+ *
+ * The X25519 function uses the Montgomery ladder from RFC 7748, the
+ * Edwards curve the extended coordinates (X:Y:Z:T) with x = X/Z,
+ * y = Y/Z and xy = T/Z from Hisil, Wong, Carter and Dawson,
+ * "Twisted Edwards Curves Revisited", which give complete formulas
+ * for a = -1.
+ */
+
 #include <config.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 
 #include "mpi-internal.h"
@@ -27,11 +45,1077 @@
 #include "g10lib.h"
 #include "context.h"
 #include "ec-context.h"
+#include "ec-internal.h"
+
+
+#if defined (__SIZEOF_INT128__) && BITS_PER_MPI_LIMB == 64
+# define FE_RADIX51 1
+# define FE_LIMBS 5
+# define FE_BITS(i) 51
+typedef u64 fe_limb_t;
+__extension__ typedef unsigned __int128 fe_dlimb_t;
+#else
+# define FE_LIMBS 10
+# define FE_BITS(i) (((i) & 1)? 25 : 26)
+typedef u32 fe_limb_t;
+#endif
+
+#define FE_MASK(i) (((fe_limb_t)1 << FE_BITS (i)) - 1)
+
+/* A field element with the value sum h[i] 2^(FE_BITS(0)+...+FE_BITS(i-1)).  */
+typedef fe_limb_t fe_t[FE_LIMBS];
+
+/* A point on the Edwards curve in extended coordinates.  */
+typedef struct
+{
+  fe_t X, Y, Z, T;
+} ge_p3_t;
+
+/* A point prepared as the second operand of an addition.  */
+typedef struct
+{
+  fe_t YplusX, YminusX, Z, T2d;
+} ge_cached_t;
+
+
+static void
+fe_0 (fe_t h)
+{
+  memset (h, 0, sizeof (fe_t));
+}
+
+
+static void
+fe_1 (fe_t h)
+{
+  memset (h, 0, sizeof (fe_t));
+  h[0] = 1;
+}
+
+
+static void
+fe_copy (fe_t h, const fe_t f)
+{
+  memcpy (h, f, sizeof (fe_t));
+}
+
+
+/* Propagate the carries of H so that each limb fits into its bits,
+   except for a small excess in the lowest limb.  */
+static void
+fe_carry (fe_t h)
+{
+  fe_limb_t c;
+  int i;
+
+  for (i = 0; i < FE_LIMBS - 1; i++)
+    {
+      c = h[i] >> FE_BITS (i);
+      h[i] &= FE_MASK (i);
+      h[i+1] += c;
+    }
+  c = h[FE_LIMBS-1] >> FE_BITS (FE_LIMBS-1);
+  h[FE_LIMBS-1] &= FE_MASK (FE_LIMBS-1);
+  h[0] += 19 * c;
+}
+
+
+static void
+fe_add (fe_t h, const fe_t f, const fe_t g)
+{
+  int i;
+
+  for (i = 0; i < FE_LIMBS; i++)
+    h[i] = f[i] + g[i];
+  fe_carry (h);
+}
+
+
+/* H = F - G.  4P is added to avoid negative limbs.  */
+static void
+fe_sub (fe_t h, const fe_t f, const fe_t g)
+{
+  int i;
+
+  for (i = 0; i < FE_LIMBS; i++)
+    h[i] = f[i] + ((fe_limb_t)4 << FE_BITS (i)) - (i? 4 : 4 * 19) - g[i];
+  fe_carry (h);
+}
+
+
+static void
+fe_neg (fe_t h, const fe_t f)
+{
+  fe_t zero;
+
+  fe_0 (zero);
+  fe_sub (h, zero, f);
+}
+
+
+#ifdef FE_RADIX51
+
+#define MUL64(a,b) ((fe_dlimb_t)(a) * (b))
+
+/* Reduce the product limbs T0 to T4 into H.  */
+#define FE_REDUCE_PRODUCT(h, t0, t1, t2, t3, t4) do {           \
+    u64 c_;                                                     \
+    c_ = (u64)(t0 >> 51); h[0] = (u64)t0 & FE_MASK (0);         \
+    t1 += c_;                                                   \
+    c_ = (u64)(t1 >> 51); h[1] = (u64)t1 & FE_MASK (0);         \
+    t2 += c_;                                                   \
+    c_ = (u64)(t2 >> 51); h[2] = (u64)t2 & FE_MASK (0);         \
+    t3 += c_;                                                   \
+    c_ = (u64)(t3 >> 51); h[3] = (u64)t3 & FE_MASK (0);         \
+    t4 += c_;                                                   \
+    c_ = (u64)(t4 >> 51); h[4] = (u64)t4 & FE_MASK (0);         \
+    h[0] += 19 * c_;                                            \
+    c_ = h[0] >> 51; h[0] &= FE_MASK (0);                       \
+    h[1] += c_;                                                 \
+  } while (0)
+
+static void
+fe_mul (fe_t h, const fe_t f, const fe_t g)
+{
+  u64 f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  u64 g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+  u64 g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4;
+  fe_dlimb_t t0, t1, t2, t3, t4;
+
+  t0 = MUL64 (f0, g0) + MUL64 (f1, g4_19) + MUL64 (f2, g3_19)
+       + MUL64 (f3, g2_19) + MUL64 (f4, g1_19);
+  t1 = MUL64 (f0, g1) + MUL64 (f1, g0) + MUL64 (f2, g4_19)
+       + MUL64 (f3, g3_19) + MUL64 (f4, g2_19);
+  t2 = MUL64 (f0, g2) + MUL64 (f1, g1) + MUL64 (f2, g0)
+       + MUL64 (f3, g4_19) + MUL64 (f4, g3_19);
+  t3 = MUL64 (f0, g3) + MUL64 (f1, g2) + MUL64 (f2, g1)
+       + MUL64 (f3, g0) + MUL64 (f4, g4_19);
+  t4 = MUL64 (f0, g4) + MUL64 (f1, g3) + MUL64 (f2, g2)
+       + MUL64 (f3, g1) + MUL64 (f4, g0);
+
+  FE_REDUCE_PRODUCT (h, t0, t1, t2, t3, t4);
+}
+
+
+static void
+fe_sq (fe_t h, const fe_t f)
+{
+  u64 f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  u64 d0 = 2 * f0, d1 = 2 * f1, d2_19 = 2 * 19 * f2;
+  u64 f3_19 = 19 * f3, f4_19 = 19 * f4, d4_19 = 2 * f4_19;
+  fe_dlimb_t t0, t1, t2, t3, t4;
+
+  t0 = MUL64 (f0, f0) + MUL64 (d4_19, f1) + MUL64 (d2_19, f3);
+  t1 = MUL64 (d0, f1) + MUL64 (d4_19, f2) + MUL64 (f3, f3_19);
+  t2 = MUL64 (d0, f2) + MUL64 (f1, f1) + MUL64 (d4_19, f3);
+  t3 = MUL64 (d0, f3) + MUL64 (d1, f2) + MUL64 (f4, f4_19);
+  t4 = MUL64 (d0, f4) + MUL64 (d1, f3) + MUL64 (f2, f2);
+
+  FE_REDUCE_PRODUCT (h, t0, t1, t2, t3, t4);
+}
+
+#else /*!FE_RADIX51*/
+
+/* The product of limbs I and J has the weight of limb I + J, or twice
+   that if both are odd.  Products beyond the highest limb wrap around
+   with a factor of 19.  */
+static void
+fe_mul (fe_t h, const fe_t f, const fe_t g)
+{
+  u64 t[FE_LIMBS];
+  u64 p, c;
+  int i, j;
+
+  memset (t, 0, sizeof t);
+  for (i = 0; i < FE_LIMBS; i++)
+    for (j = 0; j < FE_LIMBS; j++)
+      {
+        p = (u64)f[i] * g[j];
+        if ((i & j & 1))
+          p <<= 1;
+        if (i + j >= FE_LIMBS)
+          t[i + j - FE_LIMBS] += 19 * p;
+        else
+          t[i + j] += p;
+      }
+
+  for (i = 0; i < FE_LIMBS - 1; i++)
+    {
+      c = t[i] >> FE_BITS (i);
+      t[i] &= FE_MASK (i);
+      t[i+1] += c;
+    }
+  c = t[FE_LIMBS-1] >> FE_BITS (FE_LIMBS-1);
+  t[FE_LIMBS-1] &= FE_MASK (FE_LIMBS-1);
+  t[0] += 19 * c;
+  c = t[0] >> FE_BITS (0);
+  t[0] &= FE_MASK (0);
+  t[1] += c;
+
+  for (i = 0; i < FE_LIMBS; i++)
+    h[i] = (fe_limb_t)t[i];
+}
+
+
+static void
+fe_sq (fe_t h, const fe_t f)
+{
+  fe_mul (h, f, f);
+}
+
+#endif /*!FE_RADIX51*/
+
+
+/* H = F^(2^N)  */
+static void
+fe_sqn (fe_t h, const fe_t f, int n)
+{
+  fe_sq (h, f);
+  while (--n > 0)
+    fe_sq (h, h);
+}
+
+
+/* Set H from the little endian 256 bit value S.  The highest bit is
+   kept in the top limb, which is sufficient for further operations.  */
+static void
+fe_frombytes (fe_t h, const unsigned char *s)
+{
+  unsigned int i, k, pos, bits;
+  u64 v;
+
+  for (i = 0, pos = 0; i < FE_LIMBS; pos += FE_BITS (i), i++)
+    {
+      bits = (i == FE_LIMBS - 1)? 256 - pos : FE_BITS (i);
+      for (v = 0, k = 0; k < 8 && pos/8 + k < 32; k++)
+        v |= (u64)s[pos/8 + k] << (8 * k);
+      v >>= pos % 8;
+      h[i] = (fe_limb_t)(v & (((u64)1 << bits) - 1));
+    }
+}
+
+
+/* Store the fully reduced value of F at S in little endian order.  */
+static void
+fe_tobytes (unsigned char *s, const fe_t f)
+{
+  fe_t h;
+  fe_limb_t q, c;
+  unsigned int i, j, n;
+  u64 acc;
+
+  fe_copy (h, f);
+  fe_carry (h);
+
+  /* Q is 1 if H is at least P.  */
+  q = (h[0] + 19) >> FE_BITS (0);
+  for (i = 1; i < FE_LIMBS; i++)
+    q = (h[i] + q) >> FE_BITS (i);
+
+  h[0] += 19 * q;
+  for (i = 0; i < FE_LIMBS - 1; i++)
+    {
+      c = h[i] >> FE_BITS (i);
+      h[i] &= FE_MASK (i);
+      h[i+1] += c;
+    }
+  h[FE_LIMBS-1] &= FE_MASK (FE_LIMBS-1);
+
+  for (i = j = n = 0, acc = 0; i < FE_LIMBS; i++)
+    {
+      acc |= (u64)h[i] << n;
+      n += FE_BITS (i);
+      while (n >= 8)
+        {
+          s[j++] = acc;
+          acc >>= 8;
+          n -= 8;
+        }
+    }
+  s[j] = acc;
+  wipememory (h, sizeof h);
+}
+
+
+static int
+fe_iszero (const fe_t f)
+{
+  unsigned char s[32];
+  unsigned char r = 0;
+  int i;
+
+  fe_tobytes (s, f);
+  for (i = 0; i < 32; i++)
+    r |= s[i];
+  return !r;
+}
+
+
+/* Conditionally swap F and G if SWAP is 1 in constant time.  */
+static void
+fe_cswap (fe_t f, fe_t g, unsigned int swap)
+{
+  fe_limb_t mask = (fe_limb_t)0 - swap;
+  fe_limb_t x;
+  int i;
+
+  for (i = 0; i < FE_LIMBS; i++)
+    {
+      x = mask & (f[i] ^ g[i]);
+      f[i] ^= x;
+      g[i] ^= x;
+    }
+}
+
+
+/* Set F to G if MOVE is 1 in constant time.  */
+static void
+fe_cmov (fe_t f, const fe_t g, unsigned int move)
+{
+  fe_limb_t mask = (fe_limb_t)0 - move;
+  int i;
+
+  for (i = 0; i < FE_LIMBS; i++)
+    f[i] ^= mask & (f[i] ^ g[i]);
+}
+
+
+/* H = Z^(P-2) = 1/Z using the addition chain of curve25519-donna.  */
+static void
+fe_invert (fe_t h, const fe_t z)
+{
+  fe_t z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+  fe_sq (z2, z);
+  fe_sqn (t, z2, 2);
+  fe_mul (z9, t, z);
+  fe_mul (z11, z9, z2);
+  fe_sq (t, z11);
+  fe_mul (z2_5_0, t, z9);
+  fe_sqn (t, z2_5_0, 5);
+  fe_mul (z2_10_0, t, z2_5_0);
+  fe_sqn (t, z2_10_0, 10);
+  fe_mul (z2_20_0, t, z2_10_0);
+  fe_sqn (t, z2_20_0, 20);
+  fe_mul (t, t, z2_20_0);
+  fe_sqn (t, t, 10);
+  fe_mul (z2_50_0, t, z2_10_0);
+  fe_sqn (t, z2_50_0, 50);
+  fe_mul (z2_100_0, t, z2_50_0);
+  fe_sqn (t, z2_100_0, 100);
+  fe_mul (t, t, z2_100_0);
+  fe_sqn (t, t, 50);
+  fe_mul (t, t, z2_50_0);
+  fe_sqn (t, t, 5);
+  fe_mul (h, t, z11);
+}
+
+
+/* Store the non-negative A of at most 256 bits at BUF in little
+   endian order.  */
+static void
+mpi_to_le32 (unsigned char *buf, gcry_mpi_t a)
+{
+  unsigned int i;
+  mpi_size_t idx;
+
+  for (i = 0; i < 32; i++)
+    {
+      idx = i / BYTES_PER_MPI_LIMB;
+      buf[i] = idx < a->nlimbs
+               ? a->d[idx] >> (8 * (i % BYTES_PER_MPI_LIMB)) : 0;
+    }
+}
+
+
+/* Set H to A modulo P.  */
+static void
+fe_from_mpi (fe_t h, gcry_mpi_t a, mpi_ec_t ctx)
+{
+  unsigned char buf[32];
+
+  if (mpi_has_sign (a) || mpi_get_nbits (a) > 256)
+    {
+      gcry_mpi_t tmp = mpi_new (0);
+
+      _gcry_mpi_mod (tmp, a, ctx->p);
+      mpi_to_le32 (buf, tmp);
+      mpi_free (tmp);
+    }
+  else
+    mpi_to_le32 (buf, a);
+  fe_frombytes (h, buf);
+}
+
+
+static void
+fe_to_mpi (gcry_mpi_t w, const fe_t f)
+{
+  unsigned char buf[32];
+  mpi_size_t nlimbs = 32 / BYTES_PER_MPI_LIMB;
+  mpi_size_t i;
+  unsigned int j;
+
+  fe_tobytes (buf, f);
+  RESIZE_IF_NEEDED (w, nlimbs);
+  for (i = 0; i < nlimbs; i++)
+    {
+      w->d[i] = 0;
+      for (j = 0; j < BYTES_PER_MPI_LIMB; j++)
+        w->d[i] |= (mpi_limb_t)buf[i * BYTES_PER_MPI_LIMB + j] << (8 * j);
+    }
+  MPN_NORMALIZE (w->d, nlimbs);
+  w->nlimbs = nlimbs;
+  w->sign = 0;
+}
 
 
+/* Return true if A is equal to the small value V modulo P.  */
+static int
+mpi_is_small (gcry_mpi_t a, long v, mpi_ec_t ctx)
+{
+  fe_t f, g;
+
+  fe_from_mpi (f, a, ctx);
+  fe_0 (g);
+  if (v < 0)
+    {
+      g[0] = -v;
+      fe_neg (g, g);
+    }
+  else
+    g[0] = v;
+  fe_sub (f, f, g);
+  return fe_iszero (f);
+}
+
+
+
+/*
+ * Curve25519
+ */
+
+/* Compute X2/Z2 = SCALAR * U with the Montgomery ladder of RFC 7748
+   in constant time.  A24 is (A - 2)/4.  */
+static void
+x25519_ladder (fe_t x2, fe_t z2, const unsigned char *scalar, const fe_t u,
+               const fe_t a24)
+{
+  fe_t x3, z3, a, aa, b, bb, e, c, d, da, cb;
+  unsigned int swap, bit;
+  int i;
+
+  fe_1 (x2);
+  fe_0 (z2);
+  fe_copy (x3, u);
+  fe_1 (z3);
+  swap = 0;
+
+  for (i = 255; i >= 0; i--)
+    {
+      bit = (scalar[i / 8] >> (i % 8)) & 1;
+      swap ^= bit;
+      fe_cswap (x2, x3, swap);
+      fe_cswap (z2, z3, swap);
+      swap = bit;
+
+      fe_add (a, x2, z2);
+      fe_sq (aa, a);
+      fe_sub (b, x2, z2);
+      fe_sq (bb, b);
+      fe_sub (e, aa, bb);
+      fe_add (c, x3, z3);
+      fe_sub (d, x3, z3);
+      fe_mul (da, d, a);
+      fe_mul (cb, c, b);
+      fe_add (x3, da, cb);
+      fe_sq (x3, x3);
+      fe_sub (z3, da, cb);
+      fe_sq (z3, z3);
+      fe_mul (z3, z3, u);
+      fe_mul (x2, aa, bb);
+      fe_mul (z2, a24, e);
+      fe_add (z2, z2, aa);
+      fe_mul (z2, z2, e);
+    }
+  fe_cswap (x2, x3, swap);
+  fe_cswap (z2, z3, swap);
+
+  wipememory (x3, sizeof x3);
+  wipememory (z3, sizeof z3);
+  wipememory (a, sizeof a);
+  wipememory (aa, sizeof aa);
+  wipememory (b, sizeof b);
+  wipememory (bb, sizeof bb);
+  wipememory (e, sizeof e);
+  wipememory (c, sizeof c);
+  wipememory (d, sizeof d);
+  wipememory (da, sizeof da);
+  wipememory (cb, sizeof cb);
+}
+
+
+static int
+mul_point_montgomery (mpi_point_t result, gcry_mpi_t scalar,
+                      mpi_point_t point, mpi_ec_t ctx)
+{
+  unsigned char k[32];
+  fe_t u, a24, x2, z2;
+
+  fe_from_mpi (a24, ctx->a, ctx);
+  fe_from_mpi (u, point->x, ctx);
+  mpi_to_le32 (k, scalar);
+
+  x25519_ladder (x2, z2, k, u, a24);
+  wipememory (k, sizeof k);
+
+  /* Return the affine point as the generic code does.  */
+  mpi_clear (result->y);
+  if (fe_iszero (z2))
+    {
+      mpi_set_ui (result->x, 1);
+      mpi_set_ui (result->z, 0);
+    }
+  else
+    {
+      fe_invert (z2, z2);
+      fe_mul (x2, x2, z2);
+      fe_to_mpi (result->x, x2);
+      mpi_set_ui (result->z, 1);
+    }
+  wipememory (x2, sizeof x2);
+  wipememory (z2, sizeof z2);
+  return 0;
+}
+
+
+
+/*
+ * Ed25519
+ */
+
+static void
+ge_identity (ge_p3_t *r)
+{
+  fe_0 (r->X);
+  fe_1 (r->Y);
+  fe_1 (r->Z);
+  fe_0 (r->T);
+}
+
+
+static void
+ge_cached_identity (ge_cached_t *r)
+{
+  fe_1 (r->YplusX);
+  fe_1 (r->YminusX);
+  fe_1 (r->Z);
+  fe_0 (r->T2d);
+}
+
+
+/* Set R from the projective POINT.  */
+static void
+ge_from_point (ge_p3_t *r, mpi_point_t point, mpi_ec_t ctx)
+{
+  fe_t x, y, z;
+
+  fe_from_mpi (x, point->x, ctx);
+  fe_from_mpi (y, point->y, ctx);
+  fe_from_mpi (z, point->z, ctx);
+  fe_mul (r->X, x, z);
+  fe_mul (r->Y, y, z);
+  fe_sq (r->Z, z);
+  fe_mul (r->T, x, y);
+}
+
+
+static void
+ge_to_point (mpi_point_t result, const ge_p3_t *p)
+{
+  fe_to_mpi (result->x, p->X);
+  fe_to_mpi (result->y, p->Y);
+  fe_to_mpi (result->z, p->Z);
+}
+
+
+static void
+ge_to_cached (ge_cached_t *r, const ge_p3_t *p, const fe_t d2)
+{
+  fe_add (r->YplusX, p->Y, p->X);
+  fe_sub (r->YminusX, p->Y, p->X);
+  fe_copy (r->Z, p->Z);
+  fe_mul (r->T2d, p->T, d2);
+}
+
+
+/* R = P + Q  (add-2008-hwcd-3)  */
+static void
+ge_add (ge_p3_t *r, const ge_p3_t *p, const ge_cached_t *q)
+{
+  fe_t a, b, c, d, e, f, g, h;
+
+  fe_sub (a, p->Y, p->X);
+  fe_mul (a, a, q->YminusX);
+  fe_add (b, p->Y, p->X);
+  fe_mul (b, b, q->YplusX);
+  fe_mul (c, p->T, q->T2d);
+  fe_mul (d, p->Z, q->Z);
+  fe_add (d, d, d);
+  fe_sub (e, b, a);
+  fe_sub (f, d, c);
+  fe_add (g, d, c);
+  fe_add (h, b, a);
+  fe_mul (r->X, e, f);
+  fe_mul (r->Y, g, h);
+  fe_mul (r->T, e, h);
+  fe_mul (r->Z, f, g);
+}
+
+
+/* R = 2 P  (dbl-2008-hwcd with a = -1)  */
+static void
+ge_dbl (ge_p3_t *r, const ge_p3_t *p)
+{
+  fe_t a, b, c, e, f, g, h;
+
+  fe_sq (a, p->X);
+  fe_sq (b, p->Y);
+  fe_sq (c, p->Z);
+  fe_add (c, c, c);
+  fe_add (e, p->X, p->Y);
+  fe_sq (e, e);
+  fe_sub (e, e, a);
+  fe_sub (e, e, b);
+  fe_sub (g, b, a);
+  fe_sub (f, g, c);
+  fe_add (h, a, b);
+  fe_neg (h, h);
+  fe_mul (r->X, e, f);
+  fe_mul (r->Y, g, h);
+  fe_mul (r->T, e, h);
+  fe_mul (r->Z, f, g);
+}
+
+
+static void
+ge_cached_neg (ge_cached_t *r, const ge_cached_t *p)
+{
+  fe_t t;
+
+  fe_copy (t, p->YplusX);
+  fe_copy (r->YplusX, p->YminusX);
+  fe_copy (r->YminusX, t);
+  fe_copy (r->Z, p->Z);
+  fe_neg (r->T2d, p->T2d);
+}
+
+
+static void
+ge_cached_cmov (ge_cached_t *r, const ge_cached_t *p, unsigned int move)
+{
+  fe_cmov (r->YplusX, p->YplusX, move);
+  fe_cmov (r->YminusX, p->YminusX, move);
+  fe_cmov (r->Z, p->Z, move);
+  fe_cmov (r->T2d, p->T2d, move);
+}
+
+
+/* Return 1 if A equals B and 0 otherwise in constant time.  */
+static unsigned int
+ct_equal (unsigned int a, unsigned int b)
+{
+  return ((a ^ b) - 1) >> (8 * sizeof (unsigned int) - 1);
+}
+
+
+/* Compute R = K P with the little endian scalar K in constant time.
+   K is recoded into 65 signed digits of 4 bits, so that a table of
+   P to 8 P suffices.  */
+static void
+ge_scalarmult (ge_p3_t *r, const unsigned char *k, const ge_p3_t *p,
+               const fe_t d2)
+{
+  ge_cached_t tab[8], t, tneg;
+  ge_p3_t q;
+  signed char e[65];
+  int carry, i, j;
+  unsigned int babs, bneg;
+
+  for (i = 0; i < 32; i++)
+    {
+      e[2 * i] = k[i] & 15;
+      e[2 * i + 1] = (k[i] >> 4) & 15;
+    }
+  carry = 0;
+  for (i = 0; i < 64; i++)
+    {
+      e[i] += carry;
+      carry = (e[i] + 8) >> 4;
+      e[i] -= carry << 4;
+    }
+  e[64] = carry;
+
+  ge_to_cached (&tab[0], p, d2);
+  q = *p;
+  for (j = 1; j < 8; j++)
+    {
+      ge_add (&q, &q, &tab[0]);
+      ge_to_cached (&tab[j], &q, d2);
+    }
+
+  ge_identity (r);
+  for (i = 64; i >= 0; i--)
+    {
+      for (j = 0; j < 4; j++)
+        ge_dbl (r, r);
+
+      bneg = (unsigned char)e[i] >> 7;
+      babs = e[i] - (((-bneg) & e[i]) << 1);
+      ge_cached_identity (&t);
+      for (j = 0; j < 8; j++)
+        ge_cached_cmov (&t, &tab[j], ct_equal (babs, j + 1));
+      ge_cached_neg (&tneg, &t);
+      ge_cached_cmov (&t, &tneg, bneg);
+      ge_add (r, r, &t);
+    }
+
+  wipememory (e, sizeof e);
+  wipememory (tab, sizeof tab);
+  wipememory (&t, sizeof t);
+  wipememory (&tneg, sizeof tneg);
+  wipememory (&q, sizeof q);
+}
+
+
+/* Return true if CTX describes the twisted Edwards curve with a = -1
+   over the field of P = 2^255 - 19.  D2 is set to 2 d.  */
+static int
+edwards_params (fe_t d2, mpi_ec_t ctx)
+{
+  if (!mpi_is_small (ctx->a, -1, ctx))
+    return 0;
+  fe_from_mpi (d2, ctx->b, ctx);
+  fe_add (d2, d2, d2);
+  return 1;
+}
+
+
+static int
+mul_point_edwards (mpi_point_t result, gcry_mpi_t scalar,
+                   mpi_point_t point, mpi_ec_t ctx)
+{
+  unsigned char k[32];
+  fe_t d2;
+  ge_p3_t p, r;
+
+  if (!edwards_params (d2, ctx))
+    return -1;
+
+  mpi_to_le32 (k, scalar);
+  ge_from_point (&p, point, ctx);
+  ge_scalarmult (&r, k, &p, d2);
+  ge_to_point (result, &r);
+
+  wipememory (k, sizeof k);
+  wipememory (&r, sizeof r);
+  return 0;
+}
+
+
+/* Compute RESULT = SCALAR * POINT on Curve25519 or Ed25519 in
+   constant time.  Returns -1 without computing RESULT if the curve or
+   the scalar is not supported, in which case the generic code needs
+   to be used.  */
+int
+_gcry_mpi_ec_ed25519_mul_point (mpi_point_t result, gcry_mpi_t scalar,
+                                mpi_point_t point, mpi_ec_t ctx)
+{
+  if (mpi_has_sign (scalar) || mpi_get_nbits (scalar) > 256)
+    return -1;
+
+  if (ctx->model == MPI_EC_MONTGOMERY)
+    return mul_point_montgomery (result, scalar, point, ctx);
+  else if (ctx->model == MPI_EC_EDWARDS)
+    return mul_point_edwards (result, scalar, point, ctx);
+  return -1;
+}
+
+
+/* Compute RESULT = SCALAR1 * POINT1 + SCALAR2 * POINT2 on Ed25519 for
+   public scalars with the interleaved w-NAF method as in
+   _gcry_mpi_ec_mul_point2.  Returns -1 if the curve is not
+   supported.  */
+int
+_gcry_mpi_ec_ed25519_mul_point2 (mpi_point_t result,
+                                 gcry_mpi_t scalar1, mpi_point_t point1,
+                                 gcry_mpi_t scalar2, mpi_point_t point2,
+                                 mpi_ec_t ctx)
+{
+  enum { W = 5, TSIZE = 1 << (W - 2) };
+  gcry_mpi_t scalars[2];
+  mpi_point_t points[2];
+  ge_cached_t tab[2][TSIZE], neg[2][TSIZE], t;
+  signed char *naf[2];
+  unsigned int nafl[2];
+  ge_p3_t p, p2, r;
+  fe_t d2;
+  int i, j, k, maxl, d, started;
+
+  if (ctx->model != MPI_EC_EDWARDS || !edwards_params (d2, ctx))
+    return -1;
+
+  scalars[0] = scalar1;
+  scalars[1] = scalar2;
+  points[0] = point1;
+  points[1] = point2;
+
+  maxl = 0;
+  for (k = 0; k < 2; k++)
+    {
+      /* TAB[k][j] = (2j+1) POINTS[k] and NEG[k][j] its negative.  */
+      ge_from_point (&p, points[k], ctx);
+      ge_dbl (&p2, &p);
+      ge_to_cached (&t, &p2, d2);
+      ge_to_cached (&tab[k][0], &p, d2);
+      for (j = 1; j < TSIZE; j++)
+        {
+          ge_add (&p, &p, &t);
+          ge_to_cached (&tab[k][j], &p, d2);
+        }
+      for (j = 0; j < TSIZE; j++)
+        {
+          ge_cached_neg (&neg[k][j], &tab[k][j]);
+          if (mpi_has_sign (scalars[k]))
+            {
+              t = tab[k][j];
+              tab[k][j] = neg[k][j];
+              neg[k][j] = t;
+            }
+        }
+
+      naf[k] = xmalloc (mpi_get_nbits (scalars[k]) + 1);
+      nafl[k] = _gcry_mpi_ec_wnaf_recode (naf[k], scalars[k], W);
+      if (nafl[k] > maxl)
+        maxl = nafl[k];
+    }
+
+  ge_identity (&r);
+  started = 0;
+  for (i = maxl - 1; i >= 0; i--)
+    {
+      if (started)
+        ge_dbl (&r, &r);
+      for (k = 0; k < 2; k++)
+        {
+          d = i < nafl[k]? naf[k][i] : 0;
+          if (d > 0)
+            ge_add (&r, &r, &tab[k][d/2]);
+          else if (d < 0)
+            ge_add (&r, &r, &neg[k][-d/2]);
+          else
+            continue;
+          started = 1;
+        }
+    }
+  ge_to_point (result, &r);
+
+  xfree (naf[0]);
+  xfree (naf[1]);
+  return 0;
+}
+
+
+/* Compute RESULT = SCALARS[0] POINTS[0] + ... + SCALARS[N-1]
+   POINTS[N-1] on Ed25519 with Pippenger's bucket method as in
+   _gcry_mpi_ec_mul_points.  Returns -1 if the curve or one of the
+   scalars is not supported.  */
+int
+_gcry_mpi_ec_ed25519_mul_points (mpi_point_t result, unsigned int n,
+                                 gcry_mpi_t *scalars, mpi_point_t *points,
+                                 mpi_ec_t ctx)
+{
+  unsigned int c, nbuckets, win, i, j, pos, dig;
+  unsigned char *k;
+  ge_cached_t *cpoints, tmp;
+  ge_p3_t *buckets, run, sum, r, p;
+  unsigned char *used;
+  int run_used, sum_used, started;
+  fe_t d2;
+
+  if (ctx->model != MPI_EC_EDWARDS || !edwards_params (d2, ctx))
+    return -1;
+  for (i = 0; i < n; i++)
+    if (mpi_has_sign (scalars[i]) || mpi_get_nbits (scalars[i]) > 256)
+      return -1;
+
+  /* The cost per window is minimal for 2^C close to N/4.  */
+  for (c = 2; c < 16 && (8U << c) <= n; c++)
+    ;
+  nbuckets = (1 << c) - 1;
+
+  k = xmalloc (32 * n + 2);
+  cpoints = xmalloc (n * sizeof *cpoints);
+  buckets = xmalloc (nbuckets * sizeof *buckets);
+  used = xmalloc (nbuckets);
+  for (i = 0; i < n; i++)
+    {
+      mpi_to_le32 (k + 32 * i, scalars[i]);
+      ge_from_point (&p, points[i], ctx);
+      ge_to_cached (&cpoints[i], &p, d2);
+    }
+
+  ge_identity (&r);
+  started = 0;
+  for (win = (256 + c - 1) / c; win-- > 0; )
+    {
+      if (started)
+        for (i = 0; i < c; i++)
+          ge_dbl (&r, &r);
+
+      memset (used, 0, nbuckets);
+      pos = win * c;
+      for (i = 0; i < n; i++)
+        {
+          /* The two spare bytes at the end of K allow to read beyond
+             the last scalar.  */
+          dig = k[32 * i + pos / 8] | (k[32 * i + pos / 8 + 1] << 8)
+                | (k[32 * i + pos / 8 + 2] << 16);
+          dig = (dig >> (pos % 8)) & nbuckets;
+          if (pos + c > 256)
+            dig &= (1 << (256 - pos)) - 1;
+          if (!dig)
+            continue;
+          if (used[dig-1])
+            ge_add (&buckets[dig-1], &buckets[dig-1], &cpoints[i]);
+          else
+            {
+              ge_identity (&buckets[dig-1]);
+              ge_add (&buckets[dig-1], &buckets[dig-1], &cpoints[i]);
+            }
+          used[dig-1] = 1;
+        }
+
+      /* SUM = 1 BUCKETS[0] + ... + NBUCKETS BUCKETS[NBUCKETS-1]  */
+      run_used = sum_used = 0;
+      for (j = nbuckets; j-- > 0; )
+        {
+          if (used[j])
+            {
+              if (run_used)
+                {
+                  ge_to_cached (&tmp, &buckets[j], d2);
+                  ge_add (&run, &run, &tmp);
+                }
+              else
+                run = buckets[j];
+              run_used = 1;
+            }
+          if (!run_used)
+            continue;
+          if (sum_used)
+            {
+              ge_to_cached (&tmp, &run, d2);
+              ge_add (&sum, &sum, &tmp);
+            }
+          else
+            sum = run;
+          sum_used = 1;
+        }
+      if (!sum_used)
+        continue;
+
+      ge_to_cached (&tmp, &sum, d2);
+      ge_add (&r, &r, &tmp);
+      started = 1;
+    }
+  ge_to_point (result, &r);
+
+  xfree (used);
+  xfree (buckets);
+  xfree (cpoints);
+  xfree (k);
+  return 0;
+}
+
+
+/* W = W mod P for P = 2^255 - 19.  As 2^255 = 19 (mod P), the bits
+   of W from 255 up are added times 19 to the low 255 bits.  */
 void
-_gcry_mpi_ec_ed25519_mod (gcry_mpi_t a)
+_gcry_mpi_ec_ed25519_mod (gcry_mpi_t w, mpi_ec_t ctx)
 {
-  (void)a;
+  u32 a[16], r[8];
+  u64 acc;
+  mpi_size_t i;
+  unsigned int j;
+
+  if (w->sign || mpi_get_nbits (w) > 510)
+    {
+      _gcry_mpi_mod (w, w, ctx->p);
+      return;
+    }
+
+  memset (a, 0, sizeof a);
+  for (i = 0, j = 0; i < w->nlimbs; i++)
+    {
+#if BITS_PER_MPI_LIMB == 64
+      a[j++] = (u32)w->d[i];
+      a[j++] = (u32)(w->d[i] >> 32);
+#elif BITS_PER_MPI_LIMB == 32
+      a[j++] = w->d[i];
+#else
+# error please implement for this limb size.
+#endif
+    }
+
+  /* The high part is A >> 255, less than 2^255.  */
+  acc = 0;
+  for (j = 0; j < 8; j++)
+    {
+      acc += (j == 7? (a[j] & 0x7fffffff) : a[j])
+             + 19 * (u64)((a[7 + j] >> 31) | (a[8 + j] << 1));
+      r[j] = (u32)acc;
+      acc >>= 32;
+    }
+
+  /* Fold the bits from 255 up once more; the result is then less
+     than 2^255 + 19 * 2^6.  */
+  acc = 19 * ((acc << 1) | (r[7] >> 31));
+  r[7] &= 0x7fffffff;
+  for (j = 0; j < 8; j++)
+    {
+      acc += r[j];
+      r[j] = (u32)acc;
+      acc >>= 32;
+    }
+
+  /* Subtract P if R is at least P, i.e. if R + 19 is at least 2^255.  */
+  acc = 19;
+  for (j = 0; j < 7; j++)
+    acc = (acc + r[j]) >> 32;
+  if (((acc + r[7]) >> 31))
+    {
+      acc = 19;
+      for (j = 0; j < 8; j++)
+        {
+          acc += r[j];
+          r[j] = (u32)acc;
+          acc >>= 32;
+        }
+      r[7] &= 0x7fffffff;
+    }
 
+  RESIZE_IF_NEEDED (w, 32 / BYTES_PER_MPI_LIMB);
+  for (i = 0, j = 0; i < 32 / BYTES_PER_MPI_LIMB; i++)
+    {
+#if BITS_PER_MPI_LIMB == 64
+      w->d[i] = r[j] | ((mpi_limb_t)r[j+1] << 32);
+      j += 2;
+#else
+      w->d[i] = r[j++];
+#endif
+    }
+  i = 32 / BYTES_PER_MPI_LIMB;
+  MPN_NORMALIZE (w->d, i);
+  w->nlimbs = i;
 }
@@ -20,6 +20,24 @@
 #ifndef GCRY_EC_INTERNAL_H
 #define GCRY_EC_INTERNAL_H
 
-void _gcry_mpi_ec_ed25519_mod (gcry_mpi_t a);
+void _gcry_mpi_ec_ed25519_mod (gcry_mpi_t w, mpi_ec_t ctx);
+int _gcry_mpi_ec_ed25519_mul_point (mpi_point_t result, gcry_mpi_t scalar,
+                                    mpi_point_t point, mpi_ec_t ctx);
+int _gcry_mpi_ec_ed25519_mul_point2 (mpi_point_t result,
+                                     gcry_mpi_t scalar1, mpi_point_t point1,
+                                     gcry_mpi_t scalar2, mpi_point_t point2,
+                                     mpi_ec_t ctx);
+int _gcry_mpi_ec_ed25519_mul_points (mpi_point_t result, unsigned int n,
+                                     gcry_mpi_t *scalars, mpi_point_t *points,
+                                     mpi_ec_t ctx);
+
+void _gcry_mpi_ec_nist192_mod (gcry_mpi_t w, mpi_ec_t ctx);
+void _gcry_mpi_ec_nist224_mod (gcry_mpi_t w, mpi_ec_t ctx);
+void _gcry_mpi_ec_nist256_mod (gcry_mpi_t w, mpi_ec_t ctx);
+void _gcry_mpi_ec_nist384_mod (gcry_mpi_t w, mpi_ec_t ctx);
+void _gcry_mpi_ec_nist521_mod (gcry_mpi_t w, mpi_ec_t ctx);
+
+unsigned int _gcry_mpi_ec_wnaf_recode (signed char *naf, gcry_mpi_t scalar,
+                                       unsigned int w);
 
 #endif /*GCRY_EC_INTERNAL_H*/
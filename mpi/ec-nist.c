@@ -0,0 +1,336 @@
+/* ec-nist.c -  NIST optimized elliptic curve functions
+ *
+ * This file is part of Libgcrypt.
+ *
+ * Libgcrypt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * Libgcrypt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The primes of the NIST curves P-192, P-224, P-256 and P-384 are
+ * generalized Mersenne primes: a value of twice their size can be
+ * reduced by adding and subtracting its 32 bit words in fixed
+ * positions, see "Routines 2.27 to 2.29" of Hankerson, Menezes and
+ * Vanstone, "Guide to Elliptic Curve Cryptography" or appendix D.2 of
+ * FIPS 186-2.  The prime of P-521 is a Mersenne prime which allows
+ * for a reduction by a shift and an addition.
+ *
+ * The functions here work on fixed size arrays of 32 bit words and
+ * take values of up to twice the size of the prime.  Negative or
+ * larger values are passed on to the generic reduction.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "mpi-internal.h"
+#include "longlong.h"
+#include "g10lib.h"
+#include "context.h"
+#include "ec-context.h"
+#include "ec-internal.h"
+
+
+/* The maximum number of 32 bit words of the reduced value.  */
+#define NIST_MAX_WORDS 17
+
+/* Arithmetic right shift by 32 of the two's complement value A.  */
+#define ASR32(a) (((a) >> 32) | (((u64)0 - ((a) >> 63)) << 32))
+
+/* Add EXPR to the accumulator and store the low 32 bits into R[J].  */
+#define NIST_ACC(j, expr) do {          \
+    acc += (expr);                      \
+    r[j] = (u32)acc;                    \
+    acc = ASR32 (acc);                  \
+  } while (0)
+
+
+static const u32 nist_p192[6] =
+  {
+    0xffffffff, 0xffffffff, 0xfffffffe, 0xffffffff,
+    0xffffffff, 0xffffffff
+  };
+
+static const u32 nist_p224[7] =
+  {
+    0x00000001, 0x00000000, 0x00000000, 0xffffffff,
+    0xffffffff, 0xffffffff, 0xffffffff
+  };
+
+static const u32 nist_p256[8] =
+  {
+    0xffffffff, 0xffffffff, 0xffffffff, 0x00000000,
+    0x00000000, 0x00000000, 0x00000001, 0xffffffff
+  };
+
+static const u32 nist_p384[12] =
+  {
+    0xffffffff, 0x00000000, 0x00000000, 0xffffffff,
+    0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff,
+    0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff
+  };
+
+
+/* Store the 32 bit words of W into A and clear the remaining words up
+   to AWORDS.  Returns false if W does not fit or is negative.  */
+static int
+nist_load (u64 *a, unsigned int awords, gcry_mpi_t w)
+{
+  mpi_size_t i;
+  unsigned int j;
+
+  if (w->sign || (unsigned int)w->nlimbs * BYTES_PER_MPI_LIMB > awords * 4)
+    return 0;
+
+  for (i = 0, j = 0; i < w->nlimbs; i++)
+    {
+#if BITS_PER_MPI_LIMB == 64
+      a[j++] = (u32)w->d[i];
+      a[j++] = (u32)(w->d[i] >> 32);
+#elif BITS_PER_MPI_LIMB == 32
+      a[j++] = w->d[i];
+#else
+# error please implement for this limb size.
+#endif
+    }
+  for (; j < awords; j++)
+    a[j] = 0;
+
+  return 1;
+}
+
+
+/* Set W to the value of the NWORDS words in R.  */
+static void
+nist_store (gcry_mpi_t w, const u32 *r, unsigned int nwords)
+{
+  mpi_size_t nlimbs = (nwords * 4 + BYTES_PER_MPI_LIMB - 1)
+                      / BYTES_PER_MPI_LIMB;
+  mpi_size_t i;
+  unsigned int j;
+
+  RESIZE_IF_NEEDED (w, nlimbs);
+  for (i = 0, j = 0; i < nlimbs; i++)
+    {
+#if BITS_PER_MPI_LIMB == 64
+      w->d[i] = r[j++];
+      if (j < nwords)
+        w->d[i] |= (mpi_limb_t)r[j++] << 32;
+#else
+      w->d[i] = r[j++];
+#endif
+    }
+  MPN_NORMALIZE (w->d, nlimbs);
+  w->nlimbs = nlimbs;
+  w->sign = 0;
+}
+
+
+/* Reduce the value of the NWORDS words in R plus TOP * 2^(32 NWORDS)
+   modulo P, where TOP is a small signed value in two's complement.
+   This requires that 2^(32 NWORDS) < 2 P.  */
+static void
+nist_reduce_top (u32 *r, u64 top, const u32 *p, unsigned int nwords)
+{
+  u64 acc;
+  unsigned int j;
+
+  /* Subtract TOP * P until the value fits into NWORDS.  This
+     terminates after at most two rounds.  */
+  while (top)
+    {
+      acc = 0;
+      for (j = 0; j < nwords; j++)
+        {
+          acc += (u64)r[j] - top * p[j];
+          r[j] = (u32)acc;
+          acc = ASR32 (acc);
+        }
+      top += acc;
+    }
+
+  /* R is now less than 2 P.  */
+  for (j = nwords; j-- > 0; )
+    if (r[j] != p[j])
+      break;
+  if (j < nwords && r[j] < p[j])
+    return;
+
+  acc = 0;
+  for (j = 0; j < nwords; j++)
+    {
+      acc += (u64)r[j] - p[j];
+      r[j] = (u32)acc;
+      acc = ASR32 (acc);
+    }
+}
+
+
+void
+_gcry_mpi_ec_nist192_mod (gcry_mpi_t w, mpi_ec_t ctx)
+{
+  u64 a[12];
+  u32 r[6];
+  u64 acc = 0;
+
+  if (!nist_load (a, DIM (a), w))
+    {
+      _gcry_mpi_mod (w, w, ctx->p);
+      return;
+    }
+
+  NIST_ACC (0, a[0] + a[6] + a[10]);
+  NIST_ACC (1, a[1] + a[7] + a[11]);
+  NIST_ACC (2, a[2] + a[6] + a[8] + a[10]);
+  NIST_ACC (3, a[3] + a[7] + a[9] + a[11]);
+  NIST_ACC (4, a[4] + a[8] + a[10]);
+  NIST_ACC (5, a[5] + a[9] + a[11]);
+
+  nist_reduce_top (r, acc, nist_p192, DIM (r));
+  nist_store (w, r, DIM (r));
+}
+
+
+void
+_gcry_mpi_ec_nist224_mod (gcry_mpi_t w, mpi_ec_t ctx)
+{
+  u64 a[14];
+  u32 r[7];
+  u64 acc = 0;
+
+  if (!nist_load (a, DIM (a), w))
+    {
+      _gcry_mpi_mod (w, w, ctx->p);
+      return;
+    }
+
+  NIST_ACC (0, a[0] - a[7] - a[11]);
+  NIST_ACC (1, a[1] - a[8] - a[12]);
+  NIST_ACC (2, a[2] - a[9] - a[13]);
+  NIST_ACC (3, a[3] + a[7] - a[10] + a[11]);
+  NIST_ACC (4, a[4] + a[8] - a[11] + a[12]);
+  NIST_ACC (5, a[5] + a[9] - a[12] + a[13]);
+  NIST_ACC (6, a[6] + a[10] - a[13]);
+
+  nist_reduce_top (r, acc, nist_p224, DIM (r));
+  nist_store (w, r, DIM (r));
+}
+
+
+void
+_gcry_mpi_ec_nist256_mod (gcry_mpi_t w, mpi_ec_t ctx)
+{
+  u64 a[16];
+  u32 r[8];
+  u64 acc = 0;
+
+  if (!nist_load (a, DIM (a), w))
+    {
+      _gcry_mpi_mod (w, w, ctx->p);
+      return;
+    }
+
+  NIST_ACC (0, a[0] + a[8] + a[9] - a[11] - a[12] - a[13] - a[14]);
+  NIST_ACC (1, a[1] + a[9] + a[10] - a[12] - a[13] - a[14] - a[15]);
+  NIST_ACC (2, a[2] + a[10] + a[11] - a[13] - a[14] - a[15]);
+  NIST_ACC (3, a[3] - a[8] - a[9] + 2*a[11] + 2*a[12] + a[13] - a[15]);
+  NIST_ACC (4, a[4] - a[9] - a[10] + 2*a[12] + 2*a[13] + a[14]);
+  NIST_ACC (5, a[5] - a[10] - a[11] + 2*a[13] + 2*a[14] + a[15]);
+  NIST_ACC (6, a[6] - a[8] - a[9] + a[13] + 3*a[14] + 2*a[15]);
+  NIST_ACC (7, a[7] + a[8] - a[10] - a[11] - a[12] - a[13] + 3*a[15]);
+
+  nist_reduce_top (r, acc, nist_p256, DIM (r));
+  nist_store (w, r, DIM (r));
+}
+
+
+void
+_gcry_mpi_ec_nist384_mod (gcry_mpi_t w, mpi_ec_t ctx)
+{
+  u64 a[24];
+  u32 r[12];
+  u64 acc = 0;
+
+  if (!nist_load (a, DIM (a), w))
+    {
+      _gcry_mpi_mod (w, w, ctx->p);
+      return;
+    }
+
+  NIST_ACC (0, a[0] + a[12] + a[20] + a[21] - a[23]);
+  NIST_ACC (1, a[1] - a[12] + a[13] - a[20] + a[22] + a[23]);
+  NIST_ACC (2, a[2] - a[13] + a[14] - a[21] + a[23]);
+  NIST_ACC (3, a[3] + a[12] - a[14] + a[15] + a[20] + a[21] - a[22]
+               - a[23]);
+  NIST_ACC (4, a[4] + a[12] + a[13] - a[15] + a[16] + a[20] + 2*a[21]
+               + a[22] - 2*a[23]);
+  NIST_ACC (5, a[5] + a[13] + a[14] - a[16] + a[17] + a[21] + 2*a[22]
+               + a[23]);
+  NIST_ACC (6, a[6] + a[14] + a[15] - a[17] + a[18] + a[22] + 2*a[23]);
+  NIST_ACC (7, a[7] + a[15] + a[16] - a[18] + a[19] + a[23]);
+  NIST_ACC (8, a[8] + a[16] + a[17] - a[19] + a[20]);
+  NIST_ACC (9, a[9] + a[17] + a[18] - a[20] + a[21]);
+  NIST_ACC (10, a[10] + a[18] + a[19] - a[21] + a[22]);
+  NIST_ACC (11, a[11] + a[19] + a[20] - a[22] + a[23]);
+
+  nist_reduce_top (r, acc, nist_p384, DIM (r));
+  nist_store (w, r, DIM (r));
+}
+
+
+/* P = 2^521 - 1, thus W = (W mod 2^521) + (W >> 521) (mod P).  */
+void
+_gcry_mpi_ec_nist521_mod (gcry_mpi_t w, mpi_ec_t ctx)
+{
+  u64 a[2 * NIST_MAX_WORDS];
+  u32 r[NIST_MAX_WORDS];
+  u64 acc = 0;
+  unsigned int j;
+
+  if (mpi_get_nbits (w) > 2 * 521 || !nist_load (a, DIM (a), w))
+    {
+      _gcry_mpi_mod (w, w, ctx->p);
+      return;
+    }
+
+  /* The sum of the low and the high part is less than 2^522.  */
+  for (j = 0; j < NIST_MAX_WORDS; j++)
+    {
+      acc += (a[j] & (j == 16 ? 0x1ff : 0xffffffff))
+             + ((a[16 + j] >> 9) | ((a[17 + j] << 23) & 0xffffffff));
+      r[j] = (u32)acc;
+      acc >>= 32;
+    }
+
+  /* Add the bit above 2^521 once more.  */
+  acc = r[16] >> 9;
+  r[16] &= 0x1ff;
+  for (j = 0; acc && j < NIST_MAX_WORDS; j++)
+    {
+      acc += r[j];
+      r[j] = (u32)acc;
+      acc >>= 32;
+    }
+
+  /* R is now less than 2^521 and thus at most P.  */
+  for (j = 0; j < 16; j++)
+    if (r[j] != 0xffffffff)
+      break;
+  if (j == 16 && r[16] == 0x1ff)
+    memset (r, 0, sizeof r);
+
+  nist_store (w, r, DIM (r));
+}
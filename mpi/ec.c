@@ -21,6 +21,7 @@
 #include <config.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 
 #include "mpi-internal.h"
@@ -181,6 +182,20 @@ point_swap_cond (mpi_point_t d, mpi_point_t s, unsigned long swap,
 }
 
 
+/* Set D to S if SET is 1 without leaking SET through timing or
+   memory access patterns.  Both points need to have been resized
+   with point_resize and not grown afterwards.  */
+static void
+point_set_cond (mpi_point_t d, mpi_point_t s, unsigned long set,
+                mpi_ec_t ctx)
+{
+  mpi_set_cond (d->x, s->x, set);
+  if (ctx->model != MPI_EC_MONTGOMERY)
+    mpi_set_cond (d->y, s->y, set);
+  mpi_set_cond (d->z, s->z, set);
+}
+
+
 /* Set the projective coordinates from POINT into X, Y, and Z.  If a
    coordinate is not required, X, Y, or Z may be passed as NULL.  */
 void
@@ -271,43 +286,226 @@ _gcry_mpi_point_snatch_set (mpi_point_t point,
 static void
 ec_mod (gcry_mpi_t w, mpi_ec_t ec)
 {
-  if (0 && ec->dialect == ECC_DIALECT_ED25519)
-    _gcry_mpi_ec_ed25519_mod (w);
+  if (ec->t.mod)
+    ec->t.mod (w, ec);
   else if (ec->t.p_barrett)
     _gcry_mpi_mod_barrett (w, w, ec->t.p_barrett);
   else
     _gcry_mpi_mod (w, w, ec->p);
 }
 
+/* Return true if A can be used with the limb level functions below:
+   A is non-negative, not larger than P in limbs and not stored in
+   secure memory.  */
+static int
+ec_arena_arg (gcry_mpi_t a, mpi_ec_t ctx)
+{
+  return !a->sign && a->nlimbs <= ctx->p->nlimbs && !mpi_is_secure (a);
+}
+
+
+/* Return the result of comparing the value at AP of ASIZE normalized
+   limbs with P.  */
+static int
+ec_cmp_p (mpi_ptr_t ap, mpi_size_t asize, mpi_ec_t ctx)
+{
+  if (asize != ctx->p->nlimbs)
+    return asize < ctx->p->nlimbs? -1 : 1;
+  return _gcry_mpih_cmp (ap, ctx->p->d, asize);
+}
+
+
+/* Store the value at AP of ASIZE limbs into W.  */
+static void
+ec_set_limbs (gcry_mpi_t w, mpi_ptr_t ap, mpi_size_t asize)
+{
+  MPN_NORMALIZE (ap, asize);
+  RESIZE_IF_NEEDED (w, asize);
+  MPN_COPY (w->d, ap, asize);
+  w->nlimbs = asize;
+  w->sign = 0;
+}
+
+
+/* W = PRODP mod P for the PSIZE limbs at PRODP, which need to be
+   located in the arena of CTX.  PSIZE may be up to twice the size of
+   P.  */
+static void
+ec_reduce_limbs (gcry_mpi_t w, mpi_ptr_t prodp, mpi_size_t psize,
+                 mpi_ec_t ctx)
+{
+  mpi_size_t n = ctx->p->nlimbs;
+  mpi_ptr_t pn = ctx->t.arena;
+  mpi_ptr_t qp = pn + 3 * n + 1;
+  unsigned int shift = ctx->t.p_shift;
+
+  MPN_NORMALIZE (prodp, psize);
+  if (ctx->t.mod)
+    {
+      ec_set_limbs (w, prodp, psize);
+      ctx->t.mod (w, ctx);
+      return;
+    }
+
+  if (psize >= n)
+    {
+      /* Divide by P shifted so that its high bit is set.  The
+         remainder is left in the low N limbs.  */
+      if (shift)
+        {
+          prodp[psize] = _gcry_mpih_lshift (prodp, prodp, psize, shift);
+          psize++;
+        }
+      _gcry_mpih_divrem (qp, 0, prodp, psize, pn, n);
+      psize = n;
+      if (shift)
+        _gcry_mpih_rshift (prodp, prodp, n, shift);
+    }
+  ec_set_limbs (w, prodp, psize);
+}
+
+
+/* W = (U + V) mod P  */
 static void
 ec_addm (gcry_mpi_t w, gcry_mpi_t u, gcry_mpi_t v, mpi_ec_t ctx)
 {
-  mpi_add (w, u, v);
-  ec_mod (w, ctx);
+  mpi_ptr_t sp = ctx->t.arena + ctx->p->nlimbs;
+  mpi_size_t ssize;
+
+  if (!ec_arena_arg (u, ctx) || !ec_arena_arg (v, ctx))
+    {
+      mpi_add (w, u, v);
+      ec_mod (w, ctx);
+      return;
+    }
+
+  if (u->nlimbs < v->nlimbs)
+    {
+      gcry_mpi_t t = u;
+      u = v;
+      v = t;
+    }
+  ssize = u->nlimbs;
+  if (!ssize)
+    {
+      w->nlimbs = 0;
+      w->sign = 0;
+      return;
+    }
+  sp[ssize] = _gcry_mpih_add (sp, u->d, ssize, v->d, v->nlimbs);
+  ssize++;
+  MPN_NORMALIZE (sp, ssize);
+
+  /* For reduced U and V a single subtraction is sufficient.  */
+  if (ec_cmp_p (sp, ssize, ctx) >= 0)
+    {
+      _gcry_mpih_sub (sp, sp, ssize, ctx->p->d, ctx->p->nlimbs);
+      MPN_NORMALIZE (sp, ssize);
+      if (ec_cmp_p (sp, ssize, ctx) >= 0)
+        {
+          ec_reduce_limbs (w, sp, ssize, ctx);
+          return;
+        }
+    }
+  ec_set_limbs (w, sp, ssize);
 }
 
+/* W = U - V mod P.  As with mpi_sub, the result is only reduced if U
+   is.  */
 static void
 ec_subm (gcry_mpi_t w, gcry_mpi_t u, gcry_mpi_t v, mpi_ec_t ec)
 {
-  mpi_sub (w, u, v);
-  while (w->sign)
-    mpi_add (w, w, ec->p);
-  /*ec_mod (w, ec);*/
+  mpi_ptr_t sp = ec->t.arena + ec->p->nlimbs;
+  mpi_size_t n = ec->p->nlimbs;
+  mpi_size_t ssize;
+
+  if (!ec_arena_arg (u, ec) || !ec_arena_arg (v, ec)
+      || ec_cmp_p (v->d, v->nlimbs, ec) > 0)
+    {
+      mpi_sub (w, u, v);
+      while (w->sign)
+        mpi_add (w, w, ec->p);
+      /*ec_mod (w, ec);*/
+      return;
+    }
+
+  if (u->nlimbs > v->nlimbs
+      || (u->nlimbs == v->nlimbs
+          && _gcry_mpih_cmp (u->d, v->d, u->nlimbs) >= 0))
+    {
+      ssize = u->nlimbs;
+      if (ssize)
+        _gcry_mpih_sub (sp, u->d, ssize, v->d, v->nlimbs);
+    }
+  else
+    {
+      /* U < V <= P: compute (P - V) + U.  */
+      ssize = n;
+      _gcry_mpih_sub (sp, ec->p->d, n, v->d, v->nlimbs);
+      if (u->nlimbs)
+        _gcry_mpih_add (sp, sp, n, u->d, u->nlimbs);
+    }
+  ec_set_limbs (w, sp, ssize);
 }
 
+/* PRODP = UP * VP with USIZE >= VSIZE > 0.  Unlike _gcry_mpih_mul this
+   never needs temporary memory.  */
+static void
+ec_mul_limbs (mpi_ptr_t prodp, mpi_ptr_t up, mpi_size_t usize,
+              mpi_ptr_t vp, mpi_size_t vsize)
+{
+  mpi_size_t i;
+
+  if (up == vp && usize == vsize)
+    _gcry_mpih_sqr_n_basecase (prodp, up, usize);
+  else if (vsize < KARATSUBA_THRESHOLD)
+    _gcry_mpih_mul (prodp, up, usize, vp, vsize);
+  else
+    {
+      prodp[usize] = _gcry_mpih_mul_1 (prodp, up, usize, vp[0]);
+      for (i = 1; i < vsize; i++)
+        prodp[usize + i] = _gcry_mpih_addmul_1 (prodp + i, up, usize,
+                                                vp[i]);
+    }
+}
+
+/* W = U * V mod P.  The product is computed and reduced in the arena
+   of CTX, so that W may be the same as U or V without the temporary
+   copy mpi_mul would allocate.  */
 static void
 ec_mulm (gcry_mpi_t w, gcry_mpi_t u, gcry_mpi_t v, mpi_ec_t ctx)
 {
-  mpi_mul (w, u, v);
-  ec_mod (w, ctx);
+  mpi_ptr_t prodp = ctx->t.arena + ctx->p->nlimbs;
+
+  if (!ec_arena_arg (u, ctx) || !ec_arena_arg (v, ctx)
+      || ctx->t.p_barrett)
+    {
+      mpi_mul (w, u, v);
+      ec_mod (w, ctx);
+      return;
+    }
+
+  if (u->nlimbs < v->nlimbs)
+    {
+      gcry_mpi_t t = u;
+      u = v;
+      v = t;
+    }
+  if (!v->nlimbs)
+    {
+      w->nlimbs = 0;
+      w->sign = 0;
+      return;
+    }
+  ec_mul_limbs (prodp, u->d, u->nlimbs, v->d, v->nlimbs);
+  ec_reduce_limbs (w, prodp, u->nlimbs + v->nlimbs, ctx);
 }
 
 /* W = 2 * U mod P.  */
 static void
 ec_mul2 (gcry_mpi_t w, gcry_mpi_t u, mpi_ec_t ctx)
 {
-  mpi_lshift (w, u, 1);
-  ec_mod (w, ctx);
+  ec_addm (w, u, u, ctx);
 }
 
 static void
@@ -353,12 +551,19 @@ ec_invm (gcry_mpi_t x, gcry_mpi_t a, mpi_ec_t ctx)
 }
 
 
-/* Force recomputation of all helper variables.  */
-void
-_gcry_mpi_ec_get_reset (mpi_ec_t ec)
+/* Allocate the limb space used by the field arithmetic of CTX.  */
+static void
+ec_arena_init (mpi_ec_t ctx)
 {
-  ec->t.valid.a_is_pminus3 = 0;
-  ec->t.valid.two_inv_p = 0;
+  mpi_size_t n = ctx->p->nlimbs;
+
+  ctx->t.arena_nlimbs = 4 * n + 2;
+  ctx->t.arena = mpi_alloc_limb_space (ctx->t.arena_nlimbs, 0);
+  count_leading_zeros (ctx->t.p_shift, ctx->p->d[n-1]);
+  if (ctx->t.p_shift)
+    _gcry_mpih_lshift (ctx->t.arena, ctx->p->d, n, ctx->t.p_shift);
+  else
+    MPN_COPY (ctx->t.arena, ctx->p->d, n);
 }
 
 
@@ -407,6 +612,32 @@ static const char *curve25519_bad_points[] = {
   NULL
 };
 
+/* The primes of the NIST curves which have a dedicated reduction
+   function.  */
+static const struct
+{
+  unsigned int nbits;
+  const char *p;
+  void (*mod) (gcry_mpi_t w, mpi_ec_t ctx);
+} nist_primes[] =
+  {
+    { 192, "0xfffffffffffffffffffffffffffffffeffffffffffffffff",
+      _gcry_mpi_ec_nist192_mod },
+    { 224, "0xffffffffffffffffffffffffffffffff000000000000000000000001",
+      _gcry_mpi_ec_nist224_mod },
+    { 256, "0xffffffff00000001000000000000000000000000"
+           "ffffffffffffffffffffffff",
+      _gcry_mpi_ec_nist256_mod },
+    { 384, "0xffffffffffffffffffffffffffffffffffffffff"
+           "fffffffffffffffffffffffeffffffff0000000000000000ffffffff",
+      _gcry_mpi_ec_nist384_mod },
+    { 521, "0x01ffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+           "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+           "ffffffffffffff",
+      _gcry_mpi_ec_nist521_mod }
+  };
+
+
 static gcry_mpi_t
 scanval (const char *string)
 {
@@ -420,6 +651,59 @@ scanval (const char *string)
 }
 
 
+/* Select the fast reduction function and the 2^255-19 backend for
+   the current P of EC.  */
+static void
+ec_fast_mod_init (mpi_ec_t ec)
+{
+  unsigned int nbits = mpi_get_nbits (ec->p);
+  int i;
+
+  ec->t.mod = NULL;
+  ec->t.p25519 = 0;
+  for (i=0; i < DIM (nist_primes); i++)
+    if (nbits == nist_primes[i].nbits)
+      {
+        gcry_mpi_t tmp = scanval (nist_primes[i].p);
+
+        if (!mpi_cmp (ec->p, tmp))
+          ec->t.mod = nist_primes[i].mod;
+        mpi_free (tmp);
+        break;
+      }
+
+  if (nbits == 255)
+    {
+      gcry_mpi_t tmp = scanval ("0x7fffffffffffffffffffffffffffffff"
+                                "ffffffffffffffffffffffffffffffed");
+
+      if (!mpi_cmp (ec->p, tmp))
+        {
+          ec->t.p25519 = 1;
+          ec->t.mod = _gcry_mpi_ec_ed25519_mod;
+        }
+      mpi_free (tmp);
+    }
+}
+
+
+/* Force recomputation of all helper variables.  */
+void
+_gcry_mpi_ec_get_reset (mpi_ec_t ec)
+{
+  ec->t.valid.a_is_pminus3 = 0;
+  ec->t.valid.two_inv_p = 0;
+
+  /* P may have been changed.  */
+  ec_fast_mod_init (ec);
+  if (ec->t.arena)
+    {
+      _gcry_mpi_free_limb_space (ec->t.arena, ec->t.arena_nlimbs);
+      ec_arena_init (ec);
+    }
+}
+
+
 /* This function initialized a context for elliptic curve based on the
    field GF(p).  P is the prime specifying this field, A is the first
    coefficient.  CTX is expected to be zeroized.  */
@@ -464,28 +748,16 @@ ec_p_init (mpi_ec_t ctx, enum gcry_mpi_ec_models model,
     }
   else
     {
-      /* Allocate scratch variables.  */
+      /* Allocate scratch variables large enough for a product so
+         that they need not be resized later.  */
       for (i=0; i< DIM(ctx->t.scratch); i++)
-        ctx->t.scratch[i] = mpi_alloc_like (ctx->p);
+        {
+          ctx->t.scratch[i] = mpi_alloc_like (ctx->p);
+          mpi_resize (ctx->t.scratch[i], 2 * ctx->p->nlimbs + 1);
+        }
     }
 
-  /* Prepare for fast reduction.  */
-  /* FIXME: need a test for NIST values.  However it does not gain us
-     any real advantage, for 384 bits it is actually slower than using
-     mpi_mulm.  */
-/*   ctx->nist_nbits = mpi_get_nbits (ctx->p); */
-/*   if (ctx->nist_nbits == 192) */
-/*     { */
-/*       for (i=0; i < 4; i++) */
-/*         ctx->s[i] = mpi_new (192); */
-/*       ctx->c    = mpi_new (192*2); */
-/*     } */
-/*   else if (ctx->nist_nbits == 384) */
-/*     { */
-/*       for (i=0; i < 10; i++) */
-/*         ctx->s[i] = mpi_new (384); */
-/*       ctx->c    = mpi_new (384*2); */
-/*     } */
+  ec_arena_init (ctx);
 }
 
 
@@ -514,6 +786,7 @@ ec_deinit (void *opaque)
 
   for (i=0; i< DIM(ctx->t.scratch); i++)
     mpi_free (ctx->t.scratch[i]);
+  _gcry_mpi_free_limb_space (ctx->t.arena, ctx->t.arena_nlimbs);
 
 /*   if (ctx->nist_nbits == 192) */
 /*     { */
@@ -595,6 +868,32 @@ _gcry_mpi_ec_free (mpi_ec_t ctx)
 }
 
 
+/* Wipe the scratch variables of CTX.  This needs to be done before a
+   context which may have been used with a secret scalar is kept for
+   reuse.  */
+void
+_gcry_mpi_ec_wipe_scratch (mpi_ec_t ctx)
+{
+  int i;
+
+  /* Keep P at the start of the arena.  */
+  wipememory (ctx->t.arena + ctx->p->nlimbs,
+              (ctx->t.arena_nlimbs - ctx->p->nlimbs) * sizeof (mpi_limb_t));
+
+  if (ctx->model == MPI_EC_MONTGOMERY)
+    return;  /* The scratch variables hold constants.  */
+
+  for (i=0; i< DIM(ctx->t.scratch); i++)
+    {
+      gcry_mpi_t a = ctx->t.scratch[i];
+
+      wipememory (a->d, a->alloced * sizeof *a->d);
+      a->nlimbs = 0;
+      a->sign = 0;
+    }
+}
+
+
 gcry_mpi_t
 _gcry_mpi_ec_get_mpi (const char *name, gcry_ctx_t ctx, int copy)
 {
@@ -771,7 +1070,8 @@ dup_point_weierstrass (mpi_point_t result, mpi_point_t point, mpi_ec_t ctx)
           /*                          T1: used for aZ^4. */
           ec_pow2 (l1, point->x, ctx);
           ec_mulm (l1, l1, mpi_const (MPI_C_THREE), ctx);
-          ec_powm (t1, point->z, mpi_const (MPI_C_FOUR), ctx);
+          ec_pow2 (t1, point->z, ctx);
+          ec_pow2 (t1, t1, ctx);
           ec_mulm (t1, t1, ctx->a, ctx);
           ec_addm (l1, l1, t1, ctx);
         }
@@ -857,7 +1157,7 @@ dup_point_edwards (mpi_point_t result, mpi_point_t point, mpi_ec_t ctx)
 
   /* E = aC */
   if (ctx->dialect == ECC_DIALECT_ED25519)
-    mpi_sub (E, ctx->p, C);
+    ec_subm (E, ctx->p, C, ctx);
   else
     ec_mulm (E, ctx->a, C, ctx);
 
@@ -988,11 +1288,23 @@ add_points_weierstrass (mpi_point_t result,
       /* l3 = l1 - l2 */
       ec_subm (l3, l1, l2, ctx);
       /* l4 = y1 z2^3  */
-      ec_powm (l4, z2, mpi_const (MPI_C_THREE), ctx);
-      ec_mulm (l4, l4, y1, ctx);
+      if (z2_is_one)
+        mpi_set (l4, y1);
+      else
+        {
+          ec_pow2 (l4, z2, ctx);
+          ec_mulm (l4, l4, z2, ctx);
+          ec_mulm (l4, l4, y1, ctx);
+        }
       /* l5 = y2 z1^3  */
-      ec_powm (l5, z1, mpi_const (MPI_C_THREE), ctx);
-      ec_mulm (l5, l5, y2, ctx);
+      if (z1_is_one)
+        mpi_set (l5, y2);
+      else
+        {
+          ec_pow2 (l5, z1, ctx);
+          ec_mulm (l5, l5, z1, ctx);
+          ec_mulm (l5, l5, y2, ctx);
+        }
       /* l6 = l4 - l5  */
       ec_subm (l6, l4, l5, ctx);
 
@@ -1023,6 +1335,7 @@ add_points_weierstrass (mpi_point_t result,
           /* x3 = l6^2 - l7 l3^2  */
           ec_pow2 (t1, l6, ctx);
           ec_pow2 (t2, l3, ctx);
+          ec_mulm (l1, t2, l3, ctx);  /* l1 = l3^3, l1 is not used anymore */
           ec_mulm (t2, t2, l7, ctx);
           ec_subm (x3, t1, t2, ctx);
           /* l9 = l7 l3^2 - 2 x3  */
@@ -1030,8 +1343,7 @@ add_points_weierstrass (mpi_point_t result,
           ec_subm (l9, t2, t1, ctx);
           /* y3 = (l9 l6 - l8 l3^3)/2  */
           ec_mulm (l9, l9, l6, ctx);
-          ec_powm (t1, l3, mpi_const (MPI_C_THREE), ctx); /* fixme: Use saved value*/
-          ec_mulm (t1, t1, l8, ctx);
+          ec_mulm (t1, l1, l8, ctx);
           ec_subm (y3, l9, t1, ctx);
           ec_mulm (y3, y3, ec_get_two_inv_p (ctx), ctx);
         }
@@ -1284,6 +1596,407 @@ _gcry_mpi_ec_sub_points (mpi_point_t result,
 }
 
 
+/* The window size used by mul_point_window_weierstrass.  */
+#define EC_WINDOW_MAX_BITS 5
+#define EC_WINDOW_BITS(nbits) ((nbits) > 320? 5 : 4)
+
+
+/* Constant time scalar multiplication RESULT = SCALAR * POINT for
+   Weierstrass curves using a fixed window of W bits.  This uses the
+   regular recoding from Joye and Tunstall, "Exponent Recoding and
+   Regular Exponentiation Algorithms", AFRICACRYPT 2009: an odd
+   integer K of NBITS bits is written as
+
+     K = sum_{i=0}^{m-1} d_i 2^(w i),    m = ceil(NBITS / w)
+
+   with d_i = 2 u_i + 1 - 2^w for i < m-1 and d_{m-1} = 2 u_{m-1} + 1,
+   where u_i is the integer formed by the W bits of K starting at bit
+   w i + 1.  All digits are odd and thus never zero, so that every
+   window costs W doublings and exactly one addition of an entry from
+   the table of the affine points P, 3P, ..., (2^w-1)P.  The entry is
+   fetched by scanning the entire table with masked copies and a
+   negative digit is applied by a masked negation of Y.  An even
+   SCALAR is computed as SCALAR+1 and P is subtracted at the end, also
+   in constant time.
+
+   Returns -1 without computing RESULT if the table can't be
+   normalized because POINT has a small order; the caller then needs
+   to use another method.  */
+static int
+mul_point_window_weierstrass (mpi_point_t result, gcry_mpi_t scalar,
+                              mpi_point_t point, unsigned int nbits,
+                              mpi_ec_t ctx)
+{
+  unsigned int w = EC_WINDOW_BITS (nbits);
+  unsigned int tsize = 1 << (w - 1);
+  unsigned int ndigits = (nbits + w - 1) / w;
+  mpi_point_struct jac[1 << (EC_WINDOW_MAX_BITS - 1)];
+  mpi_point_struct tab[1 << (EC_WINDOW_MAX_BITS - 1)];
+  gcry_mpi_t zz[1 << (EC_WINDOW_MAX_BITS - 1)];
+  mpi_point_struct sel, tmppnt;
+  gcry_mpi_t zinv, t1, t2, ny;
+  unsigned int i, j;
+  int rc = 0;
+
+  point_init (&sel);
+  point_init (&tmppnt);
+  for (j = 0; j < tsize; j++)
+    {
+      point_init (&jac[j]);
+      point_init (&tab[j]);
+      zz[j] = mpi_new (0);
+    }
+  zinv = mpi_new (0);
+  t1 = mpi_new (0);
+  t2 = mpi_new (0);
+  ny = mpi_new (0);
+
+  /* JAC[j] = (2j+1) P  */
+  point_set (&jac[0], point);
+  _gcry_mpi_ec_dup_point (&tmppnt, point, ctx);
+  for (j = 1; j < tsize; j++)
+    _gcry_mpi_ec_add_points (&jac[j], &jac[j-1], &tmppnt, ctx);
+
+  /* Convert the table to affine coordinates using a single inversion
+     (Montgomery's trick).  ZZ[j] is the product Z_0 ... Z_j.  */
+  mpi_set (zz[0], jac[0].z);
+  for (j = 1; j < tsize; j++)
+    ec_mulm (zz[j], zz[j-1], jac[j].z, ctx);
+  if (!mpi_cmp_ui (zz[tsize-1], 0))
+    {
+      rc = -1;
+      goto leave;
+    }
+  ec_invm (zinv, zz[tsize-1], ctx);
+
+  /* The entries of TAB, SEL and NY are allocated with exactly the
+     size point_resize uses and are only written by functions which
+     never grow them, as required by mpi_set_cond.  */
+  for (j = tsize; j-- > 0; )
+    {
+      /* t1 = 1/Z_j, zinv = 1/(Z_0 ... Z_{j-1})  */
+      if (j)
+        {
+          ec_mulm (t1, zinv, zz[j-1], ctx);
+          ec_mulm (zinv, zinv, jac[j].z, ctx);
+        }
+      else
+        mpi_set (t1, zinv);
+
+      ec_pow2 (t2, t1, ctx);
+      ec_mulm (jac[j].x, jac[j].x, t2, ctx);
+      ec_mulm (t2, t2, t1, ctx);
+      ec_mulm (jac[j].y, jac[j].y, t2, ctx);
+
+      point_resize (&tab[j], ctx);
+      mpi_set (tab[j].x, jac[j].x);
+      mpi_set (tab[j].y, jac[j].y);
+      mpi_set_ui (tab[j].z, 1);
+    }
+  point_resize (&sel, ctx);
+  mpi_resize (ny, 2*ctx->p->nlimbs+1);
+
+  for (i = ndigits; i-- > 0; )
+    {
+      unsigned long u, pos, idx;
+
+      /* U are the W bits starting at bit W*I+1.  The most significant
+         digit is always positive; setting the top bit of U for it
+         allows to use the same formula for all digits.  */
+      for (u = 0, j = 0; j < w; j++)
+        u |= (unsigned long)mpi_test_bit (scalar, i * w + 1 + j) << j;
+      if (i == ndigits - 1)
+        u |= tsize;
+      pos = u >> (w - 1);
+      idx = (u ^ (pos - 1)) & (tsize - 1);
+
+      for (j = 0; j < tsize; j++)
+        point_set_cond (&sel, &tab[j], j == idx, ctx);
+      mpi_sub (ny, ctx->p, sel.y);
+      mpi_set_cond (sel.y, ny, !pos);
+
+      if (i == ndigits - 1)
+        point_set (result, &sel);
+      else
+        {
+          for (j = 0; j < w; j++)
+            _gcry_mpi_ec_dup_point (result, result, ctx);
+          _gcry_mpi_ec_add_points (result, result, &sel, ctx);
+        }
+    }
+
+  /* Subtract P if SCALAR is even.  */
+  mpi_set (sel.x, tab[0].x);
+  mpi_sub (sel.y, ctx->p, tab[0].y);
+  mpi_set_ui (sel.z, 1);
+  _gcry_mpi_ec_add_points (&tmppnt, result, &sel, ctx);
+  point_resize (result, ctx);
+  point_resize (&tmppnt, ctx);
+  point_swap_cond (result, &tmppnt, !mpi_test_bit (scalar, 0), ctx);
+
+ leave:
+  mpi_free (ny);
+  mpi_free (t2);
+  mpi_free (t1);
+  mpi_free (zinv);
+  for (j = 0; j < tsize; j++)
+    {
+      mpi_free (zz[j]);
+      point_free (&tab[j]);
+      point_free (&jac[j]);
+    }
+  point_free (&tmppnt);
+  point_free (&sel);
+  return rc;
+}
+
+
+/* The window size used for the tables of mul_point_fixed_base.  */
+#define EC_FIXED_BASE_BITS 5
+
+
+/* Precomputed multiples of a fixed base point.  The table has one
+   row for each digit of the recoding described at
+   mul_point_window_weierstrass; row I holds the affine points
+
+     (2j+1) 2^(w i) BASE,    j = 0 .. 2^(w-1)-1
+
+   with the X and Y coordinates stored as limb vectors zero-padded to
+   the size of P.  */
+struct mpi_ec_fixed_base_s
+{
+  mpi_point_struct base;  /* The base point (affine).  */
+  unsigned int nbits;     /* Maximum number of bits of a scalar.  */
+  unsigned int ndigits;   /* Number of rows.  */
+  mpi_size_t nlimbs;      /* Number of limbs of each coordinate.  */
+  mpi_ptr_t tab;          /* The coordinates.  */
+};
+
+
+/* Create a table of multiples of the affine point BASE for
+   mul_point_fixed_base to be used with scalars of up to NBITS bits.
+   CTX is used for the computation; the table may then be attached
+   to any context for the same curve.  Returns NULL if no table can
+   be computed for this curve.  */
+mpi_ec_fixed_base_t
+_gcry_mpi_ec_fixed_base_new (mpi_point_t base, unsigned int nbits,
+                             mpi_ec_t ctx)
+{
+  unsigned int w = EC_FIXED_BASE_BITS;
+  unsigned int tsize = 1 << (w - 1);
+  unsigned int ndigits = (nbits + w - 1) / w;
+  unsigned int npoints = ndigits * tsize;
+  mpi_size_t nl = ctx->p->nlimbs;
+  mpi_ec_fixed_base_t fb = NULL;
+  mpi_point_t pnts;
+  gcry_mpi_t *zz;
+  mpi_point_struct rowbase, tmppnt;
+  gcry_mpi_t zinv, t1, t2;
+  unsigned int i, j, k;
+
+  if (ctx->model == MPI_EC_MONTGOMERY || mpi_cmp_ui (base->z, 1))
+    return NULL;
+
+  pnts = xcalloc (npoints, sizeof *pnts);
+  zz = xcalloc (npoints, sizeof *zz);
+  for (k = 0; k < npoints; k++)
+    {
+      point_init (&pnts[k]);
+      zz[k] = mpi_new (0);
+    }
+  point_init (&rowbase);
+  point_init (&tmppnt);
+  zinv = mpi_new (0);
+  t1 = mpi_new (0);
+  t2 = mpi_new (0);
+
+  /* Row I is computed from B_i = 2^(w i) BASE; the next row starts
+     with B_{i+1} = (2^w - 1) B_i + B_i.  */
+  point_set (&rowbase, base);
+  for (i = 0; i < ndigits; i++)
+    {
+      mpi_point_t row = pnts + i * tsize;
+
+      point_set (&row[0], &rowbase);
+      _gcry_mpi_ec_dup_point (&tmppnt, &rowbase, ctx);
+      for (j = 1; j < tsize; j++)
+        _gcry_mpi_ec_add_points (&row[j], &row[j-1], &tmppnt, ctx);
+      if (i + 1 < ndigits)
+        {
+          _gcry_mpi_ec_add_points (&tmppnt, &row[tsize-1], &rowbase, ctx);
+          point_set (&rowbase, &tmppnt);
+        }
+    }
+
+  /* Convert all points to affine coordinates with a single
+     inversion as in mul_point_window_weierstrass.  */
+  mpi_set (zz[0], pnts[0].z);
+  for (k = 1; k < npoints; k++)
+    ec_mulm (zz[k], zz[k-1], pnts[k].z, ctx);
+  if (!mpi_cmp_ui (zz[npoints-1], 0))
+    goto leave;
+  ec_invm (zinv, zz[npoints-1], ctx);
+
+  fb = xcalloc (1, sizeof *fb);
+  fb->tab = xcalloc (npoints * 2 * nl, sizeof *fb->tab);
+  for (k = npoints; k-- > 0; )
+    {
+      mpi_point_t pnt = &pnts[k];
+
+      if (k)
+        {
+          ec_mulm (t1, zinv, zz[k-1], ctx);
+          ec_mulm (zinv, zinv, pnt->z, ctx);
+        }
+      else
+        mpi_set (t1, zinv);
+
+      if (ctx->model == MPI_EC_WEIERSTRASS)
+        {
+          ec_pow2 (t2, t1, ctx);
+          ec_mulm (pnt->x, pnt->x, t2, ctx);
+          ec_mulm (t2, t2, t1, ctx);
+          ec_mulm (pnt->y, pnt->y, t2, ctx);
+        }
+      else
+        {
+          ec_mulm (pnt->x, pnt->x, t1, ctx);
+          ec_mulm (pnt->y, pnt->y, t1, ctx);
+        }
+
+      if (pnt->x->nlimbs > nl || pnt->y->nlimbs > nl)
+        log_bug ("%s: coordinate not reduced\n", __func__);
+      MPN_COPY (fb->tab + k * 2 * nl, pnt->x->d, pnt->x->nlimbs);
+      MPN_COPY (fb->tab + k * 2 * nl + nl, pnt->y->d, pnt->y->nlimbs);
+    }
+
+  point_init (&fb->base);
+  point_set (&fb->base, base);
+  fb->nbits = nbits;
+  fb->ndigits = ndigits;
+  fb->nlimbs = nl;
+
+ leave:
+  mpi_free (t2);
+  mpi_free (t1);
+  mpi_free (zinv);
+  point_free (&tmppnt);
+  point_free (&rowbase);
+  for (k = 0; k < npoints; k++)
+    {
+      mpi_free (zz[k]);
+      point_free (&pnts[k]);
+    }
+  xfree (zz);
+  xfree (pnts);
+  return fb;
+}
+
+
+/* Set A to the NLIMBS limbs at AP.  */
+static void
+set_limbs (gcry_mpi_t a, mpi_ptr_t ap, mpi_size_t nlimbs)
+{
+  MPN_COPY (a->d, ap, nlimbs);
+  MPN_NORMALIZE (a->d, nlimbs);
+  a->nlimbs = nlimbs;
+  a->sign = 0;
+}
+
+
+/* Compute RESULT = SCALAR * POINT in constant time using the table
+   attached to CTX.  This uses the same recoding as
+   mul_point_window_weierstrass but all the doublings are in the
+   table, so that only one addition per digit remains.  Returns -1
+   without computing RESULT if there is no table for POINT or SCALAR
+   is too large.  */
+static int
+mul_point_fixed_base (mpi_point_t result, gcry_mpi_t scalar,
+                      mpi_point_t point, mpi_ec_t ctx)
+{
+  mpi_ec_fixed_base_t fb = ctx->fixed_base;
+  unsigned int w = EC_FIXED_BASE_BITS;
+  unsigned int tsize = 1 << (w - 1);
+  mpi_size_t nl, n;
+  mpi_ptr_t buf, coord, negc;
+  mpi_point_struct sel, tmppnt;
+  unsigned int i, j;
+
+  if (!fb
+      || fb->nlimbs != ctx->p->nlimbs
+      || mpi_has_sign (scalar)
+      || mpi_get_nbits (scalar) > fb->nbits
+      || mpi_cmp_ui (point->z, 1)
+      || mpi_cmp (point->x, fb->base.x)
+      || mpi_cmp (point->y, fb->base.y))
+    return -1;
+
+  nl = fb->nlimbs;
+  buf = mpi_alloc_limb_space (3 * nl, 1);
+  negc = buf + 2 * nl;
+  /* The coordinate to negate for a negative digit.  */
+  coord = ctx->model == MPI_EC_EDWARDS? buf : buf + nl;
+
+  point_init (&sel);
+  point_init (&tmppnt);
+  point_resize (&sel, ctx);
+  mpi_set_ui (sel.z, 1);
+
+  for (i = fb->ndigits; i-- > 0; )
+    {
+      mpi_ptr_t row = fb->tab + i * tsize * 2 * nl;
+      unsigned long u, pos, idx;
+      mpi_limb_t mask;
+
+      for (u = 0, j = 0; j < w; j++)
+        u |= (unsigned long)mpi_test_bit (scalar, i * w + 1 + j) << j;
+      if (i == fb->ndigits - 1)
+        u |= tsize;
+      pos = u >> (w - 1);
+      idx = (u ^ (pos - 1)) & (tsize - 1);
+
+      /* Fetch the entry by scanning the entire row.  */
+      MPN_ZERO (buf, 2 * nl);
+      for (j = 0; j < tsize; j++)
+        {
+          mask = ((mpi_limb_t)0) - (j == idx);
+          for (n = 0; n < 2 * nl; n++)
+            buf[n] |= row[j * 2 * nl + n] & mask;
+        }
+
+      _gcry_mpih_sub_n (negc, ctx->p->d, coord, nl);
+      mask = ((mpi_limb_t)0) - !pos;
+      for (n = 0; n < nl; n++)
+        coord[n] ^= mask & (coord[n] ^ negc[n]);
+
+      set_limbs (sel.x, buf, nl);
+      set_limbs (sel.y, buf + nl, nl);
+
+      if (i == fb->ndigits - 1)
+        point_set (result, &sel);
+      else
+        _gcry_mpi_ec_add_points (result, result, &sel, ctx);
+    }
+
+  /* Subtract BASE if SCALAR is even.  */
+  mpi_set (sel.x, fb->base.x);
+  mpi_set (sel.y, fb->base.y);
+  if (ctx->model == MPI_EC_EDWARDS)
+    mpi_sub (sel.x, ctx->p, sel.x);
+  else
+    mpi_sub (sel.y, ctx->p, sel.y);
+  _gcry_mpi_ec_add_points (&tmppnt, result, &sel, ctx);
+  point_resize (result, ctx);
+  point_resize (&tmppnt, ctx);
+  point_swap_cond (result, &tmppnt, !mpi_test_bit (scalar, 0), ctx);
+
+  point_free (&tmppnt);
+  point_free (&sel);
+  _gcry_mpi_free_limb_space (buf, 3 * nl);
+  return 0;
+}
+
+
 /* Scalar point multiplication - the main function for ECC.  If takes
    an integer SCALAR and a POINT as well as the usual context CTX.
    RESULT will be set to the resulting point. */
@@ -1296,6 +2009,14 @@ _gcry_mpi_ec_mul_point (mpi_point_t result,
   unsigned int i, loops;
   mpi_point_struct p1, p2, p1inv;
 
+  if (ctx->t.p25519
+      && !_gcry_mpi_ec_ed25519_mul_point (result, scalar, point, ctx))
+    return;
+
+  if (ctx->model != MPI_EC_MONTGOMERY
+      && !mul_point_fixed_base (result, scalar, point, ctx))
+    return;
+
   if (ctx->model == MPI_EC_EDWARDS
       || (ctx->model == MPI_EC_WEIERSTRASS
           && mpi_is_secure (scalar)))
@@ -1333,6 +2054,11 @@ _gcry_mpi_ec_mul_point (mpi_point_t result,
              secret key we use constant time operation.  */
           mpi_point_struct tmppnt;
 
+          if (ctx->model == MPI_EC_WEIERSTRASS
+              && !mul_point_window_weierstrass (result, scalar, point,
+                                                nbits, ctx))
+            return;
+
           point_init (&tmppnt);
           point_resize (result, ctx);
           point_resize (&tmppnt, ctx);
@@ -1511,6 +2237,413 @@ _gcry_mpi_ec_mul_point (mpi_point_t result,
 }
 
 
+/* The window size used for the w-NAF of mul_points_wnaf.  */
+#define EC_WNAF_BITS 5
+
+
+/* Store the width-W NAF of the absolute value of SCALAR at NAF, least
+   significant digit first, and return the number of digits.  All
+   non-zero digits are odd and less than 2^(w-1) in absolute value,
+   and any two of them are separated by at least W-1 zeros.  NAF needs
+   space for mpi_get_nbits (SCALAR) + 1 digits.  */
+unsigned int
+_gcry_mpi_ec_wnaf_recode (signed char *naf, gcry_mpi_t scalar, unsigned int w)
+{
+  unsigned int nbits = mpi_get_nbits (scalar);
+  unsigned long v, d;
+  unsigned int i, j;
+
+  /* V holds the bits J to J+W of the remaining scalar and a carry.  */
+  for (v = 0, i = 0; i <= w; i++)
+    v |= (unsigned long)mpi_test_bit (scalar, i) << i;
+
+  for (j = 0; j < nbits || v; j++)
+    {
+      if ((v & 1))
+        {
+          d = v & ((1UL << w) - 1);
+          if (d >= (1UL << (w - 1)))
+            {
+              naf[j] = (signed char)((long)d - (1L << w));
+              v += (1UL << w) - d;
+            }
+          else
+            {
+              naf[j] = (signed char)d;
+              v -= d;
+            }
+        }
+      else
+        naf[j] = 0;
+      v >>= 1;
+      v += (unsigned long)mpi_test_bit (scalar, j + w + 1) << w;
+    }
+
+  return j;
+}
+
+
+/* Compute RESULT = SCALARS[0] POINTS[0] + ... + SCALARS[N-1]
+   POINTS[N-1] for public scalars with the interleaved w-NAF method.
+   All the scalars share the doublings and each point has a table of
+   its odd multiples in affine coordinates.  Returns -1 without
+   computing RESULT if a table can't be normalized, i.e. if a point
+   is at infinity or has a small order.  */
+static int
+mul_points_wnaf (mpi_point_t result, int n, gcry_mpi_t *scalars,
+                 mpi_point_t *points, mpi_ec_t ctx)
+{
+  unsigned int w = EC_WNAF_BITS;
+  unsigned int tsize = 1 << (w - 2);
+  unsigned int npoints = n * tsize;
+  mpi_point_struct tab[2][1 << (EC_WNAF_BITS - 2)];
+  mpi_point_struct neg[2][1 << (EC_WNAF_BITS - 2)];
+  gcry_mpi_t zz[2 << (EC_WNAF_BITS - 2)];
+  signed char *naf[2];
+  unsigned int nafl[2];
+  mpi_point_struct tmppnt;
+  gcry_mpi_t zinv, t1, t2;
+  unsigned int i, j, k, maxl;
+  int started;
+  int rc = 0;
+
+  gcry_assert (n <= 2);
+
+  point_init (&tmppnt);
+  zinv = mpi_new (0);
+  t1 = mpi_new (0);
+  t2 = mpi_new (0);
+  for (k = 0; k < n; k++)
+    {
+      for (j = 0; j < tsize; j++)
+        {
+          point_init (&tab[k][j]);
+          point_init (&neg[k][j]);
+          zz[k * tsize + j] = mpi_new (0);
+        }
+      naf[k] = xmalloc (mpi_get_nbits (scalars[k]) + 1);
+    }
+
+  /* TAB[k][j] = (2j+1) POINTS[k]  */
+  for (k = 0; k < n; k++)
+    {
+      point_set (&tab[k][0], points[k]);
+      _gcry_mpi_ec_dup_point (&tmppnt, points[k], ctx);
+      for (j = 1; j < tsize; j++)
+        _gcry_mpi_ec_add_points (&tab[k][j], &tab[k][j-1], &tmppnt, ctx);
+    }
+
+  /* Convert the tables to affine coordinates with a single inversion
+     as in mul_point_window_weierstrass.  */
+  mpi_set (zz[0], tab[0][0].z);
+  for (i = 1; i < npoints; i++)
+    ec_mulm (zz[i], zz[i-1], tab[i / tsize][i % tsize].z, ctx);
+  if (!mpi_cmp_ui (zz[npoints-1], 0))
+    {
+      rc = -1;
+      goto leave;
+    }
+  ec_invm (zinv, zz[npoints-1], ctx);
+  for (i = npoints; i-- > 0; )
+    {
+      mpi_point_t pnt = &tab[i / tsize][i % tsize];
+      mpi_point_t npnt = &neg[i / tsize][i % tsize];
+
+      if (i)
+        {
+          ec_mulm (t1, zinv, zz[i-1], ctx);
+          ec_mulm (zinv, zinv, pnt->z, ctx);
+        }
+      else
+        mpi_set (t1, zinv);
+
+      if (ctx->model == MPI_EC_WEIERSTRASS)
+        {
+          ec_pow2 (t2, t1, ctx);
+          ec_mulm (pnt->x, pnt->x, t2, ctx);
+          ec_mulm (t2, t2, t1, ctx);
+          ec_mulm (pnt->y, pnt->y, t2, ctx);
+        }
+      else
+        {
+          ec_mulm (pnt->x, pnt->x, t1, ctx);
+          ec_mulm (pnt->y, pnt->y, t1, ctx);
+        }
+      mpi_set_ui (pnt->z, 1);
+
+      /* NEG holds the negated points.  A negative scalar is handled
+         by swapping the tables.  */
+      point_set (npnt, pnt);
+      if (ctx->model == MPI_EC_WEIERSTRASS)
+        ec_subm (npnt->y, ctx->p, pnt->y, ctx);
+      else
+        ec_subm (npnt->x, ctx->p, pnt->x, ctx);
+      if (mpi_has_sign (scalars[i / tsize]))
+        {
+          mpi_point_struct t = *pnt;
+
+          *pnt = *npnt;
+          *npnt = t;
+        }
+    }
+
+  maxl = 0;
+  for (k = 0; k < n; k++)
+    {
+      nafl[k] = _gcry_mpi_ec_wnaf_recode (naf[k], scalars[k], w);
+      if (nafl[k] > maxl)
+        maxl = nafl[k];
+    }
+
+  if (ctx->model == MPI_EC_WEIERSTRASS)
+    {
+      mpi_set_ui (result->x, 1);
+      mpi_set_ui (result->y, 1);
+      mpi_set_ui (result->z, 0);
+    }
+  else
+    {
+      mpi_set_ui (result->x, 0);
+      mpi_set_ui (result->y, 1);
+      mpi_set_ui (result->z, 1);
+    }
+
+  started = 0;
+  for (i = maxl; i-- > 0; )
+    {
+      if (started)
+        _gcry_mpi_ec_dup_point (result, result, ctx);
+      for (k = 0; k < n; k++)
+        {
+          int d = i < nafl[k]? naf[k][i] : 0;
+
+          if (d > 0)
+            _gcry_mpi_ec_add_points (result, result, &tab[k][d/2], ctx);
+          else if (d < 0)
+            _gcry_mpi_ec_add_points (result, result, &neg[k][-d/2], ctx);
+          else
+            continue;
+          started = 1;
+        }
+    }
+
+ leave:
+  for (k = 0; k < n; k++)
+    {
+      xfree (naf[k]);
+      for (j = 0; j < tsize; j++)
+        {
+          mpi_free (zz[k * tsize + j]);
+          point_free (&neg[k][j]);
+          point_free (&tab[k][j]);
+        }
+    }
+  mpi_free (t2);
+  mpi_free (t1);
+  mpi_free (zinv);
+  point_free (&tmppnt);
+  return rc;
+}
+
+
+/* Compute RESULT = SCALAR1 * POINT1 + SCALAR2 * POINT2.  This is
+   meant for signature verification and thus the computation is not
+   constant time; the scalars must not be secret.  */
+void
+_gcry_mpi_ec_mul_point2 (mpi_point_t result,
+                         gcry_mpi_t scalar1, mpi_point_t point1,
+                         gcry_mpi_t scalar2, mpi_point_t point2,
+                         mpi_ec_t ctx)
+{
+  mpi_point_struct tmppnt;
+  gcry_mpi_t scalars[2];
+  mpi_point_t points[2];
+
+  if (ctx->model == MPI_EC_MONTGOMERY)
+    log_fatal ("%s: %s not yet supported\n",
+               "_gcry_mpi_ec_mul_point2", "Montgomery");
+
+  if (ctx->t.p25519
+      && !_gcry_mpi_ec_ed25519_mul_point2 (result, scalar1, point1,
+                                           scalar2, point2, ctx))
+    return;
+
+  point_init (&tmppnt);
+
+  /* If one of the points has a table of multiples attached to CTX
+     there are no doublings required for it.  */
+  if (!mul_point_fixed_base (&tmppnt, scalar1, point1, ctx))
+    {
+      scalars[0] = scalar2;
+      points[0] = point2;
+    }
+  else if (!mul_point_fixed_base (&tmppnt, scalar2, point2, ctx))
+    {
+      scalars[0] = scalar1;
+      points[0] = point1;
+    }
+  else
+    {
+      scalars[0] = scalar1;
+      points[0] = point1;
+      scalars[1] = scalar2;
+      points[1] = point2;
+      if (mul_points_wnaf (result, 2, scalars, points, ctx))
+        {
+          _gcry_mpi_ec_mul_point (&tmppnt, scalar1, point1, ctx);
+          _gcry_mpi_ec_mul_point (result, scalar2, point2, ctx);
+          _gcry_mpi_ec_add_points (result, result, &tmppnt, ctx);
+        }
+      point_free (&tmppnt);
+      return;
+    }
+
+  if (mul_points_wnaf (result, 1, scalars, points, ctx))
+    _gcry_mpi_ec_mul_point (result, scalars[0], points[0], ctx);
+  _gcry_mpi_ec_add_points (result, result, &tmppnt, ctx);
+  point_free (&tmppnt);
+}
+
+
+/* Return the C bits of the non-negative SCALAR starting at bit POS.  */
+static unsigned int
+get_digit (gcry_mpi_t scalar, unsigned int pos, unsigned int c)
+{
+  unsigned int d = 0;
+  unsigned int i;
+
+  for (i = 0; i < c; i++)
+    d |= mpi_test_bit (scalar, pos + i) << i;
+  return d;
+}
+
+
+/* Compute RESULT = SCALARS[0] POINTS[0] + ... + SCALARS[N-1]
+   POINTS[N-1] for a large number of points with Pippenger's bucket
+   method.  The scalars are split into windows of C bits.  For each
+   window, starting at the most significant one, the points are added
+   into buckets indexed by their digit and the sum of the bucket J
+   times J is accumulated with running sums.  This needs about N + 2^(C+1)
+   additions per window instead of the N * C doublings and additions
+   of separate multiplications.  The scalars must not be negative.
+   This is meant for batch signature verification and thus the
+   computation is not constant time; the scalars must not be secret.  */
+void
+_gcry_mpi_ec_mul_points (mpi_point_t result, unsigned int n,
+                         gcry_mpi_t *scalars, mpi_point_t *points,
+                         mpi_ec_t ctx)
+{
+  unsigned int c, nbuckets, nbits, win, i, j;
+  mpi_point_struct *buckets;
+  mpi_point_struct run, sum;
+  unsigned char *used;
+  int run_used, sum_used, started;
+
+  if (ctx->model == MPI_EC_MONTGOMERY)
+    log_fatal ("%s: %s not yet supported\n",
+               "_gcry_mpi_ec_mul_points", "Montgomery");
+
+  if (ctx->t.p25519
+      && !_gcry_mpi_ec_ed25519_mul_points (result, n, scalars, points, ctx))
+    return;
+
+  /* The cost per window is minimal for 2^C close to N/4.  */
+  for (c = 2; c < 16 && (8U << c) <= n; c++)
+    ;
+  nbuckets = (1 << c) - 1;
+
+  nbits = 0;
+  for (i = 0; i < n; i++)
+    {
+      gcry_assert (!mpi_has_sign (scalars[i]));
+      if (mpi_get_nbits (scalars[i]) > nbits)
+        nbits = mpi_get_nbits (scalars[i]);
+    }
+
+  buckets = xmalloc (nbuckets * sizeof *buckets);
+  used = xmalloc (nbuckets);
+  for (j = 0; j < nbuckets; j++)
+    point_init (&buckets[j]);
+  point_init (&run);
+  point_init (&sum);
+
+  started = 0;
+  for (win = (nbits + c - 1) / c; win-- > 0; )
+    {
+      if (started)
+        for (i = 0; i < c; i++)
+          _gcry_mpi_ec_dup_point (result, result, ctx);
+
+      memset (used, 0, nbuckets);
+      for (i = 0; i < n; i++)
+        {
+          unsigned int d = get_digit (scalars[i], win * c, c);
+
+          if (!d)
+            continue;
+          if (used[d-1])
+            _gcry_mpi_ec_add_points (&buckets[d-1], &buckets[d-1],
+                                     points[i], ctx);
+          else
+            point_set (&buckets[d-1], points[i]);
+          used[d-1] = 1;
+        }
+
+      /* SUM = 1 BUCKETS[0] + ... + NBUCKETS BUCKETS[NBUCKETS-1]  */
+      run_used = sum_used = 0;
+      for (j = nbuckets; j-- > 0; )
+        {
+          if (used[j])
+            {
+              if (run_used)
+                _gcry_mpi_ec_add_points (&run, &run, &buckets[j], ctx);
+              else
+                point_set (&run, &buckets[j]);
+              run_used = 1;
+            }
+          if (!run_used)
+            continue;
+          if (sum_used)
+            _gcry_mpi_ec_add_points (&sum, &sum, &run, ctx);
+          else
+            point_set (&sum, &run);
+          sum_used = 1;
+        }
+      if (!sum_used)
+        continue;
+
+      if (started)
+        _gcry_mpi_ec_add_points (result, result, &sum, ctx);
+      else
+        point_set (result, &sum);
+      started = 1;
+    }
+
+  if (!started)
+    {
+      if (ctx->model == MPI_EC_WEIERSTRASS)
+        {
+          mpi_set_ui (result->x, 1);
+          mpi_set_ui (result->y, 1);
+          mpi_set_ui (result->z, 0);
+        }
+      else
+        {
+          mpi_set_ui (result->x, 0);
+          mpi_set_ui (result->y, 1);
+          mpi_set_ui (result->z, 1);
+        }
+    }
+
+  point_free (&sum);
+  point_free (&run);
+  for (j = 0; j < nbuckets; j++)
+    point_free (&buckets[j]);
+  xfree (used);
+  xfree (buckets);
+}
+
+
 /* Return true if POINT is on the curve described by CTX.  */
 int
 _gcry_mpi_ec_curve_point (gcry_mpi_point_t point, mpi_ec_t ctx)
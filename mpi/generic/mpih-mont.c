@@ -0,0 +1,64 @@
+/* mpih-mont.c  -  MPI helper functions for Montgomery multiplication
+ *
+ * This file is part of Libgcrypt.
+ *
+ * Libgcrypt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * Libgcrypt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi-internal.h"
+#include "longlong.h"
+
+
+/****************
+ * Compute U * V / B^SIZE modulo M, where B = 2^BITS_PER_MPI_LIMB and
+ * MINV = -1/M mod B.  U and V are less than M.  The result is less
+ * than 2 M and its low SIZE limbs are stored at RES_PTR; the most
+ * significant limb (0 or 1) is returned.  RES_PTR must not overlap
+ * the input operands and needs space for 2 * SIZE limbs.
+ *
+ * This generic version accumulates the products with addmul_1 in a
+ * double-size buffer, so that it runs at the speed of the assembler
+ * versions of addmul_1 where no specific version of this function is
+ * available.
+ */
+mpi_limb_t
+_gcry_mpih_mont_mul_n (mpi_ptr_t res_ptr, mpi_ptr_t u_ptr, mpi_ptr_t v_ptr,
+                       mpi_ptr_t m_ptr, mpi_size_t size, mpi_limb_t minv)
+{
+  mpi_size_t i;
+  mpi_limb_t cy, cy_limb, x;
+
+  MPN_ZERO (res_ptr, size);
+
+  cy_limb = 0;
+  for (i = 0; i < size; i++)
+    {
+      cy = _gcry_mpih_addmul_1 (res_ptr + i, u_ptr, size, v_ptr[i]);
+
+      /* Clear the limb at RES_PTR + I by adding a multiple of M.  */
+      x = cy_limb + cy;
+      cy_limb = x < cy;
+      cy = _gcry_mpih_addmul_1 (res_ptr + i, m_ptr, size,
+                                res_ptr[i] * minv);
+      x += cy;
+      cy_limb += x < cy;
+      res_ptr[i + size] = x;
+    }
+
+  MPN_COPY (res_ptr, res_ptr + size, size);
+  return cy_limb;
+}
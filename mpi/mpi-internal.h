@@ -61,11 +61,65 @@
 #define KARATSUBA_THRESHOLD 16
 #endif
 
+/* Squaring has its own thresholds because the basecase squaring
+ * needs only about half the multiplications of the basecase
+ * multiplication.  Above TOOM3_THRESHOLD the Toom-Cook 3-way method
+ * is used instead of Karatsuba.  The mpitune program in tests/ finds
+ * good values for these; they are then put into the mpi-asm-defs.h
+ * of the architecture.  */
+#ifdef TUNE_PROGRAM_BUILD
+# undef KARATSUBA_THRESHOLD
+# undef KARATSUBA_SQR_THRESHOLD
+# undef TOOM3_THRESHOLD
+# undef TOOM3_SQR_THRESHOLD
+# define KARATSUBA_THRESHOLD      _gcry_mpi_karatsuba_threshold
+# define KARATSUBA_SQR_THRESHOLD  _gcry_mpi_karatsuba_sqr_threshold
+# define TOOM3_THRESHOLD          _gcry_mpi_toom3_threshold
+# define TOOM3_SQR_THRESHOLD      _gcry_mpi_toom3_sqr_threshold
+extern int _gcry_mpi_karatsuba_threshold;
+extern int _gcry_mpi_karatsuba_sqr_threshold;
+extern int _gcry_mpi_toom3_threshold;
+extern int _gcry_mpi_toom3_sqr_threshold;
+#else /*!TUNE_PROGRAM_BUILD*/
+
+#ifndef KARATSUBA_SQR_THRESHOLD
+#define KARATSUBA_SQR_THRESHOLD KARATSUBA_THRESHOLD
+#endif
+#ifndef TOOM3_THRESHOLD
+#define TOOM3_THRESHOLD 128
+#endif
+#ifndef TOOM3_SQR_THRESHOLD
+#define TOOM3_SQR_THRESHOLD TOOM3_THRESHOLD
+#endif
+
 /* The code can't handle KARATSUBA_THRESHOLD smaller than 2.  */
 #if KARATSUBA_THRESHOLD < 2
 #undef KARATSUBA_THRESHOLD
 #define KARATSUBA_THRESHOLD 2
 #endif
+#if KARATSUBA_SQR_THRESHOLD < 2
+#undef KARATSUBA_SQR_THRESHOLD
+#define KARATSUBA_SQR_THRESHOLD 2
+#endif
+
+/* Toom-3 needs the three pieces to be non-empty and its scratch
+ * space to fit into MPN_MUL_TSPACE; both hold from 25 limbs on.  */
+#if TOOM3_THRESHOLD < 32
+#undef TOOM3_THRESHOLD
+#define TOOM3_THRESHOLD 32
+#endif
+#if TOOM3_SQR_THRESHOLD < 32
+#undef TOOM3_SQR_THRESHOLD
+#define TOOM3_SQR_THRESHOLD 32
+#endif
+
+#endif /*!TUNE_PROGRAM_BUILD*/
+
+/* The number of limbs of scratch space needed by _gcry_mpih_mul_n
+ * and _gcry_mpih_sqr_n for operands of SIZE limbs.  */
+#define MPN_MUL_TSPACE(size)                                  \
+  (((size) < TOOM3_THRESHOLD && (size) < TOOM3_SQR_THRESHOLD) \
+   ? 2 * (size) : 4 * (size))
 
 
 typedef mpi_limb_t *mpi_ptr_t; /* pointer to a limb */
@@ -216,6 +270,23 @@ struct karatsuba_ctx {
 
 void _gcry_mpih_release_karatsuba_ctx( struct karatsuba_ctx *ctx );
 
+/* CPU features which the assembler modules may use.  This is set by
+ * _gcry_mpi_init and tested by the modules at run time, which use
+ * the same bit values.  */
+#define MPIH_HWF_MULX  1        /* BMI2 and ADX.  */
+#define MPIH_HWF_IFMA  2        /* AVX512 IFMA.  */
+extern unsigned int _gcry_mpih_hwf;
+
+#ifdef USE_MPIH_IFMA
+/*-- amd64/mpih-ifma.S --*/
+void _gcry_mpih_mul52_ifma (mpi_ptr_t res_ptr, mpi_ptr_t u_ptr,
+                            mpi_ptr_t v_ptr, mpi_size_t n);
+void _gcry_mpih_split52_ifma (mpi_ptr_t d_ptr, mpi_ptr_t u_ptr,
+                              mpi_size_t size, mpi_size_t n);
+void _gcry_mpih_pack52_ifma (mpi_ptr_t res_ptr, mpi_ptr_t d_ptr,
+                             mpi_size_t size);
+#endif
+
 mpi_limb_t _gcry_mpih_addmul_1( mpi_ptr_t res_ptr, mpi_ptr_t s1_ptr,
 			     mpi_size_t s1_size, mpi_limb_t s2_limb);
 mpi_limb_t _gcry_mpih_submul_1( mpi_ptr_t res_ptr, mpi_ptr_t s1_ptr,
@@ -233,11 +304,24 @@ void _gcry_mpih_mul_karatsuba_case( mpi_ptr_t prodp,
 				 mpi_ptr_t vp, mpi_size_t vsize,
 				 struct karatsuba_ctx *ctx );
 
+mpi_limb_t _gcry_mpih_mont_inv (mpi_limb_t m0);
+void _gcry_mpih_mont_mul (mpi_ptr_t rp, mpi_ptr_t up, mpi_ptr_t vp,
+                          mpi_ptr_t mp, mpi_size_t size, mpi_limb_t minv,
+                          mpi_ptr_t tp);
+void _gcry_mpih_mont_sqr (mpi_ptr_t rp, mpi_ptr_t up,
+                          mpi_ptr_t mp, mpi_size_t size, mpi_limb_t minv,
+                          mpi_ptr_t tp);
+
 
 /*-- mpih-mul_1.c (or xxx/cpu/ *.S) --*/
 mpi_limb_t _gcry_mpih_mul_1( mpi_ptr_t res_ptr, mpi_ptr_t s1_ptr,
 			  mpi_size_t s1_size, mpi_limb_t s2_limb);
 
+/*-- mpih-mont.c (or xxx/cpu/ *.S) --*/
+mpi_limb_t _gcry_mpih_mont_mul_n (mpi_ptr_t res_ptr, mpi_ptr_t u_ptr,
+                                  mpi_ptr_t v_ptr, mpi_ptr_t m_ptr,
+                                  mpi_size_t size, mpi_limb_t minv);
+
 /*-- mpih-div.c --*/
 mpi_limb_t _gcry_mpih_mod_1(mpi_ptr_t dividend_ptr, mpi_size_t dividend_size,
 						 mpi_limb_t divisor_limb);
@@ -206,6 +206,303 @@ mpi_invm_odd (gcry_mpi_t x, gcry_mpi_t a_orig, gcry_mpi_t n)
   return is_gcd_one;
 }
 
+
+/*
+ * Constant-time inversion for odd moduli using the divstep algorithm
+ * of Bernstein and Yang, "Fast constant-time gcd computation and
+ * modular inversion" (https://gcd.cr.yp.to/safegcd-20190413.pdf),
+ * arranged as in libsecp256k1's modinv32: divsteps are done in
+ * batches of 30 on the low limbs only, and the resulting transition
+ * matrix is then applied to the full numbers.  Numbers are kept in
+ * signed 30-bit limbs so that a 64-bit accumulator suffices on every
+ * platform.
+ *
+ * All state lives on the stack, which limits the modulus to
+ * SAFEGCD_MAX_BITS; larger moduli use mpi_invm_odd.
+ */
+#define SAFEGCD_MAX_BITS  4096
+#define SAFEGCD_MAX_LEN   (SAFEGCD_MAX_BITS / 30 + 2)
+#define SAFEGCD_M30       ((int32_t)0x3fffffff)
+
+typedef struct
+{
+  int32_t u, v, q, r;
+} safegcd_trans_t;
+
+
+/* Perform 30 divsteps on the low bits F0 and G0 of f and g, starting
+ * with ZETA = -delta.  Store the transition matrix, scaled by 2^30,
+ * at T and return the new ZETA.  */
+static int32_t
+safegcd_divsteps (int32_t zeta, u32 f0, u32 g0, safegcd_trans_t *t)
+{
+  u32 u = 1, v = 0, q = 0, r = 1;
+  u32 f = f0, g = g0;
+  u32 c1, c2, x, y, z;
+  int i;
+
+  for (i = 0; i < 30; i++)
+    {
+      /* c1 is all ones if delta > 0, c2 is all ones if g is odd.  */
+      c1 = (u32)(zeta >> 31);
+      c2 = -(g & 1);
+      /* Conditionally subtract or add (f,u,v) to (g,q,r).  */
+      x = (f ^ c1) - c1;
+      y = (u ^ c1) - c1;
+      z = (v ^ c1) - c1;
+      g += x & c2;
+      q += y & c2;
+      r += z & c2;
+      /* In the swap case, delta becomes 1 - delta, otherwise
+       * 1 + delta.  The new f is the old g, which is g - (-f).  */
+      c1 &= c2;
+      zeta = (int32_t)(((u32)zeta ^ c1) - 1 - c1);
+      f += g & c1;
+      u += q & c1;
+      v += r & c1;
+      g >>= 1;
+      u <<= 1;
+      v <<= 1;
+    }
+
+  t->u = (int32_t)u;
+  t->v = (int32_t)v;
+  t->q = (int32_t)q;
+  t->r = (int32_t)r;
+  return zeta;
+}
+
+
+/* Compute (F,G) = T * (F,G) / 2^30 on numbers of LEN limbs.  */
+static void
+safegcd_update_fg (int32_t *f, int32_t *g, const safegcd_trans_t *t, int len)
+{
+  const int64_t u = t->u, v = t->v, q = t->q, r = t->r;
+  int64_t cf, cg;
+  int i;
+
+  cf = u * f[0] + v * g[0];
+  cg = q * f[0] + r * g[0];
+  /* The low 30 bits are zero by construction of T.  */
+  cf >>= 30;
+  cg >>= 30;
+  for (i = 1; i < len; i++)
+    {
+      cf += u * f[i] + v * g[i];
+      cg += q * f[i] + r * g[i];
+      f[i - 1] = (int32_t)cf & SAFEGCD_M30;
+      cf >>= 30;
+      g[i - 1] = (int32_t)cg & SAFEGCD_M30;
+      cg >>= 30;
+    }
+  f[len - 1] = (int32_t)cf;
+  g[len - 1] = (int32_t)cg;
+}
+
+
+/* Compute (D,E) = T * (D,E) / 2^30 mod M where MI is M^-1 mod 2^30.
+ * D and E are kept in the range (-2M, M).  */
+static void
+safegcd_update_de (int32_t *d, int32_t *e, const safegcd_trans_t *t,
+                   const int32_t *m, u32 mi, int len)
+{
+  const int64_t u = t->u, v = t->v, q = t->q, r = t->r;
+  int32_t sd, se, md, me;
+  int64_t cd, ce;
+  int i;
+
+  /* Start with a multiple of M which makes the result non-negative
+   * if D or E are negative, then add the multiple of M which clears
+   * the low 30 bits.  */
+  sd = d[len - 1] >> 31;
+  se = e[len - 1] >> 31;
+  md = (t->u & sd) + (t->v & se);
+  me = (t->q & sd) + (t->r & se);
+  cd = u * d[0] + v * e[0];
+  ce = q * d[0] + r * e[0];
+  md -= (int32_t)((mi * (u32)cd + (u32)md) & SAFEGCD_M30);
+  me -= (int32_t)((mi * (u32)ce + (u32)me) & SAFEGCD_M30);
+  cd += (int64_t)m[0] * md;
+  ce += (int64_t)m[0] * me;
+  cd >>= 30;
+  ce >>= 30;
+  for (i = 1; i < len; i++)
+    {
+      cd += u * d[i] + v * e[i] + (int64_t)m[i] * md;
+      ce += q * d[i] + r * e[i] + (int64_t)m[i] * me;
+      d[i - 1] = (int32_t)cd & SAFEGCD_M30;
+      cd >>= 30;
+      e[i - 1] = (int32_t)ce & SAFEGCD_M30;
+      ce >>= 30;
+    }
+  d[len - 1] = (int32_t)cd;
+  e[len - 1] = (int32_t)ce;
+}
+
+
+/* Propagate the carries of R so that all but the top limb are in
+ * [0, 2^30).  */
+static void
+safegcd_carry (int32_t *r, int len)
+{
+  int i;
+
+  for (i = 0; i < len - 1; i++)
+    {
+      r[i + 1] += r[i] >> 30;
+      r[i] &= SAFEGCD_M30;
+    }
+}
+
+
+/* Bring R from the range (-2M, M) to [0, M) and negate it modulo M
+ * if SIGN is negative.  */
+static void
+safegcd_normalize (int32_t *r, int32_t sign, const int32_t *m, int len)
+{
+  int32_t cond;
+  int i;
+
+  cond = r[len - 1] >> 31;
+  for (i = 0; i < len; i++)
+    r[i] += m[i] & cond;
+  cond = sign >> 31;
+  for (i = 0; i < len; i++)
+    r[i] = (r[i] ^ cond) - cond;
+  safegcd_carry (r, len);
+
+  cond = r[len - 1] >> 31;
+  for (i = 0; i < len; i++)
+    r[i] += m[i] & cond;
+  safegcd_carry (r, len);
+}
+
+
+/* Convert the SIZE limbs at AP into LEN signed 30-bit limbs at R.  */
+static void
+safegcd_from_limbs (int32_t *r, int len, mpi_ptr_t ap, mpi_size_t size)
+{
+  unsigned int bit, s;
+  mpi_size_t w;
+  mpi_limb_t l;
+  int i;
+
+  for (i = 0, bit = 0; i < len; i++, bit += 30)
+    {
+      w = bit / BITS_PER_MPI_LIMB;
+      s = bit % BITS_PER_MPI_LIMB;
+      l = 0;
+      if (w < size)
+        {
+          l = ap[w] >> s;
+          if (s > BITS_PER_MPI_LIMB - 30 && w + 1 < size)
+            l |= ap[w + 1] << (BITS_PER_MPI_LIMB - s);
+        }
+      r[i] = (int32_t)(l & SAFEGCD_M30);
+    }
+}
+
+
+/* Convert the normalized LEN limbs at R into SIZE limbs at WP.  */
+static void
+safegcd_to_limbs (mpi_ptr_t wp, mpi_size_t size, const int32_t *r, int len)
+{
+  unsigned int bit, s;
+  mpi_size_t w;
+  int i;
+
+  memset (wp, 0, size * BYTES_PER_MPI_LIMB);
+  for (i = 0, bit = 0; i < len; i++, bit += 30)
+    {
+      w = bit / BITS_PER_MPI_LIMB;
+      s = bit % BITS_PER_MPI_LIMB;
+      if (w < size)
+        wp[w] |= (mpi_limb_t)r[i] << s;
+      if (s > BITS_PER_MPI_LIMB - 30 && w + 1 < size)
+        wp[w + 1] |= (mpi_limb_t)r[i] >> (BITS_PER_MPI_LIMB - s);
+    }
+}
+
+
+/* Same as mpi_invm_odd but constant-time and without allocations
+ * (other than for resizing X).  N must be odd with at most
+ * SAFEGCD_MAX_BITS bits and 0 < A < N.  */
+static int
+mpi_invm_safegcd (gcry_mpi_t x, gcry_mpi_t a, gcry_mpi_t n)
+{
+  int32_t f[SAFEGCD_MAX_LEN], g[SAFEGCD_MAX_LEN];
+  int32_t d[SAFEGCD_MAX_LEN], e[SAFEGCD_MAX_LEN];
+  int32_t m[SAFEGCD_MAX_LEN];
+  safegcd_trans_t t;
+  mpi_size_t nsize = n->nlimbs;
+  unsigned int nbits = mpi_get_nbits (n);
+  unsigned int steps;
+  int len, i;
+  int32_t zeta, plus_one, minus_one;
+  u32 mi;
+
+  /* One spare limb for the sign and the (-2M, M) range of D and E.  */
+  len = (nbits + 29) / 30 + 1;
+
+  /* The divstep bound of Theorem 11.2 for inputs of NBITS bits.  */
+  if (nbits < 46)
+    steps = (49 * nbits + 80) / 17;
+  else
+    steps = (49 * nbits + 57) / 17;
+
+  safegcd_from_limbs (m, len, n->d, nsize);
+  safegcd_from_limbs (g, len, a->d, a->nlimbs);
+  for (i = 0; i < len; i++)
+    {
+      f[i] = m[i];
+      d[i] = 0;
+      e[i] = 0;
+    }
+  e[0] = 1;
+
+  /* M^-1 mod 2^30 by Newton iteration; M is its own inverse mod 8.  */
+  mi = (u32)m[0];
+  for (i = 0; i < 4; i++)
+    mi *= 2 - (u32)m[0] * mi;
+
+  zeta = -1;
+  for (; steps; steps -= (steps < 30 ? steps : 30))
+    {
+      zeta = safegcd_divsteps (zeta, (u32)f[0], (u32)g[0], &t);
+      safegcd_update_de (d, e, &t, m, mi, len);
+      safegcd_update_fg (f, g, &t, len);
+    }
+
+  /* Now g is zero and f is +-gcd(a,n); d is the inverse up to the
+   * sign of f.  */
+  plus_one = f[0] ^ 1;
+  minus_one = f[0] ^ SAFEGCD_M30;
+  for (i = 1; i < len - 1; i++)
+    {
+      plus_one |= f[i];
+      minus_one |= f[i] ^ SAFEGCD_M30;
+    }
+  plus_one |= f[len - 1];
+  minus_one |= ~f[len - 1];
+
+  safegcd_normalize (d, f[len - 1], m, len);
+
+  mpi_resize (x, nsize);
+  safegcd_to_limbs (x->d, nsize, d, len);
+  x->nlimbs = nsize;
+  x->sign = 0;
+  MPN_NORMALIZE (x->d, x->nlimbs);
+
+  wipememory (f, len * sizeof *f);
+  wipememory (g, len * sizeof *g);
+  wipememory (d, len * sizeof *d);
+  wipememory (e, len * sizeof *e);
+  wipememory (&t, sizeof t);
+
+  return !plus_one || !minus_one;
+}
+
+
 /****************
  * Calculate the multiplicative inverse X of A mod N
  * That is: Find the solution x for
@@ -476,7 +773,11 @@ _gcry_mpi_invm (gcry_mpi_t x, gcry_mpi_t a, gcry_mpi_t n)
     return 0; /* Inverse does not exists.  */
 
   if (mpi_test_bit (n, 0) && mpi_cmp (a, n) < 0)
-    return mpi_invm_odd (x, a, n);
+    {
+      if (!a->sign && mpi_get_nbits (n) <= SAFEGCD_MAX_BITS)
+        return mpi_invm_safegcd (x, a, n);
+      return mpi_invm_odd (x, a, n);
+    }
   else
     return mpi_invm_generic (x, a, n);
 }
@@ -223,19 +223,19 @@ _gcry_mpi_powm (gcry_mpi_t res,
             mpi_size_t xsize;
 
             /*mpih_mul_n(xp, rp, rp, rsize);*/
-            if ( rsize < KARATSUBA_THRESHOLD )
+            if ( rsize < KARATSUBA_SQR_THRESHOLD )
               _gcry_mpih_sqr_n_basecase( xp, rp, rsize );
             else
               {
                 if ( !tspace )
                   {
-                    tsize = 2 * rsize;
+                    tsize = MPN_MUL_TSPACE (rsize);
                     tspace = mpi_alloc_limb_space( tsize, 0 );
                   }
-                else if ( tsize < (2*rsize) )
+                else if ( tsize < MPN_MUL_TSPACE (rsize) )
                   {
                     _gcry_mpi_free_limb_space (tspace, 0);
-                    tsize = 2 * rsize;
+                    tsize = MPN_MUL_TSPACE (rsize);
                     tspace = mpi_alloc_limb_space (tsize, 0 );
                   }
                 _gcry_mpih_sqr_n (xp, rp, rsize, tspace);
@@ -352,6 +352,14 @@ _gcry_mpi_powm (gcry_mpi_t res,
     _gcry_mpi_free_limb_space( tspace, 0 );
 }
 #else
+/* Parameters for Montgomery multiplication with an odd modulus.  */
+struct mont_ctx
+{
+  mpi_ptr_t mp;       /* The modulus, not normalized.  */
+  mpi_limb_t minv;    /* -1/MP mod B.  */
+  mpi_ptr_t tp;       /* Scratch space of 4 * MSIZE limbs.  */
+};
+
 /**
  * Internal function to compute
  *
@@ -360,6 +368,10 @@ _gcry_mpi_powm (gcry_mpi_t res,
  * and set the size of X at the pointer XSIZE_P.
  * Use karatsuba structure at KARACTX_P.
  *
+ * If MONT is not NULL, R and S are in Montgomery form and X = R * S /
+ * B^MSIZE mod M is computed instead; all sizes are then MSIZE.  R and
+ * S being the same is computed as a square.
+ *
  * Condition:
  *   RSIZE >= SSIZE
  *   Enough space for X is allocated beforehand.
@@ -372,8 +384,19 @@ mul_mod (mpi_ptr_t xp, mpi_size_t *xsize_p,
          mpi_ptr_t rp, mpi_size_t rsize,
          mpi_ptr_t sp, mpi_size_t ssize,
          mpi_ptr_t mp, mpi_size_t msize,
-         struct karatsuba_ctx *karactx_p)
+         struct karatsuba_ctx *karactx_p, struct mont_ctx *mont)
 {
+  if (mont)
+    {
+      if (rp == sp)
+        _gcry_mpih_mont_sqr (xp, rp, mont->mp, msize, mont->minv, mont->tp);
+      else
+        _gcry_mpih_mont_mul (xp, rp, sp, mont->mp, msize, mont->minv,
+                             mont->tp);
+      *xsize_p = msize;
+      return;
+    }
+
   if( ssize < KARATSUBA_THRESHOLD )
     _gcry_mpih_mul ( xp, rp, rsize, sp, ssize );
   else
@@ -397,6 +420,10 @@ mul_mod (mpi_ptr_t xp, mpi_size_t *xsize_p,
  * attack on the RSA secret exponent, we don't use the square
  * routine but multiplication.
  *
+ * For an odd MOD, which is the case for RSA, DSA and Elgamal, the
+ * values are kept in Montgomery form, BASE * B^MSIZE mod MOD, and
+ * multiplied with Montgomery reduction instead of a division.
+ *
  * Reference:
  *   Handbook of Applied Cryptography
  *       Algorithm 14.83: Modified left-to-right k-ary exponentiation
@@ -420,6 +447,7 @@ _gcry_mpi_powm (gcry_mpi_t res,
   mpi_ptr_t bp_marker = NULL;
   mpi_ptr_t ep_marker = NULL;
   mpi_ptr_t xp_marker = NULL;
+  mpi_ptr_t mm_marker = NULL;
   unsigned int mp_nlimbs = 0;
   unsigned int bp_nlimbs = 0;
   unsigned int ep_nlimbs = 0;
@@ -430,6 +458,8 @@ _gcry_mpi_powm (gcry_mpi_t res,
   mpi_ptr_t base_u;
   mpi_size_t base_u_size;
   mpi_size_t max_u_size;
+  struct mont_ctx mont;
+  struct mont_ctx *montp = NULL;
 
   esize = expo->nlimbs;
   msize = mod->nlimbs;
@@ -486,6 +516,22 @@ _gcry_mpi_powm (gcry_mpi_t res,
   else
     MPN_COPY( mp, mod->d, msize );
 
+  if ((mod->d[0] & 1))
+    {
+      montp = &mont;
+      mont.minv = _gcry_mpih_mont_inv (mod->d[0]);
+      mont.tp = NULL;
+      /* MOD->D may be the same as RES->D, which is overwritten by the
+         intermediate values.  */
+      if (mod_shift_cnt)
+        {
+          mont.mp = mm_marker = mpi_alloc_limb_space (msize, msec);
+          MPN_COPY (mont.mp, mod->d, msize);
+        }
+      else
+        mont.mp = mp;
+    }
+
   bsize = base->nlimbs;
   bsign = base->sign;
   if (bsize > msize)
@@ -534,6 +580,39 @@ _gcry_mpi_powm (gcry_mpi_t res,
       MPN_COPY(ep, rp, esize);
     }
 
+  if (montp)
+    {
+      /* Convert BASE to Montgomery form by dividing BASE * B^MSIZE by
+         the normalized MOD.  The remainder is shifted back and has
+         MSIZE limbs, like all the values in the main loop.  */
+      mpi_ptr_t tp;
+      mpi_size_t tsize;
+      mpi_limb_t cy;
+      unsigned int tp_nlimbs;
+
+      tp_nlimbs = bsec? (2 * msize + 1):0;
+      tp = mpi_alloc_limb_space (2 * msize + 1, bsec);
+      MPN_ZERO (tp, msize);
+      MPN_COPY (tp + msize, bp, bsize);
+      tsize = msize + bsize;
+      if (mod_shift_cnt)
+        {
+          cy = _gcry_mpih_lshift (tp + msize, tp + msize, bsize,
+                                  mod_shift_cnt);
+          if (cy)
+            tp[tsize++] = cy;
+        }
+      _gcry_mpih_divrem (tp + msize, 0, tp, tsize, mp, msize);
+      if (mod_shift_cnt)
+        _gcry_mpih_rshift (tp, tp, msize, mod_shift_cnt);
+
+      if (bp_marker)
+        _gcry_mpi_free_limb_space (bp_marker, bp_nlimbs);
+      bp = bp_marker = tp;
+      bp_nlimbs = tp_nlimbs;
+      bsize = msize;
+    }
+
   /* Copy base to the result.  */
   if (res->alloced < size)
     {
@@ -558,9 +637,14 @@ _gcry_mpi_powm (gcry_mpi_t res,
     memset( &karactx, 0, sizeof karactx );
     negative_result = (ep[0] & 1) && bsign;
 
+    if (montp)
+      mont.tp = mpi_alloc_limb_space (2 * msize + MPN_MUL_TSPACE (msize),
+                                      msec);
+
     /* Precompute PRECOMP[], BASE^(2 * i + 1), BASE^1, ^3, ^5, ... */
     if (W > 1)                  /* X := BASE^2 */
-      mul_mod (xp, &xsize, bp, bsize, bp, bsize, mp, msize, &karactx);
+      mul_mod (xp, &xsize, bp, bsize, bp, bsize, mp, msize,
+               &karactx, montp);
     base_u = precomp[0] = mpi_alloc_limb_space (bsize, esec);
     base_u_size = max_u_size = precomp_size[0] = bsize;
     MPN_COPY (precomp[0], bp, bsize);
@@ -568,10 +652,10 @@ _gcry_mpi_powm (gcry_mpi_t res,
       {                         /* PRECOMP[i] = BASE^(2 * i + 1) */
         if (xsize >= base_u_size)
           mul_mod (rp, &rsize, xp, xsize, base_u, base_u_size,
-                   mp, msize, &karactx);
+                   mp, msize, &karactx, montp);
         else
           mul_mod (rp, &rsize, base_u, base_u_size, xp, xsize,
-                   mp, msize, &karactx);
+                   mp, msize, &karactx, montp);
         base_u = precomp[i] = mpi_alloc_limb_space (rsize, esec);
         base_u_size = precomp_size[i] = rsize;
         if (max_u_size < base_u_size)
@@ -689,7 +773,7 @@ _gcry_mpi_powm (gcry_mpi_t res,
               base_u_size ^= ((base_u_size ^ rsize)  & (0UL - (j != 0)));
 
               mul_mod (xp, &xsize, rp, rsize, base_u, base_u_size,
-                       mp, msize, &karactx);
+                       mp, msize, &karactx, montp);
               tp = rp; rp = xp; xp = tp;
               rsize = xsize;
             }
@@ -701,45 +785,66 @@ _gcry_mpi_powm (gcry_mpi_t res,
 
     while (j--)
       {
-        mul_mod (xp, &xsize, rp, rsize, rp, rsize, mp, msize, &karactx);
+        mul_mod (xp, &xsize, rp, rsize, rp, rsize, mp, msize,
+                 &karactx, montp);
         tp = rp; rp = xp; xp = tp;
         rsize = xsize;
       }
 
-    /* We shifted MOD, the modulo reduction argument, left
-       MOD_SHIFT_CNT steps.  Adjust the result by reducing it with the
-       original MOD.
-
-       Also make sure the result is put in RES->d (where it already
-       might be, see above).  */
-    if ( mod_shift_cnt )
+    if (montp)
       {
-        carry_limb = _gcry_mpih_lshift( res->d, rp, rsize, mod_shift_cnt);
+        /* Convert the result back from Montgomery form by multiplying
+           it with 1, into RES->d.  XP is not used anymore and may be
+           the same as RES->d.  */
+        MPN_ZERO (xp, msize);
+        xp[0] = 1;
+        _gcry_mpih_mont_mul (res->d, rp, xp, mont.mp, msize, mont.minv,
+                             mont.tp);
         rp = res->d;
-        if ( carry_limb )
-          {
-            rp[rsize] = carry_limb;
-            rsize++;
-          }
+        rsize = msize;
       }
-    else if (res->d != rp)
+    else
       {
-        MPN_COPY (res->d, rp, rsize);
-        rp = res->d;
-      }
+        /* We shifted MOD, the modulo reduction argument, left
+           MOD_SHIFT_CNT steps.  Adjust the result by reducing it with
+           the original MOD.
 
-    if ( rsize >= msize )
-      {
-        _gcry_mpih_divrem(rp + msize, 0, rp, rsize, mp, msize);
-        rsize = msize;
+           Also make sure the result is put in RES->d (where it
+           already might be, see above).  */
+        if ( mod_shift_cnt )
+          {
+            carry_limb = _gcry_mpih_lshift( res->d, rp, rsize,
+                                            mod_shift_cnt);
+            rp = res->d;
+            if ( carry_limb )
+              {
+                rp[rsize] = carry_limb;
+                rsize++;
+              }
+          }
+        else if (res->d != rp)
+          {
+            MPN_COPY (res->d, rp, rsize);
+            rp = res->d;
+          }
+
+        if ( rsize >= msize )
+          {
+            _gcry_mpih_divrem(rp + msize, 0, rp, rsize, mp, msize);
+            rsize = msize;
+          }
+
+        if ( mod_shift_cnt )
+          _gcry_mpih_rshift( rp, rp, rsize, mod_shift_cnt);
       }
 
     /* Remove any leading zero words from the result.  */
-    if ( mod_shift_cnt )
-      _gcry_mpih_rshift( rp, rp, rsize, mod_shift_cnt);
     MPN_NORMALIZE (rp, rsize);
 
     _gcry_mpih_release_karatsuba_ctx (&karactx );
+    if (montp)
+      _gcry_mpi_free_limb_space (mont.tp, (msec ? 2 * msize
+                                             + MPN_MUL_TSPACE (msize) : 0));
     for (i = 0; i < (1 << (W - 1)); i++)
       _gcry_mpi_free_limb_space( precomp[i], esec ? precomp_size[i] : 0 );
     _gcry_mpi_free_limb_space (base_u, esec ? max_u_size : 0);
@@ -768,5 +873,7 @@ _gcry_mpi_powm (gcry_mpi_t res,
     _gcry_mpi_free_limb_space( ep_marker, ep_nlimbs );
   if (xp_marker)
     _gcry_mpi_free_limb_space( xp_marker, xp_nlimbs );
+  if (mm_marker)
+    _gcry_mpi_free_limb_space (mm_marker, mp_nlimbs);
 }
 #endif
@@ -33,6 +33,11 @@
 #include "longlong.h"
 #include "g10lib.h"
 
+/* See mpi-internal.h.  This is defined here so that the tune program,
+ * which includes this file, gets it too.  */
+unsigned int _gcry_mpih_hwf;
+
+
 #define MPN_MUL_N_RECURSE(prodp, up, vp, size, tspace) \
     do {						\
 	if( (size) < KARATSUBA_THRESHOLD )		\
@@ -43,7 +48,7 @@
 
 #define MPN_SQR_N_RECURSE(prodp, up, size, tspace) \
     do {					    \
-	if ((size) < KARATSUBA_THRESHOLD)	    \
+	if ((size) < KARATSUBA_SQR_THRESHOLD)	    \
 	    _gcry_mpih_sqr_n_basecase (prodp, up, size);	 \
 	else					    \
 	    _gcry_mpih_sqr_n (prodp, up, size, tspace);	 \
@@ -52,6 +57,65 @@
 
 
 
+#ifdef USE_MPIH_IFMA
+/* With AVX512 IFMA the basecase multiplication is done in radix 2^52
+ * for sizes in this range, and Montgomery multiplication is done as
+ * a product and a separate reduction.  The upper bound is set by the
+ * digit buffers on the stack.  The lower bound is where this still
+ * pays off in modular exponentiation: the kernel alone is faster from
+ * 16 limbs on, but on the CPUs tested the 512 bit instructions lower
+ * the clock for the surrounding code as well.  */
+#define IFMA_MIN_SIZE  40
+#define IFMA_MAX_SIZE  64
+#define IFMA_DIGITS(size) (((size) * 64 + 51) / 52)
+#define IFMA_MASK ((((mpi_limb_t)1) << 52) - 1)
+#define IFMA_SIZE_OK(size) ((_gcry_mpih_hwf & MPIH_HWF_IFMA) \
+                            && (size) >= IFMA_MIN_SIZE         \
+                            && (size) <= IFMA_MAX_SIZE)
+
+/* Propagate the carries through the N digit sums at DP, which
+ * leaves digits of 52 bits.  */
+static void
+ifma_carry (mpi_ptr_t dp, mpi_size_t n)
+{
+  mpi_limb_t carry, x;
+  mpi_size_t i;
+
+  for (i = 0, carry = 0; i < n; i++)
+    {
+      x = dp[i] + carry;
+      carry = x >> 52;
+      dp[i] = x & IFMA_MASK;
+    }
+}
+
+static mpi_limb_t
+mul_n_ifma (mpi_ptr_t prodp, mpi_ptr_t up, mpi_ptr_t vp, mpi_size_t size)
+{
+  /* The digits of U padded with zeros on both sides, those of V, and
+   * those of the product, in one buffer so that it is wiped at once.  */
+  mpi_limb_t buf[16 + IFMA_DIGITS (IFMA_MAX_SIZE) + 16
+                 + IFMA_DIGITS (IFMA_MAX_SIZE) + 8
+                 + 2 * IFMA_DIGITS (IFMA_MAX_SIZE) + 16];
+  mpi_size_t n52 = IFMA_DIGITS (size);
+  mpi_ptr_t u52 = buf + 16;
+  mpi_ptr_t v52 = u52 + n52 + 16;
+  mpi_ptr_t r52 = v52 + n52 + 8;
+
+  MPN_ZERO (buf, 16);
+  _gcry_mpih_split52_ifma (u52, up, size, n52);
+  MPN_ZERO (u52 + n52, 16);
+  _gcry_mpih_split52_ifma (v52, vp, size, n52);
+  _gcry_mpih_mul52_ifma (r52, u52, v52, n52);
+  ifma_carry (r52, 2 * n52);
+  _gcry_mpih_pack52_ifma (prodp, r52, 2 * size);
+
+  wipememory (u52, (r52 - u52 + 2 * n52) * BYTES_PER_MPI_LIMB);
+  return prodp[2 * size - 1];
+}
+#endif /*USE_MPIH_IFMA*/
+
+
 /* Multiply the natural numbers u (pointed to by UP) and v (pointed to by VP),
  * both with SIZE limbs, and store the result at PRODP.  2 * SIZE limbs are
  * always stored.  Return the most significant limb.
@@ -77,6 +141,11 @@ mul_n_basecase( mpi_ptr_t prodp, mpi_ptr_t up,
     mpi_limb_t cy;
     mpi_limb_t v_limb;
 
+#ifdef USE_MPIH_IFMA
+    if( IFMA_SIZE_OK (size) )
+	return mul_n_ifma( prodp, up, vp, size );
+#endif
+
     /* Multiply by the first limb in V separately, as the result can be
      * stored (not added) to PROD.  We also avoid a loop for zeroing.  */
     v_limb = vp[0];
@@ -113,10 +182,29 @@ mul_n_basecase( mpi_ptr_t prodp, mpi_ptr_t up,
 }
 
 
+static void toom3_mul_n (mpi_ptr_t prodp, mpi_ptr_t up, mpi_ptr_t vp,
+                         mpi_size_t size, mpi_ptr_t tspace, int sqr);
+
+/* Multiply U and V of SIZE limbs.  TSPACE needs MPN_MUL_TSPACE(SIZE)
+ * limbs.  */
 static void
 mul_n( mpi_ptr_t prodp, mpi_ptr_t up, mpi_ptr_t vp,
 			mpi_size_t size, mpi_ptr_t tspace )
 {
+#ifdef USE_MPIH_IFMA
+    /* Up to its size limit the radix 2^52 basecase is faster than
+     * splitting the operands.  */
+    if( IFMA_SIZE_OK (size) ) {
+	mul_n_ifma (prodp, up, vp, size);
+	return;
+    }
+#endif
+
+    if( size >= TOOM3_THRESHOLD ) {
+	toom3_mul_n (prodp, up, vp, size, tspace, 0);
+	return;
+    }
+
     if( size & 1 ) {
       /* The size is odd, and the code below doesn't handle that.
        * Multiply the least significant (size - 1) limbs with a recursive
@@ -222,51 +310,78 @@ mul_n( mpi_ptr_t prodp, mpi_ptr_t up, mpi_ptr_t vp,
 }
 
 
+/* Square the SIZE limbs at UP into PRODP.  Each product of two
+ * different limbs occurs twice in the square, so these products are
+ * computed once, doubled by a shift and the squares of the limbs are
+ * added.  That needs about half the multiplications of
+ * mul_n_basecase.  */
 void
 _gcry_mpih_sqr_n_basecase( mpi_ptr_t prodp, mpi_ptr_t up, mpi_size_t size )
 {
-    mpi_size_t i;
-    mpi_limb_t cy_limb;
-    mpi_limb_t v_limb;
-
-    /* Multiply by the first limb in V separately, as the result can be
-     * stored (not added) to PROD.  We also avoid a loop for zeroing.  */
-    v_limb = up[0];
-    if( v_limb <= 1 ) {
-	if( v_limb == 1 )
-	    MPN_COPY( prodp, up, size );
-	else
-	    MPN_ZERO(prodp, size);
-	cy_limb = 0;
+  mpi_size_t i;
+  mpi_limb_t hi, lo, x, c1, c2, cy;
+
+#ifdef USE_MPIH_IFMA
+  if (IFMA_SIZE_OK (size))
+    {
+      mul_n_ifma (prodp, up, up, size);
+      return;
     }
-    else
-	cy_limb = _gcry_mpih_mul_1( prodp, up, size, v_limb );
-
-    prodp[size] = cy_limb;
-    prodp++;
+#endif
 
-    /* For each iteration in the outer loop, multiply one limb from
-     * U with one limb from V, and add it to PROD.  */
-    for( i=1; i < size; i++) {
-	v_limb = up[i];
-	if( v_limb <= 1 ) {
-	    cy_limb = 0;
-	    if( v_limb == 1 )
-		cy_limb = _gcry_mpih_add_n(prodp, prodp, up, size);
-	}
-	else
-	    cy_limb = _gcry_mpih_addmul_1(prodp, up, size, v_limb);
+  if (size == 1)
+    {
+      umul_ppmm (prodp[1], prodp[0], up[0], up[0]);
+      return;
+    }
 
-	prodp[size] = cy_limb;
-	prodp++;
+  /* The products U[I] U[J] with I < J.  */
+  prodp[0] = 0;
+  prodp[size] = _gcry_mpih_mul_1 (prodp + 1, up + 1, size - 1, up[0]);
+  for (i = 1; i < size - 1; i++)
+    prodp[size + i] = _gcry_mpih_addmul_1 (prodp + 2 * i + 1, up + i + 1,
+                                           size - 1 - i, up[i]);
+  prodp[2 * size - 1] = 0;
+
+  _gcry_mpih_lshift (prodp, prodp, 2 * size, 1);
+
+  /* Add the squares U[I]^2.  */
+  cy = 0;
+  for (i = 0; i < size; i++)
+    {
+      umul_ppmm (hi, lo, up[i], up[i]);
+      x = prodp[2 * i] + lo;
+      c1 = x < lo;
+      x += cy;
+      c1 += x < cy;
+      prodp[2 * i] = x;
+      x = prodp[2 * i + 1] + hi;
+      c2 = x < hi;
+      x += c1;
+      c2 += x < c1;
+      prodp[2 * i + 1] = x;
+      cy = c2;
     }
 }
 
 
+/* Square U of SIZE limbs.  TSPACE needs MPN_MUL_TSPACE(SIZE) limbs.  */
 void
 _gcry_mpih_sqr_n( mpi_ptr_t prodp,
                   mpi_ptr_t up, mpi_size_t size, mpi_ptr_t tspace)
 {
+#ifdef USE_MPIH_IFMA
+    if( IFMA_SIZE_OK (size) ) {
+	mul_n_ifma (prodp, up, up, size);
+	return;
+    }
+#endif
+
+    if( size >= TOOM3_SQR_THRESHOLD ) {
+	toom3_mul_n (prodp, up, up, size, tspace, 1);
+	return;
+    }
+
     if( size & 1 ) {
 	/* The size is odd, and the code below doesn't handle that.
 	 * Multiply the least significant (size - 1) limbs with a recursive
@@ -341,6 +456,207 @@ _gcry_mpih_sqr_n( mpi_ptr_t prodp,
 }
 
 
+/* QP = XP / 3 for the SIZE limbs at XP, which must be a multiple of
+ * 3.  QP may be equal to XP.  */
+static void
+divexact_by3 (mpi_ptr_t qp, mpi_ptr_t xp, mpi_size_t size)
+{
+  const mpi_limb_t inv3 = (~(mpi_limb_t)0) / 3 * 2 + 1;  /* 1/3 mod B */
+  mpi_limb_t x, q, c, hi, lo;
+  mpi_size_t i;
+
+  c = 0;
+  for (i = 0; i < size; i++)
+    {
+      x = xp[i];
+      q = x - c;
+      c = q > x;
+      q *= inv3;
+      qp[i] = q;
+      umul_ppmm (hi, lo, q, 3);
+      (void)lo;
+      c += hi;
+    }
+}
+
+
+/* Set SP to the absolute value of XP - YP, with XP of XSIZE and YP of
+ * YSIZE <= XSIZE limbs.  SP gets XSIZE limbs.  Return 1 if the
+ * difference is negative.  */
+static int
+sub_abs (mpi_ptr_t sp, mpi_ptr_t xp, mpi_size_t xsize,
+         mpi_ptr_t yp, mpi_size_t ysize)
+{
+  mpi_size_t i;
+
+  for (i = xsize - 1; i >= ysize; i--)
+    if (xp[i])
+      break;
+  if (i >= ysize || _gcry_mpih_cmp (xp, yp, ysize) >= 0)
+    {
+      _gcry_mpih_sub (sp, xp, xsize, yp, ysize);
+      return 0;
+    }
+  _gcry_mpih_sub_n (sp, yp, xp, ysize);
+  MPN_ZERO (sp + ysize, xsize - ysize);
+  return 1;
+}
+
+
+/* Evaluate the polynomial with the coefficients X0, X1 (K limbs) and
+ * X2 (R limbs) at XP at 1 and -1 into P1 and PM1 of K + 1 limbs each.
+ * Return 1 if the value at -1 is negative; PM1 is its absolute
+ * value.  */
+static int
+toom3_eval_pm1 (mpi_ptr_t p1, mpi_ptr_t pm1,
+                mpi_ptr_t xp, mpi_size_t k, mpi_size_t r)
+{
+  int neg;
+
+  p1[k] = _gcry_mpih_add (p1, xp, k, xp + 2 * k, r);
+  neg = sub_abs (pm1, p1, k + 1, xp + k, k);
+  p1[k] += _gcry_mpih_add_n (p1, p1, xp + k, k);
+  return neg;
+}
+
+
+/* Same as toom3_eval_pm1 but evaluate at 2 into P2.  */
+static void
+toom3_eval_2 (mpi_ptr_t p2, mpi_ptr_t xp, mpi_size_t k, mpi_size_t r)
+{
+  MPN_COPY (p2, xp + 2 * k, r);
+  MPN_ZERO (p2 + r, k + 1 - r);
+  _gcry_mpih_lshift (p2, p2, k + 1, 1);
+  p2[k] += _gcry_mpih_add_n (p2, p2, xp + k, k);
+  _gcry_mpih_lshift (p2, p2, k + 1, 1);
+  p2[k] += _gcry_mpih_add_n (p2, p2, xp, k);
+}
+
+
+/* Add the LEN limbs at XP to the SIZE limbs at PRODP.  The sum must
+ * fit into SIZE limbs.  */
+static void
+add_in (mpi_ptr_t prodp, mpi_size_t size, mpi_ptr_t xp, mpi_size_t len)
+{
+  MPN_NORMALIZE (xp, len);
+  if (len)
+    _gcry_mpih_add (prodp, prodp, size, xp, len);
+}
+
+
+/* Multiply U and V of SIZE limbs, or square U if SQR is set, with the
+ * Toom-Cook 3-way method.  The operands are split into three pieces
+ * of K, K and R limbs, the pieces evaluated at 0, 1, -1, 2 and
+ * infinity, and the five products interpolated with the sequence of
+ * M. Bodrato, "Towards Optimal Toom-Cook Multiplication for
+ * Univariate and Multivariate Polynomials in Characteristic 2 and 0",
+ * WAIFI 2007.  All intermediate values of this sequence are
+ * non-negative.
+ *
+ * The values at 1 and 2 are kept in PRODP during the recursive
+ * multiplications, the three products of K + 1 limbs in TSPACE, which
+ * needs MPN_MUL_TSPACE(SIZE) limbs in total.  */
+static void
+toom3_mul_n (mpi_ptr_t prodp, mpi_ptr_t up, mpi_ptr_t vp,
+             mpi_size_t size, mpi_ptr_t tspace, int sqr)
+{
+  mpi_size_t k = (size + 2) / 3;
+  mpi_size_t r = size - 2 * k;
+  mpi_size_t len = 2 * k + 2;
+  mpi_ptr_t v1 = tspace;
+  mpi_ptr_t vm1 = tspace + len;
+  mpi_ptr_t v2 = tspace + 2 * len;
+  mpi_ptr_t ws = tspace + 3 * len;
+  mpi_ptr_t vinf = prodp + 4 * k;
+  mpi_ptr_t ua, va, ub, vb;
+  int neg;
+
+  /* U(1) and V(1) in PRODP, U(-1) and V(-1) in V2.  U(2) and V(2) are
+     computed into PRODP after the products at 1 and -1 are done.  */
+  ua = prodp;
+  va = sqr? ua : prodp + k + 1;
+  ub = v2;
+  vb = sqr? ub : v2 + k + 1;
+
+  neg = toom3_eval_pm1 (ua, ub, up, k, r);
+  if (sqr)
+    neg = 0;
+  else
+    neg ^= toom3_eval_pm1 (va, vb, vp, k, r);
+
+  if (sqr)
+    {
+      MPN_SQR_N_RECURSE (v1, ua, k + 1, ws);
+      MPN_SQR_N_RECURSE (vm1, ub, k + 1, ws);
+    }
+  else
+    {
+      MPN_MUL_N_RECURSE (v1, ua, va, k + 1, ws);
+      MPN_MUL_N_RECURSE (vm1, ub, vb, k + 1, ws);
+    }
+
+  toom3_eval_2 (ua, up, k, r);
+  if (sqr)
+    {
+      MPN_SQR_N_RECURSE (v2, ua, k + 1, ws);
+    }
+  else
+    {
+      toom3_eval_2 (va, vp, k, r);
+      MPN_MUL_N_RECURSE (v2, ua, va, k + 1, ws);
+    }
+
+  /* The value at 0 and at infinity.  */
+  if (sqr)
+    {
+      MPN_SQR_N_RECURSE (prodp, up, k, ws);
+      MPN_SQR_N_RECURSE (vinf, up + 2 * k, r, ws);
+    }
+  else
+    {
+      MPN_MUL_N_RECURSE (prodp, up, vp, k, ws);
+      MPN_MUL_N_RECURSE (vinf, up + 2 * k, vp + 2 * k, r, ws);
+    }
+  MPN_ZERO (prodp + 2 * k, 2 * k);
+
+  /* With C0 to C4 the coefficients of the product:
+   *   V2  = (V2 - VM1) / 3       = C1 + C2 + 3 C3 + 5 C4
+   *   VM1 = (V1 - VM1) / 2       = C1 + C3
+   *   V1  = V1 - V0              = C1 + C2 + C3 + C4
+   *   V2  = (V2 - V1) / 2        = C3 + 2 C4
+   *   V1  = V1 - VM1 - VINF      = C2
+   *   V2  = V2 - 2 VINF          = C3
+   *   VM1 = VM1 - V2             = C1
+   */
+  if (neg)
+    {
+      _gcry_mpih_add_n (v2, v2, vm1, len);
+      divexact_by3 (v2, v2, len);
+      _gcry_mpih_add_n (vm1, v1, vm1, len);
+    }
+  else
+    {
+      _gcry_mpih_sub_n (v2, v2, vm1, len);
+      divexact_by3 (v2, v2, len);
+      _gcry_mpih_sub_n (vm1, v1, vm1, len);
+    }
+  _gcry_mpih_rshift (vm1, vm1, len, 1);
+  _gcry_mpih_sub (v1, v1, len, prodp, 2 * k);
+  _gcry_mpih_sub_n (v2, v2, v1, len);
+  _gcry_mpih_rshift (v2, v2, len, 1);
+  _gcry_mpih_sub_n (v1, v1, vm1, len);
+  _gcry_mpih_sub (v1, v1, len, vinf, 2 * r);
+  _gcry_mpih_sub (v2, v2, len, vinf, 2 * r);
+  _gcry_mpih_sub (v2, v2, len, vinf, 2 * r);
+  _gcry_mpih_sub_n (vm1, vm1, v2, len);
+
+  /* PRODP = V0 + C1 B^K + C2 B^2K + C3 B^3K + VINF B^4K  */
+  add_in (prodp + k, 2 * size - k, vm1, len);
+  add_in (prodp + 2 * k, 2 * size - 2 * k, v1, len);
+  add_in (prodp + 3 * k, 2 * size - 3 * k, v2, len);
+}
+
+
 /* This should be made into an inline function in gmp.h.  */
 void
 _gcry_mpih_mul_n( mpi_ptr_t prodp,
@@ -349,14 +665,14 @@ _gcry_mpih_mul_n( mpi_ptr_t prodp,
     int secure;
 
     if( up == vp ) {
-	if( size < KARATSUBA_THRESHOLD )
+	if( size < KARATSUBA_SQR_THRESHOLD )
 	    _gcry_mpih_sqr_n_basecase( prodp, up, size );
 	else {
 	    mpi_ptr_t tspace;
 	    secure = _gcry_is_secure( up );
-	    tspace = mpi_alloc_limb_space( 2 * size, secure );
+	    tspace = mpi_alloc_limb_space( MPN_MUL_TSPACE (size), secure );
 	    _gcry_mpih_sqr_n( prodp, up, size, tspace );
-	    _gcry_mpi_free_limb_space (tspace, 2 * size );
+	    _gcry_mpi_free_limb_space (tspace, MPN_MUL_TSPACE (size) );
 	}
     }
     else {
@@ -365,9 +681,9 @@ _gcry_mpih_mul_n( mpi_ptr_t prodp,
 	else {
 	    mpi_ptr_t tspace;
 	    secure = _gcry_is_secure( up ) || _gcry_is_secure( vp );
-	    tspace = mpi_alloc_limb_space( 2 * size, secure );
+	    tspace = mpi_alloc_limb_space( MPN_MUL_TSPACE (size), secure );
 	    mul_n (prodp, up, vp, size, tspace);
-	    _gcry_mpi_free_limb_space (tspace, 2 * size );
+	    _gcry_mpi_free_limb_space (tspace, MPN_MUL_TSPACE (size) );
 	}
     }
 }
@@ -385,13 +701,18 @@ _gcry_mpih_mul_karatsuba_case( mpi_ptr_t prodp,
     if( !ctx->tspace || ctx->tspace_size < vsize ) {
 	if( ctx->tspace )
 	    _gcry_mpi_free_limb_space( ctx->tspace, ctx->tspace_nlimbs );
-        ctx->tspace_nlimbs = 2 * vsize;
-	ctx->tspace = mpi_alloc_limb_space (2 * vsize,
+        ctx->tspace_nlimbs = MPN_MUL_TSPACE (vsize);
+	ctx->tspace = mpi_alloc_limb_space (ctx->tspace_nlimbs,
 				            (_gcry_is_secure (up)
                                              || _gcry_is_secure (vp)));
 	ctx->tspace_size = vsize;
     }
 
+    if( up == vp && usize == vsize ) {
+	MPN_SQR_N_RECURSE( prodp, up, vsize, ctx->tspace );
+	return;
+    }
+
     MPN_MUL_N_RECURSE( prodp, up, vp, vsize, ctx->tspace );
 
     prodp += vsize;
@@ -480,6 +801,11 @@ _gcry_mpih_mul( mpi_ptr_t prodp, mpi_ptr_t up, mpi_size_t usize,
     mpi_limb_t cy;
     struct karatsuba_ctx ctx;
 
+    if( up == vp && usize == vsize && usize ) {
+	_gcry_mpih_mul_n( prodp, up, up, usize );
+	return *prod_endp;
+    }
+
     if( vsize < KARATSUBA_THRESHOLD ) {
 	mpi_size_t i;
 	mpi_limb_t v_limb;
@@ -527,3 +853,102 @@ _gcry_mpih_mul( mpi_ptr_t prodp, mpi_ptr_t up, mpi_size_t usize,
     _gcry_mpih_release_karatsuba_ctx( &ctx );
     return *prod_endp;
 }
+
+
+/* Return -1/M0 mod B, with B = 2^BITS_PER_MPI_LIMB, for an odd M0.
+ * Each Newton step doubles the number of correct low bits, starting
+ * with 3 bits from M0 * M0 = 1 (mod 8).  */
+mpi_limb_t
+_gcry_mpih_mont_inv (mpi_limb_t m0)
+{
+  mpi_limb_t x = m0;
+  int i;
+
+  for (i = 3; i < BITS_PER_MPI_LIMB; i *= 2)
+    x *= 2 - m0 * x;
+
+  return -x;
+}
+
+
+/* Set RP to the value of the SIZE limbs at TP plus TOP * B^SIZE,
+ * reduced once by MP.  The subtraction is always done and its result
+ * selected with a mask, so that the timing does not depend on the
+ * data.  RP must not overlap TP.  */
+static void
+mont_reduce_final (mpi_ptr_t rp, mpi_ptr_t tp, mpi_limb_t top,
+                   mpi_ptr_t mp, mpi_size_t size)
+{
+  mpi_limb_t mask;
+  mpi_size_t i;
+
+  mask = _gcry_mpih_sub_n (rp, tp, mp, size);
+  mask = 0 - ((top | (mask ^ 1)) & 1);
+  for (i = 0; i < size; i++)
+    rp[i] = (rp[i] & mask) | (tp[i] & ~mask);
+}
+
+
+/* Set RP to the 2 * SIZE limbs at TP divided by B^SIZE mod MP, one
+ * limb at a time.  TP is clobbered.  */
+static void
+mont_redc (mpi_ptr_t rp, mpi_ptr_t tp,
+           mpi_ptr_t mp, mpi_size_t size, mpi_limb_t minv)
+{
+  mpi_limb_t cy, top, x;
+  mpi_size_t i;
+
+  top = 0;
+  for (i = 0; i < size; i++)
+    {
+      cy = _gcry_mpih_addmul_1 (tp + i, mp, size, tp[i] * minv);
+      x = tp[i + size] + top;
+      top = x < top;
+      x += cy;
+      top += x < cy;
+      tp[i + size] = x;
+    }
+
+  mont_reduce_final (rp, tp + size, top, mp, size);
+}
+
+
+/* RP = UP * VP / B^SIZE mod MP for UP and VP less than MP, and with
+ * MINV = -1/MP mod B from _gcry_mpih_mont_inv.  RP may be one of the
+ * operands.  TP is scratch space of 2 * SIZE limbs.  */
+void
+_gcry_mpih_mont_mul (mpi_ptr_t rp, mpi_ptr_t up, mpi_ptr_t vp,
+                     mpi_ptr_t mp, mpi_size_t size, mpi_limb_t minv,
+                     mpi_ptr_t tp)
+{
+  mpi_limb_t top;
+
+#ifdef USE_MPIH_IFMA
+  if (IFMA_SIZE_OK (size))
+    {
+      mul_n_ifma (tp, up, vp, size);
+      mont_redc (rp, tp, mp, size, minv);
+      return;
+    }
+#endif
+
+  top = _gcry_mpih_mont_mul_n (tp, up, vp, mp, size, minv);
+  mont_reduce_final (rp, tp, top, mp, size);
+}
+
+
+/* RP = UP * UP / B^SIZE mod MP, see _gcry_mpih_mont_mul.  The square
+ * is computed first and then reduced a limb at a time.  TP is scratch
+ * space of 2 * SIZE + MPN_MUL_TSPACE(SIZE) limbs.  */
+void
+_gcry_mpih_mont_sqr (mpi_ptr_t rp, mpi_ptr_t up,
+                     mpi_ptr_t mp, mpi_size_t size, mpi_limb_t minv,
+                     mpi_ptr_t tp)
+{
+  if (size < KARATSUBA_SQR_THRESHOLD)
+    _gcry_mpih_sqr_n_basecase (tp, up, size);
+  else
+    _gcry_mpih_sqr_n (tp, up, size, tp + 2 * size);
+
+  mont_redc (rp, tp, mp, size, minv);
+}
@@ -47,6 +47,14 @@ _gcry_mpi_init (void)
 {
   int idx;
   unsigned long value;
+  unsigned int hwf;
+
+  hwf = _gcry_get_hw_features ();
+  _gcry_mpih_hwf = 0;
+  if ((hwf & HWF_INTEL_BMI2) && (hwf & HWF_INTEL_ADX))
+    _gcry_mpih_hwf |= MPIH_HWF_MULX;
+  if ((hwf & HWF_INTEL_AVX512_IFMA))
+    _gcry_mpih_hwf |= MPIH_HWF_IFMA;
 
   for (idx=0; idx < MPI_NUMBER_OF_CONSTANTS; idx++)
     {
@@ -76,6 +76,30 @@ typedef gcry_err_code_t (*gcry_pk_verify_t) (gcry_sexp_t s_sig,
                                              gcry_sexp_t s_data,
                                              gcry_sexp_t keyparms);
 
+/* Type for the pk_verify_batch function.  */
+typedef gcry_err_code_t (*gcry_pk_verify_batch_t) (gcry_sexp_t *s_sigs,
+                                                   gcry_sexp_t *s_data,
+                                                   gcry_sexp_t *keyparms,
+                                                   size_t n,
+                                                   gcry_err_code_t *r_rcs);
+
+/* Type for the pk_prepare function.  */
+typedef gcry_err_code_t (*gcry_pk_prepare_t) (void **r_key,
+                                              gcry_sexp_t keyparms);
+
+/* Type for the pk_sign_prepared function.  */
+typedef gcry_err_code_t (*gcry_pk_sign_prepared_t) (gcry_sexp_t *r_sig,
+                                                    gcry_sexp_t s_data,
+                                                    void *key);
+
+/* Type for the pk_decrypt_prepared function.  */
+typedef gcry_err_code_t (*gcry_pk_decrypt_prepared_t) (gcry_sexp_t *r_plain,
+                                                       gcry_sexp_t s_data,
+                                                       void *key);
+
+/* Type for the pk_release_prepared function.  */
+typedef void (*gcry_pk_release_prepared_t) (void *key);
+
 /* Type for the pk_get_nbits function.  */
 typedef unsigned (*gcry_pk_get_nbits_t) (gcry_sexp_t keyparms);
 
@@ -119,6 +143,11 @@ typedef struct gcry_pk_spec
   pk_comp_keygrip_t comp_keygrip;
   pk_get_curve_t get_curve;
   pk_get_curve_param_t get_curve_param;
+  gcry_pk_verify_batch_t verify_batch;
+  gcry_pk_prepare_t prepare;
+  gcry_pk_sign_prepared_t sign_prepared;
+  gcry_pk_decrypt_prepared_t decrypt_prepared;
+  gcry_pk_release_prepared_t release_prepared;
 } gcry_pk_spec_t;
 
 
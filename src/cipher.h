@@ -42,6 +42,7 @@
 #define PUBKEY_FLAG_GOST           (1 << 13)
 #define PUBKEY_FLAG_NO_KEYTEST     (1 << 14)
 #define PUBKEY_FLAG_DJB_TWEAK      (1 << 15)
+#define PUBKEY_FLAG_PARALLEL       (1 << 16)
 
 
 enum pk_operation
@@ -120,12 +121,18 @@ void _gcry_sha1_hash_buffer (void *outbuf,
                              const void *buffer, size_t length);
 void _gcry_sha1_hash_buffers (void *outbuf,
                               const gcry_buffer_t *iov, int iovcnt);
+void _gcry_sha1_hash_buffers_multi (void *outbuf,
+                                    const gcry_buffer_t *iov, int nmsgs);
 
 /*-- sha256.c --*/
 void _gcry_sha256_hash_buffer (void *outbuf,
                                const void *buffer, size_t length);
 void _gcry_sha256_hash_buffers (void *outbuf,
                                 const gcry_buffer_t *iov, int iovcnt);
+void _gcry_sha256_hash_buffers_multi (void *outbuf,
+                                      const gcry_buffer_t *iov, int nmsgs);
+void _gcry_sha224_hash_buffers_multi (void *outbuf,
+                                      const gcry_buffer_t *iov, int nmsgs);
 
 /*-- sha512.c --*/
 void _gcry_sha512_hash_buffer (void *outbuf,
@@ -133,6 +140,10 @@ void _gcry_sha512_hash_buffer (void *outbuf,
 void _gcry_sha512_hash_buffers (void *outbuf,
                                 const gcry_buffer_t *iov, int iovcnt);
 
+/*-- keccak.c --*/
+void _gcry_keccak_hash_buffers_multi (int algo, void *outbuf, size_t outlen,
+                                      const gcry_buffer_t *iov, int nmsgs);
+
 /*-- blake2.c --*/
 gcry_err_code_t _gcry_blake2_init_with_key(void *ctx, unsigned int flags,
 					   const unsigned char *key,
@@ -158,6 +169,11 @@ size_t _gcry_aes_ocb_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
 			    const void *inbuf_arg, size_t nblocks, int encrypt);
 size_t _gcry_aes_ocb_auth (gcry_cipher_hd_t c, const void *abuf_arg,
 			   size_t nblocks);
+void _gcry_aes_xts_crypt (gcry_cipher_hd_t c, unsigned char *tweak,
+			  void *outbuf_arg, const void *inbuf_arg,
+			  size_t nblocks, int encrypt);
+size_t _gcry_aes_gcm_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
+			    const void *inbuf_arg, size_t nblocks, int encrypt);
 
 /*-- blowfish.c --*/
 void _gcry_blowfish_cfb_dec (void *context, unsigned char *iv,
@@ -246,6 +262,11 @@ size_t _gcry_twofish_ocb_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
 size_t _gcry_twofish_ocb_auth (gcry_cipher_hd_t c, const void *abuf_arg,
 			       size_t nblocks);
 
+/*-- chacha20.c --*/
+size_t _gcry_chacha20_poly1305_crypt (gcry_cipher_hd_t c, void *outbuf_arg,
+				      const void *inbuf_arg, size_t length,
+				      int encrypt);
+
 /*-- dsa.c --*/
 void _gcry_register_pk_dsa_progress (gcry_handler_progress_t cbc, void *cb_data);
 
@@ -258,6 +279,12 @@ void _gcry_register_pk_elg_progress (gcry_handler_progress_t cb,
 void _gcry_register_pk_ecc_progress (gcry_handler_progress_t cbc,
                                      void *cb_data);
 
+/*-- ecc-curves.c --*/
+void _gcry_ecc_enable_cache (void);
+
+/*-- rsa.c --*/
+void _gcry_rsa_enable_blinding_cache (void);
+
 
 /*-- primegen.c --*/
 void _gcry_register_primegen_progress (gcry_handler_progress_t cb,
@@ -326,6 +353,8 @@ extern gcry_md_spec_t _gcry_digest_spec_blake2s_256;
 extern gcry_md_spec_t _gcry_digest_spec_blake2s_224;
 extern gcry_md_spec_t _gcry_digest_spec_blake2s_160;
 extern gcry_md_spec_t _gcry_digest_spec_blake2s_128;
+extern gcry_md_spec_t _gcry_digest_spec_blake2bp_512;
+extern gcry_md_spec_t _gcry_digest_spec_blake2sp_256;
 
 /* Declarations for the pubkey cipher specifications.  */
 extern gcry_pk_spec_t _gcry_pubkey_spec_rsa;
@@ -58,6 +58,8 @@ _gcry_ctx_alloc (int type, size_t length, void (*deinit)(void*))
   switch (type)
     {
     case CONTEXT_TYPE_EC:
+    case CONTEXT_TYPE_PK_KEY:
+    case CONTEXT_TYPE_KDF:
       break;
     default:
       log_bug ("bad context type %d given to _gcry_ctx_alloc\n", type);
@@ -125,6 +127,8 @@ _gcry_ctx_release (gcry_ctx_t ctx)
   switch (ctx->type)
     {
     case CONTEXT_TYPE_EC:
+    case CONTEXT_TYPE_PK_KEY:
+    case CONTEXT_TYPE_KDF:
       break;
     default:
       log_fatal ("bad context type %d detected in gcry_ctx_relase\n",
@@ -22,6 +22,8 @@
 
 /* Context types as used in struct gcry_context.  */
 #define CONTEXT_TYPE_EC 1  /* The context is used with EC functions.  */
+#define CONTEXT_TYPE_PK_KEY 2  /* The context holds a prepared key.  */
+#define CONTEXT_TYPE_KDF 3     /* The context holds a prepared KDF.  */
 
 
 gcry_ctx_t _gcry_ctx_alloc (int type, size_t length, void (*deinit)(void*));
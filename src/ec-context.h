@@ -20,6 +20,10 @@
 #ifndef GCRY_EC_CONTEXT_H
 #define GCRY_EC_CONTEXT_H
 
+/* A table of precomputed multiples of a base point.  */
+struct mpi_ec_fixed_base_s;
+typedef struct mpi_ec_fixed_base_s *mpi_ec_fixed_base_t;
+
 /* This context is used with all our EC functions. */
 struct mpi_ec_ctx_s
 {
@@ -44,6 +48,10 @@ struct mpi_ec_ctx_s
   gcry_mpi_point_t Q;   /* Public key.   */
   gcry_mpi_t d;         /* Private key.  */
 
+  /* Optional table for multiplications of G; not owned by the
+     context.  */
+  mpi_ec_fixed_base_t fixed_base;
+
 
   /* This structure is private to mpi/ec.c! */
   struct {
@@ -54,23 +62,34 @@ struct mpi_ec_ctx_s
 
     int a_is_pminus3;  /* True if A = P - 3. */
 
+    int p25519;        /* True if P = 2^255 - 19.  */
+
     gcry_mpi_t two_inv_p;
 
     mpi_barrett_t p_barrett;
 
+    /* Fast reduction modulo P for special primes or NULL.  */
+    void (*mod) (gcry_mpi_t w, mpi_ec_t ctx);
+
     /* Scratch variables.  */
     gcry_mpi_t scratch[11];
 
-    /* Helper for fast reduction.  */
-    /*   int nist_nbits; /\* If this is a NIST curve, the # of bits.  *\/ */
-    /*   gcry_mpi_t s[10]; */
-    /*   gcry_mpi_t c; */
+    /* Limb space for the field arithmetic so that it does not need
+       to allocate memory: P shifted to have its high bit set (N
+       limbs), a product (2N+1 limbs) and a quotient (N+1 limbs).  */
+    mpi_limb_t *arena;
+    unsigned int arena_nlimbs;
+    unsigned int p_shift;  /* Left shift count of P in ARENA.  */
   } t;
 };
 
 
 /*-- mpi/ec.c --*/
 void _gcry_mpi_ec_get_reset (mpi_ec_t ec);
+void _gcry_mpi_ec_wipe_scratch (mpi_ec_t ctx);
+mpi_ec_fixed_base_t _gcry_mpi_ec_fixed_base_new (mpi_point_t base,
+                                                 unsigned int nbits,
+                                                 mpi_ec_t ctx);
 
 
 /*-- cipher/ecc-curves.c --*/
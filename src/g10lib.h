@@ -174,6 +174,11 @@ void _gcry_log_printsxp (const char *text, gcry_sexp_t sexp);
 void _gcry_set_log_verbosity( int level );
 int _gcry_log_verbosity( int level );
 
+unsigned int _gcry_get_ncpus (void);
+void _gcry_run_workers (unsigned int n,
+                        void (*func) (void *arg, unsigned int idx),
+                        void *arg);
+
 
 #ifdef JNLIB_GCC_M_FUNCTION
 #define BUG() _gcry_bug( __FILE__ , __LINE__, __FUNCTION__ )
@@ -232,6 +237,11 @@ char **_gcry_strtokenize (const char *string, const char *delim);
 #define HWF_ARM_PMULL           (1 << 19)
 
 #define HWF_INTEL_RDTSC         (1 << 20)
+#define HWF_INTEL_AVX512        (1 << 21)
+#define HWF_INTEL_VAES_VPCLMUL  (1 << 22)
+#define HWF_INTEL_SHAEXT        (1 << 23)
+#define HWF_INTEL_ADX           (1 << 24)
+#define HWF_INTEL_AVX512_IFMA   (1 << 25)
 
 
 
@@ -258,6 +268,11 @@ gcry_mpi_t _gcry_generate_secret_prime (unsigned int nbits,
                                  gcry_random_level_t random_level,
                                  int (*extra_check)(void*, gcry_mpi_t),
                                  void *extra_check_arg);
+gcry_mpi_t _gcry_generate_secret_prime_parallel (unsigned int nbits,
+                                 gcry_random_level_t random_level,
+                                 int (*extra_check)(void*, gcry_mpi_t),
+                                 void *extra_check_arg,
+                                 unsigned int nworkers);
 gcry_mpi_t _gcry_generate_public_prime (unsigned int nbits,
                                  gcry_random_level_t random_level,
                                  int (*extra_check)(void*, gcry_mpi_t),
@@ -95,6 +95,14 @@ gpg_err_code_t _gcry_pk_sign (gcry_sexp_t *result,
                               gcry_sexp_t data, gcry_sexp_t skey);
 gpg_err_code_t _gcry_pk_verify (gcry_sexp_t sigval,
                                 gcry_sexp_t data, gcry_sexp_t pkey);
+gpg_err_code_t _gcry_pk_verify_batch (gcry_sexp_t *sigvals,
+                                      gcry_sexp_t *data, gcry_sexp_t *pkeys,
+                                      size_t n, gcry_error_t *r_errs);
+gpg_err_code_t _gcry_pk_prepare_key (gcry_ctx_t *r_ctx, gcry_sexp_t s_skey);
+gpg_err_code_t _gcry_pk_decrypt_prepared (gcry_sexp_t *r_plain,
+                                          gcry_sexp_t s_data, gcry_ctx_t ctx);
+gpg_err_code_t _gcry_pk_sign_prepared (gcry_sexp_t *r_sig,
+                                       gcry_sexp_t s_hash, gcry_ctx_t ctx);
 gpg_err_code_t _gcry_pk_testkey (gcry_sexp_t key);
 gpg_err_code_t _gcry_pk_genkey (gcry_sexp_t *r_key, gcry_sexp_t s_parms);
 gpg_err_code_t _gcry_pk_ctl (int cmd, void *buffer, size_t buflen);
@@ -127,6 +135,16 @@ void _gcry_md_hash_buffer (int algo, void *digest,
 gpg_err_code_t _gcry_md_hash_buffers (int algo, unsigned int flags,
                                       void *digest,
                                       const gcry_buffer_t *iov, int iovcnt);
+gpg_err_code_t _gcry_md_hash_buffers_multi (int algo, unsigned int flags,
+                                            void *digests,
+                                            const gcry_buffer_t *iov,
+                                            int nmsgs);
+gpg_err_code_t _gcry_md_hash_buffers_extract_multi (int algo,
+                                                    unsigned int flags,
+                                                    void *outputs,
+                                                    size_t outlen,
+                                                    const gcry_buffer_t *iov,
+                                                    int nmsgs);
 int _gcry_md_get_algo (gcry_md_hd_t hd);
 unsigned int _gcry_md_get_algo_dlen (int algo);
 int _gcry_md_is_enabled (gcry_md_hd_t a, int algo);
@@ -187,6 +205,14 @@ gpg_err_code_t _gcry_kdf_derive (const void *passphrase, size_t passphraselen,
                                  const void *salt, size_t saltlen,
                                  unsigned long iterations,
                                  size_t keysize, void *keybuffer);
+gpg_err_code_t _gcry_kdf_prepare (gcry_ctx_t *r_ctx, int algo, int subalgo,
+                                  unsigned long iterations,
+                                  unsigned int flags);
+gpg_err_code_t _gcry_kdf_derive_prepared (gcry_ctx_t ctx,
+                                          const void *passphrase,
+                                          size_t passphraselen,
+                                          const void *salt, size_t saltlen,
+                                          size_t keysize, void *keybuffer);
 
 
 gpg_err_code_t _gcry_prime_generate (gcry_mpi_t *prime,
@@ -816,6 +816,14 @@ _gcry_vcontrol (enum gcry_ctl_cmds cmd, va_list arg_ptr)
         gpgrt_get_syscall_clamp (&pre_syscall_func, &post_syscall_func);
       break;
 
+    case GCRYCTL_ENABLE_ECC_CACHE:
+      _gcry_ecc_enable_cache ();
+      break;
+
+    case GCRYCTL_ENABLE_RSA_BLINDING_CACHE:
+      _gcry_rsa_enable_blinding_cache ();
+      break;
+
     default:
       _gcry_set_preferred_rng_type (0);
       rc = GPG_ERR_INV_OP;
@@ -96,7 +96,8 @@ get_cpuid(unsigned int in, unsigned int *eax, unsigned int *ebx,
     *edx = regs[3];
 }
 
-#if defined(ENABLE_AVX_SUPPORT) || defined(ENABLE_AVX2_SUPPORT)
+#if defined(ENABLE_AVX_SUPPORT) || defined(ENABLE_AVX2_SUPPORT) \
+    || defined(ENABLE_AVX512_SUPPORT)
 static unsigned int
 get_xgetbv(void)
 {
@@ -110,7 +111,7 @@ get_xgetbv(void)
 
   return t_eax;
 }
-#endif /* ENABLE_AVX_SUPPORT || ENABLE_AVX2_SUPPORT */
+#endif /* ENABLE_AVX_SUPPORT || ENABLE_AVX2_SUPPORT || ENABLE_AVX512_SUPPORT */
 
 #endif /* i386 && GNUC */
 
@@ -147,7 +148,8 @@ get_cpuid(unsigned int in, unsigned int *eax, unsigned int *ebx,
     *edx = regs[3];
 }
 
-#if defined(ENABLE_AVX_SUPPORT) || defined(ENABLE_AVX2_SUPPORT)
+#if defined(ENABLE_AVX_SUPPORT) || defined(ENABLE_AVX2_SUPPORT) \
+    || defined(ENABLE_AVX512_SUPPORT)
 static unsigned int
 get_xgetbv(void)
 {
@@ -161,7 +163,7 @@ get_xgetbv(void)
 
   return t_eax;
 }
-#endif /* ENABLE_AVX_SUPPORT || ENABLE_AVX2_SUPPORT */
+#endif /* ENABLE_AVX_SUPPORT || ENABLE_AVX2_SUPPORT || ENABLE_AVX512_SUPPORT */
 
 #endif /* x86-64 && GNUC */
 
@@ -177,12 +179,14 @@ detect_x86_gnuc (void)
   } vendor_id;
   unsigned int features, features2;
   unsigned int os_supports_avx_avx2_registers = 0;
+  unsigned int os_supports_avx512_registers = 0;
   unsigned int max_cpuid_level;
   unsigned int fms, family, model;
   unsigned int result = 0;
   unsigned int avoid_vpgather = 0;
 
   (void)os_supports_avx_avx2_registers;
+  (void)os_supports_avx512_registers;
 
   if (!is_cpuid_available())
     return 0;
@@ -310,13 +314,21 @@ detect_x86_gnuc (void)
   if (features & 0x02000000)
      result |= HWF_INTEL_AESNI;
 #endif /*ENABLE_AESNI_SUPPORT*/
-#if defined(ENABLE_AVX_SUPPORT) || defined(ENABLE_AVX2_SUPPORT)
-  /* Test bit 27 for OSXSAVE (required for AVX/AVX2).  */
+#if defined(ENABLE_AVX_SUPPORT) || defined(ENABLE_AVX2_SUPPORT) \
+    || defined(ENABLE_AVX512_SUPPORT)
+  /* Test bit 27 for OSXSAVE (required for AVX/AVX2/AVX512).  */
   if (features & 0x08000000)
     {
+      unsigned int xcr0 = get_xgetbv();
+
       /* Check that OS has enabled both XMM and YMM state support.  */
-      if ((get_xgetbv() & 0x6) == 0x6)
+      if ((xcr0 & 0x6) == 0x6)
         os_supports_avx_avx2_registers = 1;
+
+      /* Check that OS has enabled also the opmask, upper ZMM0-15 and
+       * ZMM16-31 state support.  */
+      if ((xcr0 & 0xe6) == 0xe6)
+        os_supports_avx512_registers = 1;
     }
 #endif
 #ifdef ENABLE_AVX_SUPPORT
@@ -342,12 +354,16 @@ detect_x86_gnuc (void)
   if (max_cpuid_level >= 7 && (features & 0x00000001))
     {
       /* Get CPUID:7 contains further Intel feature flags. */
-      get_cpuid(7, NULL, &features, NULL, NULL);
+      get_cpuid(7, NULL, &features, &features2, NULL);
 
       /* Test bit 8 for BMI2.  */
       if (features & 0x00000100)
           result |= HWF_INTEL_BMI2;
 
+      /* Test bit 19 for ADX.  */
+      if (features & 0x00080000)
+          result |= HWF_INTEL_ADX;
+
 #ifdef ENABLE_AVX2_SUPPORT
       /* Test bit 5 for AVX2.  */
       if (features & 0x00000020)
@@ -357,6 +373,28 @@ detect_x86_gnuc (void)
       if ((result & HWF_INTEL_AVX2) && !avoid_vpgather)
         result |= HWF_INTEL_FAST_VPGATHER;
 #endif /*ENABLE_AVX_SUPPORT*/
+
+#ifdef ENABLE_AVX512_SUPPORT
+      /* Test bits 16 (AVX512F), 17 (AVX512DQ), 30 (AVX512BW) and 31
+       * (AVX512VL) for AVX512.  */
+      if ((features & 0xc0030000) == 0xc0030000)
+        if (os_supports_avx512_registers)
+          result |= HWF_INTEL_AVX512;
+
+      /* Test bit 21 for AVX512 IFMA.  */
+      if ((result & HWF_INTEL_AVX512) && (features & 0x00200000))
+        result |= HWF_INTEL_AVX512_IFMA;
+#endif /*ENABLE_AVX512_SUPPORT*/
+
+      /* Test bits 9 and 10 of ECX for VAES and VPCLMULQDQ.  */
+      if ((result & HWF_INTEL_AVX2) && (features2 & 0x00000600) == 0x00000600)
+        result |= HWF_INTEL_VAES_VPCLMUL;
+
+#if defined(ENABLE_SHAEXT_SUPPORT)
+      /* Test bit 29 for SHA Extensions. */
+      if (features & (1 << 29))
+        result |= HWF_INTEL_SHAEXT;
+#endif
     }
 
   return result;
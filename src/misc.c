@@ -25,6 +25,9 @@
 #include <string.h>
 #include <stdarg.h>
 #include <unistd.h>
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
 
 #include "g10lib.h"
 #include "secmem.h"
@@ -529,3 +532,82 @@ _gcry_divide_by_zero (void)
     gpg_err_set_errno (EDOM);
     _gcry_fatal_error (gpg_err_code_from_errno (errno), "divide by zero");
 }
+
+
+/* Return the number of online processors or 1 if that is not
+   known.  */
+unsigned int
+_gcry_get_ncpus (void)
+{
+#if defined(HAVE_SYSCONF) && defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+
+  if (n > 0)
+    return n;
+#endif
+  return 1;
+}
+
+
+#ifdef HAVE_PTHREAD
+struct worker_s
+{
+  void (*func) (void *arg, unsigned int idx);
+  void *arg;
+  unsigned int idx;
+  int started;
+  pthread_t thread;
+};
+
+static void *
+worker_thread (void *opaque)
+{
+  struct worker_s *w = opaque;
+
+  w->func (w->arg, w->idx);
+  return NULL;
+}
+#endif /*HAVE_PTHREAD*/
+
+
+/* Call FUNC (ARG, IDX) for IDX from 0 to N-1 and return when all
+   calls have returned.  The calls are run on separate threads, with
+   the call for IDX 0 done by the calling thread.  If threads are not
+   supported or can't be created, the remaining calls are made one
+   after the other by the calling thread.  */
+void
+_gcry_run_workers (unsigned int n,
+                   void (*func) (void *arg, unsigned int idx), void *arg)
+{
+  unsigned int idx;
+#ifdef HAVE_PTHREAD
+  struct worker_s *workers;
+
+  workers = n > 1? xtrycalloc (n, sizeof *workers) : NULL;
+  if (workers)
+    {
+      for (idx = 1; idx < n; idx++)
+        {
+          workers[idx].func = func;
+          workers[idx].arg = arg;
+          workers[idx].idx = idx;
+          workers[idx].started = !pthread_create (&workers[idx].thread,
+                                                  NULL, worker_thread,
+                                                  &workers[idx]);
+        }
+
+      func (arg, 0);
+
+      for (idx = 1; idx < n; idx++)
+        if (workers[idx].started)
+          pthread_join (workers[idx].thread, NULL);
+        else
+          func (arg, idx);
+      xfree (workers);
+      return;
+    }
+#endif /*HAVE_PTHREAD*/
+
+  for (idx = 0; idx < n; idx++)
+    func (arg, idx);
+}
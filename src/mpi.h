@@ -295,6 +295,13 @@ void _gcry_mpi_ec_sub_points (mpi_point_t result,
 void _gcry_mpi_ec_mul_point (mpi_point_t result,
                              gcry_mpi_t scalar, mpi_point_t point,
                              mpi_ec_t ctx);
+void _gcry_mpi_ec_mul_point2 (mpi_point_t result,
+                              gcry_mpi_t scalar1, mpi_point_t point1,
+                              gcry_mpi_t scalar2, mpi_point_t point2,
+                              mpi_ec_t ctx);
+void _gcry_mpi_ec_mul_points (mpi_point_t result, unsigned int n,
+                              gcry_mpi_t *scalars, mpi_point_t *points,
+                              mpi_ec_t ctx);
 int  _gcry_mpi_ec_curve_point (gcry_mpi_point_t point, mpi_ec_t ctx);
 int _gcry_mpi_ec_bad_point (gcry_mpi_point_t point, mpi_ec_t ctx);
 
@@ -597,6 +597,14 @@ gcry_mpi_ec_mul (gcry_mpi_point_t w, gcry_mpi_t n, gcry_mpi_point_t u,
                           _gcry_ctx_get_pointer (ctx, CONTEXT_TYPE_EC));
 }
 
+void
+gcry_mpi_ec_mul2 (gcry_mpi_point_t w, gcry_mpi_t n1, gcry_mpi_point_t u1,
+                  gcry_mpi_t n2, gcry_mpi_point_t u2, gcry_ctx_t ctx)
+{
+  _gcry_mpi_ec_mul_point2 (w, n1, u1, n2, u2,
+                           _gcry_ctx_get_pointer (ctx, CONTEXT_TYPE_EC));
+}
+
 int
 gcry_mpi_ec_curve_point (gcry_mpi_point_t point, gcry_ctx_t ctx)
 {
@@ -1010,6 +1018,56 @@ gcry_pk_verify (gcry_sexp_t sigval, gcry_sexp_t data, gcry_sexp_t pkey)
   return gpg_error (_gcry_pk_verify (sigval, data, pkey));
 }
 
+gcry_error_t
+gcry_pk_verify_batch (gcry_sexp_t *sigvals, gcry_sexp_t *data,
+                      gcry_sexp_t *pkeys, size_t n, gcry_error_t *r_errs)
+{
+  size_t i;
+
+  if (!fips_is_operational ())
+    {
+      if (r_errs)
+        for (i = 0; i < n; i++)
+          r_errs[i] = gpg_error (fips_not_operational ());
+      return gpg_error (fips_not_operational ());
+    }
+  return gpg_error (_gcry_pk_verify_batch (sigvals, data, pkeys, n, r_errs));
+}
+
+gcry_error_t
+gcry_pk_prepare_key (gcry_ctx_t *r_ctx, gcry_sexp_t skey)
+{
+  if (!fips_is_operational ())
+    {
+      *r_ctx = NULL;
+      return gpg_error (fips_not_operational ());
+    }
+  return gpg_error (_gcry_pk_prepare_key (r_ctx, skey));
+}
+
+gcry_error_t
+gcry_pk_decrypt_prepared (gcry_sexp_t *result, gcry_sexp_t data,
+                          gcry_ctx_t ctx)
+{
+  if (!fips_is_operational ())
+    {
+      *result = NULL;
+      return gpg_error (fips_not_operational ());
+    }
+  return gpg_error (_gcry_pk_decrypt_prepared (result, data, ctx));
+}
+
+gcry_error_t
+gcry_pk_sign_prepared (gcry_sexp_t *result, gcry_sexp_t data, gcry_ctx_t ctx)
+{
+  if (!fips_is_operational ())
+    {
+      *result = NULL;
+      return gpg_error (fips_not_operational ());
+    }
+  return gpg_error (_gcry_pk_sign_prepared (result, data, ctx));
+}
+
 gcry_error_t
 gcry_pk_testkey (gcry_sexp_t key)
 {
@@ -1210,6 +1268,34 @@ gcry_md_hash_buffers (int algo, unsigned int flags, void *digest,
   return gpg_error (_gcry_md_hash_buffers (algo, flags, digest, iov, iovcnt));
 }
 
+gpg_error_t
+gcry_md_hash_buffers_multi (int algo, unsigned int flags, void *digests,
+                            const gcry_buffer_t *iov, int nmsgs)
+{
+  if (!fips_is_operational ())
+    {
+      (void)fips_not_operational ();
+      fips_signal_error ("called in non-operational state");
+    }
+  return gpg_error (_gcry_md_hash_buffers_multi (algo, flags, digests,
+                                                 iov, nmsgs));
+}
+
+gpg_error_t
+gcry_md_hash_buffers_extract_multi (int algo, unsigned int flags,
+                                    void *outputs, size_t outlen,
+                                    const gcry_buffer_t *iov, int nmsgs)
+{
+  if (!fips_is_operational ())
+    {
+      (void)fips_not_operational ();
+      fips_signal_error ("called in non-operational state");
+    }
+  return gpg_error (_gcry_md_hash_buffers_extract_multi (algo, flags,
+                                                         outputs, outlen,
+                                                         iov, nmsgs));
+}
+
 int
 gcry_md_get_algo (gcry_md_hd_t hd)
 {
@@ -1299,6 +1385,25 @@ gcry_kdf_derive (const void *passphrase, size_t passphraselen,
                                       keysize, keybuffer));
 }
 
+gpg_error_t
+gcry_kdf_prepare (gcry_ctx_t *r_ctx, int algo, int subalgo,
+                  unsigned long iterations, unsigned int flags)
+{
+  return gpg_error (_gcry_kdf_prepare (r_ctx, algo, subalgo, iterations,
+                                       flags));
+}
+
+gpg_error_t
+gcry_kdf_derive_prepared (gcry_ctx_t ctx,
+                          const void *passphrase, size_t passphraselen,
+                          const void *salt, size_t saltlen,
+                          size_t keysize, void *keybuffer)
+{
+  return gpg_error (_gcry_kdf_derive_prepared (ctx, passphrase, passphraselen,
+                                               salt, saltlen,
+                                               keysize, keybuffer));
+}
+
 void
 gcry_randomize (void *buffer, size_t length, enum gcry_random_level level)
 {
@@ -104,6 +104,8 @@ MARK_VISIBLEX (gcry_md_get_algo)
 MARK_VISIBLEX (gcry_md_get_algo_dlen)
 MARK_VISIBLEX (gcry_md_hash_buffer)
 MARK_VISIBLEX (gcry_md_hash_buffers)
+MARK_VISIBLEX (gcry_md_hash_buffers_multi)
+MARK_VISIBLEX (gcry_md_hash_buffers_extract_multi)
 MARK_VISIBLEX (gcry_md_info)
 MARK_VISIBLEX (gcry_md_is_enabled)
 MARK_VISIBLEX (gcry_md_is_secure)
@@ -164,9 +166,15 @@ MARK_VISIBLEX (gcry_pk_map_name)
 MARK_VISIBLEX (gcry_pk_sign)
 MARK_VISIBLEX (gcry_pk_testkey)
 MARK_VISIBLEX (gcry_pk_verify)
+MARK_VISIBLEX (gcry_pk_verify_batch)
+MARK_VISIBLEX (gcry_pk_prepare_key)
+MARK_VISIBLEX (gcry_pk_decrypt_prepared)
+MARK_VISIBLEX (gcry_pk_sign_prepared)
 MARK_VISIBLEX (gcry_pubkey_get_sexp)
 
 MARK_VISIBLEX (gcry_kdf_derive)
+MARK_VISIBLEX (gcry_kdf_prepare)
+MARK_VISIBLEX (gcry_kdf_derive_prepared)
 
 MARK_VISIBLEX (gcry_prime_check)
 MARK_VISIBLEX (gcry_prime_generate)
@@ -225,6 +233,7 @@ MARK_VISIBLEX (gcry_mpi_ec_dup)
 MARK_VISIBLEX (gcry_mpi_ec_decode_point)
 MARK_VISIBLEX (gcry_mpi_ec_get_affine)
 MARK_VISIBLEX (gcry_mpi_ec_mul)
+MARK_VISIBLEX (gcry_mpi_ec_mul2)
 MARK_VISIBLEX (gcry_mpi_ec_new)
 MARK_VISIBLEX (gcry_mpi_ec_get_mpi)
 MARK_VISIBLEX (gcry_mpi_ec_get_point)
@@ -360,6 +369,10 @@ MARK_VISIBLEX (_gcry_mpi_get_const)
 #define gcry_pk_sign                _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_pk_testkey             _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_pk_verify              _gcry_USE_THE_UNDERSCORED_FUNCTION
+#define gcry_pk_verify_batch        _gcry_USE_THE_UNDERSCORED_FUNCTION
+#define gcry_pk_prepare_key         _gcry_USE_THE_UNDERSCORED_FUNCTION
+#define gcry_pk_decrypt_prepared    _gcry_USE_THE_UNDERSCORED_FUNCTION
+#define gcry_pk_sign_prepared       _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_pubkey_get_sexp        _gcry_USE_THE_UNDERSCORED_FUNCTION
 
 #define gcry_md_algo_info           _gcry_USE_THE_UNDERSCORED_FUNCTION
@@ -373,6 +386,8 @@ MARK_VISIBLEX (_gcry_mpi_get_const)
 #define gcry_md_get_algo_dlen       _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_md_hash_buffer         _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_md_hash_buffers        _gcry_USE_THE_UNDERSCORED_FUNCTION
+#define gcry_md_hash_buffers_multi  _gcry_USE_THE_UNDERSCORED_FUNCTION
+#define gcry_md_hash_buffers_extract_multi _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_md_info                _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_md_is_enabled          _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_md_is_secure           _gcry_USE_THE_UNDERSCORED_FUNCTION
@@ -401,6 +416,8 @@ MARK_VISIBLEX (_gcry_mpi_get_const)
 #define gcry_mac_ctl                _gcry_USE_THE_UNDERSCORED_FUNCTION
 
 #define gcry_kdf_derive             _gcry_USE_THE_UNDERSCORED_FUNCTION
+#define gcry_kdf_prepare            _gcry_USE_THE_UNDERSCORED_FUNCTION
+#define gcry_kdf_derive_prepared    _gcry_USE_THE_UNDERSCORED_FUNCTION
 
 #define gcry_prime_check            _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_prime_generate         _gcry_USE_THE_UNDERSCORED_FUNCTION
@@ -502,6 +519,7 @@ MARK_VISIBLEX (_gcry_mpi_get_const)
 #define gcry_mpi_ec_get_mpi         _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_mpi_ec_get_point       _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_mpi_ec_mul             _gcry_USE_THE_UNDERSCORED_FUNCTION
+#define gcry_mpi_ec_mul2            _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_mpi_ec_new             _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_mpi_ec_set_mpi         _gcry_USE_THE_UNDERSCORED_FUNCTION
 #define gcry_mpi_ec_set_point       _gcry_USE_THE_UNDERSCORED_FUNCTION
@@ -8451,6 +8451,42 @@ check_digests (void)
 	"\x0e\xfc\x29\xde" },
       { GCRY_MD_BLAKE2S_128, "?",
 	"\x70\x0b\x8a\x71\x1d\x34\x0a\xf0\x13\x93\x19\x93\x5e\xd7\x54\x9c" },
+      { GCRY_MD_BLAKE2BP_512, "abc",
+	"\xb9\x1a\x6b\x66\xae\x87\x52\x6c\x40\x0b\x0a\x8b\x53\x77\x4d\xc6"
+	"\x52\x84\xad\x8f\x65\x75\xf8\x14\x8f\xf9\x3d\xff\x94\x3a\x6e\xcd"
+	"\x83\x62\x13\x0f\x22\xd6\xda\xe6\x33\xaa\x0f\x91\xdf\x4a\xc8\x9a"
+	"\xaf\xf3\x1d\x0f\x1b\x92\x3c\x89\x8e\x82\x02\x5d\xed\xbd\xad\x6e" },
+      { GCRY_MD_BLAKE2BP_512,
+	"",
+	"\x9d\x94\x61\x07\x3e\x4e\xb6\x40\xa2\x55\x35\x7b\x83\x9f\x39\x4b"
+	"\x83\x8c\x6f\xf5\x7c\x9b\x68\x6a\x3f\x76\x10\x7c\x10\x66\x72\x8f"
+	"\x3c\x99\x56\xbd\x78\x5c\xbc\x3b\xf7\x9d\xc2\xab\x57\x8c\x5a\x0c"
+	"\x06\x3b\x9d\x9c\x40\x58\x48\xde\x1d\xbe\x82\x1c\xd0\x5c\x94\x0a",
+	0, 64,
+	"\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+	"\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+	"\x20\x21\x22\x23\x24\x25\x26\x27\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f"
+	"\x30\x31\x32\x33\x34\x35\x36\x37\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f",
+	64 },
+      { GCRY_MD_BLAKE2BP_512, "?",
+	"\xb6\x30\x85\x3b\x1d\x8c\x71\x2b\x59\xf5\x1a\xb3\xb9\x99\xdc\xb1"
+	"\xc2\xa0\x03\x57\x07\x25\x0c\xf8\x91\xa0\x14\x3a\x00\xb7\x32\x20"
+	"\xad\xaa\x78\xfb\x43\x23\xe3\xd5\xba\x89\x6e\x28\x57\xec\xc1\x32"
+	"\x65\x10\x67\x51\x96\xbc\xef\xf5\x14\x97\x54\x11\x74\xd8\x1a\xfd" },
+      { GCRY_MD_BLAKE2SP_256, "abc",
+	"\x70\xf7\x5b\x58\xf1\xfe\xca\xb8\x21\xdb\x43\xc8\x8a\xd8\x4e\xdd"
+	"\xe5\xa5\x26\x00\x61\x6c\xd2\x25\x17\xb7\xbb\x14\xd4\x40\xa7\xd5" },
+      { GCRY_MD_BLAKE2SP_256,
+	"",
+	"\x71\x5c\xb1\x38\x95\xae\xb6\x78\xf6\x12\x41\x60\xbf\xf2\x14\x65"
+	"\xb3\x0f\x4f\x68\x74\x19\x3f\xc8\x51\xb4\x62\x10\x43\xf0\x9c\xc6",
+	0, 32,
+	"\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+	"\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f",
+	32 },
+      { GCRY_MD_BLAKE2SP_256, "?",
+	"\x41\x3c\x45\x84\xd5\xae\xbd\x7e\x9a\xfd\x5d\x1b\x0b\x9b\x1a\xd2"
+	"\xe1\x28\x1b\xae\x97\x28\x0f\x20\xe2\x64\xf7\x08\x76\x29\x3d\x5f" },
       { 0 }
     };
   gcry_error_t err;
@@ -8551,6 +8587,156 @@ check_digests (void)
     fprintf (stderr, "Completed hash checks.\n");
 }
 
+
+/* Compare gcry_md_hash_buffers_multi against gcry_md_hash_buffer using
+   batches of messages with different lengths.  */
+static void
+check_md_hash_buffers_multi (void)
+{
+  static const int algos[] =
+    { GCRY_MD_SHA1, GCRY_MD_SHA224, GCRY_MD_SHA256, GCRY_MD_SHA512,
+      GCRY_MD_SHA3_256, GCRY_MD_SHA3_512, 0 };
+  gcry_buffer_t iov[17];
+  unsigned char data[17 * 300];
+  unsigned char digests[17 * 64];
+  unsigned char expect[64];
+  gpg_error_t err;
+  int i, j, nmsgs, mdlen;
+
+  if (verbose)
+    fprintf (stderr, "Starting multi-buffer hash checks.\n");
+
+  for (i = 0; i < sizeof data; i++)
+    data[i] = i * 7 + (i >> 8);
+
+  for (i = 0; algos[i]; i++)
+    {
+      if (gcry_md_test_algo (algos[i]))
+        continue;
+
+      mdlen = gcry_md_get_algo_dlen (algos[i]);
+
+      for (nmsgs = 0; nmsgs <= DIM (iov); nmsgs++)
+        {
+          memset (iov, 0, sizeof iov);
+          for (j = 0; j < nmsgs; j++)
+            {
+              iov[j].data = data;
+              iov[j].off = j * 300;
+              iov[j].len = (j * 53 + nmsgs * 11) % 300;
+            }
+
+          err = gcry_md_hash_buffers_multi (algos[i], 0, digests, iov, nmsgs);
+          if (err)
+            {
+              fail ("algo %d, gcry_md_hash_buffers_multi failed: %s\n",
+                    algos[i], gpg_strerror (err));
+              continue;
+            }
+
+          for (j = 0; j < nmsgs; j++)
+            {
+              gcry_md_hash_buffer (algos[i], expect, data + iov[j].off,
+                                   iov[j].len);
+              if (memcmp (digests + j * mdlen, expect, mdlen))
+                fail ("algo %d, gcry_md_hash_buffers_multi mismatch "
+                      "(msg %d of %d)\n", algos[i], j, nmsgs);
+            }
+        }
+    }
+
+  err = gcry_md_hash_buffers_multi (GCRY_MD_SHA256, 1, digests, iov, 1);
+  if (gpg_err_code (err) != GPG_ERR_INV_ARG)
+    fail ("gcry_md_hash_buffers_multi did not reject invalid flags\n");
+
+  if (verbose)
+    fprintf (stderr, "Completed multi-buffer hash checks.\n");
+}
+
+
+/* Compare gcry_md_hash_buffers_extract_multi against gcry_md_extract
+   using batches of messages and output lengths spanning several
+   blocks.  */
+static void
+check_md_hash_buffers_extract_multi (void)
+{
+  static const int algos[] = { GCRY_MD_SHAKE128, GCRY_MD_SHAKE256, 0 };
+  static const size_t outlens[] = { 1, 32, 169, 400 };
+  gcry_buffer_t iov[9];
+  unsigned char data[9 * 500];
+  unsigned char outputs[9 * 400];
+  unsigned char expect[400];
+  gcry_md_hd_t hd;
+  gpg_error_t err;
+  int i, j, k, nmsgs;
+  size_t outlen;
+
+  if (verbose)
+    fprintf (stderr, "Starting multi-buffer XOF checks.\n");
+
+  for (i = 0; i < sizeof data; i++)
+    data[i] = i * 13 + (i >> 8);
+
+  for (i = 0; algos[i]; i++)
+    {
+      if (gcry_md_test_algo (algos[i]))
+        continue;
+
+      for (k = 0; k < DIM (outlens); k++)
+        for (nmsgs = 0; nmsgs <= DIM (iov); nmsgs++)
+          {
+            outlen = outlens[k];
+
+            memset (iov, 0, sizeof iov);
+            for (j = 0; j < nmsgs; j++)
+              {
+                iov[j].data = data;
+                iov[j].off = j * 500;
+                iov[j].len = (j * 131 + nmsgs * 29 + k * 7) % 500;
+              }
+
+            err = gcry_md_hash_buffers_extract_multi (algos[i], 0, outputs,
+                                                      outlen, iov, nmsgs);
+            if (err)
+              {
+                fail ("algo %d, gcry_md_hash_buffers_extract_multi failed: "
+                      "%s\n", algos[i], gpg_strerror (err));
+                continue;
+              }
+
+            for (j = 0; j < nmsgs; j++)
+              {
+                err = gcry_md_open (&hd, algos[i], 0);
+                if (err)
+                  {
+                    fail ("algo %d, gcry_md_open failed: %s\n", algos[i],
+                          gpg_strerror (err));
+                    return;
+                  }
+                gcry_md_write (hd, data + iov[j].off, iov[j].len);
+                err = gcry_md_extract (hd, algos[i], expect, outlen);
+                gcry_md_close (hd);
+                if (err)
+                  fail ("algo %d, gcry_md_extract failed: %s\n", algos[i],
+                        gpg_strerror (err));
+                else if (memcmp (outputs + j * outlen, expect, outlen))
+                  fail ("algo %d, gcry_md_hash_buffers_extract_multi mismatch "
+                        "(msg %d of %d, %d bytes)\n", algos[i], j, nmsgs,
+                        (int)outlen);
+              }
+          }
+    }
+
+  err = gcry_md_hash_buffers_extract_multi (GCRY_MD_SHA256, 0, outputs, 32,
+                                            iov, 1);
+  if (gpg_err_code (err) != GPG_ERR_DIGEST_ALGO)
+    fail ("gcry_md_hash_buffers_extract_multi did not reject "
+          "non-XOF algorithm\n");
+
+  if (verbose)
+    fprintf (stderr, "Completed multi-buffer XOF checks.\n");
+}
+
 static void
 check_one_hmac (int algo, const char *data, int datalen,
 		const char *key, int keylen, const char *expect)
@@ -11076,6 +11262,8 @@ main (int argc, char **argv)
           check_cipher_modes ();
           check_bulk_cipher_modes ();
           check_digests ();
+          check_md_hash_buffers_multi ();
+          check_md_hash_buffers_extract_multi ();
           check_hmac ();
           check_mac ();
           check_pubkey ();
@@ -41,13 +41,35 @@ else
 	fi
 fi
 
+# Use HWFEATURES to limit the combinations to the listed HW features,
+#  for example: HWFEATURES="intel-shaext intel-avx2 intel-ssse3"
+if [ "x$HWFEATURES" != "x" ]; then
+	hwfeatures="$HWFEATURES"
+else
+	hwfeatures=""
+fi
+
 get_supported_hwfeatures() {
 	$binpre "tests/version$binext" 2>&1 | \
 		grep "hwflist" | \
 		sed -e 's/hwflist://' -e 's/:/ /g' -e 's/\x0d/\x0a/g'
 }
 
-hwfs=($(get_supported_hwfeatures))
+filter_hwfeatures() {
+	for hwf in $(get_supported_hwfeatures); do
+		if [ "x$hwfeatures" = "x" ]; then
+			echo "$hwf"
+			continue
+		fi
+		for want in $hwfeatures; do
+			if [ "x$want" = "x$hwf" ]; then
+				echo "$hwf"
+			fi
+		done
+	done
+}
+
+hwfs=($(filter_hwfeatures))
 retcodes=()
 optslist=()
 echo "Total HW-feature combinations: $((1<<${#hwfs[@]}))"
@@ -1576,6 +1576,217 @@ hash_bench (char **argv, int argc)
 }
 
 
+/************************************************** Multi-buffer hash benchmarks. */
+
+/* Size of each message hashed by gcry_md_hash_buffers_multi.  */
+#define HASH_MULTI_MSG_SIZE		1024
+
+/* Upper limit for the number of messages hashed per call.  */
+#define HASH_MULTI_MAX_MSGS		16
+
+/* Output length used for extendable-output functions.  */
+#define HASH_MULTI_XOF_OUTLEN		32
+
+struct bench_hash_multi_mode
+{
+  struct bench_ops *ops;
+
+  int algo;
+  int nmsgs;
+  size_t outlen;
+  unsigned char *data;
+  unsigned char *digests;
+  gcry_buffer_t iov[HASH_MULTI_MAX_MSGS];
+};
+
+
+static int
+bench_hash_multi_init (struct bench_obj *obj)
+{
+  struct bench_hash_multi_mode *mode = obj->priv;
+  size_t datalen = HASH_MULTI_MSG_SIZE * mode->nmsgs;
+  int i;
+
+  /* The X axis is the number of hashed messages.  */
+  obj->min_bufsize = mode->nmsgs;
+  obj->max_bufsize = mode->nmsgs * 16;
+  obj->step_size = mode->nmsgs;
+  obj->num_measure_repetitions = num_measurement_repetitions;
+
+  /* XOF algorithms have no fixed digest length.  */
+  mode->outlen = gcry_md_get_algo_dlen (mode->algo);
+  if (!mode->outlen)
+    mode->outlen = HASH_MULTI_XOF_OUTLEN;
+
+  mode->data = malloc (datalen);
+  mode->digests = malloc (mode->outlen * mode->nmsgs);
+  if (!mode->data || !mode->digests)
+    {
+      fprintf (stderr, PGM ": out of core\n");
+      exit (1);
+    }
+
+  for (i = 0; i < datalen; i++)
+    mode->data[i] = 0x55 ^ (-i);
+
+  memset (mode->iov, 0, sizeof (mode->iov));
+  for (i = 0; i < mode->nmsgs; i++)
+    {
+      mode->iov[i].data = mode->data + i * HASH_MULTI_MSG_SIZE;
+      mode->iov[i].len = HASH_MULTI_MSG_SIZE;
+    }
+
+  return 0;
+}
+
+static void
+bench_hash_multi_free (struct bench_obj *obj)
+{
+  struct bench_hash_multi_mode *mode = obj->priv;
+
+  free (mode->data);
+  free (mode->digests);
+  mode->data = NULL;
+  mode->digests = NULL;
+}
+
+static void
+bench_hash_multi_do_bench (struct bench_obj *obj, void *buf, size_t buflen)
+{
+  struct bench_hash_multi_mode *mode = obj->priv;
+  gcry_error_t err;
+  size_t i;
+
+  (void)buf;
+
+  for (i = 0; i < buflen; i += mode->nmsgs)
+    {
+      if (gcry_md_get_algo_dlen (mode->algo))
+        err = gcry_md_hash_buffers_multi (mode->algo, 0, mode->digests,
+                                          mode->iov, mode->nmsgs);
+      else
+        err = gcry_md_hash_buffers_extract_multi (mode->algo, 0,
+                                                  mode->digests,
+                                                  mode->outlen,
+                                                  mode->iov, mode->nmsgs);
+      if (err)
+        {
+          fprintf (stderr, PGM ": hashing messages failed: %s\n",
+                   gpg_strerror (err));
+          exit (1);
+        }
+    }
+}
+
+static struct bench_ops hash_multi_ops = {
+  &bench_hash_multi_init,
+  &bench_hash_multi_free,
+  &bench_hash_multi_do_bench
+};
+
+
+static void
+hash_multi_bench_one (int algo, int nmsgs)
+{
+  struct bench_hash_multi_mode mode = { &hash_multi_ops };
+  struct bench_obj obj = { 0 };
+  double nsecs_per_hash;
+  double cycles_per_hash;
+  double hashes_per_sec;
+  char lanes_name[16];
+  char nsecphash_buf[16];
+  char hpsec_buf[16];
+  char cphash_buf[16];
+
+  mode.algo = algo;
+  mode.nmsgs = nmsgs;
+
+  snprintf (lanes_name, sizeof (lanes_name), "%d", nmsgs);
+  bench_print_algo (-14, gcry_md_algo_name (algo));
+  bench_print_mode (5, lanes_name);
+
+  obj.ops = mode.ops;
+  obj.priv = &mode;
+
+  nsecs_per_hash = do_slope_benchmark (&obj);
+
+  strcpy (cphash_buf, csv_mode ? "" : "-");
+
+  double_to_str (nsecphash_buf, sizeof (nsecphash_buf), nsecs_per_hash);
+
+  hashes_per_sec = (1000.0 * 1000.0 * 1000.0) / nsecs_per_hash;
+  double_to_str (hpsec_buf, sizeof (hpsec_buf), hashes_per_sec);
+
+  /* If user didn't provide CPU speed, we cannot show cycles/hash results.  */
+  if (cpu_ghz > 0.0)
+    {
+      cycles_per_hash = nsecs_per_hash * cpu_ghz;
+      double_to_str (cphash_buf, sizeof (cphash_buf), cycles_per_hash);
+    }
+
+  if (csv_mode)
+    {
+      printf ("%s,%s,%s,,,%s,ns/hash,%s,hash/s,%s,c/hash\n",
+	      current_section_name,
+	      current_algo_name ? current_algo_name : "",
+	      current_mode_name ? current_mode_name : "",
+	      nsecphash_buf,
+	      hpsec_buf,
+	      cphash_buf);
+    }
+  else
+    {
+      printf ("%14s %13s %13s\n", nsecphash_buf, hpsec_buf, cphash_buf);
+    }
+}
+
+static void
+_hash_multi_bench (int algo)
+{
+  int nmsgs;
+
+  for (nmsgs = 1; nmsgs <= HASH_MULTI_MAX_MSGS; nmsgs *= 2)
+    hash_multi_bench_one (algo, nmsgs);
+}
+
+void
+hash_multi_bench (char **argv, int argc)
+{
+  static const int default_algos[] =
+    { GCRY_MD_SHA1, GCRY_MD_SHA224, GCRY_MD_SHA256, GCRY_MD_SHA3_256,
+      GCRY_MD_SHAKE128, GCRY_MD_SHAKE256, 0 };
+  int i, algo;
+
+  bench_print_section ("hash-multi", "Hash (" STR2(HASH_MULTI_MSG_SIZE)
+                       " byte messages)");
+
+  if (!csv_mode)
+    {
+      printf (" %-*s |  %5s | ", 14, "", "msgs");
+      printf ("%14s %13s %13s\n", "nanosecs/hash", "hashes/sec",
+              "cycles/hash");
+    }
+
+  if (argv && argc)
+    {
+      for (i = 0; i < argc; i++)
+	{
+	  algo = gcry_md_map_name (argv[i]);
+	  if (algo)
+	    _hash_multi_bench (algo);
+	}
+    }
+  else
+    {
+      for (i = 0; default_algos[i]; i++)
+	if (!gcry_md_test_algo (default_algos[i]))
+	  _hash_multi_bench (default_algos[i]);
+    }
+
+  bench_print_footer (14);
+}
+
+
 /************************************************************ MAC benchmarks. */
 
 struct bench_mac_mode
@@ -1917,7 +2128,8 @@ void
 print_help (void)
 {
   static const char *help_lines[] = {
-    "usage: bench-slope [options] [hash|mac|cipher|kdf [algonames]]",
+    "usage: bench-slope [options] [hash|hash-multi|mac|cipher|kdf "
+    "[algonames]]",
     "",
     " options:",
     "   --cpu-mhz <mhz>           Set CPU speed for calculating cycles",
@@ -2088,6 +2300,7 @@ main (int argc, char **argv)
     {
       warm_up_cpu ();
       hash_bench (NULL, 0);
+      hash_multi_bench (NULL, 0);
       mac_bench (NULL, 0);
       cipher_bench (NULL, 0);
       kdf_bench (NULL, 0);
@@ -2100,6 +2313,14 @@ main (int argc, char **argv)
       warm_up_cpu ();
       hash_bench ((argc == 0) ? NULL : argv, argc);
     }
+  else if (!strcmp (*argv, "hash-multi"))
+    {
+      argc--;
+      argv++;
+
+      warm_up_cpu ();
+      hash_multi_bench ((argc == 0) ? NULL : argv, argc);
+    }
   else if (!strcmp (*argv, "mac"))
     {
       argc--;
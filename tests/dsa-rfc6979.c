@@ -979,5 +979,9 @@ main (int argc, char **argv)
 
   check_dsa_rfc6979 ();
 
+  /* Run the tests again using the ECC context cache.  */
+  xgcry_control (GCRYCTL_ENABLE_ECC_CACHE, 0);
+  check_dsa_rfc6979 ();
+
   return error_count ? 1 : 0;
 }
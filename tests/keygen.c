@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <time.h>
 #include "../src/gcrypt-int.h"
 
 
@@ -198,6 +199,25 @@ check_rsa_keys (void)
     check_generated_rsa_key (key, 65539);
   gcry_sexp_release (key);
 
+  if (verbose)
+    info ("creating 2048 bit RSA key using several threads\n");
+  rc = gcry_sexp_new (&keyparm,
+                      "(genkey\n"
+                      " (rsa\n"
+                      "  (nbits 4:2048)\n"
+                      "  (flags parallel)\n"
+                      " ))", 0, 1);
+  if (rc)
+    die ("error creating S-expression: %s\n", gpg_strerror (rc));
+  rc = gcry_pk_genkey (&key, keyparm);
+  gcry_sexp_release (keyparm);
+  if (rc)
+    fail ("error generating RSA key: %s\n", gpg_strerror (rc));
+
+  if (!rc)
+    check_generated_rsa_key (key, 65537);
+  gcry_sexp_release (key);
+
 
   if (verbose)
     info ("creating 512 bit RSA key with e=257\n");
@@ -645,6 +665,63 @@ check_nonce (void)
 }
 
 
+/* Return the wall clock time in milliseconds.  */
+static double
+now_msec (void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+  struct timespec ts;
+
+  clock_gettime (CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#else
+  return time (NULL) * 1000.0;
+#endif
+}
+
+
+/* Print the minimum, average and maximum time to generate an RSA key
+   of NBITS over LOOPS runs, with and without the parallel flag.  */
+static void
+time_rsa_keys (unsigned int nbits, unsigned int loops)
+{
+  static const char *flags[2] = { "", "(flags parallel)" };
+  gcry_sexp_t keyparm, key;
+  double start, t, tmin, tmax, tsum;
+  unsigned int loop;
+  int rc, mode;
+
+  printf ("%-10s %10s %10s %10s\n", "mode", "min/ms", "avg/ms", "max/ms");
+  for (mode = 0; mode < 2; mode++)
+    {
+      rc = gcry_sexp_build (&keyparm, NULL, "(genkey (rsa (nbits %u) %s))",
+                            nbits, flags[mode]);
+      if (rc)
+        die ("error creating S-expression: %s\n", gpg_strerror (rc));
+
+      tmin = tmax = tsum = 0;
+      for (loop = 0; loop < loops; loop++)
+        {
+          start = now_msec ();
+          rc = gcry_pk_genkey (&key, keyparm);
+          t = now_msec () - start;
+          if (rc)
+            die ("error generating RSA key: %s\n", gpg_strerror (rc));
+          gcry_sexp_release (key);
+          if (!loop || t < tmin)
+            tmin = t;
+          if (t > tmax)
+            tmax = t;
+          tsum += t;
+        }
+      gcry_sexp_release (keyparm);
+
+      printf ("%-10s %10.0f %10.0f %10.0f\n", mode? "parallel" : "single",
+              tmin, tsum / loops, tmax);
+    }
+}
+
+
 static void
 progress_cb (void *cb_data, const char *what, int printchar,
 		  int current, int total)
@@ -671,7 +748,9 @@ usage (int mode)
          "  --debug         flyswatter\n"
          "  --fips          run in FIPS mode\n"
          "  --no-quick      To not use the quick RNG hack\n"
-         "  --progress      print progress indicators\n",
+         "  --progress      print progress indicators\n"
+         "  --timing NBITS  time the generation of RSA keys\n"
+         "  --loops N       number of keys for --timing (default: 5)\n",
          mode? stderr : stdout);
   if (mode)
     exit (1);
@@ -684,6 +763,8 @@ main (int argc, char **argv)
   int opt_fips = 0;
   int with_progress = 0;
   int no_quick = 0;
+  unsigned int timing_nbits = 0;
+  unsigned int loops = 5;
 
   if (argc)
     { argc--; argv++; }
@@ -727,6 +808,24 @@ main (int argc, char **argv)
           argc--; argv++;
           no_quick = 1;
         }
+      else if (!strcmp (*argv, "--timing"))
+        {
+          argc--; argv++;
+          if (!argc)
+            usage (1);
+          timing_nbits = atoi (*argv);
+          argc--; argv++;
+        }
+      else if (!strcmp (*argv, "--loops"))
+        {
+          argc--; argv++;
+          if (!argc)
+            usage (1);
+          loops = atoi (*argv);
+          if (!loops)
+            loops = 1;
+          argc--; argv++;
+        }
       else if (!strncmp (*argv, "--", 2))
         die ("unknown option '%s'", *argv);
       else
@@ -758,7 +857,9 @@ main (int argc, char **argv)
   if (opt_fips && !in_fips_mode)
     die ("failed to switch into FIPS mode\n");
 
-  if (!argc)
+  if (timing_nbits)
+    time_rsa_keys (timing_nbits, loops);
+  else if (!argc)
     {
       check_rsa_keys ();
       check_elg_keys ();
@@ -425,6 +425,51 @@ test_mul (void)
 }
 
 
+/* Check products and squares large enough for the Toom-3 code and
+   the CPU specific kernels by dividing them again.  */
+static int
+test_mul_large (void)
+{
+  static const unsigned int nbits[] = { 4096, 6144, 8192, 9000, 16384,
+                                        65536 };
+  gcry_mpi_t a, b, prod, quot, rem;
+  int i, sqr;
+
+  prod = gcry_mpi_new (0);
+  quot = gcry_mpi_new (0);
+  rem = gcry_mpi_new (0);
+  for (i = 0; i < DIM (nbits); i++)
+    for (sqr = 0; sqr < 2; sqr++)
+      {
+        a = gcry_mpi_new (nbits[i]);
+        gcry_mpi_randomize (a, nbits[i], GCRY_WEAK_RANDOM);
+        gcry_mpi_set_highbit (a, nbits[i] - 1);
+        if (sqr)
+          b = gcry_mpi_copy (a);
+        else
+          {
+            b = gcry_mpi_new (nbits[i]);
+            gcry_mpi_randomize (b, nbits[i] - 7, GCRY_WEAK_RANDOM);
+            gcry_mpi_set_highbit (b, nbits[i] - 8);
+          }
+
+        gcry_mpi_mul (prod, a, sqr? a : b);
+        gcry_mpi_div (quot, rem, prod, b, 0);
+        if (gcry_mpi_cmp_ui (rem, 0) || gcry_mpi_cmp (quot, a))
+          fail ("large %s of %u bits failed\n",
+                sqr? "squaring" : "multiplication", nbits[i]);
+
+        gcry_mpi_release (a);
+        gcry_mpi_release (b);
+      }
+
+  gcry_mpi_release (prod);
+  gcry_mpi_release (quot);
+  gcry_mpi_release (rem);
+  return 1;
+}
+
+
 /* What we test here is that we don't overwrite our args and that
    using the same mpi for several args works.  */
 static int
@@ -552,6 +597,60 @@ test_powm (void)
 }
 
 
+/* Check the inverse modulo odd numbers of various sizes against the
+   definition and against the gcd.  */
+static int
+test_invm (void)
+{
+  gcry_mpi_t a = gcry_mpi_new (0);
+  gcry_mpi_t n = gcry_mpi_new (0);
+  gcry_mpi_t x = gcry_mpi_new (0);
+  gcry_mpi_t t = gcry_mpi_new (0);
+  unsigned int nbits, i;
+  int rc;
+
+  for (nbits = 2; nbits <= 4200; nbits += nbits < 300 ? 1 : 97)
+    for (i = 0; i < 4; i++)
+      {
+        gcry_mpi_randomize (n, nbits, GCRY_WEAK_RANDOM);
+        gcry_mpi_set_bit (n, 0);
+        gcry_mpi_set_bit (n, nbits - 1);
+        if (i == 0)
+          gcry_mpi_sub_ui (a, n, 1);
+        else
+          {
+            gcry_mpi_randomize (a, nbits, GCRY_WEAK_RANDOM);
+            gcry_mpi_mod (a, a, n);
+          }
+        if (i == 3)
+          {
+            /* Make A and N share the factor 3.  */
+            gcry_mpi_mul_ui (n, n, 3);
+            gcry_mpi_mul_ui (a, a, 3);
+          }
+        if (!gcry_mpi_cmp_ui (a, 0))
+          continue;
+
+        rc = gcry_mpi_invm (x, a, n);
+        gcry_mpi_gcd (t, a, n);
+        if (rc != !gcry_mpi_cmp_ui (t, 1))
+          fail ("test_invm: wrong return value for %u bits\n", nbits);
+        else if (rc)
+          {
+            gcry_mpi_mulm (t, x, a, n);
+            if (gcry_mpi_cmp_ui (t, 1) || gcry_mpi_cmp (x, n) >= 0)
+              fail ("test_invm: wrong inverse for %u bits\n", nbits);
+          }
+      }
+
+  gcry_mpi_release (a);
+  gcry_mpi_release (n);
+  gcry_mpi_release (x);
+  gcry_mpi_release (t);
+  return 1;
+}
+
+
 int
 main (int argc, char* argv[])
 {
@@ -574,7 +673,9 @@ main (int argc, char* argv[])
   test_add ();
   test_sub ();
   test_mul ();
+  test_mul_large ();
   test_powm ();
+  test_invm ();
 
   return !!error_count;
 }
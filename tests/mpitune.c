@@ -0,0 +1,494 @@
+/* mpitune.c  -  Find the multiplication thresholds of the MPI code
+ * Copyright (C) 2020 g10 Code GmbH
+ *
+ * This file is part of Libgcrypt.
+ *
+ * Libgcrypt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * Libgcrypt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* This program is built with the multiplication code of mpi/ compiled
+ * in, but with the thresholds turned into variables.  It times the
+ * code around each threshold and prints the values to be put into
+ * the mpi-asm-defs.h of the architecture.  With --check it instead
+ * compares the results of all code paths with the basecase
+ * multiplication.  */
+
+#define TUNE_PROGRAM_BUILD 1
+#include "../mpi/mpih-mul.c"
+
+#include <stdarg.h>
+#include <time.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+# include <cpuid.h>
+#endif
+
+#define PGM "mpitune"
+
+int _gcry_mpi_karatsuba_threshold = 16;
+int _gcry_mpi_karatsuba_sqr_threshold = 16;
+int _gcry_mpi_toom3_threshold = 128;
+int _gcry_mpi_toom3_sqr_threshold = 128;
+
+static int verbose;
+
+
+/* The parts of the library the multiplication code needs.  */
+mpi_ptr_t
+_gcry_mpi_alloc_limb_space (unsigned int nlimbs, int sec)
+{
+  (void)sec;
+  return _gcry_xcalloc (nlimbs? nlimbs : 1, sizeof (mpi_limb_t));
+}
+
+void
+_gcry_mpi_free_limb_space (mpi_ptr_t a, unsigned int nlimbs)
+{
+  (void)nlimbs;
+  free (a);
+}
+
+int
+_gcry_is_secure (const void *a)
+{
+  (void)a;
+  return 0;
+}
+
+void *
+_gcry_xcalloc (size_t n, size_t m)
+{
+  void *p = calloc (n, m);
+
+  if (!p)
+    {
+      fprintf (stderr, PGM ": out of core\n");
+      exit (2);
+    }
+  return p;
+}
+
+void
+_gcry_free (void *a)
+{
+  free (a);
+}
+
+
+static void
+die (const char *format, ...)
+{
+  va_list arg_ptr;
+
+  fflush (stdout);
+  fprintf (stderr, "%s: ", PGM);
+  va_start (arg_ptr, format);
+  vfprintf (stderr, format, arg_ptr);
+  va_end (arg_ptr);
+  exit (1);
+}
+
+
+/* A simple xorshift generator; the operands need not be random in
+ * any cryptographic sense.  */
+static mpi_limb_t
+rnd_limb (void)
+{
+  static unsigned long long state = 0x9e3779b97f4a7c15ULL;
+  mpi_limb_t x = 0;
+  int i;
+
+  for (i = 0; i < BYTES_PER_MPI_LIMB; i += 4)
+    {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      x = (x << 16 << 16) | (state & 0xffffffff);
+    }
+  return x;
+}
+
+
+/* Fill the SIZE limbs at XP.  Every fourth operand consists of all
+ * one bits to exercise the carry paths.  */
+static void
+fill (mpi_ptr_t xp, mpi_size_t size)
+{
+  static unsigned int count;
+  mpi_size_t i;
+
+  if (!(count++ % 4))
+    for (i = 0; i < size; i++)
+      xp[i] = ~(mpi_limb_t)0;
+  else
+    for (i = 0; i < size; i++)
+      xp[i] = rnd_limb ();
+}
+
+
+/* Return the MPIH_HWF_ bits for the features of this CPU.  */
+static unsigned int
+detect_hwf (void)
+{
+  unsigned int hwf = 0;
+#if defined(__x86_64__) && defined(__GNUC__)
+  unsigned int eax, ebx, ecx, edx, xcr0_lo, xcr0_hi;
+
+  if (!__get_cpuid_count (7, 0, &eax, &ebx, &ecx, &edx))
+    return 0;
+  if ((ebx & (1 << 8)) && (ebx & (1 << 19)))
+    hwf |= MPIH_HWF_MULX;
+
+  /* IFMA also needs the OS to save the AVX512 registers.  */
+  if ((ebx & (1 << 16)) && (ebx & (1 << 21)))
+    {
+      __get_cpuid (1, &eax, &ebx, &ecx, &edx);
+      if ((ecx & (1 << 27)))
+        {
+          asm volatile ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+          if ((xcr0_lo & 0xe6) == 0xe6)
+            hwf |= MPIH_HWF_IFMA;
+        }
+    }
+#endif
+  return hwf;
+}
+
+
+/* The reference functions run without any of the CPU specific code
+ * paths.  */
+static void
+ref_mul (mpi_ptr_t prodp, mpi_ptr_t up, mpi_ptr_t vp, mpi_size_t size)
+{
+  unsigned int saved = _gcry_mpih_hwf;
+
+  _gcry_mpih_hwf = 0;
+  mul_n_basecase (prodp, up, vp, size);
+  _gcry_mpih_hwf = saved;
+}
+
+
+static void
+check_size (mpi_size_t size, mpi_ptr_t up, mpi_ptr_t vp,
+            mpi_ptr_t rp, mpi_ptr_t refp)
+{
+  unsigned int saved = _gcry_mpih_hwf;
+  mpi_size_t vsize, i;
+
+  fill (up, size);
+  fill (vp, size);
+
+  ref_mul (refp, up, vp, size);
+  _gcry_mpih_mul_n (rp, up, vp, size);
+  if (memcmp (rp, refp, 2 * size * sizeof *rp))
+    die ("multiplication of %d limbs failed\n", (int)size);
+
+  ref_mul (refp, up, up, size);
+  _gcry_mpih_mul_n (rp, up, up, size);
+  if (memcmp (rp, refp, 2 * size * sizeof *rp))
+    die ("squaring of %d limbs failed\n", (int)size);
+
+  _gcry_mpih_sqr_n_basecase (rp, up, size);
+  if (memcmp (rp, refp, 2 * size * sizeof *rp))
+    die ("basecase squaring of %d limbs failed\n", (int)size);
+
+  _gcry_mpih_mul (rp, up, size, up, size);
+  if (memcmp (rp, refp, 2 * size * sizeof *rp))
+    die ("squaring of %d limbs with _gcry_mpih_mul failed\n", (int)size);
+
+  /* An unbalanced product through the Karatsuba chunking.  */
+  vsize = size / 3 + 1;
+  _gcry_mpih_hwf = 0;
+  MPN_ZERO (refp, size + vsize);
+  for (i = 0; i < vsize; i++)
+    refp[size + i] = _gcry_mpih_addmul_1 (refp + i, up, size, vp[i]);
+  _gcry_mpih_hwf = saved;
+  _gcry_mpih_mul (rp, up, size, vp, vsize);
+  if (memcmp (rp, refp, (size + vsize) * sizeof *rp))
+    die ("multiplication of %d by %d limbs failed\n", (int)size, (int)vsize);
+}
+
+
+/* Compare the kernels of the assembler modules with and without the
+ * CPU specific code paths.  */
+static void
+check_kernels (mpi_size_t size, mpi_ptr_t up, mpi_ptr_t vp, mpi_ptr_t mp,
+               mpi_ptr_t rp, mpi_ptr_t refp, mpi_ptr_t tp)
+{
+  unsigned int saved = _gcry_mpih_hwf;
+  mpi_limb_t limb, cy, refcy, minv;
+
+  fill (up, size);
+  fill (vp, size);
+  fill (refp, size);
+  MPN_COPY (rp, refp, size);
+  limb = rnd_limb ();
+
+  _gcry_mpih_hwf = 0;
+  refcy = _gcry_mpih_addmul_1 (refp, up, size, limb);
+  _gcry_mpih_hwf = saved;
+  cy = _gcry_mpih_addmul_1 (rp, up, size, limb);
+  if (cy != refcy || memcmp (rp, refp, size * sizeof *rp))
+    die ("addmul_1 of %d limbs failed\n", (int)size);
+
+  _gcry_mpih_hwf = 0;
+  refcy = _gcry_mpih_submul_1 (refp, vp, size, limb);
+  _gcry_mpih_hwf = saved;
+  cy = _gcry_mpih_submul_1 (rp, vp, size, limb);
+  if (cy != refcy || memcmp (rp, refp, size * sizeof *rp))
+    die ("submul_1 of %d limbs failed\n", (int)size);
+
+  /* Montgomery multiplication needs an odd M larger than U and V.  */
+  fill (mp, size);
+  mp[0] |= 1;
+  mp[size - 1] |= (mpi_limb_t)1 << (BITS_PER_MPI_LIMB - 1);
+  up[size - 1] &= ~((mpi_limb_t)1 << (BITS_PER_MPI_LIMB - 1));
+  vp[size - 1] &= ~((mpi_limb_t)1 << (BITS_PER_MPI_LIMB - 1));
+  minv = _gcry_mpih_mont_inv (mp[0]);
+
+  _gcry_mpih_hwf = 0;
+  refcy = _gcry_mpih_mont_mul_n (refp, up, vp, mp, size, minv);
+  _gcry_mpih_hwf = saved;
+  cy = _gcry_mpih_mont_mul_n (rp, up, vp, mp, size, minv);
+  if (cy != refcy || memcmp (rp, refp, size * sizeof *rp))
+    die ("mont_mul_n of %d limbs failed\n", (int)size);
+
+  _gcry_mpih_hwf = 0;
+  _gcry_mpih_mont_mul (refp, up, vp, mp, size, minv, tp);
+  _gcry_mpih_hwf = saved;
+  _gcry_mpih_mont_mul (rp, up, vp, mp, size, minv, tp);
+  if (memcmp (rp, refp, size * sizeof *rp))
+    die ("mont_mul of %d limbs failed\n", (int)size);
+
+  _gcry_mpih_hwf = 0;
+  _gcry_mpih_mont_sqr (refp, up, mp, size, minv, tp);
+  _gcry_mpih_hwf = saved;
+  _gcry_mpih_mont_sqr (rp, up, mp, size, minv, tp);
+  if (memcmp (rp, refp, size * sizeof *rp))
+    die ("mont_sqr of %d limbs failed\n", (int)size);
+}
+
+
+static void
+check (void)
+{
+  static const mpi_size_t large[] = { 500, 729, 1000, 1024, 2187 };
+  mpi_size_t maxsize = 2187;
+  mpi_ptr_t up, vp, mp, rp, refp, tp;
+  mpi_size_t size;
+  int i, pass;
+
+  up = _gcry_xcalloc (maxsize, sizeof *up);
+  vp = _gcry_xcalloc (maxsize, sizeof *vp);
+  mp = _gcry_xcalloc (maxsize, sizeof *mp);
+  rp = _gcry_xcalloc (2 * maxsize, sizeof *rp);
+  refp = _gcry_xcalloc (2 * maxsize, sizeof *refp);
+  tp = _gcry_xcalloc (6 * maxsize, sizeof *tp);
+
+  if (verbose)
+    printf ("checking with CPU features %#x\n", _gcry_mpih_hwf);
+  for (size = 1; size <= 300; size++)
+    check_kernels (size, up, vp, mp, rp, refp, tp);
+
+  /* Use the smallest thresholds the code supports so that the small
+   * sizes go through all the recursion levels.  */
+  for (pass = 0; pass < 2; pass++)
+    {
+      _gcry_mpi_karatsuba_threshold = pass? 2 : 16;
+      _gcry_mpi_karatsuba_sqr_threshold = pass? 3 : 2;
+      _gcry_mpi_toom3_threshold = 25;
+      _gcry_mpi_toom3_sqr_threshold = pass? 32 : 25;
+      if (verbose)
+        printf ("checking with thresholds %d %d %d %d\n",
+                _gcry_mpi_karatsuba_threshold,
+                _gcry_mpi_karatsuba_sqr_threshold,
+                _gcry_mpi_toom3_threshold, _gcry_mpi_toom3_sqr_threshold);
+
+      for (size = 1; size <= 300; size++)
+        check_size (size, up, vp, rp, refp);
+      for (i = 0; i < DIM (large); i++)
+        check_size (large[i], up, vp, rp, refp);
+    }
+
+  free (up);
+  free (vp);
+  free (mp);
+  free (rp);
+  free (refp);
+  free (tp);
+}
+
+
+/* Return the time in microseconds for one multiplication or squaring
+ * of SIZE limbs.  The best of several runs is taken because other
+ * load on the machine only ever makes a run slower.  */
+static double
+time_op (int sqr, mpi_ptr_t up, mpi_ptr_t vp, mpi_ptr_t rp, mpi_size_t size)
+{
+  clock_t start, now;
+  unsigned long count;
+  double t, best = 0;
+  int i, run;
+
+  for (run = 0; run < 5; run++)
+    {
+      count = 0;
+      start = clock ();
+      do
+        {
+          for (i = 0; i < 16; i++)
+            _gcry_mpih_mul_n (rp, up, sqr? up : vp, size);
+          count += 16;
+          now = clock ();
+        }
+      while (now - start < CLOCKS_PER_SEC / 100);
+
+      t = (double)(now - start) * 1e6 / CLOCKS_PER_SEC / count;
+      if (!run || t < best)
+        best = t;
+    }
+
+  return best;
+}
+
+
+/* Find the smallest size from START on at which the method enabled
+ * by setting *VAR to the size is faster than the one below.  Three
+ * consecutive wins are required to get over the timing noise.  */
+static int
+tune_one (const char *name, int *var, int sqr, int start, int limit)
+{
+  mpi_ptr_t up, vp, rp;
+  double t_below, t_above;
+  int size, step, wins = 0, first = 0;
+
+  up = _gcry_xcalloc (limit, sizeof *up);
+  vp = _gcry_xcalloc (limit, sizeof *vp);
+  rp = _gcry_xcalloc (2 * limit, sizeof *rp);
+  fill (up, limit);
+  fill (vp, limit);
+
+  for (size = start; size < limit; size += step)
+    {
+      step = size < 64? 1 : size / 32;
+
+      *var = size + 1;
+      t_below = time_op (sqr, up, vp, rp, size);
+      *var = size;
+      t_above = time_op (sqr, up, vp, rp, size);
+      if (verbose)
+        printf ("%s %4d: %10.3f %10.3f\n", name, size, t_below, t_above);
+
+      if (t_above < t_below)
+        {
+          if (!wins++)
+            first = size;
+          if (wins == 3)
+            break;
+        }
+      else
+        wins = 0;
+    }
+  if (size >= limit)
+    first = limit;
+
+  *var = first;
+  free (up);
+  free (vp);
+  free (rp);
+  return first;
+}
+
+
+int
+main (int argc, char **argv)
+{
+  int last_argc = -1;
+  int do_check = 0;
+  unsigned int hwf_mask = ~0U;
+
+  if (argc)
+    { argc--; argv++; }
+
+  while (argc && last_argc != argc )
+    {
+      last_argc = argc;
+      if (!strcmp (*argv, "--"))
+        {
+          argc--; argv++;
+          break;
+        }
+      else if (!strcmp (*argv, "--help"))
+        {
+          fputs ("usage: " PGM " [options]\n"
+                 "Options:\n"
+                 "  --verbose       print timings\n"
+                 "  --check         check the code paths instead of tuning\n"
+                 "  --hwf N         use only the CPU features in the mask N\n",
+                 stdout);
+          exit (0);
+        }
+      else if (!strcmp (*argv, "--verbose"))
+        {
+          verbose = 1;
+          argc--; argv++;
+        }
+      else if (!strcmp (*argv, "--check"))
+        {
+          do_check = 1;
+          argc--; argv++;
+        }
+      else if (!strcmp (*argv, "--hwf"))
+        {
+          argc--; argv++;
+          if (argc)
+            {
+              hwf_mask = strtoul (*argv, NULL, 0);
+              argc--; argv++;
+            }
+        }
+      else if (!strncmp (*argv, "--", 2))
+        die ("unknown option '%s'\n", *argv);
+    }
+
+  _gcry_mpih_hwf = detect_hwf () & hwf_mask;
+
+  if (do_check)
+    {
+      check ();
+      if (verbose)
+        printf ("all checks passed\n");
+      return 0;
+    }
+
+  /* Keep Toom-3 out of the way while tuning Karatsuba.  */
+  _gcry_mpi_toom3_threshold = _gcry_mpi_toom3_sqr_threshold = 100000;
+  tune_one ("karatsuba", &_gcry_mpi_karatsuba_threshold, 0, 4, 200);
+  tune_one ("karatsuba_sqr", &_gcry_mpi_karatsuba_sqr_threshold, 1, 4, 200);
+  /* Toom-3 is only tried by the Karatsuba code and needs at least
+   * 25 limbs.  */
+  tune_one ("toom3", &_gcry_mpi_toom3_threshold, 0,
+            _gcry_mpi_karatsuba_threshold < 25
+            ? 25 : _gcry_mpi_karatsuba_threshold, 1000);
+  tune_one ("toom3_sqr", &_gcry_mpi_toom3_sqr_threshold, 1,
+            _gcry_mpi_karatsuba_sqr_threshold < 25
+            ? 25 : _gcry_mpi_karatsuba_sqr_threshold, 1000);
+
+  printf ("#define KARATSUBA_THRESHOLD      %d\n"
+          "#define KARATSUBA_SQR_THRESHOLD  %d\n"
+          "#define TOOM3_THRESHOLD          %d\n"
+          "#define TOOM3_SQR_THRESHOLD      %d\n",
+          _gcry_mpi_karatsuba_threshold, _gcry_mpi_karatsuba_sqr_threshold,
+          _gcry_mpi_toom3_threshold, _gcry_mpi_toom3_sqr_threshold);
+  return 0;
+}
@@ -49,6 +49,9 @@ typedef struct context
 
 typedef int (*work_t) (context_t context, unsigned int final);
 
+/* Number of operations per benchmark.  */
+static unsigned int loops = 10;
+
 
 static void
 show_sexp (const char *prefix, gcry_sexp_t a)
@@ -110,7 +113,7 @@ static void
 benchmark (work_t worker, context_t context)
 {
   clock_t timer_start, timer_stop;
-  unsigned int loop = 10;
+  unsigned int loop = loops;
   unsigned int i = 0;
   struct tms timer;
   int ret = 0;
@@ -135,8 +138,8 @@ benchmark (work_t worker, context_t context)
 #endif
 
   if (ret)
-    printf ("%.0f ms\n",
-	    (((double) ((timer_stop - timer_start) / loop)) / CLOCKS_PER_SEC)
+    printf ("%.2f ms\n",
+	    (((double) (timer_stop - timer_start) / loop) / CLOCKS_PER_SEC)
 	    * 10000000);
   else
     printf ("[skipped]\n");
@@ -388,12 +391,219 @@ generate_key (const char *algorithm, const char *key_size)
 }
 
 
+/* Report the number of verifications per second of gcry_pk_verify
+   and of gcry_pk_verify_batch for batches of up to MAX_BATCH
+   signatures made with keys on CURVE.  */
+static void
+batch_verify (const char *curve, unsigned int max_batch)
+{
+  gcry_error_t err;
+  int eddsa = !strcmp (curve, "Ed25519");
+  gcry_sexp_t key_spec, key_pair;
+  gcry_sexp_t skeys[16], pkeys[16];
+  gcry_sexp_t *keys, *data, *sigs;
+  gcry_error_t *errs;
+  unsigned char msg[32];
+  unsigned int nkeys = DIM (skeys);
+  unsigned int batch, i, loop;
+  clock_t start;
+  double t_single, t_batch;
+
+  for (i = 0; i < nkeys; i++)
+    {
+      err = gcry_sexp_build (&key_spec, NULL,
+                             eddsa? "(genkey (ecc (curve %s) (flags eddsa)))"
+                             /**/ : "(genkey (ecc (curve %s)))", curve);
+      if (err)
+        die ("sexp_build failed: %s\n", gpg_strerror (err));
+      err = gcry_pk_genkey (&key_pair, key_spec);
+      if (err)
+        die ("pk_genkey failed: %s\n", gpg_strerror (err));
+      skeys[i] = gcry_sexp_find_token (key_pair, "private-key", 0);
+      pkeys[i] = gcry_sexp_find_token (key_pair, "public-key", 0);
+      assert (skeys[i] && pkeys[i]);
+      gcry_sexp_release (key_pair);
+      gcry_sexp_release (key_spec);
+    }
+
+  keys = gcry_xcalloc (max_batch, sizeof *keys);
+  data = gcry_xcalloc (max_batch, sizeof *data);
+  sigs = gcry_xcalloc (max_batch, sizeof *sigs);
+  errs = gcry_xcalloc (max_batch, sizeof *errs);
+  for (i = 0; i < max_batch; i++)
+    {
+      gcry_randomize (msg, sizeof msg, GCRY_WEAK_RANDOM);
+      err = gcry_sexp_build (&data[i], NULL,
+                             eddsa? "(data (flags eddsa) (hash-algo sha512)"
+                             /**/   " (value %b))"
+                             /**/ : "(data (flags raw) (value %b))",
+                             (int)sizeof msg, msg);
+      if (err)
+        die ("sexp_build failed: %s\n", gpg_strerror (err));
+      keys[i] = pkeys[i % nkeys];
+      err = gcry_pk_sign (&sigs[i], data[i], skeys[i % nkeys]);
+      if (err)
+        die ("pk_sign failed: %s\n", gpg_strerror (err));
+    }
+
+  printf ("Batch verification with %s keys:\n", curve);
+  printf ("%8s %14s %14s\n", "batch", "single/s", "batch/s");
+  for (batch = 1; batch <= max_batch; batch *= 2)
+    {
+      start = clock ();
+      for (loop = 0; loop < loops; loop++)
+        for (i = 0; i < batch; i++)
+          {
+            err = gcry_pk_verify (sigs[i], data[i], keys[i]);
+            if (err)
+              die ("pk_verify failed: %s\n", gpg_strerror (err));
+          }
+      t_single = (double)(clock () - start) / CLOCKS_PER_SEC;
+
+      start = clock ();
+      for (loop = 0; loop < loops; loop++)
+        {
+          err = gcry_pk_verify_batch (sigs, data, keys, batch, errs);
+          if (err)
+            die ("pk_verify_batch failed: %s\n", gpg_strerror (err));
+        }
+      t_batch = (double)(clock () - start) / CLOCKS_PER_SEC;
+
+      printf ("%8u %14.0f %14.0f\n", batch,
+              t_single > 0? loops * batch / t_single : 0.0,
+              t_batch > 0? loops * batch / t_batch : 0.0);
+    }
+
+  for (i = 0; i < max_batch; i++)
+    {
+      gcry_sexp_release (sigs[i]);
+      gcry_sexp_release (data[i]);
+    }
+  for (i = 0; i < nkeys; i++)
+    {
+      gcry_sexp_release (skeys[i]);
+      gcry_sexp_release (pkeys[i]);
+    }
+  gcry_free (errs);
+  gcry_free (sigs);
+  gcry_free (data);
+  gcry_free (keys);
+}
+
+
+/* Report the number of signatures and decryptions per second with an
+   NBITS RSA key given as S-expression and as a prepared key.  */
+static void
+prepared_key (const char *nbits)
+{
+  gcry_error_t err;
+  gcry_sexp_t key_spec, key_pair, skey, pkey;
+  gcry_sexp_t data, plain, sig, cipher, result;
+  gcry_ctx_t ctx;
+  unsigned char msg[32];
+  unsigned int loop;
+  clock_t start;
+  double t_sexp, t_prep;
+
+  err = gcry_sexp_build (&key_spec, NULL, "(genkey (rsa (nbits %s)))",
+                         nbits);
+  if (err)
+    die ("sexp_build failed: %s\n", gpg_strerror (err));
+  err = gcry_pk_genkey (&key_pair, key_spec);
+  if (err)
+    die ("pk_genkey failed: %s\n", gpg_strerror (err));
+  skey = gcry_sexp_find_token (key_pair, "private-key", 0);
+  pkey = gcry_sexp_find_token (key_pair, "public-key", 0);
+  assert (skey && pkey);
+  gcry_sexp_release (key_pair);
+  gcry_sexp_release (key_spec);
+
+  err = gcry_pk_prepare_key (&ctx, skey);
+  if (err)
+    die ("pk_prepare_key failed: %s\n", gpg_strerror (err));
+
+  gcry_randomize (msg, sizeof msg, GCRY_WEAK_RANDOM);
+  err = gcry_sexp_build (&data, NULL,
+                         "(data (flags pkcs1) (hash sha256 %b))",
+                         (int)sizeof msg, msg);
+  if (!err)
+    err = gcry_sexp_build (&plain, NULL, "(data (flags pkcs1) (value %b))",
+                           (int)sizeof msg, msg);
+  if (err)
+    die ("sexp_build failed: %s\n", gpg_strerror (err));
+  err = gcry_pk_encrypt (&cipher, plain, pkey);
+  if (err)
+    die ("pk_encrypt failed: %s\n", gpg_strerror (err));
+
+  printf ("Prepared keys with %s bit RSA:\n", nbits);
+  printf ("%8s %14s %14s\n", "op", "sexp/s", "prepared/s");
+
+  start = clock ();
+  for (loop = 0; loop < loops; loop++)
+    {
+      err = gcry_pk_sign (&sig, data, skey);
+      if (err)
+        die ("pk_sign failed: %s\n", gpg_strerror (err));
+      gcry_sexp_release (sig);
+    }
+  t_sexp = (double)(clock () - start) / CLOCKS_PER_SEC;
+
+  start = clock ();
+  for (loop = 0; loop < loops; loop++)
+    {
+      err = gcry_pk_sign_prepared (&sig, data, ctx);
+      if (err)
+        die ("pk_sign_prepared failed: %s\n", gpg_strerror (err));
+      gcry_sexp_release (sig);
+    }
+  t_prep = (double)(clock () - start) / CLOCKS_PER_SEC;
+
+  printf ("%8s %14.0f %14.0f\n", "sign",
+          t_sexp > 0? loops / t_sexp : 0.0,
+          t_prep > 0? loops / t_prep : 0.0);
+
+  start = clock ();
+  for (loop = 0; loop < loops; loop++)
+    {
+      err = gcry_pk_decrypt (&result, cipher, skey);
+      if (err)
+        die ("pk_decrypt failed: %s\n", gpg_strerror (err));
+      gcry_sexp_release (result);
+    }
+  t_sexp = (double)(clock () - start) / CLOCKS_PER_SEC;
+
+  start = clock ();
+  for (loop = 0; loop < loops; loop++)
+    {
+      err = gcry_pk_decrypt_prepared (&result, cipher, ctx);
+      if (err)
+        die ("pk_decrypt_prepared failed: %s\n", gpg_strerror (err));
+      gcry_sexp_release (result);
+    }
+  t_prep = (double)(clock () - start) / CLOCKS_PER_SEC;
+
+  printf ("%8s %14.0f %14.0f\n", "decrypt",
+          t_sexp > 0? loops / t_sexp : 0.0,
+          t_prep > 0? loops / t_prep : 0.0);
+
+  gcry_sexp_release (cipher);
+  gcry_sexp_release (plain);
+  gcry_sexp_release (data);
+  gcry_ctx_release (ctx);
+  gcry_sexp_release (skey);
+  gcry_sexp_release (pkey);
+}
+
+
 
 int
 main (int argc, char **argv)
 {
   int last_argc = -1;
   int genkey_mode = 0;
+  int batch_mode = 0;
+  int prepared_mode = 0;
+  unsigned int max_batch = 256;
   int fips_mode = 0;
 
   if (argc)
@@ -413,6 +623,12 @@ main (int argc, char **argv)
                 "Various public key tests:\n\n"
                 "  Default is to process all given key files\n\n"
                 "  --genkey ALGONAME SIZE  Generate a public key\n"
+                "  --batch-verify CURVE    Compare single and batch"
+                " verification\n"
+                "  --max-batch N  largest batch size (default: 256)\n"
+                "  --prepared NBITS        Compare S-expression and"
+                " prepared RSA keys\n"
+                "  --loops N    run each operation N times (default: 10)\n"
                 "\n"
                 "  --verbose    enable extra informational output\n"
                 "  --debug      enable additional debug output\n"
@@ -434,11 +650,43 @@ main (int argc, char **argv)
           genkey_mode = 1;
           argc--; argv++;
         }
+      else if (!strcmp (*argv, "--batch-verify"))
+        {
+          batch_mode = 1;
+          argc--; argv++;
+        }
+      else if (!strcmp (*argv, "--prepared"))
+        {
+          prepared_mode = 1;
+          argc--; argv++;
+        }
+      else if (!strcmp (*argv, "--max-batch"))
+        {
+          argc--; argv++;
+          if (argc)
+            {
+              max_batch = atoi (*argv);
+              if (!max_batch)
+                max_batch = 1;
+              argc--; argv++;
+            }
+        }
       else if (!strcmp (*argv, "--fips"))
         {
           fips_mode = 1;
           argc--; argv++;
         }
+      else if (!strcmp (*argv, "--loops"))
+        {
+          argc--; argv++;
+          if (argc)
+            {
+              loops = atoi (*argv);
+              if (!loops)
+                loops = 1;
+              argc--; argv++;
+            }
+        }
     }
 
   xgcry_control (GCRYCTL_SET_VERBOSITY, (int)verbose);
@@ -453,7 +701,7 @@ main (int argc, char **argv)
       exit (1);
     }
 
-  if (genkey_mode)
+  if (genkey_mode || batch_mode || prepared_mode)
     {
       /* No valuable keys are create, so we can speed up our RNG. */
       xgcry_control (GCRYCTL_ENABLE_QUICK_RANDOM, 0);
@@ -467,7 +715,15 @@ main (int argc, char **argv)
     {
       generate_key (argv[0], argv[1]);
     }
-  else if (!genkey_mode && argc)
+  else if (batch_mode && argc == 1)
+    {
+      batch_verify (argv[0], max_batch);
+    }
+  else if (prepared_mode && argc == 1)
+    {
+      prepared_key (argv[0]);
+    }
+  else if (!genkey_mode && !batch_mode && !prepared_mode && argc)
     {
       int i;
 
@@ -660,6 +660,17 @@ main (int argc, char **argv)
   /* No valuable keys are create, so we can speed up our RNG. */
   xgcry_control (GCRYCTL_ENABLE_QUICK_RANDOM, 0);
 
+  if (run_oaep)
+    check_oaep ();
+  if (run_pss)
+    check_pss ();
+  if (run_v15c)
+    check_v15crypt ();
+  if (run_v15s)
+    check_v15sign ();
+
+  /* Run the tests again using the RSA blinding cache.  */
+  xgcry_control (GCRYCTL_ENABLE_RSA_BLINDING_CACHE, 0);
   if (run_oaep)
     check_oaep ();
   if (run_pss)
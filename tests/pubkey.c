@@ -300,6 +300,105 @@ check_keys (gcry_sexp_t pkey, gcry_sexp_t skey, unsigned int nbits_data,
   gcry_sexp_release (plain);
 }
 
+/* Check that signing and decryption with the key prepared from SKEY
+   give the same results as with SKEY itself.  PREPARE_FAIL_CODE is
+   the expected error code from gcry_pk_prepare_key or 0.  */
+static void
+check_prepared (gcry_sexp_t pkey, gcry_sexp_t skey,
+                gpg_err_code_t prepare_fail_code)
+{
+  static const char hash[] =
+    "(data (flags pkcs1) (hash sha256 "
+    "#11223344556677889900AABBCCDDEEFF10203040506070809000A0B0C0D0E0F0#))";
+  gcry_ctx_t ctx;
+  gcry_sexp_t data, plain, sig0, sig1, cipher, plain0, plain1;
+  char *buf0, *buf1;
+  size_t len0, len1;
+  gcry_mpi_t x0, x1;
+  int rc, i;
+
+  rc = gcry_pk_prepare_key (&ctx, skey);
+  if (prepare_fail_code)
+    {
+      if (gpg_err_code (rc) != prepare_fail_code)
+        fail ("gcry_pk_prepare_key returned %s\n", gpg_strerror (rc));
+      gcry_ctx_release (ctx);
+      return;
+    }
+  if (rc)
+    die ("gcry_pk_prepare_key failed: %s\n", gpg_strerror (rc));
+
+  /* PKCS#1 v1.5 signatures are deterministic.  */
+  rc = gcry_sexp_new (&data, hash, 0, 1);
+  if (!rc)
+    rc = gcry_sexp_build (&plain, NULL, "(data (flags raw) (value %m))",
+                          x0 = gcry_mpi_set_ui (NULL, 0x12345678));
+  if (rc)
+    die ("converting data failed: %s\n", gpg_strerror (rc));
+  gcry_mpi_release (x0);
+  rc = gcry_pk_sign (&sig0, data, skey);
+  if (rc)
+    die ("signing failed: %s\n", gpg_strerror (rc));
+  buf0 = gcry_xmalloc (len0 = gcry_sexp_sprint (sig0, GCRYSEXP_FMT_CANON,
+                                                NULL, 0));
+  gcry_sexp_sprint (sig0, GCRYSEXP_FMT_CANON, buf0, len0);
+
+  /* Use the prepared key a few times to cover the blinding updates.  */
+  for (i = 0; i < 3; i++)
+    {
+      rc = gcry_pk_sign_prepared (&sig1, data, ctx);
+      if (rc)
+        die ("signing with prepared key failed: %s\n", gpg_strerror (rc));
+      buf1 = gcry_xmalloc (len1 = gcry_sexp_sprint (sig1, GCRYSEXP_FMT_CANON,
+                                                    NULL, 0));
+      gcry_sexp_sprint (sig1, GCRYSEXP_FMT_CANON, buf1, len1);
+      if (len0 != len1 || memcmp (buf0, buf1, len0))
+        fail ("signature of prepared key differs\n");
+      gcry_free (buf1);
+      gcry_sexp_release (sig1);
+
+      rc = gcry_pk_encrypt (&cipher, plain, pkey);
+      if (rc)
+        die ("encryption failed: %s\n", gpg_strerror (rc));
+      rc = gcry_pk_decrypt (&plain0, cipher, skey);
+      if (!rc)
+        rc = gcry_pk_decrypt_prepared (&plain1, cipher, ctx);
+      if (rc)
+        die ("decryption failed: %s\n", gpg_strerror (rc));
+      x0 = gcry_sexp_nth_mpi (plain0, 0, GCRYMPI_FMT_USG);
+      x1 = gcry_sexp_nth_mpi (plain1, 0, GCRYMPI_FMT_USG);
+      if (!x0 || !x1 || gcry_mpi_cmp (x0, x1))
+        fail ("decryption with prepared key differs\n");
+      gcry_mpi_release (x0);
+      gcry_mpi_release (x1);
+      gcry_sexp_release (plain0);
+      gcry_sexp_release (plain1);
+      gcry_sexp_release (cipher);
+    }
+
+  gcry_free (buf0);
+  gcry_sexp_release (sig0);
+  gcry_ctx_release (ctx);
+
+  /* A missing or foreign context must be rejected, not abort.  */
+  rc = gcry_pk_sign_prepared (&sig1, data, NULL);
+  if (gpg_err_code (rc) != GPG_ERR_INV_ARG)
+    fail ("signing without a context returned %s\n", gpg_strerror (rc));
+  rc = gcry_mpi_ec_new (&ctx, NULL, "NIST P-256");
+  if (rc)
+    die ("gcry_mpi_ec_new failed: %s\n", gpg_strerror (rc));
+  rc = gcry_pk_sign_prepared (&sig1, data, ctx);
+  if (gpg_err_code (rc) != GPG_ERR_INV_ARG)
+    fail ("signing with an EC context returned %s\n", gpg_strerror (rc));
+  rc = gcry_pk_decrypt_prepared (&plain1, plain, ctx);
+  if (gpg_err_code (rc) != GPG_ERR_INV_ARG)
+    fail ("decrypting with an EC context returned %s\n", gpg_strerror (rc));
+  gcry_ctx_release (ctx);
+
+  gcry_sexp_release (plain);
+  gcry_sexp_release (data);
+}
+
 static void
 get_keys_sample (gcry_sexp_t *pkey, gcry_sexp_t *skey, int secret_variant)
 {
@@ -640,6 +739,7 @@ check_run (void)
           die ("gcry_pk_testkey failed: %s\n", gpg_strerror (err));
       /* Run the usual check but expect an error from variant 2.  */
       check_keys (pkey, skey, 800, variant == 2? GPG_ERR_NO_OBJ : 0);
+      check_prepared (pkey, skey, 0);
       gcry_sexp_release (pkey);
       gcry_sexp_release (skey);
     }
@@ -648,6 +748,7 @@ check_run (void)
     fprintf (stderr, "Checking generated RSA key.\n");
   get_keys_new (&pkey, &skey);
   check_keys (pkey, skey, 800, 0);
+  check_prepared (pkey, skey, 0);
   gcry_sexp_release (pkey);
   gcry_sexp_release (skey);
 
@@ -662,6 +763,7 @@ check_run (void)
     fprintf (stderr, "Checking generated Elgamal key.\n");
   get_elg_key_new (&pkey, &skey, 0);
   check_keys (pkey, skey, 400, 0);
+  check_prepared (pkey, skey, GPG_ERR_NOT_IMPLEMENTED);
   gcry_sexp_release (pkey);
   gcry_sexp_release (skey);
 
@@ -37,6 +37,15 @@ static int sign_with_pk;
 static int no_verify;
 static int custom_data_file;
 
+/* The number of test vectors verified together by check_batch.  */
+#define BATCH_SIZE 64
+
+static gcry_sexp_t batch_sig[BATCH_SIZE];
+static gcry_sexp_t batch_msg[BATCH_SIZE];
+static gcry_sexp_t batch_pk[BATCH_SIZE];
+static int batch_testno[BATCH_SIZE];
+static int batch_count;
+
 
 static void
 show_note (const char *format, ...)
@@ -181,6 +190,254 @@ hexdowncase (char *string)
 }
 
 
+/* Store the MPI A as NBYTES little endian bytes at BUF.  */
+static void
+mpi_to_le (unsigned char *buf, size_t nbytes, gcry_mpi_t a)
+{
+  size_t n, i;
+  unsigned char t;
+
+  memset (buf, 0, nbytes);
+  if (gcry_mpi_print (GCRYMPI_FMT_USG, buf, nbytes, &n, a))
+    die ("mpi_to_le failed\n");
+  memmove (buf + nbytes - n, buf, n);
+  memset (buf, 0, nbytes - n);
+  for (i = 0; i < nbytes / 2; i++)
+    {
+      t = buf[i];
+      buf[i] = buf[nbytes - 1 - i];
+      buf[nbytes - 1 - i] = t;
+    }
+}
+
+
+/* Return the little endian number at BUF of length NBYTES.  */
+static gcry_mpi_t
+mpi_from_le (const unsigned char *buf, size_t nbytes)
+{
+  unsigned char tmp[64];
+  gcry_mpi_t a;
+  size_t i;
+
+  for (i = 0; i < nbytes; i++)
+    tmp[i] = buf[nbytes - 1 - i];
+  if (gcry_mpi_scan (&a, GCRYMPI_FMT_USG, tmp, nbytes, NULL))
+    die ("mpi_from_le failed\n");
+  return a;
+}
+
+
+/* Store the EdDSA encoding of the point P at BUF.  */
+static void
+encode_point (unsigned char *buf, gcry_mpi_point_t p, gcry_ctx_t ctx)
+{
+  gcry_mpi_t x = gcry_mpi_new (0);
+  gcry_mpi_t y = gcry_mpi_new (0);
+
+  if (gcry_mpi_ec_get_affine (x, y, p, ctx))
+    die ("encode_point failed\n");
+  mpi_to_le (buf, 32, y);
+  if (gcry_mpi_test_bit (x, 0))
+    buf[31] |= 0x80;
+  gcry_mpi_release (x);
+  gcry_mpi_release (y);
+}
+
+
+/* Check that gcry_pk_verify and gcry_pk_verify_batch agree on a
+   signature whose R has a component of order 4: R = rG + T with
+   T = (sqrt(-1), 0), and S = r + H(R,A,M) a.  Such a signature
+   satisfies the group equation only with the cofactor, which both
+   functions use.  The valid signatures in SIGS, MSGS and PKS fill
+   up the batches.  */
+static void
+check_batch_torsion (gcry_sexp_t *sigs, gcry_sexp_t *msgs, gcry_sexp_t *pks,
+                     int count)
+{
+  static const char seed_hex[] =
+    "9d61b19deffd5a60ba844af492ec2cc44449c5697b326919703bac031cae7f60";
+  static const char sqrtm1_hex[] =
+    "2B8324804FC1DF0B2B4D00993DFBD7A72F431806AD2FE478C4EE1B274A0EA0B0";
+  static const char msg[] = "small order component";
+  static const int sizes[] = { 1, 2, 3, 4, 8, BATCH_SIZE };
+  gpg_error_t err, err0;
+  gcry_error_t errs[BATCH_SIZE];
+  gcry_sexp_t t_sig[BATCH_SIZE], t_msg[BATCH_SIZE], t_pk[BATCH_SIZE];
+  gcry_ctx_t ctx;
+  gcry_mpi_t a, r, h, sval, n, x;
+  gcry_mpi_point_t G, A, R, T;
+  unsigned char digest[64], enc_a[32], enc_r[32], enc_s[32];
+  unsigned char buf[32 + 32 + sizeof msg - 1];
+  void *seed;
+  size_t seedlen;
+  int i, j, bad;
+
+  if (count < BATCH_SIZE)
+    return;
+
+  if (gcry_mpi_ec_new (&ctx, NULL, "Ed25519"))
+    die ("gcry_mpi_ec_new failed\n");
+  G = gcry_mpi_ec_get_point ("g", ctx, 1);
+  n = gcry_mpi_ec_get_mpi ("n", ctx, 1);
+  A = gcry_mpi_point_new (0);
+  R = gcry_mpi_point_new (0);
+  h = gcry_mpi_new (0);
+  sval = gcry_mpi_new (0);
+
+  /* a = the clamped first half of SHA512(seed), A = aG.  */
+  seed = hex2buffer (seed_hex, &seedlen);
+  gcry_md_hash_buffer (GCRY_MD_SHA512, digest, seed, seedlen);
+  xfree (seed);
+  digest[0] &= 0xf8;
+  digest[31] &= 0x7f;
+  digest[31] |= 0x40;
+  a = mpi_from_le (digest, 32);
+  gcry_mpi_ec_mul (A, a, G, ctx);
+  encode_point (enc_a, A, ctx);
+
+  /* R = rG + T for some r.  */
+  r = gcry_mpi_set_ui (NULL, 0x12345678);
+  gcry_mpi_ec_mul (R, r, G, ctx);
+  if (gcry_mpi_scan (&x, GCRYMPI_FMT_HEX, sqrtm1_hex, 0, NULL))
+    die ("scanning sqrt(-1) failed\n");
+  T = gcry_mpi_point_snatch_set (NULL, x, gcry_mpi_new (0),
+                                 gcry_mpi_set_ui (NULL, 1));
+  if (!gcry_mpi_ec_curve_point (T, ctx))
+    die ("T is not on the curve\n");
+  gcry_mpi_ec_add (R, R, T, ctx);
+  encode_point (enc_r, R, ctx);
+
+  /* S = r + H(R,A,M) a mod n  */
+  memcpy (buf, enc_r, 32);
+  memcpy (buf + 32, enc_a, 32);
+  memcpy (buf + 64, msg, sizeof msg - 1);
+  gcry_md_hash_buffer (GCRY_MD_SHA512, digest, buf, sizeof buf);
+  gcry_mpi_release (h);
+  h = mpi_from_le (digest, 64);
+  gcry_mpi_mulm (sval, h, a, n);
+  gcry_mpi_addm (sval, sval, r, n);
+
+  for (bad = 0; bad < 2; bad++)
+    {
+      /* The second round uses S + 1, which is not valid at all.  */
+      if (bad)
+        gcry_mpi_addm (sval, sval, GCRYMPI_CONST_ONE, n);
+      mpi_to_le (enc_s, 32, sval);
+
+      err = gcry_sexp_build (&t_sig[0], NULL,
+                             "(sig-val(eddsa(r %b)(s %b)))",
+                             32, enc_r, 32, enc_s);
+      if (!err)
+        err = gcry_sexp_build (&t_msg[0], NULL,
+                               "(data(flags eddsa)(hash-algo sha512)"
+                               "(value %b))", (int)sizeof msg - 1, msg);
+      if (!err)
+        err = gcry_sexp_build (&t_pk[0], NULL,
+                               "(public-key(ecc(curve \"Ed25519\")"
+                               "(flags eddsa)(q %b)))", 32, enc_a);
+      if (err)
+        die ("building the torsion test failed: %s\n", gpg_strerror (err));
+
+      err0 = gcry_pk_verify (t_sig[0], t_msg[0], t_pk[0]);
+      if (gpg_err_code (err0) != (bad? GPG_ERR_BAD_SIGNATURE : 0))
+        fail ("gcry_pk_verify returned %s for the %s torsion signature",
+              gpg_strerror (err0), bad? "bad" : "good");
+
+      for (i = 0; i < DIM (sizes); i++)
+        {
+          for (j = 1; j < sizes[i]; j++)
+            {
+              t_sig[j] = sigs[j];
+              t_msg[j] = msgs[j];
+              t_pk[j] = pks[j];
+            }
+          gcry_pk_verify_batch (t_sig, t_msg, t_pk, sizes[i], errs);
+          if (gpg_err_code (errs[0]) != gpg_err_code (err0))
+            fail ("gcry_pk_verify_batch returned %s for the %s torsion"
+                  " signature in a batch of %d",
+                  gpg_strerror (errs[0]), bad? "bad" : "good", sizes[i]);
+          for (j = 1; j < sizes[i]; j++)
+            if (errs[j])
+              fail ("gcry_pk_verify_batch failed for item %d of %d"
+                    " with a torsion signature: %s",
+                    j, sizes[i], gpg_strerror (errs[j]));
+        }
+
+      gcry_sexp_release (t_sig[0]);
+      gcry_sexp_release (t_msg[0]);
+      gcry_sexp_release (t_pk[0]);
+    }
+
+  gcry_mpi_point_release (T);
+  gcry_mpi_point_release (R);
+  gcry_mpi_point_release (A);
+  gcry_mpi_point_release (G);
+  gcry_mpi_release (sval);
+  gcry_mpi_release (h);
+  gcry_mpi_release (r);
+  gcry_mpi_release (a);
+  gcry_mpi_release (n);
+  gcry_ctx_release (ctx);
+}
+
+
+/* Verify the signatures collected by one_test with
+   gcry_pk_verify_batch, and for a full batch once more with two of
+   the messages swapped.  The last few test vectors all sign the
+   empty message and are not suitable for the latter.  */
+static void
+check_batch (void)
+{
+  gpg_error_t err;
+  gcry_error_t errs[BATCH_SIZE];
+  gcry_sexp_t s_tmp;
+  int i, k;
+
+  if (!batch_count)
+    return;
+
+  err = gcry_pk_verify_batch (batch_sig, batch_msg, batch_pk, batch_count,
+                              errs);
+  if (err)
+    fail ("gcry_pk_verify_batch failed for tests %d to %d: %s",
+          batch_testno[0], batch_testno[batch_count-1], gpg_strerror (err));
+  for (i = 0; i < batch_count; i++)
+    if (errs[i])
+      fail ("gcry_pk_verify_batch failed for test %d: %s",
+            batch_testno[i], gpg_strerror (errs[i]));
+
+  check_batch_torsion (batch_sig, batch_msg, batch_pk, batch_count);
+
+  if (batch_count == BATCH_SIZE)
+    {
+      k = batch_count / 2;
+      s_tmp = batch_msg[k-1];
+      batch_msg[k-1] = batch_msg[k];
+      batch_msg[k] = s_tmp;
+
+      err = gcry_pk_verify_batch (batch_sig, batch_msg, batch_pk,
+                                  batch_count, errs);
+      if (gpg_err_code (err) != GPG_ERR_BAD_SIGNATURE)
+        fail ("gcry_pk_verify_batch did not detect bad signatures"
+              " for tests %d to %d", batch_testno[0],
+              batch_testno[batch_count-1]);
+      for (i = 0; i < batch_count; i++)
+        if (gpg_err_code (errs[i])
+            != ((i == k-1 || i == k)? GPG_ERR_BAD_SIGNATURE : 0))
+          fail ("gcry_pk_verify_batch returned a wrong result"
+                " for test %d: %s", batch_testno[i], gpg_strerror (errs[i]));
+    }
+
+  for (i = 0; i < batch_count; i++)
+    {
+      gcry_sexp_release (batch_sig[i]);
+      gcry_sexp_release (batch_msg[i]);
+      gcry_sexp_release (batch_pk[i]);
+    }
+  batch_count = 0;
+}
+
+
 static void
 one_test (int testno, const char *sk, const char *pk,
           const char *msg, const char *sig)
@@ -327,6 +584,18 @@ one_test (int testno, const char *sk, const char *pk,
       fail ("gcry_pk_verify failed for test %d: %s",
             testno, gpg_strerror (err));
 
+  /* Keep the signature for check_batch.  */
+  if (!no_verify && s_sig)
+    {
+      batch_testno[batch_count] = testno;
+      batch_sig[batch_count] = s_sig;
+      batch_msg[batch_count] = s_msg;
+      batch_pk[batch_count] = s_pk;
+      s_sig = s_msg = s_pk = NULL;
+      if (++batch_count == BATCH_SIZE)
+        check_batch ();
+    }
+
 
  leave:
   gcry_sexp_release (s_sig);
@@ -393,6 +662,7 @@ check_ed25519 (const char *fname)
   xfree (sk);
   xfree (msg);
   xfree (sig);
+  check_batch ();
 
   if (ntests != N_TESTS && !custom_data_file)
     fail ("did %d tests but expected %d", ntests, N_TESTS);
@@ -487,6 +757,9 @@ main (int argc, char **argv)
 
   start_timer ();
   check_ed25519 (fname);
+  /* Run the tests again using the ECC context cache.  */
+  xgcry_control (GCRYCTL_ENABLE_ECC_CACHE, 0);
+  check_ed25519 (fname);
   stop_timer ();
 
   xfree (fname);
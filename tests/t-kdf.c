@@ -962,6 +962,83 @@ check_pbkdf2 (void)
       "\x13\x3a\x4c\xe8\x37\xb4\xd2\x52\x1e\xe2"
       "\xbf\x03\xe1\x1c\x71\xca\x79\x4e\x07\x97"
     },
+    { /* from RFC-7914 */
+      "passwd", 6,
+      "salt", 4,
+      GCRY_MD_SHA256,
+      1,
+      64,
+      "\x55\xac\x04\x6e\x56\xe3\x08\x9f\xec\x16\x91\xc2\x25\x44\xb6\x05"
+      "\xf9\x41\x85\x21\x6d\xde\x04\x65\xe6\x8b\x9d\x57\xc2\x0d\xac\xbc"
+      "\x49\xca\x9c\xcc\xf1\x79\xb6\x45\x99\x16\x64\xb3\x9d\x77\xef\x31"
+      "\x7c\x71\xb8\x45\xb1\xe3\x0b\xd5\x09\x11\x20\x41\xd3\xa1\x97\x83"
+    },
+    { /* from RFC-7914 */
+      "Password", 8,
+      "NaCl", 4,
+      GCRY_MD_SHA256,
+      80000,
+      64,
+      "\x4d\xdc\xd8\xf6\x0b\x98\xbe\x21\x83\x0c\xee\x5e\xf2\x27\x01\xf9"
+      "\x64\x1a\x44\x18\xd0\x4c\x04\x14\xae\xff\x08\x87\x6b\x34\xab\x56"
+      "\xa1\xd4\x25\xa1\x22\x58\x33\x54\x9a\xdb\x84\x1b\x51\xc9\xb3\x17"
+      "\x6a\x27\x2b\xde\xbb\xa1\xd0\x78\x47\x8f\x62\xb3\x97\xf3\x3c\x8d"
+    },
+    { /* long password and salt, many blocks */
+      "0123456789012345678901234567890123456789"
+      "0123456789012345678901234567890123456789"
+      "01234567890123456789", 100,
+      "SaltSaltSaltSaltSaltSaltSaltSaltSalt"
+      "SaltSaltSaltSaltSaltSaltSaltSaltSalt", 72,
+      GCRY_MD_SHA1,
+      1000,
+      200,
+      "\x18\x16\x8f\xac\x1b\x7f\x83\x5d\x83\x7a\x01\xb5\x9a\x31\x13\x93"
+      "\x81\x76\x4a\xd9\x28\x4e\x93\xfa\xc4\x78\xd0\xb5\xc2\xfb\x5f\x99"
+      "\xb3\x6f\xb8\xf0\xdc\xb0\x89\x76\x2a\xe8\xcd\x82\xf3\x69\xba\xee"
+      "\xc5\x76\x48\xce\x70\xa4\x3e\x52\xd7\x39\xd1\x5e\x39\x1d\xab\x45"
+      "\x56\x90\xa2\xf6\x6c\x00\xfb\x07\xd9\xbb\xad\xa4\xb9\x3c\x9a\x28"
+      "\xe8\x96\x3a\x11\x42\x9c\x54\x80\x4e\xdb\xa9\xd4\x1b\xc7\xb8\xda"
+      "\xe8\xdb\x27\x8f\xaa\x8a\x57\xc2\x2a\xf0\x26\xf5\x44\x12\xac\xd3"
+      "\x28\xba\x08\x12\xc2\xb0\x47\x61\xd8\xca\x68\x34\xb7\x10\xe8\x78"
+      "\x82\x72\x3c\xf5\x5d\x91\x29\xe8\xc3\x31\x5a\x3f\x78\x41\x7b\xc8"
+      "\xbe\x62\x82\x00\xa6\x50\x94\x69\x5e\xdc\x23\x5c\xc1\x93\xb3\x19"
+      "\x53\xef\x3e\x16\x3d\x5e\x84\x1b\xa6\x28\x26\x50\x18\xaf\x84\xf3"
+      "\x21\x22\x9e\x28\x95\x78\x58\x9e\x4e\x3f\x2f\xec\x5c\x43\x27\x9e"
+      "\x63\xb5\x19\x41\x6c\xfa\x30\xbf"
+    },
+    { /* not in RFC-6070 */
+      "password", 8,
+      "salt", 4,
+      GCRY_MD_SHA224,
+      1000,
+      100,
+      "\xd3\xbc\xf3\x20\xfd\x91\x89\x08\xea\xfc\xaa\x46\x0f\xaf\x40\xe2"
+      "\x01\xf6\x50\x8d\x4e\x6f\x3d\x9c\x1c\x0a\xbd\x30\xda\xe0\x8c\xc8"
+      "\xb1\xbc\x06\x57\xe2\xeb\xc2\x29\xd2\x2e\x48\xdf\x55\xdf\x72\xe8"
+      "\x3f\x2e\x50\xdb\x23\x24\xa7\x3b\x01\xdd\xbb\x88\x83\x16\x62\xf0"
+      "\x08\x0d\xa7\x02\x59\x64\xa7\x78\xae\xe5\x80\xfd\x2b\x77\x82\x40"
+      "\x70\xdb\xd3\x2f\x40\x15\x8e\x70\x9a\xd3\x2a\xc7\xe2\xdd\x28\xdf"
+      "\xc9\xd9\x5c\xf3"
+    },
+    { /* long password, many blocks */
+      "passphrase longer than one block of the hash algorithm: "
+      "0123456789", 66,
+      "salt", 4,
+      GCRY_MD_SHA256,
+      1000,
+      160,
+      "\xde\xb6\x77\x0c\x5a\xef\xc5\x3e\x46\xc4\xeb\x8d\x5d\x7e\xff\xd8"
+      "\x64\x2a\x36\xbf\x39\x55\xee\x96\x10\xa3\x47\x9d\xa6\xd5\xda\x82"
+      "\xe9\xda\xe3\x98\xfc\xeb\xe4\x9e\xfe\x5a\xfa\x78\xa7\xa3\x21\x11"
+      "\xb1\x99\xd7\x39\x6b\xa0\x55\xc3\x3a\x7c\x15\x2e\xa1\x4c\x57\x36"
+      "\xf6\xe0\x11\x90\x7b\x65\xf7\x69\x2e\x2c\x12\xe0\xee\x02\xa2\x79"
+      "\xe2\xa9\x46\xf2\x39\x7b\xed\x45\x61\x66\x4f\x53\x9b\x6f\x1d\x6b"
+      "\x24\xec\xfa\xcf\x74\xd0\x8a\x3c\x1c\xef\xbb\xc9\x17\x98\x50\xad"
+      "\x32\x8e\x0a\x20\x7e\x1b\x76\xea\x15\x76\x28\x96\x36\x62\xf9\x7c"
+      "\x2b\x7a\x6f\xd2\xec\xd6\xd9\x3b\x74\x20\x27\x19\x35\x16\xda\x1e"
+      "\xa6\xa5\x87\x82\x96\x70\xc6\x42\xe6\x05\xa5\xbc\xe5\x7a\x40\xdc"
+    },
     {
       "password", 8,
       "salt", 4,
@@ -1089,7 +1166,7 @@ check_pbkdf2 (void)
   };
   int tvidx;
   gpg_error_t err;
-  unsigned char outbuf[100];
+  unsigned char outbuf[200];
   int i;
 
   for (tvidx=0; tvidx < DIM(tv); tvidx++)
@@ -1188,6 +1265,9 @@ check_scrypt (void)
   gpg_error_t err;
   unsigned char outbuf[64];
   int i;
+  gcry_ctx_t ctx;
+  unsigned int flags;
+  int n;
 
   for (tvidx=0; tvidx < DIM(tv); tvidx++)
     {
@@ -1211,7 +1291,45 @@ check_scrypt (void)
             fprintf (stderr, " %02x", outbuf[i]);
           putc ('\n', stderr);
         }
+
+      /* Derive twice with a prepared context, once sequentially and
+         once with worker threads.  */
+      for (flags = 0; flags <= GCRY_KDF_FLAG_PARALLEL; flags++)
+        {
+          err = gcry_kdf_prepare (&ctx,
+                                  tv[tvidx].parm_r == 1 ? 41 : GCRY_KDF_SCRYPT,
+                                  tv[tvidx].parm_n, tv[tvidx].parm_p, flags);
+          if (err)
+            {
+              fail ("scrypt test %d: prepare failed: %s\n",
+                    tvidx, gpg_strerror (err));
+              continue;
+            }
+          for (n = 0; n < 2; n++)
+            {
+              memset (outbuf, 0, sizeof outbuf);
+              err = gcry_kdf_derive_prepared (ctx, tv[tvidx].p, tv[tvidx].plen,
+                                              tv[tvidx].salt,
+                                              tv[tvidx].saltlen,
+                                              tv[tvidx].dklen, outbuf);
+              if (err)
+                fail ("scrypt test %d: prepared (flags %u) failed: %s\n",
+                      tvidx, flags, gpg_strerror (err));
+              else if (memcmp (outbuf, tv[tvidx].dk, tv[tvidx].dklen))
+                fail ("scrypt test %d: prepared (flags %u) mismatch\n",
+                      tvidx, flags);
+            }
+          gcry_ctx_release (ctx);
+        }
     }
+
+  err = gcry_kdf_prepare (&ctx, GCRY_KDF_SCRYPT, 16, 1, 2);
+  if (gpg_err_code (err) != GPG_ERR_INV_FLAG)
+    fail ("scrypt prepare with bad flags: %s\n", gpg_strerror (err));
+
+  err = gcry_kdf_derive_prepared (NULL, "p", 1, "s", 1, sizeof outbuf, outbuf);
+  if (gpg_err_code (err) != GPG_ERR_INV_ARG)
+    fail ("scrypt derive without a context: %s\n", gpg_strerror (err));
 }
 
 
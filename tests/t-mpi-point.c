@@ -1287,6 +1287,203 @@ point_on_curve (void)
 }
 
 
+/* Check gcry_mpi_ec_mul2 against separate multiplications.  */
+static void
+ec_mul2 (void)
+{
+  static const char *curves[] = { "NIST P-256", "NIST P-384", "Ed25519" };
+  gpg_error_t err;
+  gcry_ctx_t ctx;
+  gcry_mpi_point_t G, Q, R, R1, R2, P1, P2;
+  gcry_mpi_t n, s1, s2, t1, t2, x1, y1, x2, y2;
+  int cidx, i;
+  int rc1, rc2;
+
+  wherestr = "ec_mul2";
+  for (cidx = 0; cidx < DIM (curves); cidx++)
+    {
+      if (gcry_fips_mode_active () && !strcmp (curves[cidx], "Ed25519"))
+        continue;
+      info ("checking double scalar multiplication on %s\n", curves[cidx]);
+
+      err = gcry_mpi_ec_new (&ctx, NULL, curves[cidx]);
+      if (err)
+        die ("gcry_mpi_ec_new failed: %s\n", gpg_strerror (err));
+      G = gcry_mpi_ec_get_point ("g", ctx, 1);
+      n = gcry_mpi_ec_get_mpi ("n", ctx, 1);
+      if (!G || !n)
+        die ("gcry_mpi_ec_get_* failed\n");
+
+      Q = gcry_mpi_point_new (0);
+      R = gcry_mpi_point_new (0);
+      R1 = gcry_mpi_point_new (0);
+      R2 = gcry_mpi_point_new (0);
+      s1 = gcry_mpi_new (0);
+      s2 = gcry_mpi_new (0);
+      t1 = gcry_mpi_new (0);
+      t2 = gcry_mpi_new (0);
+      x1 = gcry_mpi_new (0);
+      y1 = gcry_mpi_new (0);
+      x2 = gcry_mpi_new (0);
+      y2 = gcry_mpi_new (0);
+
+      gcry_mpi_randomize (s1, gcry_mpi_get_nbits (n) - 1, GCRY_WEAK_RANDOM);
+      gcry_mpi_ec_mul (Q, s1, G, ctx);
+
+      for (i = 0; i < 32; i++)
+        {
+          P1 = (i & 1)? Q : G;
+          P2 = (i & 2)? Q : G;
+          gcry_mpi_randomize (s1, (i & 4)? 512 : 256, GCRY_WEAK_RANDOM);
+          gcry_mpi_randomize (s2, (i & 8)? 512 : 256, GCRY_WEAK_RANDOM);
+          if ((i & 16))
+            gcry_mpi_neg (s2, s2);
+          switch (i)
+            {
+            case 4:  gcry_mpi_set_ui (s1, 0); break;
+            case 5:  gcry_mpi_set_ui (s2, 1); break;
+            case 8:  gcry_mpi_sub_ui (s1, n, 1); break;
+            case 12: gcry_mpi_set_ui (s1, 0); gcry_mpi_set_ui (s2, 0); break;
+            case 16: gcry_mpi_neg (s2, s1); break;
+            }
+
+          gcry_mpi_ec_mul2 (R, s1, P1, s2, P2, ctx);
+
+          /* gcry_mpi_ec_mul expects non-negative scalars.  */
+          gcry_mpi_mod (t1, s1, n);
+          gcry_mpi_mod (t2, s2, n);
+          gcry_mpi_ec_mul (R1, t1, P1, ctx);
+          gcry_mpi_ec_mul (R2, t2, P2, ctx);
+          gcry_mpi_ec_add (R1, R1, R2, ctx);
+
+          rc1 = gcry_mpi_ec_get_affine (x1, y1, R1, ctx);
+          rc2 = gcry_mpi_ec_get_affine (x2, y2, R, ctx);
+          if (rc1 != rc2
+              || (!rc1 && (gcry_mpi_cmp (x1, x2) || gcry_mpi_cmp (y1, y2))))
+            {
+              fail ("double scalar multiplication failed (i=%d)\n", i);
+              print_mpi ("s1", s1);
+              print_mpi ("s2", s2);
+              print_point ("expected", R1);
+              print_point ("     got", R);
+            }
+        }
+
+      gcry_mpi_release (y2);
+      gcry_mpi_release (x2);
+      gcry_mpi_release (y1);
+      gcry_mpi_release (x1);
+      gcry_mpi_release (t2);
+      gcry_mpi_release (t1);
+      gcry_mpi_release (s2);
+      gcry_mpi_release (s1);
+      gcry_mpi_point_release (R2);
+      gcry_mpi_point_release (R1);
+      gcry_mpi_point_release (R);
+      gcry_mpi_point_release (Q);
+      gcry_mpi_release (n);
+      gcry_mpi_point_release (G);
+      gcry_ctx_release (ctx);
+    }
+}
+
+
+/* Check that a context still computes correctly after its domain
+   parameters have been replaced by those of a curve over a different
+   field.  The fast reduction chosen for the original P must not be
+   used any longer.  */
+static void
+ec_param_change (void)
+{
+  static struct
+  {
+    const char *curve;          /* The curve of the new context.  */
+    const char *desc;
+    const char *p, *a, *b;      /* The replacement parameters.  */
+    const char *g_x, *g_y;
+    const char *k;              /* The scalar.  */
+    const char *r_x, *r_y;      /* The expected result k * G.  */
+  } tv[] =
+    {
+      {
+        "NIST P-256", "secp256k1",
+        "0xfffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f",
+        "0x00",
+        "0x07",
+        "0x79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798",
+        "0x483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8",
+        "0x1d3c5e7f9a2b4c6d8e0f1a3b5c7d9e1f2a4b6c8d0e2f4a6b8c0d2e4f6a8b0c2d",
+        "0x2cff0c55a3ee25ac5dd20b87a6625dff650063ce276b259f824dc80c06ca2ac0",
+        "0x57fe6cd5a260e3a56700d5a03b649356e24939e33ec5f54a08f4b53d3b6d9d8e"
+      },
+      {
+        /* Only the X coordinate is computed for this one.  */
+        "Curve25519", "a Montgomery curve over GF(2^255-31)",
+        "0x7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffe1",
+        "0x01db41",
+        "0x01",
+        "0x09",
+        "0x00",
+        "0x5d3c5e7f9a2b4c6d8e0f1a3b5c7d9e1f2a4b6c8d0e2f4a6b8c0d2e4f6a8b0c28",
+        "0x79e62abd1685b47018d404833cc0082e768600208f7718962be9d1dd3f183ab7",
+        NULL
+      }
+    };
+  gpg_error_t err;
+  gcry_ctx_t ctx;
+  gcry_mpi_point_t G, R;
+  gcry_mpi_t k, x, y;
+  int idx, i;
+
+  wherestr = "ec_param_change";
+  for (idx = 0; idx < DIM (tv); idx++)
+    {
+      if (gcry_fips_mode_active () && !strcmp (tv[idx].curve, "Curve25519"))
+        continue;
+      info ("checking %s with the parameters of %s\n",
+            tv[idx].curve, tv[idx].desc);
+
+      err = gcry_mpi_ec_new (&ctx, NULL, tv[idx].curve);
+      if (err)
+        die ("gcry_mpi_ec_new failed: %s\n", gpg_strerror (err));
+
+      for (i = 0; i < 3; i++)
+        {
+          x = hex2mpi (i == 0? tv[idx].p : i == 1? tv[idx].a : tv[idx].b);
+          err = gcry_mpi_ec_set_mpi (i == 0? "p" : i == 1? "a" : "b", x, ctx);
+          if (err)
+            die ("gcry_mpi_ec_set_mpi failed: %s\n", gpg_strerror (err));
+          gcry_mpi_release (x);
+        }
+
+      G = make_point (tv[idx].g_x, tv[idx].g_y, "1");
+      R = gcry_mpi_point_new (0);
+      k = hex2mpi (tv[idx].k);
+      x = gcry_mpi_new (0);
+      y = gcry_mpi_new (0);
+
+      gcry_mpi_ec_mul (R, k, G, ctx);
+      if (gcry_mpi_ec_get_affine (x, tv[idx].r_y? y : NULL, R, ctx))
+        fail ("failed to get affine coordinates\n");
+      else if (cmp_mpihex (x, tv[idx].r_x)
+               || (tv[idx].r_y && cmp_mpihex (y, tv[idx].r_y)))
+        {
+          fail ("point multiplication failed for %s with the parameters"
+                " of %s\n", tv[idx].curve, tv[idx].desc);
+          print_mpi ("x", x);
+          print_mpi ("y", y);
+        }
+
+      gcry_mpi_release (y);
+      gcry_mpi_release (x);
+      gcry_mpi_release (k);
+      gcry_mpi_point_release (R);
+      gcry_mpi_point_release (G);
+      gcry_ctx_release (ctx);
+    }
+}
+
+
 int
 main (int argc, char **argv)
 {
@@ -1310,6 +1507,8 @@ main (int argc, char **argv)
   context_param ();
   basic_ec_math ();
   point_on_curve ();
+  ec_mul2 ();
+  ec_param_change ();
 
   /* The tests are for P-192 and ed25519 which are not supported in
      FIPS mode.  */